@@ -0,0 +1,80 @@
+// Tests that a localField/foreignField $lookup joining a sharded foreign collection runs on the
+// shards when both collections are sharded on the join field with the same chunk placement, and is
+// rejected when they are not.
+(function() {
+"use strict";
+
+load("jstests/noPassthrough/libs/server_parameter_helpers.js");  // For setParameterOnAllHosts.
+load("jstests/libs/discover_topology.js");                       // For findNonConfigNodes.
+
+const st = new ShardingTest({shards: 2, mongos: 1});
+const dbName = "test";
+const db = st.s.getDB(dbName);
+
+setParameterOnAllHosts(
+    DiscoverTopology.findNonConfigNodes(st.s), "internalQueryEnableCoLocatedLookup", true);
+
+assert.commandWorked(st.s.adminCommand({enableSharding: dbName}));
+st.ensurePrimaryShard(dbName, st.shard0.shardName);
+
+// Shards 'coll' on 'key', 'splitAt' separating the chunk on shard0 from the chunk on shard1.
+function shardCollection(coll, key, splitAt) {
+    assert.commandWorked(st.s.adminCommand({shardCollection: coll.getFullName(), key: {[key]: 1}}));
+    assert.commandWorked(st.s.adminCommand({split: coll.getFullName(), middle: {[key]: splitAt}}));
+    assert.commandWorked(st.s.adminCommand({
+        moveChunk: coll.getFullName(),
+        find: {[key]: splitAt},
+        to: st.shard1.shardName,
+        _waitForDelete: true
+    }));
+}
+
+const localColl = db.local;
+const coLocatedColl = db.coLocated;
+const notCoLocatedColl = db.notCoLocated;
+
+shardCollection(localColl, "a", 0);
+shardCollection(coLocatedColl, "b", 0);
+shardCollection(notCoLocatedColl, "b", 10);
+
+for (let i = -5; i < 5; ++i) {
+    assert.commandWorked(localColl.insert({_id: i, a: i}));
+    assert.commandWorked(coLocatedColl.insert({_id: i, b: i}));
+    assert.commandWorked(notCoLocatedColl.insert({_id: i, b: i}));
+}
+
+function lookupFrom(coll) {
+    return [
+        {$lookup: {from: coll.getName(), localField: "a", foreignField: "b", as: "matches"}},
+        {$sort: {_id: 1}}
+    ];
+}
+
+// The co-located $lookup runs on each shard and finds the one matching foreign document.
+const results = localColl.aggregate(lookupFrom(coLocatedColl)).toArray();
+assert.eq(10, results.length, results);
+for (let result of results) {
+    assert.eq([{_id: result._id, b: result.a}], result.matches, result);
+}
+
+const explain = localColl.explain().aggregate(lookupFrom(coLocatedColl));
+assert(explain.hasOwnProperty("splitPipeline"), explain);
+assert(explain.splitPipeline.shardsPart.some((stage) => stage.hasOwnProperty("$lookup")), explain);
+
+// The chunks of 'notCoLocated' are split at a different point, so the router rejects the $lookup
+// when it plans the pipeline.
+assert.commandFailedWithCode(
+    db.runCommand(
+        {aggregate: localColl.getName(), pipeline: lookupFrom(notCoLocatedColl), cursor: {}}),
+    28769);
+
+// Without co-located $lookup, a sharded foreign collection is rejected as before.
+setParameterOnAllHosts(
+    DiscoverTopology.findNonConfigNodes(st.s), "internalQueryEnableCoLocatedLookup", false);
+assert.commandFailedWithCode(
+    db.runCommand(
+        {aggregate: localColl.getName(), pipeline: lookupFrom(coLocatedColl), cursor: {}}),
+    28769);
+
+st.stop();
+}());
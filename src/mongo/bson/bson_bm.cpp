@@ -112,8 +112,32 @@ void BM_validate(benchmark::State& state) {
     state.SetBytesProcessed(totalSize);
 }
 
+// Validates an array of flat documents holding only fixed-width values, as in a typical batch of
+// time series or metrics inserts. The field names are long enough to span several 16-byte blocks.
+void BM_validateFlat(benchmark::State& state) {
+    BSONArrayBuilder builder;
+    auto len = state.range(0);
+    size_t totalSize = 0;
+    for (auto j = 0; j < len; j++) {
+        builder.append(BSON("_id" << j << "timestamp" << Date_t::fromMillisSinceEpoch(j)
+                                  << "sensor_temperature_celsius" << j * 0.5
+                                  << "sensor_relative_humidity_percent" << j % 100
+                                  << "sensor_sample_count" << static_cast<long long>(j)
+                                  << "sensor_is_calibrated" << (j % 2 == 0)));
+    }
+    BSONObj array = builder.done();
+
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        benchmark::DoNotOptimize(validateBSON(array.objdata(), array.objsize()));
+        totalSize += array.objsize();
+    }
+    state.SetBytesProcessed(totalSize);
+}
+
 BENCHMARK(BM_arrayBuilder)->Ranges({{{1}, {100'000}}});
 BENCHMARK(BM_arrayLookup)->Ranges({{{1}, {100'000}}});
 BENCHMARK(BM_validate)->Ranges({{{1}, {1'000}}});
+BENCHMARK(BM_validateFlat)->Ranges({{{1}, {1'000}}});
 
 }  // namespace mongo
@@ -31,11 +31,16 @@
 #include <cstring>
 #include <vector>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "mongo/base/data_view.h"
 #include "mongo/bson/bson_depth.h"
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/bsonelement.h"
 #include "mongo/logv2/log.h"
+#include "mongo/platform/bits.h"
 
 namespace mongo {
 namespace {
@@ -150,6 +155,18 @@ private:
             // This is actually by far the hottest code in all of BSON validation.
             dassert(ptr < end);
             size_t len = 0;
+#if defined(__SSE2__)
+            // Look for the NUL 16 bytes at a time while they are all within the object, which
+            // covers most field names with a single compare. The object ends in a NUL, so the
+            // scalar loop below finds it without reading past the end.
+            const auto zero = _mm_setzero_si128();
+            while (end - (ptr + len) >= 16) {
+                auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + len));
+                if (auto mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero)))
+                    return len + countTrailingZeros64(mask);
+                len += 16;
+            }
+#endif
             while (ptr[len])
                 ++len;
             return len;
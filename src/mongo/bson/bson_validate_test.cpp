@@ -244,6 +244,23 @@ TEST(BSONValidateFast, Simple3) {
     ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
 }
 
+TEST(BSONValidateFast, FieldNameLengths) {
+    // Field names of every length around the 16-byte blocks which are scanned at once, with
+    // elements ending close to the end of the object.
+    for (size_t len = 1; len <= 48; ++len) {
+        std::string fieldName(len, 'f');
+        BSONObj x = BSON(fieldName << 1 << "g" << true << fieldName + "h" << BSONNULL);
+        ASSERT_OK(validateBSON(x.objdata(), x.objsize()));
+
+        BufBuilder bb;
+        BSONObjBuilder ob(bb);
+        ob.append(fieldName, 1);
+        appendInvalidStringElement(fieldName.c_str(), &bb);
+        BSONObj invalid = ob.done();
+        ASSERT_NOT_OK(validateBSON(invalid.objdata(), invalid.objsize()));
+    }
+}
+
 TEST(BSONValidateFast, NestedObject) {
     BSONObj x = BSON("a" << 1 << "b"
                          << BSON("c" << 2 << "d" << BSONArrayBuilder().obj() << "e"
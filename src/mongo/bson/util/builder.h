@@ -438,6 +438,9 @@ public:
     static constexpr size_t kDefaultInitSizeBytes = 512;
     BufBuilder(size_t initsize = kDefaultInitSizeBytes) : BasicBufBuilder(initsize) {}
 
+    /* build in 'buf', which must not be shared. It is grown with SharedBuffer::realloc(). */
+    explicit BufBuilder(SharedBuffer buf) : BasicBufBuilder(std::move(buf)) {}
+
     /* assume ownership of the buffer */
     SharedBuffer release() {
         return _buf.release();
@@ -135,6 +135,10 @@ Message DBClientCursor::_assembleInit() {
                 // Legacy queries don't handle requestResumeToken.
                 qr.getValue()->setRequestResumeToken(true);
             }
+            if (query.getBoolField(QueryRequest::kRequestEncodedOplogBatchesField)) {
+                // Legacy queries don't handle requestEncodedOplogBatches.
+                qr.getValue()->setRequestEncodedOplogBatches(true);
+            }
             if (query.hasField("$_resumeAfter")) {
                 // Legacy queries don't handle resumeAfter.
                 qr.getValue()->setResumeAfter(query.getObjectField("$_resumeAfter"));
@@ -48,6 +48,7 @@
 #include "mongo/db/query/find.h"
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/get_executor.h"
+#include "mongo/db/repl/oplog_batch_encoding.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/db/stats/counters.h"
@@ -466,12 +467,25 @@ public:
             std::uint64_t numResults = 0;
             bool stashedResult = false;
 
+            // Secondaries reading the oplog may ask for each batch to be returned as a single
+            // encoded document.
+            boost::optional<repl::EncodedOplogBatchBuilder> encodedBatch;
+            if (originalQR.getRequestEncodedOplogBatches()) {
+                uassert(ErrorCodes::BadValue,
+                        str::stream() << QueryRequest::kRequestEncodedOplogBatchesField
+                                      << " is only supported on the oplog",
+                        nss.isOplog());
+                encodedBatch.emplace();
+            }
+
             try {
                 while (!FindCommon::enoughForFirstBatch(originalQR, numResults) &&
                        PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr))) {
                     // If we can't fit this result inside the current batch, then we stash it for
                     // later.
-                    if (!FindCommon::haveSpaceForNext(obj, numResults, firstBatch.bytesUsed())) {
+                    auto bytesUsed =
+                        firstBatch.bytesUsed() + (encodedBatch ? encodedBatch->bytesUsed() : 0);
+                    if (!FindCommon::haveSpaceForNext(obj, numResults, bytesUsed)) {
                         exec->enqueue(obj);
                         stashedResult = true;
                         break;
@@ -481,9 +495,19 @@ public:
                     firstBatch.setPostBatchResumeToken(exec->getPostBatchResumeToken());
 
                     // Add result to output buffer.
-                    firstBatch.append(obj);
+                    if (encodedBatch) {
+                        encodedBatch->append(obj);
+                    } else {
+                        firstBatch.append(obj);
+                    }
                     numResults++;
                 }
+
+                if (encodedBatch) {
+                    for (auto&& doc : encodedBatch->done()) {
+                        firstBatch.append(doc);
+                    }
+                }
             } catch (DBException& exception) {
                 firstBatch.abandon();
 
@@ -50,8 +50,10 @@
 #include "mongo/db/query/getmore_request.h"
 #include "mongo/db/query/plan_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_request.h"
 #include "mongo/db/read_concern.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/repl/oplog_batch_encoding.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/repl/speculative_majority_read_info.h"
 #include "mongo/db/service_context.h"
@@ -311,12 +313,23 @@ public:
             // timeout to the user.
             BSONObj obj;
             PlanExecutor::ExecState state;
+
+            // The find command which created the cursor may have asked for each batch of oplog
+            // entries to be returned as a single encoded document.
+            boost::optional<repl::EncodedOplogBatchBuilder> encodedBatch;
+            if (cursor->getOriginatingCommandObj()[QueryRequest::kRequestEncodedOplogBatchesField]
+                    .trueValue()) {
+                encodedBatch.emplace();
+            }
+
             try {
                 while (!FindCommon::enoughForGetMore(request.batchSize.value_or(0), *numResults) &&
                        PlanExecutor::ADVANCED == (state = exec->getNext(&obj, nullptr))) {
                     // If adding this object will cause us to exceed the message size limit, then we
                     // stash it for later.
-                    if (!FindCommon::haveSpaceForNext(obj, *numResults, nextBatch->bytesUsed())) {
+                    auto bytesUsed =
+                        nextBatch->bytesUsed() + (encodedBatch ? encodedBatch->bytesUsed() : 0);
+                    if (!FindCommon::haveSpaceForNext(obj, *numResults, bytesUsed)) {
                         exec->enqueue(obj);
                         break;
                     }
@@ -326,9 +339,19 @@ public:
 
                     // If this executor produces a postBatchResumeToken, add it to the response.
                     nextBatch->setPostBatchResumeToken(exec->getPostBatchResumeToken());
-                    nextBatch->append(obj);
+                    if (encodedBatch) {
+                        encodedBatch->append(obj);
+                    } else {
+                        nextBatch->append(obj);
+                    }
                     (*numResults)++;
                 }
+
+                if (encodedBatch) {
+                    for (auto&& doc : encodedBatch->done()) {
+                        nextBatch->append(doc);
+                    }
+                }
             } catch (const ExceptionFor<ErrorCodes::CloseChangeStream>&) {
                 // This exception indicates that we should close the cursor without reporting an
                 // error.
@@ -664,6 +687,12 @@ public:
                     // Indicate that an exhaust message should be generated and the previous BSONObj
                     // command parameters should be reused as the next BSONObj command parameters.
                     reply->setNextInvocation(boost::none);
+
+                    // Unless the cursor waits for new data, the next batch is generated
+                    // immediately, so this one may be sent together with it.
+                    if (!cursorPin->isAwaitData()) {
+                        reply->setCanDeferExhaustReply();
+                    }
                 }
             }
         }
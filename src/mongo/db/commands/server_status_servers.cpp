@@ -34,9 +34,11 @@
 #include "mongo/transport/message_compressor_registry.h"
 #include "mongo/transport/service_entry_point.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_work_stealing.h"
 #include "mongo/util/net/hostname_canonicalization.h"
 #include "mongo/util/net/socket_utils.h"
 #include "mongo/util/net/ssl_manager.h"
+#include "mongo/util/shared_buffer_pool.h"
 
 namespace mongo {
 
@@ -84,7 +86,15 @@ public:
         BSONObjBuilder b;
         networkCounter.append(b);
         appendMessageCompressionStats(&b);
-        auto executor = transport::ServiceExecutorSynchronous::get(opCtx->getServiceContext());
+        {
+            BSONObjBuilder section(b.subobjStart("bufferPool"));
+            SharedBufferPool::appendStats(&section);
+        }
+        transport::ServiceExecutor* executor =
+            transport::ServiceExecutorWorkStealing::get(opCtx->getServiceContext());
+        if (!executor) {
+            executor = transport::ServiceExecutorSynchronous::get(opCtx->getServiceContext());
+        }
         if (executor) {
             BSONObjBuilder section(b.subobjStart("serviceExecutorTaskStats"));
             executor->appendStats(&section);
@@ -452,6 +452,10 @@ struct DbResponse {
     // The next invocation for an exhaust command. If this is boost::none, the previous invocation
     // should be reused for the next invocation.
     boost::optional<BSONObj> nextInvocation;
+
+    // For exhaust commands, indicates whether the next invocation returns without waiting for new
+    // data, so that this response may be held back and sent together with the next one.
+    bool canDeferExhaustReply = false;
 };
 
 /**
@@ -32,12 +32,36 @@
 #include "mongo/db/ftdc/block_compressor.h"
 
 #include <zlib.h>
+#include <zstd.h>
 
+#include "mongo/util/assert_util.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
 
-StatusWith<ConstDataRange> BlockCompressor::compress(ConstDataRange source) {
+StatusWith<ConstDataRange> BlockCompressor::compress(ConstDataRange source, Codec codec) {
+    switch (codec) {
+        case Codec::kZlib:
+            return _compressZlib(source);
+        case Codec::kZstd:
+            return _compressZstd(source);
+    }
+    MONGO_UNREACHABLE;
+}
+
+StatusWith<ConstDataRange> BlockCompressor::uncompress(ConstDataRange source,
+                                                       size_t uncompressedLength,
+                                                       Codec codec) {
+    switch (codec) {
+        case Codec::kZlib:
+            return _uncompressZlib(source, uncompressedLength);
+        case Codec::kZstd:
+            return _uncompressZstd(source, uncompressedLength);
+    }
+    MONGO_UNREACHABLE;
+}
+
+StatusWith<ConstDataRange> BlockCompressor::_compressZlib(ConstDataRange source) {
     z_stream stream;
     int level = Z_DEFAULT_COMPRESSION;
 
@@ -77,8 +101,21 @@ StatusWith<ConstDataRange> BlockCompressor::compress(ConstDataRange source) {
     return ConstDataRange(_buffer.data(), stream.total_out);
 }
 
-StatusWith<ConstDataRange> BlockCompressor::uncompress(ConstDataRange source,
-                                                       size_t uncompressedLength) {
+StatusWith<ConstDataRange> BlockCompressor::_compressZstd(ConstDataRange source) {
+    _buffer.resize(ZSTD_compressBound(source.length()));
+
+    size_t ret = ZSTD_compress(
+        _buffer.data(), _buffer.size(), source.data(), source.length(), ZSTD_CLEVEL_DEFAULT);
+    if (ZSTD_isError(ret)) {
+        return {ErrorCodes::InternalError,
+                str::stream() << "ZSTD_compress failed with " << ZSTD_getErrorName(ret)};
+    }
+
+    return ConstDataRange(_buffer.data(), ret);
+}
+
+StatusWith<ConstDataRange> BlockCompressor::_uncompressZlib(ConstDataRange source,
+                                                            size_t uncompressedLength) {
     z_stream stream;
 
     stream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(source.data()));
@@ -115,4 +152,17 @@ StatusWith<ConstDataRange> BlockCompressor::uncompress(ConstDataRange source,
     return ConstDataRange(_buffer.data(), stream.total_out);
 }
 
+StatusWith<ConstDataRange> BlockCompressor::_uncompressZstd(ConstDataRange source,
+                                                            size_t uncompressedLength) {
+    _buffer.resize(uncompressedLength);
+
+    size_t ret = ZSTD_decompress(_buffer.data(), _buffer.size(), source.data(), source.length());
+    if (ZSTD_isError(ret)) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "ZSTD_decompress failed with " << ZSTD_getErrorName(ret)};
+    }
+
+    return ConstDataRange(_buffer.data(), ret);
+}
+
 }  // namespace mongo
@@ -31,7 +31,10 @@
 
 #include "mongo/db/ftdc/compressor.h"
 
-#include "mongo/base/data_builder.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "mongo/db/ftdc/config.h"
 #include "mongo/db/ftdc/util.h"
 #include "mongo/db/ftdc/varint.h"
@@ -43,6 +46,66 @@ namespace mongo {
 
 using std::swap;
 
+namespace {
+
+// Number of deltas checked for zero at a time when skipping over runs of zeroes.
+constexpr std::size_t kZeroBlockSize = 4;
+
+bool isZeroBlock(const std::uint64_t* deltas) {
+#if defined(__SSE2__)
+    auto first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas));
+    auto second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(deltas + 2));
+    auto bytes = _mm_or_si128(first, second);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128())) == 0xFFFF;
+#else
+    return (deltas[0] | deltas[1] | deltas[2] | deltas[3]) == 0;
+#endif
+}
+
+/**
+ * Encodes the deltas of one metric at 'out' and returns the position after them. A run of zeroes
+ * is written as the pair (0, count - 1) once a non-zero delta ends it, so 'zeroesCount' carries an
+ * unfinished run over to the next metric.
+ *
+ * 'out' must have room for FTDCVarInt::kMaxSizeBytes64 bytes per delta, plus one pair for a run
+ * carried over from the previous metric.
+ */
+char* encodeMetricDeltas(const std::uint64_t* deltas,
+                         std::size_t count,
+                         std::uint32_t* zeroesCount,
+                         char* out) {
+    for (std::size_t j = 0; j < count; ++j) {
+        // Most metrics do not change between samples, so skip over their zeroes a block at a time.
+        while (j + kZeroBlockSize <= count && isZeroBlock(deltas + j)) {
+            *zeroesCount += kZeroBlockSize;
+            j += kZeroBlockSize;
+        }
+
+        if (j == count) {
+            break;
+        }
+
+        const std::uint64_t delta = deltas[j];
+        if (delta == 0) {
+            ++*zeroesCount;
+            continue;
+        }
+
+        // If we have a non-zero sample, then write out all the accumulated zero samples.
+        if (*zeroesCount > 0) {
+            out = FTDCVarInt::encode(0, out);
+            out = FTDCVarInt::encode(*zeroesCount - 1, out);
+            *zeroesCount = 0;
+        }
+
+        out = FTDCVarInt::encode(delta, out);
+    }
+
+    return out;
+}
+
+}  // namespace
+
 StatusWith<boost::optional<std::tuple<ConstDataRange, FTDCCompressor::CompressorState, Date_t>>>
 FTDCCompressor::addSample(const BSONObj& sample, Date_t date) {
     if (_referenceDoc.isEmpty()) {
@@ -129,9 +192,6 @@ StatusWith<std::tuple<ConstDataRange, Date_t>> FTDCCompressor::getCompressedSamp
     _uncompressedChunkBuffer.appendNum(static_cast<std::uint32_t>(_deltaCount));
 
     if (_metricsCount != 0 && _deltaCount != 0) {
-        // On average, we do not need all 10 bytes for every sample, worst case, we grow the buffer
-        DataBuilder db(_metricsCount * _deltaCount * FTDCVarInt::kMaxSizeBytes64 / 2);
-
         std::uint32_t zeroesCount = 0;
 
         // For each set of samples for a particular metric,
@@ -145,61 +205,30 @@ StatusWith<std::tuple<ConstDataRange, Date_t>> FTDCCompressor::getCompressedSamp
         //   - Each memeber is stored as VarInt packed integer
         // 3. Finally, for non-zero members, we store these as VarInt packed
         //
-        // These byte arrays are added to a buffer which is then concatenated with other chunks and
-        // compressed with ZLIB.
+        // The deltas of each metric are contiguous in _deltas, so each metric is encoded in one
+        // pass straight into the uncompressed buffer, which is then compressed with the
+        // configured codec.
+        const int maxMetricSize = (_deltaCount + 2) * FTDCVarInt::kMaxSizeBytes64;
         for (std::uint32_t i = 0; i < _metricsCount; i++) {
-            for (std::uint32_t j = 0; j < _deltaCount; j++) {
-                std::uint64_t delta = _deltas[getArrayOffset(_maxDeltas, j, i)];
-
-                if (delta == 0) {
-                    ++zeroesCount;
-                    continue;
-                }
-
-                // If we have a non-zero sample, then write out all the accumulated zero samples.
-                if (zeroesCount > 0) {
-                    auto s1 = db.writeAndAdvance(FTDCVarInt(0));
-                    if (!s1.isOK()) {
-                        return s1;
-                    }
-
-                    auto s2 = db.writeAndAdvance(FTDCVarInt(zeroesCount - 1));
-                    if (!s2.isOK()) {
-                        return s2;
-                    }
-
-                    zeroesCount = 0;
-                }
-
-                auto s3 = db.writeAndAdvance(FTDCVarInt(delta));
-                if (!s3.isOK()) {
-                    return s3;
-                }
-            }
-
-            // If we are on the last metric, and the previous loop ended in a zero, write out the
-            // RLE
-            // pair of zero information.
-            if ((i == (_metricsCount - 1)) && zeroesCount) {
-                auto s1 = db.writeAndAdvance(FTDCVarInt(0));
-                if (!s1.isOK()) {
-                    return s1;
-                }
-
-                auto s2 = db.writeAndAdvance(FTDCVarInt(zeroesCount - 1));
-                if (!s2.isOK()) {
-                    return s2;
-                }
-            }
+            const int start = _uncompressedChunkBuffer.len();
+            char* begin = _uncompressedChunkBuffer.grow(maxMetricSize);
+            char* end = encodeMetricDeltas(
+                &_deltas[getArrayOffset(_maxDeltas, 0, i)], _deltaCount, &zeroesCount, begin);
+            _uncompressedChunkBuffer.setlen(start + (end - begin));
         }
 
-        // Append the entire compacted metric chunk into the uncompressed buffer
-        ConstDataRange cdr = db.getCursor();
-        _uncompressedChunkBuffer.appendBuf(cdr.data(), cdr.length());
+        // If the last metric ended in a run of zeroes, write out the RLE pair of zero information.
+        if (zeroesCount) {
+            const int start = _uncompressedChunkBuffer.len();
+            char* begin = _uncompressedChunkBuffer.grow(2 * FTDCVarInt::kMaxSizeBytes64);
+            char* end = FTDCVarInt::encode(0, begin);
+            end = FTDCVarInt::encode(zeroesCount - 1, end);
+            _uncompressedChunkBuffer.setlen(start + (end - begin));
+        }
     }
 
     auto swDest = _compressor.compress(
-        ConstDataRange(_uncompressedChunkBuffer.buf(), _uncompressedChunkBuffer.len()));
+        ConstDataRange(_uncompressedChunkBuffer.buf(), _uncompressedChunkBuffer.len()), _codec);
 
     // The only way for compression to fail is if the buffer size calculations are wrong
     if (!swDest.isOK()) {
@@ -80,7 +80,8 @@ public:
         kCompressorFull,
     };
 
-    explicit FTDCCompressor(const FTDCConfig* config) : _config(config) {}
+    explicit FTDCCompressor(const FTDCConfig* config)
+        : _config(config), _codec(config->compressor) {}
 
     /**
      * Add a bson document containing metrics into the compressor.
@@ -128,6 +129,13 @@ public:
      */
     StatusWith<std::tuple<ConstDataRange, Date_t>> getCompressedSamples();
 
+    /**
+     * Codec the buffers returned by the compressor are compressed with.
+     */
+    BlockCompressor::Codec getCodec() const {
+        return _codec;
+    }
+
     /**
      * Reset the state of the compressor.
      *
@@ -157,6 +165,9 @@ private:
     // Config
     const FTDCConfig* const _config;
 
+    // Codec for every chunk, so that it can not change between compressing a chunk and writing it
+    const BlockCompressor::Codec _codec;
+
     // Reference schema document
     BSONObj _referenceDoc;
 
@@ -122,8 +122,9 @@ TEST_F(FTDCCompressorTest, TestStrings) {
  */
 class TestTie {
 public:
-    TestTie(FTDCValidationMode mode = FTDCValidationMode::kStrict)
-        : _compressor(&_config), _mode(mode) {}
+    TestTie(FTDCValidationMode mode = FTDCValidationMode::kStrict,
+            BlockCompressor::Codec codec = BlockCompressor::Codec::kZlib)
+        : _config(makeConfig(codec)), _compressor(&_config), _mode(mode) {}
 
     ~TestTie() {
         validate(boost::none);
@@ -155,13 +156,13 @@ public:
     void validate(boost::optional<ConstDataRange> cdr) {
         std::vector<BSONObj> list;
         if (cdr.is_initialized()) {
-            auto sw = _decompressor.uncompress(cdr.get());
+            auto sw = _decompressor.uncompress(cdr.get(), _config.compressor);
             ASSERT_TRUE(sw.isOK());
             list = sw.getValue();
         } else {
             auto swBuf = _compressor.getCompressedSamples();
             ASSERT_TRUE(swBuf.isOK());
-            auto sw = _decompressor.uncompress(std::get<0>(swBuf.getValue()));
+            auto sw = _decompressor.uncompress(std::get<0>(swBuf.getValue()), _config.compressor);
             ASSERT_TRUE(sw.isOK());
 
             list = sw.getValue();
@@ -542,6 +543,53 @@ TEST_F(FTDCCompressorTest, TestManyMetrics) {
     }
 }
 
+// Test runs of zeros of many lengths, both within a metric and across metrics, with each codec
+TEST_F(FTDCCompressorTest, TestZeroRuns) {
+    const size_t metrics = 7;
+
+    for (auto codec : {BlockCompressor::Codec::kZlib, BlockCompressor::Codec::kZstd}) {
+        TestTie c(FTDCValidationMode::kStrict, codec);
+
+        for (size_t i = 0; i != FTDCConfig::kMaxSamplesPerArchiveMetricChunkDefault - 1; i++) {
+            BSONObjBuilder builder;
+
+            // Metric m changes every m + 1 samples, and the last metric never changes
+            for (size_t m = 0; m < metrics; m++) {
+                builder.append(std::to_string(m),
+                               static_cast<long long>(m == metrics - 1 ? 0 : i / (m + 1)));
+            }
+
+            auto st = c.addSample(builder.obj());
+            ASSERT_HAS_SPACE(st);
+        }
+    }
+}
+
+// Test many metrics with the zstd codec
+TEST_F(FTDCCompressorTest, TestManyMetricsZstd) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+
+    std::uniform_int_distribution<long long> genValues(1, std::numeric_limits<long long>::max());
+    const size_t metrics = 1000;
+
+    TestTie c(FTDCValidationMode::kStrict, BlockCompressor::Codec::kZstd);
+
+    auto st = c.addSample(generateSample(rd, genValues, metrics));
+    ASSERT_HAS_SPACE(st);
+
+    for (size_t i = 0; i != FTDCConfig::kMaxSamplesPerArchiveMetricChunkDefault - 2; i++) {
+        st = c.addSample(generateSample(rd, genValues, metrics));
+        ASSERT_HAS_SPACE(st);
+    }
+
+    st = c.addSample(generateSample(rd, genValues, metrics));
+    ASSERT_FULL(st);
+
+    st = c.addSample(generateSample(rd, genValues, metrics));
+    ASSERT_HAS_SPACE(st);
+}
+
 // Test various non-finite double values
 TEST_F(FTDCCompressorTest, TestDoubleValues) {
     TestTie c;
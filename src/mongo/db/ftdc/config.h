@@ -31,6 +31,7 @@
 
 #include <cstdint>
 
+#include "mongo/db/ftdc/block_compressor.h"
 #include "mongo/util/time_support.h"
 
 namespace mongo {
@@ -47,7 +48,8 @@ struct FTDCConfig {
           maxFileSizeBytes(kMaxFileSizeBytesDefault),
           period(kPeriodMillisDefault),
           maxSamplesPerArchiveMetricChunk(kMaxSamplesPerArchiveMetricChunkDefault),
-          maxSamplesPerInterimMetricChunk(kMaxSamplesPerInterimMetricChunkDefault) {}
+          maxSamplesPerInterimMetricChunk(kMaxSamplesPerInterimMetricChunkDefault),
+          compressor(BlockCompressor::Codec::kZlib) {}
 
     /**
      * True if FTDC is collecting data. False otherwise
@@ -84,6 +86,12 @@ struct FTDCConfig {
      */
     std::uint32_t maxSamplesPerInterimMetricChunk;
 
+    /**
+     * Codec used to compress metric chunks. Only zlib chunks can be read by versions which predate
+     * the metric chunk version field.
+     */
+    BlockCompressor::Codec compressor;
+
     static const bool kEnabledDefault = true;
 
     static const std::int64_t kPeriodMillisDefault;
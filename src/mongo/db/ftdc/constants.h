@@ -39,6 +39,7 @@ extern const char kFTDCArchiveFile[];
 
 extern const char kFTDCIdField[];
 extern const char kFTDCTypeField[];
+extern const char kFTDCVersionField[];
 
 extern const char kFTDCDataField[];
 extern const char kFTDCDocField[];
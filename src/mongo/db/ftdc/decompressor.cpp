@@ -42,7 +42,8 @@
 
 namespace mongo {
 
-StatusWith<std::vector<BSONObj>> FTDCDecompressor::uncompress(ConstDataRange buf) {
+StatusWith<std::vector<BSONObj>> FTDCDecompressor::uncompress(ConstDataRange buf,
+                                                              BlockCompressor::Codec codec) {
     ConstDataRangeCursor compressedDataRange(buf);
 
     // Read the length of the uncompressed buffer
@@ -60,7 +61,8 @@ StatusWith<std::vector<BSONObj>> FTDCDecompressor::uncompress(ConstDataRange buf
         return Status(ErrorCodes::InvalidLength, "Metrics chunk has exceeded the allowable size.");
     }
 
-    auto statusUncompress = _compressor.uncompress(compressedDataRange, uncompressedLength);
+    auto statusUncompress =
+        _compressor.uncompress(compressedDataRange, uncompressedLength, codec);
 
     if (!statusUncompress.isOK()) {
         return {statusUncompress.getStatus()};
@@ -126,37 +128,32 @@ StatusWith<std::vector<BSONObj>> FTDCDecompressor::uncompress(ConstDataRange buf
     // Read the samples
     std::vector<std::uint64_t> deltas(metricsCount * sampleCount);
 
-    // decompress the deltas
-    std::uint64_t zeroesCount = 0;
-
-    auto cdrc = ConstDataRangeCursor(cdc);
-
-    for (std::uint32_t i = 0; i < metricsCount; i++) {
-        for (std::uint32_t j = 0; j < sampleCount; j++) {
-            if (zeroesCount) {
-                deltas[FTDCCompressor::getArrayOffset(sampleCount, j, i)] = 0;
-                zeroesCount--;
-                continue;
-            }
-
-            auto swDelta = cdrc.readAndAdvanceNoThrow<FTDCVarInt>();
-
-            if (!swDelta.isOK()) {
-                return swDelta.getStatus();
-            }
-
-            if (swDelta.getValue() == 0) {
-                auto swZero = cdrc.readAndAdvanceNoThrow<FTDCVarInt>();
-
-                if (!swZero.isOK()) {
-                    return swZero.getStatus();
-                }
+    // Decompress the deltas. They are stored metric by metric, in the same order as the array,
+    // so they are decoded as one run over it. The array starts zeroed, so runs of zeroes, which
+    // may span metrics, are skipped over.
+    const char* ptr = cdc.data();
+    const char* const end = ptr + cdc.length();
+    const std::size_t deltasCount = deltas.size();
+
+    for (std::size_t k = 0; k < deltasCount;) {
+        std::uint64_t delta;
+        ptr = FTDCVarInt::decode(ptr, end, &delta);
+        if (!ptr) {
+            return {ErrorCodes::Overflow, "Metrics chunk has truncated or invalid deltas."};
+        }
 
-                zeroesCount = swZero.getValue();
-            }
+        if (delta != 0) {
+            deltas[k++] = delta;
+            continue;
+        }
 
-            deltas[FTDCCompressor::getArrayOffset(sampleCount, j, i)] = swDelta.getValue();
+        std::uint64_t zeroesCount;
+        ptr = FTDCVarInt::decode(ptr, end, &zeroesCount);
+        if (!ptr) {
+            return {ErrorCodes::Overflow, "Metrics chunk has truncated or invalid deltas."};
         }
+
+        k += std::min<std::uint64_t>(zeroesCount, deltasCount - k - 1) + 1;
     }
 
     // Inflate the deltas
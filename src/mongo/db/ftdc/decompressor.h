@@ -55,7 +55,8 @@ public:
      *
      * Returns N samples where N = sample count + 1. The 1 is the reference document.
      */
-    StatusWith<std::vector<BSONObj>> uncompress(ConstDataRange buf);
+    StatusWith<std::vector<BSONObj>> uncompress(
+        ConstDataRange buf, BlockCompressor::Codec codec = BlockCompressor::Codec::kZlib);
 
 private:
     BlockCompressor _compressor;
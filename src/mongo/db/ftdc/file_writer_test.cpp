@@ -145,9 +145,10 @@ TEST_F(FTDCFileTest, TestFileBasicCompress) {
  */
 class FileTestTie {
 public:
-    FileTestTie()
+    FileTestTie(BlockCompressor::Codec codec = BlockCompressor::Codec::kZlib)
         : _tempdir("metrics_testpath"),
           _path(boost::filesystem::path(_tempdir.path()) / kTestFile),
+          _config(makeConfig(codec)),
           _writer(&_config) {
         deleteFileIfNeeded(_path);
 
@@ -268,6 +269,17 @@ TEST_F(FTDCFileTest, TestFull) {
     }
 }
 
+// Test that chunks compressed with zstd are read back
+TEST_F(FTDCFileTest, TestFullZstd) {
+    FileTestTie c(BlockCompressor::Codec::kZstd);
+
+    for (size_t i = 0; i <= FTDCConfig::kMaxSamplesPerArchiveMetricChunkDefault * 2; i++) {
+        c.addSample(BSON("name"
+                         << "joe"
+                         << "key1" << static_cast<long long int>(i) << "key2" << 45));
+    }
+}
+
 // Test a large documents so that we cause multiple 4kb buffers to flush on Windows.
 TEST_F(FTDCFileTest, TestLargeDocuments) {
     FileTestTie c;
@@ -170,6 +170,16 @@ Status onUpdateFTDCPerInterimUpdate(const std::int32_t potentialNewValue) {
     return Status::OK();
 }
 
+Status validateFTDCCompressor(const std::string& value) {
+    if (value != "zlib" && value != "zstd") {
+        return {ErrorCodes::BadValue,
+                str::stream() << "Unsupported diagnostic data compressor '" << value
+                              << "', expected 'zlib' or 'zstd'"};
+    }
+
+    return Status::OK();
+}
+
 FTDCSimpleInternalCommandCollector::FTDCSimpleInternalCommandCollector(StringData command,
                                                                        StringData name,
                                                                        StringData ns,
@@ -260,6 +270,9 @@ void startFTDC(boost::filesystem::path& path,
         ftdcStartupParams.maxSamplesPerArchiveMetricChunk.load();
     config.maxSamplesPerInterimMetricChunk =
         ftdcStartupParams.maxSamplesPerInterimMetricChunk.load();
+    config.compressor = gDiagnosticDataCollectionCompressor == "zstd"
+        ? BlockCompressor::Codec::kZstd
+        : BlockCompressor::Codec::kZlib;
 
     ftdcDirectoryPathParameter = path;
 
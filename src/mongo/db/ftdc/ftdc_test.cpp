@@ -112,6 +112,12 @@ void ValidateDocumentList(const std::vector<BSONObj>& docs1,
 }
 
 
+FTDCConfig makeConfig(BlockCompressor::Codec codec) {
+    FTDCConfig config;
+    config.compressor = codec;
+    return config;
+}
+
 void deleteFileIfNeeded(const boost::filesystem::path& p) {
     if (boost::filesystem::exists(p)) {
         boost::filesystem::remove(p);
@@ -30,6 +30,7 @@
 #include <boost/filesystem.hpp>
 #include <vector>
 
+#include "mongo/db/ftdc/config.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/service_context_test_fixture.h"
 
@@ -74,6 +75,11 @@ void ValidateDocumentList(const std::vector<BSONObj>& docs1,
                           const std::vector<BSONObj>& docs2,
                           FTDCValidationMode mode);
 
+/**
+ * Create a default config which compresses chunks with the specified codec.
+ */
+FTDCConfig makeConfig(BlockCompressor::Codec codec);
+
 /**
  * Delete a file if it exists.
  */
@@ -55,6 +55,7 @@ const char kFTDCArchiveFile[] = "metrics";
 
 const char kFTDCIdField[] = "_id";
 const char kFTDCTypeField[] = "type";
+const char kFTDCVersionField[] = "version";
 
 const char kFTDCDataField[] = "data";
 const char kFTDCDocField[] = "doc";
@@ -435,11 +436,16 @@ BSONObj createBSONMetadataDocument(const BSONObj& metadata, Date_t date) {
     return builder.obj();
 }
 
-BSONObj createBSONMetricChunkDocument(ConstDataRange buf, Date_t date) {
+BSONObj createBSONMetricChunkDocument(ConstDataRange buf,
+                                      Date_t date,
+                                      BlockCompressor::Codec codec) {
     BSONObjBuilder builder;
 
     builder.appendDate(kFTDCIdField, date);
     builder.appendNumber(kFTDCTypeField, static_cast<int>(FTDCType::kMetricChunk));
+    if (codec == BlockCompressor::Codec::kZstd) {
+        builder.appendNumber(kFTDCVersionField, static_cast<int>(FTDCMetricChunkVersion::kZstd));
+    }
     builder.appendBinData(kFTDCDataField, buf.length(), BinDataType::BinDataGeneral, buf.data());
 
     return builder.obj();
@@ -511,7 +517,28 @@ StatusWith<std::vector<BSONObj>> getMetricsFromMetricDoc(const BSONObj& obj,
                 str::stream() << "Field " << std::string(kFTDCTypeField) << " is not a BinData."};
     }
 
-    return decompressor->uncompress({buffer, static_cast<std::size_t>(length)});
+    long long version;
+    status = bsonExtractIntegerFieldWithDefault(
+        obj, kFTDCVersionField, static_cast<int>(FTDCMetricChunkVersion::kZlib), &version);
+    if (!status.isOK()) {
+        return {status};
+    }
+
+    BlockCompressor::Codec codec;
+    switch (static_cast<FTDCMetricChunkVersion>(version)) {
+        case FTDCMetricChunkVersion::kZlib:
+            codec = BlockCompressor::Codec::kZlib;
+            break;
+        case FTDCMetricChunkVersion::kZstd:
+            codec = BlockCompressor::Codec::kZstd;
+            break;
+        default:
+            return {ErrorCodes::BadValue,
+                    str::stream() << "Field '" << std::string(kFTDCVersionField)
+                                  << "' is not an expected value, found '" << version << "'"};
+    }
+
+    return decompressor->uncompress({buffer, static_cast<std::size_t>(length)}, codec);
 }
 
 }  // namespace FTDCBSONUtil
@@ -34,6 +34,7 @@
 
 #include "mongo/base/status.h"
 #include "mongo/base/status_with.h"
+#include "mongo/db/ftdc/block_compressor.h"
 #include "mongo/db/ftdc/decompressor.h"
 #include "mongo/db/jsobj.h"
 
@@ -67,6 +68,24 @@ enum class FTDCType : std::int32_t {
     kMetricChunk = 1,
 };
 
+/**
+ * Format version of the compressed data in a metric chunk.
+ *
+ * NOTE: Persisted to disk via BSON Objects. Metric chunks without a version field are kZlib, so
+ * that chunks written with the default codec remain readable by versions which predate the field.
+ */
+enum class FTDCMetricChunkVersion : std::int32_t {
+    /**
+     * The deltas are compressed with zlib.
+     */
+    kZlib = 1,
+
+    /**
+     * The deltas are compressed with zstd.
+     */
+    kZstd = 2,
+};
+
 
 /**
  * Extract an array of numbers from a pair of documents. Verifies the pair of documents have same
@@ -141,15 +160,19 @@ BSONObj createBSONMetadataDocument(const BSONObj& metadata, Date_t date);
  * Create a BSON metric chunk document for storage. The passed in document is embedded as the
  * data field in the example above. For the _id field, the date is specified by the caller
  * since the metric chunk usually composed of multiple samples gathered over a period of time.
+ * The version field is only written for chunks which are not compressed with zlib.
  *
  * Example:
  * {
  *  "_id" : Date_t
  *  "type" : 1
+ *  "version" : 2
  *  "data" : BinData(...)
  * }
  */
-BSONObj createBSONMetricChunkDocument(ConstDataRange buf, Date_t now);
+BSONObj createBSONMetricChunkDocument(ConstDataRange buf,
+                                      Date_t now,
+                                      BlockCompressor::Codec codec = BlockCompressor::Codec::kZlib);
 
 /**
  * Get the _id field of a BSON document
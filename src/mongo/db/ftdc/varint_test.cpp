@@ -74,6 +74,41 @@ TEST(FTDCVarIntTest, TestIntCompression) {
     }
 }
 
+// Test the unchecked encoder and decoder agree with the DataType handler
+void TestIntEncode(std::uint64_t i) {
+    char expected[FTDCVarInt::kMaxSizeBytes64];
+    DataRangeCursor cursor(expected, expected + sizeof(expected));
+    ASSERT_OK(cursor.writeAndAdvanceNoThrow(FTDCVarInt(i)));
+    std::size_t expectedLength = cursor.data() - expected;
+
+    char buf[FTDCVarInt::kMaxSizeBytes64];
+    char* end = FTDCVarInt::encode(i, buf);
+    ASSERT_EQUALS(static_cast<std::size_t>(end - buf), expectedLength);
+    ASSERT_EQUALS(0, memcmp(buf, expected, expectedLength));
+
+    std::uint64_t d;
+    ASSERT(FTDCVarInt::decode(buf, end, &d) == end);
+    ASSERT_EQUALS(i, d);
+
+    // Truncated data does not decode
+    ASSERT(FTDCVarInt::decode(buf, end - 1, &d) == nullptr);
+}
+
+TEST(FTDCVarIntTest, TestIntEncode) {
+    for (int i = 0; i < 64; i++) {
+        TestIntEncode(1ULL << i);
+        TestIntEncode((1ULL << i) - 1);
+    }
+
+    TestIntEncode(std::numeric_limits<std::uint64_t>::max());
+
+    // The tenth byte can only hold one bit
+    const char overflow[] = {
+        '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\xff', '\x02'};
+    std::uint64_t d;
+    ASSERT(FTDCVarInt::decode(overflow, overflow + sizeof(overflow), &d) == nullptr);
+}
+
 // Test data builder can write a lot of zeros
 TEST(FTDCVarIntTest, TestDataBuilder) {
     DataBuilder db(1);
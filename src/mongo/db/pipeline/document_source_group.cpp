@@ -41,6 +41,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/stats/resource_consumption_metrics.h"
 #include "mongo/util/destructor_guard.h"
 
@@ -165,6 +166,10 @@ int DocumentSourceGroup::freeMemory() {
 }
 
 DocumentSource::GetNextResult DocumentSourceGroup::doGetNext() {
+    if (_streamingMerge) {
+        return getNextStreamingMerge();
+    }
+
     if (!_initialized) {
         const auto initializationResult = initialize();
         if (initializationResult.isPaused()) {
@@ -231,6 +236,19 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
 
 DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
     // Not spilled, and not streaming.
+    if (_sortedOutput) {
+        if (_sortedGroupsPos >= _sortedGroups.size())
+            return GetNextResult::makeEOF();
+
+        const auto* group = _sortedGroups[_sortedGroupsPos++];
+        Document out = makeDocument(group->first, group->second, pExpCtx->needsMerge);
+
+        if (_sortedGroupsPos == _sortedGroups.size())
+            dispose();
+
+        return out;
+    }
+
     if (_groups->empty())
         return GetNextResult::makeEOF();
 
@@ -242,10 +260,73 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
     return out;
 }
 
+DocumentSource::GetNextResult DocumentSourceGroup::getNextStreamingMerge() {
+    // The input is ordered by _id, so all of the partial results for one group arrive before any
+    // partial result for the next. Only the group currently being combined is held in memory.
+    while (true) {
+        auto input = pSource->getNext();
+        if (input.isPaused()) {
+            return input;
+        }
+
+        if (input.isEOF()) {
+            if (!_streamingGroupOpen) {
+                return input;
+            }
+            _streamingGroupOpen = false;
+            return makeDocument(_currentId, _currentAccumulators, pExpCtx->needsMerge);
+        }
+
+        auto rootDocument = input.releaseDocument();
+        Value id = computeId(rootDocument);
+
+        boost::optional<Document> completedGroup;
+        if (!_streamingGroupOpen) {
+            startCurrentGroup(id);
+        } else if (pExpCtx->getValueComparator().evaluate(id != _currentId)) {
+            completedGroup = makeDocument(_currentId, _currentAccumulators, pExpCtx->needsMerge);
+            startCurrentGroup(id);
+        }
+
+        for (size_t i = 0; i < _accumulatedFields.size(); ++i) {
+            _currentAccumulators[i]->process(
+                _accumulatedFields[i].expr.argument->evaluate(rootDocument, &pExpCtx->variables),
+                _doingMerge);
+        }
+
+        if (completedGroup) {
+            return std::move(*completedGroup);
+        }
+    }
+}
+
+void DocumentSourceGroup::startCurrentGroup(const Value& id) {
+    if (_currentAccumulators.size() != _accumulatedFields.size()) {
+        _currentAccumulators.reserve(_accumulatedFields.size());
+        for (auto&& accumulatedField : _accumulatedFields) {
+            _currentAccumulators.push_back(accumulatedField.makeAccumulator());
+        }
+    }
+
+    _currentId = id;
+    Value expandedId = expandId(_currentId);
+    Document idDoc =
+        expandedId.getType() == BSONType::Object ? expandedId.getDocument() : Document();
+    for (size_t i = 0; i < _accumulatedFields.size(); ++i) {
+        Value initializerValue =
+            _accumulatedFields[i].expr.initializer->evaluate(idDoc, &pExpCtx->variables);
+        _currentAccumulators[i]->reset();
+        _currentAccumulators[i]->startNewGroup(initializerValue);
+    }
+    _streamingGroupOpen = true;
+}
+
 void DocumentSourceGroup::doDispose() {
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
     _sorterIterator.reset();
+    _sortedGroups.clear();
+    _sortedGroupsPos = 0;
 
     // Make us look done.
     groupsIterator = _groups->end();
@@ -299,6 +380,14 @@ Value DocumentSourceGroup::serialize(boost::optional<ExplainOptions::Verbosity>
         insides["$doingMerge"] = Value(true);
     }
 
+    if (_sortedOutput) {
+        insides["$sortedOutput"] = Value(true);
+    }
+
+    if (_streamingMerge) {
+        insides["$streamingMerge"] = Value(true);
+    }
+
     return Value(DOC(getSourceName() << insides.freeze()));
 }
 
@@ -467,6 +556,14 @@ intrusive_ptr<DocumentSource> DocumentSourceGroup::createFromBson(
             massert(17030, "$doingMerge should be true if present", groupField.Bool());
 
             pGroup->setDoingMerge(true);
+        } else if (pFieldName == "$sortedOutput") {
+            uassert(5338701, "$sortedOutput should be true if present", groupField.Bool());
+
+            pGroup->setSortedOutput(true);
+        } else if (pFieldName == "$streamingMerge") {
+            uassert(5338702, "$streamingMerge should be true if present", groupField.Bool());
+
+            pGroup->_streamingMerge = true;
         } else {
             // Any other field will be treated as an accumulator specification.
             pGroup->addAccumulator(
@@ -475,6 +572,9 @@ intrusive_ptr<DocumentSource> DocumentSourceGroup::createFromBson(
     }
 
     uassert(15955, "a group specification must include an _id", !pGroup->_idExpressions.empty());
+    uassert(5338703,
+            "$streamingMerge may only be specified along with $doingMerge",
+            !pGroup->_streamingMerge || pGroup->_doingMerge);
     return pGroup;
 }
 
@@ -607,6 +707,16 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
 
                 verify(_sorterIterator->more());  // we put data in, we should get something out.
                 _firstPartOfNextGroup = _sorterIterator->next();
+            } else if (_sortedOutput) {
+                // Return the groups in the same order in which they would have been spilled.
+                _sortedGroups.reserve(_groups->size());
+                for (auto&& group : *_groups) {
+                    _sortedGroups.push_back(&group);
+                }
+                std::sort(_sortedGroups.begin(),
+                          _sortedGroups.end(),
+                          SpillSTLComparator(pExpCtx->getValueComparator()));
+                _sortedGroupsPos = 0;
             } else {
                 // start the group iterator
                 groupsIterator = _groups->begin();
@@ -686,6 +796,18 @@ Value DocumentSourceGroup::computeId(const Document& root) {
     for (size_t i = 0; i < _idExpressions.size(); i++) {
         vals.push_back(_idExpressions[i]->evaluate(root, &pExpCtx->variables));
     }
+
+    // A $group with sorted output keys its groups by the _id document itself. Missing values are
+    // left out of that document, so ordering the groups by the array of values instead would not
+    // match the order of the serialized sort keys which the merger compares.
+    if (_sortedOutput) {
+        invariant(_idFieldNames.size() == vals.size());
+        MutableDocument md(vals.size());
+        for (size_t i = 0; i < vals.size(); i++) {
+            md[_idFieldNames[i]] = vals[i];
+        }
+        return md.freezeToValue();
+    }
     return Value(std::move(vals));
 }
 
@@ -694,6 +816,10 @@ Value DocumentSourceGroup::expandId(const Value& val) {
     if (_idFieldNames.empty())
         return val;
 
+    // computeId() has already built the _id document
+    if (_sortedOutput && _idFieldNames.size() > 1)
+        return val;
+
     // _id is a single-field document containing val
     if (_idFieldNames.size() == 1)
         return Value(DOC(_idFieldNames[0] << val));
@@ -715,7 +841,8 @@ Document DocumentSourceGroup::makeDocument(const Value& id,
     MutableDocument out(1 + n);
 
     /* add the _id field */
-    out.addField("_id", expandId(id));
+    Value expandedId = expandId(id);
+    out.addField("_id", expandedId);
 
     /* add the rest of the fields */
     for (size_t i = 0; i < n; ++i) {
@@ -728,6 +855,11 @@ Document DocumentSourceGroup::makeDocument(const Value& id,
         }
     }
 
+    if (_sortedOutput) {
+        // The merger orders the streams from each shard by this key.
+        out.metadata().setSortKey(expandedId, true /* isSingleElementKey */);
+    }
+
     return out.freeze();
 }
 
@@ -750,6 +882,15 @@ boost::optional<DocumentSource::DistributedPlanLogic> DocumentSourceGroup::distr
         mergingGroup->addAccumulator(copiedAccumulatedField);
     }
 
+    // If enabled, have each shard return its partial groups in _id order so that the merger can
+    // combine them as they stream past, holding a single group in memory at a time. The merger
+    // compares the sort keys without a collator, so this is only done for the simple collation.
+    // The shards' $group is switched to sorted output when the pipeline is actually split.
+    if (internalQueryEnableStreamingGroupMerge.load() && !pExpCtx->getCollator()) {
+        mergingGroup->setStreamingMerge(true);
+        return DistributedPlanLogic{this, mergingGroup, BSON("_id" << 1)};
+    }
+
     // {shardsStage, mergingStage, sortPattern}
     return DistributedPlanLogic{this, mergingGroup, boost::none};
 }
@@ -792,6 +933,11 @@ bool DocumentSourceGroup::canRunInParallelBeforeWriteStage(
 
 std::unique_ptr<GroupFromFirstDocumentTransformation>
 DocumentSourceGroup::rewriteGroupAsTransformOnFirstDocument() const {
+    if (_sortedOutput || _streamingMerge) {
+        // The transformation would not attach the sort keys which the merger relies upon.
+        return nullptr;
+    }
+
     if (_idExpressions.size() != 1) {
         // This transformation is only intended for $group stages that group on a single field.
         return nullptr;
@@ -156,6 +156,32 @@ public:
         _doingMerge = doingMerge;
     }
 
+    /**
+     * Returns true if this $group stage emits its groups in ascending order of their _id, with each
+     * output document carrying its _id as sort key metadata. Set on the shards half of a split
+     * $group whose merging half streams.
+     */
+    bool sortedOutput() const {
+        return _sortedOutput;
+    }
+
+    void setSortedOutput(bool sortedOutput) {
+        _sortedOutput = sortedOutput;
+    }
+
+    /**
+     * Returns true if this merging $group expects its input to be ordered by _id, and therefore
+     * combines each group as it streams past rather than building a table of every group.
+     */
+    bool streamingMerge() const {
+        return _streamingMerge;
+    }
+
+    void setStreamingMerge(bool streamingMerge) {
+        invariant(!streamingMerge || _doingMerge);
+        _streamingMerge = streamingMerge;
+    }
+
     /**
      * Returns true if this $group stage used disk during execution and false otherwise.
      */
@@ -210,6 +236,17 @@ private:
     GetNextResult getNextSpilled();
     GetNextResult getNextStandard();
 
+    /**
+     * Used in place of initialize() and the methods above by a streaming merge. Consumes input
+     * until the group key changes, and returns the group which has just been completed.
+     */
+    GetNextResult getNextStreamingMerge();
+
+    /**
+     * Resets '_currentAccumulators' to begin accumulating the group identified by 'id'.
+     */
+    void startCurrentGroup(const Value& id);
+
     /**
      * Before returning anything, this source must prepare itself. In a streaming $group,
      * initialize() requests the first document from the previous source, and uses it to prepare the
@@ -272,6 +309,19 @@ private:
     Value _currentId;
     Accumulators _currentAccumulators;
 
+    // See sortedOutput() and streamingMerge().
+    bool _sortedOutput = false;
+    bool _streamingMerge = false;
+
+    // Only used when '_sortedOutput' is true and '_spilled' is false. The groups of '_groups' in
+    // the order in which they are returned, and the position of the next one to return.
+    std::vector<const GroupsMap::value_type*> _sortedGroups;
+    size_t _sortedGroupsPos = 0;
+
+    // Only used when '_streamingMerge' is true. Set while '_currentId' and '_currentAccumulators'
+    // hold a group which has not yet been returned.
+    bool _streamingGroupOpen = false;
+
     // We use boost::optional to defer initialization until the ExpressionContext containing the
     // correct comparator is injected, since the groups must be built using the comparator's
     // definition of equality.
@@ -244,6 +244,61 @@ TEST_F(DocumentSourceGroupTest, ShouldNotReportDottedGroupKeyAsARename) {
     ASSERT_EQ(modifiedPathsRet.renames.size(), 0UL);
 }
 
+TEST_F(DocumentSourceGroupTest, SortedOutputShouldReturnGroupsInIdOrderWithSortKeys) {
+    auto expCtx = getExpCtx();
+    auto spec = fromjson("{$group: {_id: '$x', count: {$sum: 1}}}");
+    auto group = DocumentSourceGroup::createFromBson(spec.firstElement(), expCtx);
+    static_cast<DocumentSourceGroup*>(group.get())->setSortedOutput(true);
+    auto mock = DocumentSourceMock::createForTest(
+        {Document{{"x", 3}}, Document{{"x", 1}}, Document{{"x", 2}}, Document{{"x", 1}}}, expCtx);
+    group->setSource(mock.get());
+
+    for (auto&& expected : {Document{{"_id", 1}, {"count", 2}},
+                            Document{{"_id", 2}, {"count", 1}},
+                            Document{{"_id", 3}, {"count", 1}}}) {
+        auto next = group->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        auto doc = next.releaseDocument();
+        ASSERT_DOCUMENT_EQ(doc, expected);
+        ASSERT_TRUE(doc.metadata().hasSortKey());
+        ASSERT_VALUE_EQ(doc.metadata().getSortKey(), expected["_id"]);
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+}
+
+TEST_F(DocumentSourceGroupTest, StreamingMergeShouldCombineAdjacentPartialGroups) {
+    auto expCtx = getExpCtx();
+    auto spec = fromjson(
+        "{$group: {_id: '$_id', count: {$sum: '$count'}, $doingMerge: true, $streamingMerge: "
+        "true}}");
+    auto group = DocumentSourceGroup::createFromBson(spec.firstElement(), expCtx);
+    ASSERT_TRUE(static_cast<DocumentSourceGroup*>(group.get())->streamingMerge());
+    auto mock =
+        DocumentSourceMock::createForTest({Document{{"_id", 1}, {"count", 2}},
+                                           DocumentSource::GetNextResult::makePauseExecution(),
+                                           Document{{"_id", 1}, {"count", 3}},
+                                           Document{{"_id", 2}, {"count", 1}}},
+                                          expCtx);
+    group->setSource(mock.get());
+
+    // The first group cannot be returned until a partial result for another group is seen.
+    ASSERT_TRUE(group->getNext().isPaused());
+    auto next = group->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"_id", 1}, {"count", 5}}));
+    next = group->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"_id", 2}, {"count", 1}}));
+    ASSERT_TRUE(group->getNext().isEOF());
+}
+
+TEST_F(DocumentSourceGroupTest, StreamingMergeShouldRequireDoingMerge) {
+    auto spec = fromjson("{$group: {_id: '$_id', $streamingMerge: true}}");
+    ASSERT_THROWS_CODE(DocumentSourceGroup::createFromBson(spec.firstElement(), getExpCtx()),
+                       AssertionException,
+                       5338703);
+}
+
 BSONObj toBson(const intrusive_ptr<DocumentSource>& source) {
     vector<Value> arr;
     source->serializeToArray(arr);
@@ -31,11 +31,14 @@
 
 #include "mongo/db/pipeline/document_source_lookup.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "mongo/base/init.h"
+#include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/db/exec/document_value/document.h"
 #include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_algo.h"
 #include "mongo/db/pipeline/document_path_support.h"
@@ -54,6 +57,42 @@ using std::vector;
 
 namespace {
 
+constexpr StringData kCoLocatedForeignVersionsField = "$_internalCoLocatedForeignVersions"_sd;
+
+// Once the values looked up by a batch of inputs take this many bytes, the remaining inputs are
+// looked up by another query, so that the $in array stays well within the maximum BSON size.
+constexpr int kMaxForeignBatchValuesBytes = 1024 * 1024;
+
+/**
+ * Returns true if 'path' has a component which may refer to a position within an array.
+ */
+bool hasPositionalComponent(const FieldPath& path) {
+    for (size_t i = 0; i < path.getPathLength(); ++i) {
+        if (str::parseUnsignedBase10Integer(path.getFieldName(i))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Collects the values which 'input' looks up along 'localField' into 'localValues'. Returns false
+ * if the foreign documents matching them cannot be found by hashing the values which the foreign
+ * documents hold along 'foreignField': null matches missing fields, and regular expressions only
+ * match other regular expressions.
+ */
+bool collectHashableLocalValues(const Document& input,
+                                const FieldPath& localField,
+                                std::vector<Value>* localValues) {
+    bool hashable = true;
+    document_path_support::visitAllValuesAtPath(input, localField, [&](const Value& nextValue) {
+        localValues->push_back(nextValue);
+        hashable = hashable && !nextValue.nullish() && !nextValue.isArray() &&
+            nextValue.getType() != BSONType::RegEx;
+    });
+    return hashable && !localValues->empty();
+}
+
 /**
  * Constructs a query of the following shape:
  *  {$or: [
@@ -113,6 +152,40 @@ NamespaceString parseLookupFromAndResolveNamespace(const BSONElement& elem, Stri
     return nss;
 }
 
+/**
+ * Returns true if the index described by 'spec' can serve equality lookups on 'fieldName' under
+ * 'collator', which is null for the simple collation.
+ */
+bool canIndexServeLookUp(const BSONObj& spec,
+                         StringData fieldName,
+                         const CollatorInterface* collator) {
+    // A partial, sparse or hidden index cannot be used for every value of 'fieldName'.
+    if (spec.hasField(IndexDescriptor::kPartialFilterExprFieldName) ||
+        spec[IndexDescriptor::kSparseFieldName].trueValue() ||
+        spec[IndexDescriptor::kHiddenFieldName].trueValue()) {
+        return false;
+    }
+
+    // Only an ascending or descending first key, rather than a special index type such as hashed
+    // or wildcard, is planned for the equality match.
+    auto keyPattern = spec[IndexDescriptor::kKeyPatternFieldName];
+    if (keyPattern.type() != BSONType::Object) {
+        return false;
+    }
+    auto firstKey = keyPattern.Obj().firstElement();
+    if (firstKey.fieldNameStringData() != fieldName || !firstKey.isNumber()) {
+        return false;
+    }
+
+    auto collation = spec[IndexDescriptor::kCollationFieldName];
+    if (!collator) {
+        return collation.eoo();
+    }
+    return collation.type() == BSONType::Object &&
+        SimpleBSONObjComparator::kInstance.evaluate(collation.Obj() ==
+                                                    collator->getSpec().toBSON());
+}
+
 }  // namespace
 
 DocumentSourceLookUp::DocumentSourceLookUp(NamespaceString fromNs,
@@ -227,6 +300,18 @@ PrivilegeVector DocumentSourceLookUp::LiteParsed::requiredPrivileges(
     return requiredPrivileges;
 }
 
+StringData DocumentSourceLookUp::joinStrategyToString(JoinStrategy strategy) {
+    switch (strategy) {
+        case JoinStrategy::kNestedLoop:
+            return "NestedLoopJoin"_sd;
+        case JoinStrategy::kIndexedNestedLoop:
+            return "IndexedNestedLoopJoin"_sd;
+        case JoinStrategy::kHashJoin:
+            return "HashJoin"_sd;
+    }
+    MONGO_UNREACHABLE;
+}
+
 REGISTER_DOCUMENT_SOURCE(lookup,
                          DocumentSourceLookUp::LiteParsed::parse,
                          DocumentSourceLookUp::createFromBson);
@@ -242,6 +327,9 @@ StageConstraints DocumentSourceLookUp::constraints(Pipeline::SplitState) const {
         // shard, rather than just the primary, since each shard should have an identical copy of
         // the namespace.
         hostRequirement = HostTypeRequirement::kAnyShard;
+    } else if (isCoLocated()) {
+        // Each shard joins its own documents against its own portion of the foreign collection.
+        hostRequirement = HostTypeRequirement::kAnyShard;
     } else {
         // When $lookup on sharded foreign collections is allowed, the foreign collection is
         // sharded, and the stage is executing on mongos, the stage can run on mongos or any shard.
@@ -279,13 +367,38 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
         return unwindResult();
     }
 
-    auto nextInput = pSource->getNext();
+    if (!wasConstructedWithPipelineSyntax() && !_joinStrategy) {
+        // Wait for an input document, so that an empty input never reads the foreign collection.
+        auto nextInput = pSource->getNext();
+        if (!nextInput.isAdvanced()) {
+            return nextInput;
+        }
+        _firstInput = nextInput.releaseDocument();
+        chooseJoinStrategy();
+    }
+
+    if (_joinStrategy == JoinStrategy::kHashJoin) {
+        return getNextHashJoin();
+    }
+
+    if (const auto batchSize = getForeignLookupBatchSize(); batchSize > 1) {
+        return getNextBatched(batchSize);
+    }
+
+    auto nextInput = getNextInput();
     if (!nextInput.isAdvanced()) {
         return nextInput;
     }
 
     auto inputDoc = nextInput.releaseDocument();
+    auto results = lookUpDocument(inputDoc);
 
+    MutableDocument output(std::move(inputDoc));
+    output.setNestedField(_as, Value(std::move(results)));
+    return output.freeze();
+}
+
+std::vector<Value> DocumentSourceLookUp::lookUpDocument(const Document& inputDoc) {
     // If we have not absorbed a $unwind, we cannot absorb a $match. If we have absorbed a $unwind,
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
@@ -297,44 +410,303 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
         _resolvedPipeline.back() = matchStage;
     }
 
-    std::unique_ptr<Pipeline, PipelineDeleter> pipeline;
+    auto pipeline = buildPipelineForInput(inputDoc);
+
+    std::vector<Value> results;
+    long long objsize = 0;
+    while (auto result = pipeline->getNext()) {
+        appendForeignResult(std::move(*result), &results, &objsize);
+    }
+    _usedDisk = _usedDisk || pipeline->usedDisk();
+    return results;
+}
+
+std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipelineForInput(
+    const Document& inputDoc) {
     try {
-        pipeline = buildPipeline(inputDoc);
+        return buildPipeline(inputDoc);
     } catch (const ExceptionForCat<ErrorCategory::StaleShardVersionError>& ex) {
         // If lookup on a sharded collection is disallowed and the foreign collection is sharded,
         // throw a custom exception.
         if (auto staleInfo = ex.extraInfo<StaleConfigInfo>()) {
             uassert(51069,
                     "Cannot run $lookup with sharded foreign collection",
-                    foreignShardedLookupAllowed() || !staleInfo->getVersionWanted() ||
+                    foreignShardedLookupAllowed() || isCoLocated() ||
+                        !staleInfo->getVersionWanted() ||
                         staleInfo->getVersionWanted() == ChunkVersion::UNSHARDED());
         }
         throw;
     }
+}
 
-    std::vector<Value> results;
-    long long objsize = 0;
+void DocumentSourceLookUp::appendForeignResult(Document result,
+                                               std::vector<Value>* results,
+                                               long long* objsize) const {
     const auto maxBytes = internalLookupStageIntermediateDocumentMaxSizeBytes.load();
+    long long safeSum = 0;
+    bool hasOverflowed = overflow::add(*objsize, result.getApproximateSize(), &safeSum);
+    uassert(4568,
+            str::stream() << "Total size of documents in " << _fromNs.coll()
+                          << " matching pipeline's $lookup stage exceeds " << maxBytes << " bytes",
+
+            !hasOverflowed && *objsize <= maxBytes);
+    *objsize = safeSum;
+    results->emplace_back(std::move(result));
+}
+
+size_t DocumentSourceLookUp::getForeignLookupBatchSize() const {
+    const auto batchSize = internalLookupStageForeignBatchSize.load();
+    if (batchSize <= 1 || wasConstructedWithPipelineSyntax()) {
+        return 1;
+    }
+
+    // The results of a batch are matched back to their input documents by the values found along
+    // 'foreignField'. Positional path components would make that differ from the query semantics.
+    return hasPositionalComponent(*_foreignField) ? 1 : batchSize;
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::getNextBatched(size_t batchSize) {
+    if (_batchedOutput.empty()) {
+        if (_pausedAfterBatch) {
+            _pausedAfterBatch = false;
+            return GetNextResult::makePauseExecution();
+        }
+
+        std::vector<Document> inputs;
+        inputs.reserve(batchSize);
+        while (inputs.size() < batchSize) {
+            auto nextInput = getNextInput();
+            if (!nextInput.isAdvanced()) {
+                if (inputs.empty()) {
+                    return nextInput;
+                }
+                // Return the pause once the documents which came before it have been returned.
+                _pausedAfterBatch = nextInput.isPaused();
+                break;
+            }
+            inputs.push_back(nextInput.releaseDocument());
+        }
+        lookUpBatch(std::move(inputs));
+    }
+
+    auto output = std::move(_batchedOutput.front());
+    _batchedOutput.pop_front();
+    return output;
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::getNextInput() {
+    if (_firstInput) {
+        auto input = std::move(*_firstInput);
+        _firstInput.reset();
+        return input;
+    }
+    return pSource->getNext();
+}
+
+void DocumentSourceLookUp::chooseJoinStrategy() {
+    auto& joinState =
+        pExpCtx->lookUpJoinStates[std::make_pair(_fromNs, _foreignField->fullPath())];
+    if (!joinState) {
+        joinState = makeJoinState();
+    }
+    _joinState = joinState;
+    _joinStrategy = _joinState->strategy;
+}
+
+std::shared_ptr<const LookUpJoinState> DocumentSourceLookUp::makeJoinState() {
+    auto state = std::make_shared<LookUpJoinState>();
+    const auto maxMemoryBytes = internalLookupStageHashJoinMaxMemoryBytes.load();
+    if (maxMemoryBytes <= 0) {
+        return state;
+    }
 
+    if (isCoLocated()) {
+        // The foreign collection is sharded on 'foreignField', so it has an index on it.
+        state->strategy = JoinStrategy::kIndexedNestedLoop;
+        return state;
+    }
+
+    // The catalog of the foreign collection is only known to mongod.
+    if (pExpCtx->inMongos) {
+        return state;
+    }
+
+    // Only a collection can have indexes. A view's pipeline precedes the placeholder $match.
+    if (_resolvedPipeline.size() == 1) {
+        auto indexSpecs = pExpCtx->mongoProcessInterface->getIndexSpecs(
+            pExpCtx->opCtx, _resolvedNs, false /* includeBuildUUIDs */);
+        for (auto&& spec : indexSpecs) {
+            if (canIndexServeLookUp(spec, _foreignField->fullPath(), pExpCtx->getCollator())) {
+                state->strategy = JoinStrategy::kIndexedNestedLoop;
+                return state;
+            }
+        }
+    }
+
+    if (hasPositionalComponent(*_foreignField)) {
+        return state;
+    }
+
+    // The size of the documents in the foreign collection, or in the collection behind a view,
+    // bounds the memory a hash table needs from below. Do not start reading one which is already
+    // known not to fit.
+    BSONObjBuilder storageStats;
+    auto status = pExpCtx->mongoProcessInterface->appendStorageStats(
+        pExpCtx->opCtx, _resolvedNs, BSONObj(), &storageStats);
+    if (!status.isOK() && status != ErrorCodes::NamespaceNotFound) {
+        return state;
+    }
+    if (storageStats.obj()["size"].safeNumberLong() > maxMemoryBytes) {
+        return state;
+    }
+
+    if (buildHashJoinTable(state.get())) {
+        state->strategy = JoinStrategy::kHashJoin;
+    }
+    return state;
+}
+
+bool DocumentSourceLookUp::buildHashJoinTable(LookUpJoinState* state) {
+    const auto maxMemoryBytes = internalLookupStageHashJoinMaxMemoryBytes.load();
+
+    // Read the whole foreign collection once.
+    _resolvedPipeline.back() = BSON("$match" << BSONObj());
+    auto pipeline = buildPipelineForInput(Document());
+
+    auto table = pExpCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>();
+    std::vector<Document> foreignDocs;
+    long long memoryBytes = 0;
     while (auto result = pipeline->getNext()) {
-        long long safeSum = 0;
-        bool hasOverflowed = overflow::add(objsize, result->getApproximateSize(), &safeSum);
-        uassert(4568,
-                str::stream() << "Total size of documents in " << _fromNs.coll()
-                              << " matching pipeline's $lookup stage exceeds " << maxBytes
-                              << " bytes",
+        memoryBytes += result->getApproximateSize();
+        if (memoryBytes > maxMemoryBytes) {
+            // The foreign side is too large to hold in memory, so look it up per input instead.
+            return false;
+        }
 
-                !hasOverflowed && objsize <= maxBytes);
-        objsize = safeSum;
-        results.emplace_back(std::move(*result));
+        const auto position = foreignDocs.size();
+        document_path_support::visitAllValuesAtPath(
+            *result, *_foreignField, [&](const Value& foreignValue) {
+                auto& positions = table[foreignValue];
+                if (positions.empty() || positions.back() != position) {
+                    positions.push_back(position);
+                }
+            });
+        foreignDocs.push_back(std::move(*result));
     }
     _usedDisk = _usedDisk || pipeline->usedDisk();
 
+    state->hashJoinDocs = std::move(foreignDocs);
+    state->hashJoinTable = std::move(table);
+    return true;
+}
+
+DocumentSource::GetNextResult DocumentSourceLookUp::getNextHashJoin() {
+    auto nextInput = getNextInput();
+    if (!nextInput.isAdvanced()) {
+        return nextInput;
+    }
+
+    auto inputDoc = nextInput.releaseDocument();
+    std::vector<Value> results;
+    std::vector<Value> localValues;
+    if (!collectHashableLocalValues(inputDoc, *_localField, &localValues)) {
+        results = lookUpDocument(inputDoc);
+    } else {
+        std::vector<size_t> matches;
+        for (auto&& localValue : localValues) {
+            auto it = _joinState->hashJoinTable->find(localValue);
+            if (it != _joinState->hashJoinTable->end()) {
+                matches.insert(matches.end(), it->second.begin(), it->second.end());
+            }
+        }
+
+        // Return the matches in the order in which the foreign collection was read.
+        std::sort(matches.begin(), matches.end());
+        matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+        long long objsize = 0;
+        for (auto position : matches) {
+            appendForeignResult(_joinState->hashJoinDocs[position], &results, &objsize);
+        }
+    }
+
     MutableDocument output(std::move(inputDoc));
     output.setNestedField(_as, Value(std::move(results)));
     return output.freeze();
 }
 
+void DocumentSourceLookUp::lookUpBatch(std::vector<Document> inputs) {
+    std::vector<std::vector<Value>> results(inputs.size());
+    std::vector<long long> resultSizes(inputs.size(), 0);
+
+    for (size_t begin = 0; begin < inputs.size();) {
+        begin = lookUpBatchPart(inputs, begin, &results, &resultSizes);
+    }
+
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        MutableDocument output(std::move(inputs[i]));
+        output.setNestedField(_as, Value(std::move(results[i])));
+        _batchedOutput.push_back(output.freeze());
+    }
+}
+
+size_t DocumentSourceLookUp::lookUpBatchPart(const std::vector<Document>& inputs,
+                                             size_t begin,
+                                             std::vector<std::vector<Value>>* results,
+                                             std::vector<long long>* resultSizes) {
+    // Maps each value looked up by the query to the positions of the inputs which look it up.
+    auto inputsByValue = pExpCtx->getValueComparator().makeUnorderedValueMap<std::vector<size_t>>();
+    BSONArrayBuilder batchValues;
+
+    size_t end = begin;
+    while (end < inputs.size() && batchValues.len() < kMaxForeignBatchValuesBytes) {
+        const auto i = end++;
+        std::vector<Value> localValues;
+        if (!collectHashableLocalValues(inputs[i], *_localField, &localValues)) {
+            (*results)[i] = lookUpDocument(inputs[i]);
+            continue;
+        }
+
+        for (auto&& localValue : localValues) {
+            auto& inputsForValue = inputsByValue[localValue];
+            if (inputsForValue.empty()) {
+                batchValues << localValue;
+            }
+            if (inputsForValue.empty() || inputsForValue.back() != i) {
+                inputsForValue.push_back(i);
+            }
+        }
+    }
+
+    if (batchValues.arrSize() > 0) {
+        // A single query fetches the foreign documents for every input in this part of the batch.
+        _resolvedPipeline.back() = BSON(
+            "$match" << BSON(_foreignField->fullPath() << BSON("$in" << batchValues.arr())));
+        auto pipeline = buildPipelineForInput(inputs[begin]);
+
+        std::vector<size_t> matchingInputs;
+        while (auto result = pipeline->getNext()) {
+            matchingInputs.clear();
+            document_path_support::visitAllValuesAtPath(
+                *result, *_foreignField, [&](const Value& foreignValue) {
+                    auto it = inputsByValue.find(foreignValue);
+                    if (it != inputsByValue.end()) {
+                        matchingInputs.insert(
+                            matchingInputs.end(), it->second.begin(), it->second.end());
+                    }
+                });
+
+            std::sort(matchingInputs.begin(), matchingInputs.end());
+            matchingInputs.erase(std::unique(matchingInputs.begin(), matchingInputs.end()),
+                                 matchingInputs.end());
+            for (auto i : matchingInputs) {
+                appendForeignResult(*result, &(*results)[i], &(*resultSizes)[i]);
+            }
+        }
+        _usedDisk = _usedDisk || pipeline->usedDisk();
+    }
+    return end;
+}
+
 std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
     const Document& inputDoc) {
     // Copy all 'let' variables into the foreign pipeline's expression context.
@@ -343,7 +715,18 @@ std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
     // Resolve the 'let' variables to values per the given input document.
     resolveLetVariables(inputDoc, &_fromExpCtx->variables);
 
-    if (!foreignShardedLookupAllowed()) {
+    if (isCoLocated()) {
+        // Read the local portion of the foreign collection at the version the router planned with,
+        // so that a chunk migration since then is detected rather than missing matches.
+        auto shardName = _fromExpCtx->mongoProcessInterface->getShardName(_fromExpCtx->opCtx);
+        auto it = _coLocatedForeignVersions->find(shardName);
+        uassert(5338704,
+                str::stream() << "co-located $lookup has no version of " << _fromNs.ns()
+                              << " for shard " << shardName,
+                it != _coLocatedForeignVersions->end());
+        _fromExpCtx->mongoProcessInterface->setExpectedShardVersion(
+            _fromExpCtx->opCtx, _fromExpCtx->ns, it->second);
+    } else if (!foreignShardedLookupAllowed()) {
         // Enforce that the foreign collection must be unsharded for lookup.
         _fromExpCtx->mongoProcessInterface->setExpectedShardVersion(
             _fromExpCtx->opCtx, _fromExpCtx->ns, ChunkVersion::UNSHARDED());
@@ -355,8 +738,10 @@ std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
         pipelineOpts.optimize = true;
         pipelineOpts.attachCursorSource = true;
         pipelineOpts.validator = lookupPipeValidator;
-        // By default, $lookup doesnt support sharded 'from' collections.
-        pipelineOpts.allowTargetingShards = internalQueryAllowShardedLookup.load();
+        // By default, $lookup doesnt support sharded 'from' collections. A co-located $lookup
+        // only ever reads the foreign collection on this shard.
+        pipelineOpts.allowTargetingShards =
+            internalQueryAllowShardedLookup.load() && !isCoLocated();
         return Pipeline::makePipeline(_resolvedPipeline, _fromExpCtx, pipelineOpts);
     }
 
@@ -539,6 +924,9 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _batchedOutput.clear();
+    _joinState.reset();
+    _firstInput.reset();
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
@@ -742,7 +1130,18 @@ void DocumentSourceLookUp::serializeToArray(
     }
 
     MutableDocument output(doc);
+    if (isCoLocated()) {
+        BSONObjBuilder versions;
+        for (auto&& [shardName, version] : *_coLocatedForeignVersions) {
+            version.appendWithField(&versions, shardName);
+        }
+        output[getSourceName()][kCoLocatedForeignVersionsField] = Value(versions.obj());
+    }
     if (explain) {
+        if (_joinStrategy) {
+            output[getSourceName()]["strategy"] = Value(joinStrategyToString(*_joinStrategy));
+        }
+
         if (_unwindSrc) {
             const boost::optional<FieldPath> indexPath = _unwindSrc->indexPath();
             output[getSourceName()]["unwinding"] =
@@ -820,6 +1219,11 @@ boost::optional<DocumentSource::DistributedPlanLogic> DocumentSourceLookUp::dist
         return boost::none;
     }
 
+    if (isCoLocated()) {
+        // The matching foreign documents for every input document live on the same shard as it.
+        return boost::none;
+    }
+
     // {shardsStage, mergingStage, sortPattern}
     return DistributedPlanLogic{nullptr, this, boost::none};
 }
@@ -860,6 +1264,7 @@ intrusive_ptr<DocumentSource> DocumentSourceLookUp::createFromBson(
 
     BSONObj letVariables;
     std::vector<BSONObj> pipeline;
+    boost::optional<std::map<std::string, ChunkVersion>> coLocatedForeignVersions;
     bool hasPipeline = false;
     bool hasLet = false;
 
@@ -893,6 +1298,24 @@ intrusive_ptr<DocumentSource> DocumentSourceLookUp::createFromBson(
             continue;
         }
 
+        if (argName == kCoLocatedForeignVersionsField) {
+            uassert(ErrorCodes::FailedToParse,
+                    str::stream() << "$lookup argument '" << argName
+                                  << "' is only allowed in a pipeline sent by mongos",
+                    pExpCtx->fromMongos);
+            uassert(ErrorCodes::FailedToParse,
+                    str::stream() << "$lookup argument '" << argName
+                                  << "' must be an object, is type " << argument.type(),
+                    argument.type() == BSONType::Object);
+            coLocatedForeignVersions.emplace();
+            for (auto&& versionElem : argument.Obj()) {
+                (*coLocatedForeignVersions)[versionElem.fieldName()] =
+                    uassertStatusOK(ChunkVersion::parseWithField(
+                        versionElem.wrap(), versionElem.fieldNameStringData()));
+            }
+            continue;
+        }
+
         uassert(ErrorCodes::FailedToParse,
                 str::stream() << "$lookup argument '" << argName << "' must be a string, found "
                               << argument << ": " << argument.type(),
@@ -918,6 +1341,10 @@ intrusive_ptr<DocumentSource> DocumentSourceLookUp::createFromBson(
         uassert(ErrorCodes::FailedToParse,
                 "$lookup with 'pipeline' may not specify 'localField' or 'foreignField'",
                 localField.empty() && foreignField.empty());
+        uassert(ErrorCodes::FailedToParse,
+                str::stream() << "$lookup with 'pipeline' may not specify '"
+                              << kCoLocatedForeignVersionsField << "'",
+                !coLocatedForeignVersions);
 
         return new DocumentSourceLookUp(std::move(fromNs),
                                         std::move(as),
@@ -933,11 +1360,16 @@ intrusive_ptr<DocumentSource> DocumentSourceLookUp::createFromBson(
                 "$lookup with a 'let' argument must also specify 'pipeline'",
                 !hasLet);
 
-        return new DocumentSourceLookUp(std::move(fromNs),
-                                        std::move(as),
-                                        std::move(localField),
-                                        std::move(foreignField),
-                                        pExpCtx);
+        intrusive_ptr<DocumentSourceLookUp> lookupStage =
+            new DocumentSourceLookUp(std::move(fromNs),
+                                     std::move(as),
+                                     std::move(localField),
+                                     std::move(foreignField),
+                                     pExpCtx);
+        if (coLocatedForeignVersions) {
+            lookupStage->setCoLocated(std::move(*coLocatedForeignVersions));
+        }
+        return lookupStage;
     }
 }
 
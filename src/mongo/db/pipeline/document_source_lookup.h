@@ -30,6 +30,8 @@
 #pragma once
 
 #include <boost/optional.hpp>
+#include <deque>
+#include <map>
 
 #include "mongo/db/exec/document_value/value_comparator.h"
 #include "mongo/db/pipeline/document_source.h"
@@ -39,6 +41,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
+#include "mongo/s/chunk_version.h"
 
 namespace mongo {
 
@@ -50,6 +53,20 @@ class DocumentSourceLookUp final : public DocumentSource {
 public:
     static constexpr StringData kStageName = "$lookup"_sd;
 
+    /**
+     * How a localField/foreignField $lookup finds the foreign documents for each input document.
+     */
+    enum class JoinStrategy {
+        // Runs a query against the foreign collection for each input, or batch of inputs.
+        kNestedLoop,
+        // As kNestedLoop, but the queries can use an index on 'foreignField'.
+        kIndexedNestedLoop,
+        // Reads the foreign collection once into a hash table keyed by 'foreignField'.
+        kHashJoin,
+    };
+
+    static StringData joinStrategyToString(JoinStrategy strategy);
+
     struct LetVariable {
         LetVariable(std::string name, boost::intrusive_ptr<Expression> expression, Variables::Id id)
             : name(std::move(name)), expression(std::move(expression)), id(id) {}
@@ -71,12 +88,15 @@ public:
                   std::move(parseTimeName), std::move(foreignNss), std::move(pipeline)) {}
 
         /**
-         * Lookup from a sharded collection may not be allowed.
+         * Lookup from a sharded collection may not be allowed. A localField/foreignField $lookup
+         * may join a co-located sharded collection; whether it really is co-located is only known
+         * once the router plans the pipeline, which rejects the $lookup if it is not.
          */
         bool allowShardedForeignCollection(NamespaceString nss) const override final {
             const bool foreignShardedAllowed =
                 getTestCommandsEnabled() && internalQueryAllowShardedLookup.load();
-            if (foreignShardedAllowed) {
+            if (foreignShardedAllowed ||
+                (_pipelines.empty() && internalQueryEnableCoLocatedLookup.load())) {
                 return true;
             }
             auto involvedNss = getInvolvedNamespaces();
@@ -163,6 +183,33 @@ public:
         return _letVariables;
     }
 
+    const NamespaceString& getFromNs() const {
+        return _fromNs;
+    }
+
+    /**
+     * Marks this $lookup as joining a foreign collection whose chunks are placed on the same shards
+     * as the documents being looked up. Such a $lookup runs on each shard against the local
+     * portion of the foreign collection, which it reads at the version given in
+     * 'foreignVersions' for that shard.
+     */
+    void setCoLocated(std::map<std::string, ChunkVersion> foreignVersions) {
+        invariant(!wasConstructedWithPipelineSyntax());
+        _coLocatedForeignVersions = std::move(foreignVersions);
+    }
+
+    bool isCoLocated() const {
+        return static_cast<bool>(_coLocatedForeignVersions);
+    }
+
+    /**
+     * Returns the strategy chosen for this $lookup, which is only known once it has received its
+     * first input document.
+     */
+    boost::optional<JoinStrategy> getJoinStrategy() const {
+        return _joinStrategy;
+    }
+
     /**
      * Returns a non-executable pipeline which can be useful for introspection. In this pipeline,
      * all view definitions are resolved. This pipeline is present in both the sub-pipeline version
@@ -239,6 +286,87 @@ private:
 
     GetNextResult unwindResult();
 
+    /**
+     * Runs the foreign pipeline for the single document 'inputDoc' and returns the matching foreign
+     * documents.
+     */
+    std::vector<Value> lookUpDocument(const Document& inputDoc);
+
+    /**
+     * Returns the number of input documents whose foreign documents are fetched by a single query,
+     * or 1 if each input document must be looked up on its own.
+     */
+    size_t getForeignLookupBatchSize() const;
+
+    /**
+     * Returns the next output document, looking up the foreign documents for up to 'batchSize'
+     * input documents at a time.
+     */
+    GetNextResult getNextBatched(size_t batchSize);
+
+    /**
+     * Fetches the foreign documents for all of 'inputs' with $in queries on 'foreignField', one
+     * unless their values are large, and queues an output document for each input. Inputs whose
+     * local values cannot be matched back to the results, such as null or regular expressions, are
+     * looked up individually.
+     */
+    void lookUpBatch(std::vector<Document> inputs);
+
+    /**
+     * Fetches the foreign documents for the inputs from position 'begin' with one $in query,
+     * adding them to 'results' and their sizes to 'resultSizes'. Stops taking inputs once their
+     * values would make the query too large, and returns the position of the first input left out.
+     */
+    size_t lookUpBatchPart(const std::vector<Document>& inputs,
+                           size_t begin,
+                           std::vector<std::vector<Value>>* results,
+                           std::vector<long long>* resultSizes);
+
+    /**
+     * Returns the input document held back by doGetNext() while choosing the join strategy, if
+     * any, and otherwise the next result from 'pSource'.
+     */
+    GetNextResult getNextInput();
+
+    /**
+     * Sets '_joinState', reusing the choice of an earlier $lookup parsed with the same context on
+     * the same foreign namespace and field if there was one.
+     */
+    void chooseJoinStrategy();
+
+    /**
+     * Chooses between looking up the foreign documents for each input and a hash join. A hash join
+     * is used when there is no index on 'foreignField' and the foreign side fits within
+     * internalLookupStageHashJoinMaxMemoryBytes.
+     */
+    std::shared_ptr<const LookUpJoinState> makeJoinState();
+
+    /**
+     * Reads the foreign side into the hash table of 'state'. Returns false if it would use more
+     * than internalLookupStageHashJoinMaxMemoryBytes.
+     */
+    bool buildHashJoinTable(LookUpJoinState* state);
+
+    /**
+     * Returns the next output document, probing the hash table in '_joinState' with the input's
+     * local values.
+     */
+    GetNextResult getNextHashJoin();
+
+    /**
+     * Adds 'result' to 'results', asserting that the total size of the matching foreign documents,
+     * tracked in 'objsize', stays within the limit.
+     */
+    void appendForeignResult(Document result,
+                             std::vector<Value>* results,
+                             long long* objsize) const;
+
+    /**
+     * Calls buildPipeline(), reporting a stale shard version of a foreign collection which may not
+     * be sharded as such.
+     */
+    std::unique_ptr<Pipeline, PipelineDeleter> buildPipelineForInput(const Document& inputDoc);
+
     /**
      * Resolves let defined variables against 'localDoc' and stores the results in 'variables'.
      */
@@ -305,6 +433,10 @@ private:
 
     std::vector<LetVariable> _letVariables;
 
+    // Set if the foreign collection is co-located with the local documents, in which case this
+    // maps each shard's name to the version of the foreign collection to read on that shard.
+    boost::optional<std::map<std::string, ChunkVersion>> _coLocatedForeignVersions;
+
     boost::intrusive_ptr<DocumentSourceMatch> _matchSrc;
     boost::intrusive_ptr<DocumentSourceUnwind> _unwindSrc;
 
@@ -314,6 +446,28 @@ private:
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
     boost::optional<Document> _input;
     boost::optional<Document> _nextValue;
+
+    // Output documents for a batch of inputs whose foreign documents were fetched together.
+    std::deque<Document> _batchedOutput;
+    // Set if the input paused after the documents now in '_batchedOutput'.
+    bool _pausedAfterBatch = false;
+
+    // Chosen once a localField/foreignField $lookup has received its first input document, which
+    // is held in '_firstInput' until it is looked up.
+    boost::optional<JoinStrategy> _joinStrategy;
+    std::shared_ptr<const LookUpJoinState> _joinState;
+    boost::optional<Document> _firstInput;
+};
+
+/**
+ * The join strategy of a localField/foreignField $lookup and, for a hash join, the foreign
+ * documents and a map from each value along 'foreignField' to the positions of the documents which
+ * hold it.
+ */
+struct LookUpJoinState {
+    DocumentSourceLookUp::JoinStrategy strategy = DocumentSourceLookUp::JoinStrategy::kNestedLoop;
+    std::vector<Document> hashJoinDocs;
+    boost::optional<ValueUnorderedMap<std::vector<size_t>>> hashJoinTable;
 };
 
 }  // namespace mongo
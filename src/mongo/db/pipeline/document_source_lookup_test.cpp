@@ -46,10 +46,12 @@
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/field_path.h"
 #include "mongo/db/pipeline/process_interface/stub_mongo_process_interface.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
 #include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -606,6 +608,52 @@ TEST_F(DocumentSourceLookUpTest, LookupDistributedPlanLogic) {
     ASSERT(lookupStage->distributedPlanLogic()->mergingStage != nullptr);
 }
 
+// Tests that a co-located $lookup runs on the shards, and that the foreign collection versions it
+// was planned with survive serialization.
+TEST_F(DocumentSourceLookUpTest, CoLocatedLookupRunsOnShardsAndReParses) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "coll");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    auto lookupStage = DocumentSourceLookUp::createFromBson(
+        fromjson("{$lookup: {from: 'coll', localField: 'tenantId', foreignField: 'tenantId', as: "
+                 "'as'}}")
+            .firstElement(),
+        expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(lookupStage.get());
+    ASSERT_FALSE(lookup->isCoLocated());
+    ASSERT(lookup->constraints(Pipeline::SplitState::kUnsplit).hostRequirement ==
+           StageConstraints::HostTypeRequirement::kPrimaryShard);
+
+    const OID epoch = OID::gen();
+    lookup->setCoLocated({{"shard0", ChunkVersion(2, 0, epoch)},
+                          {"shard1", ChunkVersion(2, 1, epoch)}});
+    ASSERT(lookup->constraints(Pipeline::SplitState::kUnsplit).hostRequirement ==
+           StageConstraints::HostTypeRequirement::kAnyShard);
+    ASSERT(!lookup->distributedPlanLogic());
+
+    vector<Value> serialization;
+    lookupStage->serializeToArray(serialization);
+    ASSERT_EQ(serialization.size(), 1UL);
+
+    // Only a pipeline sent by mongos may carry the foreign collection versions.
+    ASSERT_THROWS_CODE(DocumentSourceLookUp::createFromBson(
+                           serialization[0].getDocument().toBson().firstElement(), expCtx),
+                       AssertionException,
+                       ErrorCodes::FailedToParse);
+
+    expCtx->fromMongos = true;
+    auto roundTripped = DocumentSourceLookUp::createFromBson(
+        serialization[0].getDocument().toBson().firstElement(), expCtx);
+    ASSERT(static_cast<DocumentSourceLookUp*>(roundTripped.get())->isCoLocated());
+
+    vector<Value> newSerialization;
+    roundTripped->serializeToArray(newSerialization);
+    ASSERT_EQ(newSerialization.size(), 1UL);
+    ASSERT_VALUE_EQ(newSerialization[0], serialization[0]);
+}
+
 TEST(MakeMatchStageFromInput, NonArrayValueUsesEqQuery) {
     auto input = Document{{"local", 1}};
     BSONObj matchStage = DocumentSourceLookUp::makeMatchStageFromInput(
@@ -663,14 +711,54 @@ public:
     MockMongoInterface(deque<DocumentSource::GetNextResult> mockResults,
                        bool removeLeadingQueryStages = false)
         : _mockResults(std::move(mockResults)),
-          _removeLeadingQueryStages(removeLeadingQueryStages) {}
+          _removeLeadingQueryStages(removeLeadingQueryStages) {
+        for (auto&& result : _mockResults) {
+            if (result.isAdvanced()) {
+                _dataSize += result.getDocument().toBson().objsize();
+            }
+        }
+    }
+
+    /**
+     * Overrides the size of the foreign collection reported in its storage stats, which is
+     * otherwise the total size of the mocked documents.
+     */
+    void setDataSize(long long dataSize) {
+        _dataSize = dataSize;
+    }
+
+    void setIndexSpecs(std::list<BSONObj> indexSpecs) {
+        _indexSpecs = std::move(indexSpecs);
+    }
+
+    /**
+     * Returns the number of pipelines which have been run against the foreign collection.
+     */
+    int getNumPipelinesAttached() const {
+        return _numPipelinesAttached;
+    }
 
     bool isSharded(OperationContext* opCtx, const NamespaceString& ns) final {
         return false;
     }
 
+    std::list<BSONObj> getIndexSpecs(OperationContext* opCtx,
+                                     const NamespaceString& ns,
+                                     bool includeBuildUUIDs) final {
+        return _indexSpecs;
+    }
+
+    Status appendStorageStats(OperationContext* opCtx,
+                              const NamespaceString& nss,
+                              const BSONObj& param,
+                              BSONObjBuilder* builder) const final {
+        builder->appendNumber("size", _dataSize);
+        return Status::OK();
+    }
+
     std::unique_ptr<Pipeline, PipelineDeleter> attachCursorSourceToPipeline(
         Pipeline* ownedPipeline, bool allowTargetingShards = true) final {
+        ++_numPipelinesAttached;
         std::unique_ptr<Pipeline, PipelineDeleter> pipeline(
             ownedPipeline, PipelineDeleter(ownedPipeline->getContext()->opCtx));
 
@@ -690,8 +778,49 @@ public:
 private:
     deque<DocumentSource::GetNextResult> _mockResults;
     bool _removeLeadingQueryStages = false;
+    long long _dataSize = 0;
+    int _numPipelinesAttached = 0;
+    std::list<BSONObj> _indexSpecs;
 };
 
+/**
+ * Runs a $lookup on '_id' of a foreign collection with the indexes 'indexSpecs' for one input
+ * document, and returns the join strategy it chooses when a hash join is allowed.
+ */
+DocumentSourceLookUp::JoinStrategy chooseJoinStrategyWithIndexes(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx, std::list<BSONObj> indexSpecs) {
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const auto originalMaxMemory = internalLookupStageHashJoinMaxMemoryBytes.load();
+    internalLookupStageHashJoinMaxMemoryBytes.store(1024 * 1024);
+    ON_BLOCK_EXIT([&] { internalLookupStageHashJoinMaxMemoryBytes.store(originalMaxMemory); });
+
+    auto mockLocalSource = DocumentSourceMock::createForTest({Document{{"foreignId", 0}}}, expCtx);
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    mongoProcessInterface->setIndexSpecs(std::move(indexSpecs));
+    expCtx->mongoProcessInterface = mongoProcessInterface;
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    lookup->setSource(mockLocalSource.get());
+
+    ASSERT_TRUE(lookup->getNext().isAdvanced());
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+    return *lookup->getJoinStrategy();
+}
+
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
@@ -743,6 +872,377 @@ TEST_F(DocumentSourceLookUpTest, ShouldPropagatePauses) {
     lookup->dispose();
 }
 
+TEST_F(DocumentSourceLookUpTest, ShouldMatchBatchedForeignResultsBackToEachInput) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const auto originalBatchSize = internalLookupStageForeignBatchSize.load();
+    internalLookupStageForeignBatchSize.store(10);
+    ON_BLOCK_EXIT([&] { internalLookupStageForeignBatchSize.store(originalBatchSize); });
+
+    auto mockLocalSource =
+        DocumentSourceMock::createForTest({Document{{"foreignId", 0}},
+                                           Document{{"foreignId", 1}},
+                                           Document{{"foreignId", {0, 1}}},
+                                           DocumentSource::GetNextResult::makePauseExecution(),
+                                           Document{{"foreignId", 2}}},
+                                          expCtx);
+
+    // The first three inputs share a single foreign query, whose results must be matched back to
+    // each of them by the values of 'foreignField'.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}}, Document{{"_id", 1}}, Document{{"_id", {1, 2}}}};
+    expCtx->mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    lookup->setSource(mockLocalSource.get());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", 0}, {"foreignDocs", {Document{{"_id", 0}}}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 1},
+                  {"foreignDocs", {Document{{"_id", 1}}, Document{{"_id", {1, 2}}}}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", {0, 1}},
+                                 {"foreignDocs",
+                                  {Document{{"_id", 0}},
+                                   Document{{"_id", 1}},
+                                   Document{{"_id", {1, 2}}}}}}));
+
+    // The pause which ended the first batch is returned after its documents.
+    ASSERT_TRUE(lookup->getNext().isPaused());
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"foreignId", 2}, {"foreignDocs", {Document{{"_id", {1, 2}}}}}}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldSplitBatchWhoseLocalValuesAreLarge) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const auto originalBatchSize = internalLookupStageForeignBatchSize.load();
+    internalLookupStageForeignBatchSize.store(10);
+    ON_BLOCK_EXIT([&] { internalLookupStageForeignBatchSize.store(originalBatchSize); });
+
+    // The values of the first two inputs alone are large enough to fill a query.
+    std::vector<std::string> largeValues;
+    for (char c : {'a', 'b', 'c'}) {
+        largeValues.emplace_back(700 * 1024, c);
+    }
+
+    deque<DocumentSource::GetNextResult> mockLocalContents;
+    deque<DocumentSource::GetNextResult> mockForeignContents;
+    for (auto&& value : largeValues) {
+        mockLocalContents.push_back(Document{{"foreignId", value}});
+        mockForeignContents.push_back(Document{{"_id", value}});
+    }
+    auto mockLocalSource = DocumentSourceMock::createForTest(mockLocalContents, expCtx);
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoProcessInterface;
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    lookup->setSource(mockLocalSource.get());
+
+    for (auto&& value : largeValues) {
+        auto next = lookup->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(
+            next.releaseDocument(),
+            (Document{{"foreignId", value}, {"foreignDocs", {Document{{"_id", value}}}}}));
+    }
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    // The three inputs arrived together, but their values were split across two queries.
+    ASSERT_EQ(2, mongoProcessInterface->getNumPipelinesAttached());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldHashJoinUnindexedForeignCollectionWithinMemoryLimit) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const auto originalMaxMemory = internalLookupStageHashJoinMaxMemoryBytes.load();
+    internalLookupStageHashJoinMaxMemoryBytes.store(1024 * 1024);
+    ON_BLOCK_EXIT([&] { internalLookupStageHashJoinMaxMemoryBytes.store(originalMaxMemory); });
+
+    auto mockLocalSource = DocumentSourceMock::createForTest({Document{{"foreignId", 0}},
+                                                              Document{{"foreignId", {0, 1}}},
+                                                              Document{{"foreignId", 3}}},
+                                                             expCtx);
+
+    // The mock interface reports no indexes, so the foreign collection is read once.
+    deque<DocumentSource::GetNextResult> mockForeignContents{
+        Document{{"_id", 0}}, Document{{"_id", 1}}, Document{{"_id", {1, 2}}}};
+    expCtx->mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    lookup->setSource(mockLocalSource.get());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", 0}, {"foreignDocs", {Document{{"_id", 0}}}}}));
+    ASSERT(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kHashJoin);
+
+    // Each foreign document is returned once, even if it matches more than one local value.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", {0, 1}},
+                                 {"foreignDocs",
+                                  {Document{{"_id", 0}},
+                                   Document{{"_id", 1}},
+                                   Document{{"_id", {1, 2}}}}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", 3}, {"foreignDocs", std::vector<Value>{}}}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    std::vector<Value> explained;
+    lookup->serializeToArray(explained, ExplainOptions::Verbosity::kExecStats);
+    ASSERT_EQ(explained.size(), 1UL);
+    ASSERT_VALUE_EQ(explained[0]["$lookup"]["strategy"], Value("HashJoin"_sd));
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldUseIndexedNestedLoopWithIndexOnForeignField) {
+    ASSERT(chooseJoinStrategyWithIndexes(getExpCtx(),
+                                         {BSON("v" << 2 << "key" << BSON("_id" << 1 << "x" << -1)
+                                                   << "name"
+                                                   << "_id_1_x_-1")}) ==
+           DocumentSourceLookUp::JoinStrategy::kIndexedNestedLoop);
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldUseIndexedNestedLoopWithIndexOfSameCollation) {
+    auto expCtx = getExpCtx();
+    auto collator =
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kReverseString);
+    auto collation = collator->getSpec().toBSON();
+    expCtx->setCollator(std::move(collator));
+
+    ASSERT(chooseJoinStrategyWithIndexes(expCtx,
+                                         {BSON("v" << 2 << "key" << BSON("_id" << -1) << "name"
+                                                   << "_id_-1"
+                                                   << "collation" << collation)}) ==
+           DocumentSourceLookUp::JoinStrategy::kIndexedNestedLoop);
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldIgnoreIndexesWhichCannotServeLookUp) {
+    const std::vector<BSONObj> unusableIndexSpecs{
+        BSON("v" << 2 << "key" << BSON("_id" << 1) << "name"
+                 << "partial"
+                 << "partialFilterExpression" << BSON("_id" << BSON("$gt" << 0))),
+        BSON("v" << 2 << "key" << BSON("_id" << 1) << "name"
+                 << "sparse"
+                 << "sparse" << true),
+        BSON("v" << 2 << "key" << BSON("_id" << 1) << "name"
+                 << "hidden"
+                 << "hidden" << true),
+        BSON("v" << 2 << "key"
+                 << BSON("_id"
+                         << "hashed")
+                 << "name"
+                 << "hashed"),
+        BSON("v" << 2 << "key" << BSON("$**" << 1) << "name"
+                 << "wildcard"),
+        BSON("v" << 2 << "key" << BSON("_id" << 1) << "name"
+                 << "collation"
+                 << "collation"
+                 << BSON("locale"
+                         << "fr")),
+        BSON("v" << 2 << "key" << BSON("x" << 1 << "_id" << 1) << "name"
+                 << "secondKey"),
+    };
+
+    for (auto&& spec : unusableIndexSpecs) {
+        ASSERT(chooseJoinStrategyWithIndexes(getExpCtx(), {spec}) ==
+               DocumentSourceLookUp::JoinStrategy::kHashJoin)
+            << spec;
+    }
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldIgnoreIndexOfSimpleCollationWithNonSimpleCollation) {
+    auto expCtx = getExpCtx();
+    expCtx->setCollator(
+        std::make_unique<CollatorInterfaceMock>(CollatorInterfaceMock::MockType::kReverseString));
+
+    ASSERT(chooseJoinStrategyWithIndexes(
+               expCtx,
+               {BSON("v" << 2 << "key" << BSON("_id" << 1) << "name"
+                         << "_id_")}) == DocumentSourceLookUp::JoinStrategy::kHashJoin);
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldNotChooseJoinStrategyWithoutInput) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const auto originalMaxMemory = internalLookupStageHashJoinMaxMemoryBytes.load();
+    internalLookupStageHashJoinMaxMemoryBytes.store(1024 * 1024);
+    ON_BLOCK_EXIT([&] { internalLookupStageHashJoinMaxMemoryBytes.store(originalMaxMemory); });
+
+    auto mockLocalSource = DocumentSourceMock::createForTest(
+        {DocumentSource::GetNextResult::makePauseExecution()}, expCtx);
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoProcessInterface;
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    lookup->setSource(mockLocalSource.get());
+
+    ASSERT_TRUE(lookup->getNext().isPaused());
+    ASSERT_TRUE(lookup->getNext().isEOF());
+
+    // The foreign collection was never read for an input without documents.
+    ASSERT_FALSE(lookup->getJoinStrategy());
+    ASSERT_EQ(0, mongoProcessInterface->getNumPipelinesAttached());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldNotReadForeignCollectionLargerThanHashJoinMemoryLimit) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const auto originalMaxMemory = internalLookupStageHashJoinMaxMemoryBytes.load();
+    internalLookupStageHashJoinMaxMemoryBytes.store(1024 * 1024);
+    ON_BLOCK_EXIT([&] { internalLookupStageHashJoinMaxMemoryBytes.store(originalMaxMemory); });
+
+    auto mockLocalSource = DocumentSourceMock::createForTest({Document{{"foreignId", 0}}}, expCtx);
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    mongoProcessInterface->setDataSize(2 * 1024 * 1024);
+    expCtx->mongoProcessInterface = mongoProcessInterface;
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+    lookup->setSource(mockLocalSource.get());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"foreignId", 0}, {"foreignDocs", {Document{{"_id", 0}}}}}));
+    ASSERT(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kNestedLoop);
+
+    // Only the query for the input document ran, not a scan to build a hash table.
+    ASSERT_EQ(1, mongoProcessInterface->getNumPipelinesAttached());
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldReuseHashJoinTableOfLookUpWithSameContext) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+
+    const auto originalMaxMemory = internalLookupStageHashJoinMaxMemoryBytes.load();
+    internalLookupStageHashJoinMaxMemoryBytes.store(1024 * 1024);
+    ON_BLOCK_EXIT([&] { internalLookupStageHashJoinMaxMemoryBytes.store(originalMaxMemory); });
+
+    deque<DocumentSource::GetNextResult> mockForeignContents{Document{{"_id", 0}},
+                                                             Document{{"_id", 1}}};
+    auto mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+    expCtx->mongoProcessInterface = mongoProcessInterface;
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "foreignId"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "foreignDocs"_sd}}}}
+                          .toBson();
+
+    // As happens to a $lookup in a sub-pipeline, which is parsed again for each input of the
+    // enclosing stage.
+    for (int foreignId = 0; foreignId < 2; ++foreignId) {
+        auto mockLocalSource =
+            DocumentSourceMock::createForTest({Document{{"foreignId", foreignId}}}, expCtx);
+        auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+        auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+        lookup->setSource(mockLocalSource.get());
+
+        auto next = lookup->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(
+            next.releaseDocument(),
+            (Document{{"foreignId", foreignId}, {"foreignDocs", {Document{{"_id", foreignId}}}}}));
+        ASSERT(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kHashJoin);
+        ASSERT_TRUE(lookup->getNext().isEOF());
+        lookup->dispose();
+    }
+
+    // The foreign collection was read once, by the first $lookup.
+    ASSERT_EQ(1, mongoProcessInterface->getNumPipelinesAttached());
+}
+
 TEST_F(DocumentSourceLookUpTest, ShouldPropagatePausesWhileUnwinding) {
     auto expCtx = getExpCtx();
     NamespaceString fromNs("test", "foreign");
@@ -31,6 +31,7 @@
 
 #include <boost/intrusive_ptr.hpp>
 #include <boost/optional.hpp>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -57,6 +58,8 @@
 
 namespace mongo {
 
+struct LookUpJoinState;
+
 class ExpressionContext : public RefCountable {
 public:
     static constexpr size_t kMaxSubPipelineViewDepth = 20;
@@ -349,6 +352,12 @@ public:
     // Tracks the depth of nested aggregation sub-pipelines. Used to enforce depth limits.
     size_t subPipelineDepth = 0;
 
+    // The join strategies chosen by the localField/foreignField $lookup stages parsed with this
+    // context, keyed by foreign namespace and 'foreignField'. A $lookup in a sub-pipeline is parsed
+    // again for each input of the enclosing stage, and reuses the choice made the first time.
+    std::map<std::pair<NamespaceString, std::string>, std::shared_ptr<const LookUpJoinState>>
+        lookUpJoinStates;
+
     // If set, this will disallow use of features introduced in versions above the provided version.
     boost::optional<ServerGlobalParams::FeatureCompatibility::Version>
         maxFeatureCompatibilityVersion;
@@ -32,11 +32,14 @@
 
 #include "sharded_agg_helpers.h"
 
+#include "mongo/db/commands/test_commands_enabled.h"
 #include "mongo/db/curop.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
+#include "mongo/db/pipeline/document_source_facet.h"
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_limit.h"
+#include "mongo/db/pipeline/document_source_lookup.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_merge.h"
 #include "mongo/db/pipeline/document_source_out.h"
@@ -47,6 +50,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
 #include "mongo/db/pipeline/semantic_analysis.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/vector_clock.h"
 #include "mongo/logv2/log.h"
 #include "mongo/rpc/get_status_from_command_result.h"
@@ -272,6 +276,16 @@ boost::optional<BSONObj> findSplitPoint(Pipeline::SourceContainer* shardPipe, Pi
         // A source may not simultaneously be present on both sides of the split.
         invariant(distributedPlanLogic->shardsStage != distributedPlanLogic->mergingStage);
 
+        // A streaming $group merge relies on each shard returning its partial groups in order.
+        if (auto mergingGroup =
+                dynamic_cast<DocumentSourceGroup*>(distributedPlanLogic->mergingStage.get());
+            mergingGroup && mergingGroup->streamingMerge()) {
+            auto shardsGroup =
+                dynamic_cast<DocumentSourceGroup*>(distributedPlanLogic->shardsStage.get());
+            invariant(shardsGroup);
+            shardsGroup->setSortedOutput(true);
+        }
+
         if (distributedPlanLogic->shardsStage)
             shardPipe->push_back(std::move(distributedPlanLogic->shardsStage));
 
@@ -593,6 +607,211 @@ void abandonCacheIfSentToShards(Pipeline* shardsPipeline) {
     }
 }
 
+/**
+ * Returns the version of the foreign collection of 'lookup' on each shard if that collection is
+ * sharded on the foreignField with exactly the same chunks as 'localCm' has on the localField.
+ * Every foreign document that could match a local document then lives on that document's shard.
+ */
+boost::optional<std::map<std::string, ChunkVersion>> getCoLocatedForeignVersions(
+    OperationContext* opCtx, const ChunkManager& localCm, const DocumentSourceLookUp& lookup) {
+    const auto& resolvedNs = lookup.getContext()->getResolvedNamespace(lookup.getFromNs());
+    if (!resolvedNs.pipeline.empty()) {
+        // The foreign namespace is a view.
+        return boost::none;
+    }
+
+    auto swForeignCm = getCollectionRoutingInfoForTxnCmd(opCtx, resolvedNs.ns);
+    if (!swForeignCm.isOK() || !swForeignCm.getValue().isSharded()) {
+        return boost::none;
+    }
+    const auto& foreignCm = swForeignCm.getValue();
+
+    // Both shard keys must be over the join field alone, and be of the same kind.
+    const auto& foreignKeyPattern = foreignCm.getShardKeyPattern().toBSON();
+    const auto localKey = localCm.getShardKeyPattern().toBSON().firstElement();
+    if (foreignKeyPattern.nFields() != 1 ||
+        foreignKeyPattern.firstElement().fieldNameStringData() !=
+            lookup.getForeignField()->fullPath() ||
+        foreignKeyPattern.firstElement().woCompare(localKey, 0 /* ignore field names */) != 0) {
+        return boost::none;
+    }
+
+    if (foreignCm.numChunks() != localCm.numChunks()) {
+        return boost::none;
+    }
+
+    std::vector<Chunk> localChunks;
+    localChunks.reserve(localCm.numChunks());
+    localCm.forEachChunk([&](const auto& chunk) {
+        localChunks.push_back(chunk);
+        return true;
+    });
+
+    // The chunks of both collections are enumerated in ascending order, so they must match one by
+    // one in their bounds and owning shards.
+    bool samePlacement = true;
+    size_t chunkIndex = 0;
+    std::map<std::string, ChunkVersion> foreignVersions;
+    foreignCm.forEachChunk([&](const auto& chunk) {
+        const auto& localChunk = localChunks[chunkIndex++];
+        samePlacement = chunk.getShardId() == localChunk.getShardId() &&
+            chunk.getMin().firstElement().woCompare(localChunk.getMin().firstElement(), 0) == 0 &&
+            chunk.getMax().firstElement().woCompare(localChunk.getMax().firstElement(), 0) == 0;
+        if (samePlacement && !foreignVersions.count(chunk.getShardId().toString())) {
+            foreignVersions[chunk.getShardId().toString()] =
+                foreignCm.getVersion(chunk.getShardId());
+        }
+        return samePlacement;
+    });
+
+    if (!samePlacement) {
+        return boost::none;
+    }
+    return foreignVersions;
+}
+
+/**
+ * Marks each localField/foreignField $lookup in the shards' part of 'pipeline' whose local field is
+ * still the shard key of the collection being aggregated, and whose foreign collection is placed
+ * on the shards in the same way, so that it runs on each shard rather than after the merge.
+ */
+void markCoLocatedLookups(OperationContext* opCtx, Pipeline* pipeline, const ChunkManager& cm) {
+    const auto& keyPattern = cm.getShardKeyPattern().toBSON();
+    if (keyPattern.nFields() != 1 || pipeline->getContext()->getCollator()) {
+        // Values which are equal under a collation may be owned by different chunks.
+        return;
+    }
+
+    // The name of the shard key field as of the current stage.
+    std::string shardKeyPath = keyPattern.firstElement().fieldName();
+    for (auto&& stage : pipeline->getSources()) {
+        auto lookup = dynamic_cast<DocumentSourceLookUp*>(stage.get());
+        if (lookup && !lookup->wasConstructedWithPipelineSyntax() &&
+            lookup->getLocalField()->fullPath() == shardKeyPath) {
+            if (auto foreignVersions = getCoLocatedForeignVersions(opCtx, cm, *lookup)) {
+                lookup->setCoLocated(std::move(*foreignVersions));
+            }
+        }
+
+        if (stage->distributedPlanLogic()) {
+            // The remaining stages will not run on the shards.
+            return;
+        }
+
+        auto renames = semantic_analysis::renamedPaths(
+            {shardKeyPath}, *stage, semantic_analysis::Direction::kForward);
+        if (!renames) {
+            return;
+        }
+        shardKeyPath = (*renames)[shardKeyPath];
+    }
+}
+
+/**
+ * Throws if a localField/foreignField $lookup in 'pipeline' joins a sharded foreign collection but
+ * was not marked as co-located. Parsing admits such a $lookup when co-located $lookup is enabled,
+ * since only the routing information available here tells whether the collections are placed on
+ * the shards in the same way. A $lookup nested in a $facet is never marked, so any such $lookup of
+ * a sharded collection is rejected.
+ */
+void assertShardedLookupsAreCoLocated(OperationContext* opCtx, const Pipeline& pipeline) {
+    if (getTestCommandsEnabled() && internalQueryAllowShardedLookup.load()) {
+        return;
+    }
+
+    for (auto&& stage : pipeline.getSources()) {
+        if (auto facet = dynamic_cast<DocumentSourceFacet*>(stage.get())) {
+            for (auto&& facetPipeline : facet->getFacetPipelines()) {
+                assertShardedLookupsAreCoLocated(opCtx, *facetPipeline.pipeline);
+            }
+            continue;
+        }
+
+        auto lookup = dynamic_cast<DocumentSourceLookUp*>(stage.get());
+        if (!lookup || lookup->wasConstructedWithPipelineSyntax() || lookup->isCoLocated()) {
+            continue;
+        }
+
+        const auto& foreignNss =
+            lookup->getContext()->getResolvedNamespace(lookup->getFromNs()).ns;
+        auto swForeignCm = getCollectionRoutingInfoForTxnCmd(opCtx, foreignNss);
+        uassert(28769,
+                str::stream() << foreignNss.ns()
+                              << " cannot be sharded unless its chunks are placed like those of "
+                              << pipeline.getContext()->ns.ns(),
+                !swForeignCm.isOK() || !swForeignCm.getValue().isSharded());
+    }
+}
+
+/**
+ * If the merging half of the pipeline begins with a $group which combines the partial groups from
+ * the shards, and nothing after it needs to see a single stream, returns an exchange policy which
+ * partitions the partial groups by a hash of their _id across the targeted shards. Each shard then
+ * completes its own share of the groups, and can spill to disk while doing so.
+ */
+boost::optional<ShardedExchangePolicy> checkIfEligibleForGroupExchange(
+    const Pipeline* mergePipeline, const std::set<ShardId>& shardIds) {
+    if (!internalQueryEnableGroupMergeExchange.load() || internalQueryDisableExchange.load()) {
+        return boost::none;
+    }
+
+    const auto& expCtx = mergePipeline->getContext();
+    if (shardIds.size() < 2 || expCtx->getCollator()) {
+        // Group keys which compare equal under a collation may still hash differently.
+        return boost::none;
+    }
+
+    const auto& stages = mergePipeline->getSources();
+    if (stages.empty()) {
+        return boost::none;
+    }
+
+    auto mergingGroup = dynamic_cast<DocumentSourceGroup*>(stages.front().get());
+    if (!mergingGroup || !mergingGroup->doingMerge() || mergingGroup->streamingMerge()) {
+        // The exchange does not preserve the order which a streaming merge depends upon.
+        return boost::none;
+    }
+
+    // The outputs of the consumers are simply concatenated, so every later stage must be able to
+    // run over a subset of the groups.
+    for (auto it = std::next(stages.begin()); it != stages.end(); ++it) {
+        const auto constraints = (*it)->constraints(Pipeline::SplitState::kSplitForMerge);
+        if ((*it)->distributedPlanLogic() ||
+            constraints.hostRequirement == StageConstraints::HostTypeRequirement::kMongoS ||
+            constraints.hostRequirement == StageConstraints::HostTypeRequirement::kPrimaryShard) {
+            return boost::none;
+        }
+    }
+
+    // Divide the range of 64-bit hashes evenly between the shards.
+    const int numConsumers = shardIds.size();
+    const auto step = std::numeric_limits<unsigned long long>::max() / numConsumers;
+
+    std::vector<BSONObj> boundaries;
+    std::vector<int> consumerIds;
+    boundaries.emplace_back(BSON("_id" << MINKEY));
+    for (int i = 1; i < numConsumers; ++i) {
+        const auto splitPoint = static_cast<long long>(
+            static_cast<unsigned long long>(std::numeric_limits<long long>::min()) + step * i);
+        boundaries.emplace_back(BSON("_id" << splitPoint));
+    }
+    boundaries.emplace_back(BSON("_id" << MAXKEY));
+    for (int i = 0; i < numConsumers; ++i) {
+        consumerIds.emplace_back(i);
+    }
+
+    ExchangeSpec exchangeSpec;
+    exchangeSpec.setPolicy(ExchangePolicyEnum::kKeyRange);
+    exchangeSpec.setKey(BSON("_id"
+                             << "hashed"));
+    exchangeSpec.setBoundaries(std::move(boundaries));
+    exchangeSpec.setConsumers(numConsumers);
+    exchangeSpec.setConsumerIds(std::move(consumerIds));
+
+    return ShardedExchangePolicy{std::move(exchangeSpec),
+                                 std::vector<ShardId>(shardIds.begin(), shardIds.end())};
+}
+
 
 }  // namespace
 
@@ -852,11 +1071,6 @@ DispatchShardPipelineResults dispatchShardPipeline(
     auto shardResults = std::vector<AsyncRequestsSender::Response>();
     auto opCtx = expCtx->opCtx;
 
-    const bool needsPrimaryShardMerge =
-        (pipeline->needsPrimaryShardMerger() || internalQueryAlwaysMergeOnPrimaryShard.load());
-
-    const bool needsMongosMerge = pipeline->needsMongosMerger();
-
     const auto shardQuery = pipeline->getInitialQuery();
 
     auto executionNsRoutingInfoStatus = getExecutionNsRoutingInfo(opCtx, expCtx->ns);
@@ -871,6 +1085,21 @@ DispatchShardPipelineResults dispatchShardPipeline(
         ? std::move(executionNsRoutingInfoStatus.getValue())
         : boost::optional<ChunkManager>{};
 
+    // A co-located $lookup no longer needs to run on the primary shard, so this must be decided
+    // before the merging requirements of the pipeline are.
+    if (internalQueryEnableCoLocatedLookup.load() && executionNsRoutingInfo &&
+        executionNsRoutingInfo->isSharded()) {
+        markCoLocatedLookups(opCtx, pipeline.get(), *executionNsRoutingInfo);
+    }
+    if (internalQueryEnableCoLocatedLookup.load()) {
+        assertShardedLookupsAreCoLocated(opCtx, *pipeline);
+    }
+
+    const bool needsPrimaryShardMerge =
+        (pipeline->needsPrimaryShardMerger() || internalQueryAlwaysMergeOnPrimaryShard.load());
+
+    const bool needsMongosMerge = pipeline->needsMongosMerger();
+
     // Determine whether we can run the entire aggregation on a single shard.
     const auto collationObj = expCtx->getCollatorBSON();
     const bool mustRunOnAll = mustRunOnAllShards(expCtx->ns, hasChangeStream);
@@ -899,6 +1128,10 @@ DispatchShardPipelineResults dispatchShardPipeline(
         splitPipelines = splitPipeline(std::move(pipeline));
 
         exchangeSpec = checkIfEligibleForExchange(opCtx, splitPipelines->mergePipeline.get());
+        if (!exchangeSpec && !needsMongosMerge) {
+            exchangeSpec =
+                checkIfEligibleForGroupExchange(splitPipelines->mergePipeline.get(), shardIds);
+        }
     }
 
     // Generate the command object for the targeted shards.
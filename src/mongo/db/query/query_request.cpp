@@ -350,6 +350,12 @@ StatusWith<std::unique_ptr<QueryRequest>> QueryRequest::parseFromFindCommand(
                 return status;
             }
             qr->_requestResumeToken = el.boolean();
+        } else if (fieldName == kRequestEncodedOplogBatchesField) {
+            Status status = checkFieldType(el, Bool);
+            if (!status.isOK()) {
+                return status;
+            }
+            qr->_requestEncodedOplogBatches = el.boolean();
         } else if (fieldName == kUse44SortKeys) {
             Status status = checkFieldType(el, Bool);
             if (!status.isOK()) {
@@ -545,6 +551,10 @@ void QueryRequest::asFindCommandInternal(BSONObjBuilder* cmdBuilder) const {
     if (!_resumeAfter.isEmpty()) {
         cmdBuilder->append(kResumeAfterField, _resumeAfter);
     }
+
+    if (_requestEncodedOplogBatches) {
+        cmdBuilder->append(kRequestEncodedOplogBatchesField, true);
+    }
 }
 
 void QueryRequest::addShowRecordIdMetaProj() {
@@ -1006,6 +1016,12 @@ StatusWith<BSONObj> QueryRequest::asAggregationCommand() const {
                               << " not supported in aggregation."};
     }
 
+    if (_requestEncodedOplogBatches) {
+        return {ErrorCodes::InvalidPipelineOperator,
+                str::stream() << "Option " << kRequestEncodedOplogBatchesField
+                              << " not supported in aggregation."};
+    }
+
     // Now that we've successfully validated this QR, begin building the aggregation command.
     aggregationBuilder.append("aggregate", _nss.coll());
 
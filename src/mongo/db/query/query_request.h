@@ -80,6 +80,7 @@ public:
     static constexpr auto kAllowSpeculativeMajorityReadField = "allowSpeculativeMajorityRead";
     static constexpr auto kRequestResumeTokenField = "$_requestResumeToken";
     static constexpr auto kResumeAfterField = "$_resumeAfter";
+    static constexpr auto kRequestEncodedOplogBatchesField = "$_requestEncodedOplogBatches";
     static constexpr auto kUse44SortKeys = "_use44SortKeys";
     static constexpr auto kMaxTimeMSOpOnlyField = "maxTimeMSOpOnly";
 
@@ -465,6 +466,14 @@ public:
         _resumeAfter = resumeAfter;
     }
 
+    bool getRequestEncodedOplogBatches() const {
+        return _requestEncodedOplogBatches;
+    }
+
+    void setRequestEncodedOplogBatches(bool requestEncodedOplogBatches) {
+        _requestEncodedOplogBatches = requestEncodedOplogBatches;
+    }
+
     /**
      * Return options as a bit vector.
      */
@@ -551,6 +560,10 @@ private:
     // field.
     BSONObj _resumeAfter;
 
+    // If true, each batch of oplog entries is returned as a single dictionary-encoded document
+    // when that is smaller. See oplog_batch_encoding.h.
+    bool _requestEncodedOplogBatches = false;
+
     bool _wantMore = true;
 
     // Must be either unset or positive. Negative skip is illegal and a skip of zero received from
@@ -125,6 +125,10 @@ MONGO_FAIL_POINT_DEFINE(sleepBetweenInsertOpTimeGenerationAndLogOp);
 // are visible, but before we have advanced 'lastApplied' for the write.
 MONGO_FAIL_POINT_DEFINE(hangBeforeLogOpAdvancesLastApplied);
 
+// Room for the fields of an insert oplog entry other than the document: the namespace, which is at
+// most 255 bytes, the optimes, wall clock time, collection UUID and retryable write fields.
+constexpr int kInsertOplogEntryOverheadBytes = 1024;
+
 void abortIndexBuilds(OperationContext* opCtx,
                       const OplogEntry::CommandType& commandType,
                       const NamespaceString& nss,
@@ -474,7 +478,13 @@ std::vector<OpTime> logInsertOps(OperationContext* opCtx,
 
         opTimes[i] = insertStatementOplogSlot;
         timestamps[i] = insertStatementOplogSlot.getTimestamp();
-        bsonOplogEntries[i] = oplogEntry.toBSON();
+
+        // Size the builder for the whole entry up front, so that the document, which is usually a
+        // view into the received message, is copied into the entry once and never moved again by
+        // the builder growing.
+        BSONObjBuilder oplogEntryBuilder(begin[i].doc.objsize() + kInsertOplogEntryOverheadBytes);
+        oplogEntry.serialize(&oplogEntryBuilder);
+        bsonOplogEntries[i] = oplogEntryBuilder.obj();
         // The storage engine will assign the RecordId based on the "ts" field of the oplog entry,
         // see oploghack::extractKey.
         records[i] = Record{
@@ -52,6 +52,7 @@
 #include "mongo/platform/basic.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/log_with_sampling.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 namespace repl {
@@ -326,8 +327,14 @@ void OplogApplierImpl::_run(OplogBuffer* oplogBuffer) {
                                          << lastAppliedOpTimeAtStartOfBatch.toString() << ")."));
         }
 
+        std::size_t numOpsInBatch = 0;
+        for (const auto& op : ops.getBatch()) {
+            numOpsInBatch += OplogBatcher::getOpCount(op);
+        }
+
         // Don't allow the fsync+lock thread to see intermediate states of batch application.
         stdx::lock_guard<SimpleMutex> fsynclk(filesLockedFsync);
+        Timer batchTimer;
 
         // Apply the operations in this batch. '_applyOplogBatch' returns the optime of the
         // last op that was applied, which should be the last optime in the batch.
@@ -364,6 +371,8 @@ void OplogApplierImpl::_run(OplogBuffer* oplogBuffer) {
 
         // 4. Finalize this batch. The finalizer advances the global timestamp to lastOpTimeInBatch.
         finalizer->record({lastOpTimeInBatch, lastWallTimeInBatch});
+
+        _oplogBatcher->recordAppliedBatch(numOpsInBatch, Microseconds(batchTimer.micros()));
     }
 }
 
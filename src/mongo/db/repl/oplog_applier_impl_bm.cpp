@@ -0,0 +1,370 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/logical_session_id.h"
+#include "mongo/db/repl/oplog_applier_impl.h"
+#include "mongo/db/repl/oplog_applier_impl_test_fixture.h"
+#include "mongo/db/repl/oplog_batch_size_controller.h"
+#include "mongo/db/repl/oplog_buffer_blocking_queue.h"
+#include "mongo/db/repl/oplog_entry_test_helpers.h"
+#include "mongo/db/repl/repl_server_parameters_gen.h"
+#include "mongo/db/repl/replication_coordinator.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+// Benchmarks secondary oplog application in isolation: synthetic oplog entries are pushed into an
+// OplogBufferBlockingQueue and drained through the real OplogBatcher and OplogApplierImpl into a
+// WiredTiger instance. Every benchmark reports the per-phase time spent forming batches and
+// applying them, as well as how busy the writer threads were while batches were being applied.
+
+const int kNumCollections = 4;
+const int kOpsPerTransaction = 10;
+
+enum class Workload { kInsert, kUpdate, kDelete, kTransaction, kMixed };
+
+/**
+ * OplogApplierImpl that records how long writer threads spend applying their share of each batch.
+ */
+class TimedOplogApplier : public OplogApplierImpl {
+public:
+    using OplogApplierImpl::OplogApplierImpl;
+
+    long long getWriterBusyMicros() const {
+        return _writerBusyMicros.load();
+    }
+
+protected:
+    Status applyOplogBatchPerWorker(OperationContext* opCtx,
+                                    std::vector<const OplogEntry*>* ops,
+                                    WorkerMultikeyPathInfo* workerMultikeyPathInfo) override {
+        Timer timer;
+        auto status =
+            OplogApplierImpl::applyOplogBatchPerWorker(opCtx, ops, workerMultikeyPathInfo);
+        _writerBusyMicros.fetchAndAdd(timer.micros());
+        return status;
+    }
+
+private:
+    AtomicWord<long long> _writerBusyMicros{0};
+};
+
+struct ReplayStats {
+    long long batches = 0;
+    long long batchingMicros = 0;
+    long long applyMicros = 0;
+};
+
+/**
+ * Reuses the OplogApplierImpl unit test setup (mock replication coordinator and consistency
+ * markers, real storage interface and oplog) outside of the unit test framework.
+ */
+class OplogApplierBenchmarkFixture : public OplogApplierImplTest {
+public:
+    OplogApplierBenchmarkFixture() : OplogApplierImplTest("wiredTiger") {
+        setUp();
+        for (int i = 0; i < kNumCollections; ++i) {
+            NamespaceString nss("bench", str::stream() << "coll" << i);
+            _collections.emplace_back(nss, createCollectionWithUuid(_opCtx.get(), nss));
+        }
+        createCollectionWithUuid(_opCtx.get(), NamespaceString::kSessionTransactionsTableNamespace);
+    }
+
+    ~OplogApplierBenchmarkFixture() {
+        tearDown();
+    }
+
+    using OplogApplierImplTest::getConsistencyMarkers;
+    using OplogApplierImplTest::getStorageInterface;
+
+    OperationContext* getOperationContext() const {
+        return _opCtx.get();
+    }
+
+    /**
+     * Returns 'numOps' operations of the given workload. Documents that the workload updates or
+     * deletes are inserted as part of this call.
+     */
+    std::vector<OplogEntry> makeWorkload(Workload workload, int numOps) {
+        // Every call works on documents that were never used before, so that inserts are not
+        // turned into upserts and deletes always find their target.
+        const int firstId = _nextId;
+        _nextId += numOps;
+
+        std::vector<OplogEntry> ops;
+        ops.reserve(numOps);
+        switch (workload) {
+            case Workload::kInsert:
+                for (int id = firstId; id < firstId + numOps; ++id) {
+                    ops.push_back(_makeInsert(id));
+                }
+                break;
+            case Workload::kUpdate:
+                _populate(firstId, numOps);
+                for (int id = firstId; id < firstId + numOps; ++id) {
+                    ops.push_back(_makeUpdate(id));
+                }
+                break;
+            case Workload::kDelete:
+                _populate(firstId, numOps);
+                for (int id = firstId; id < firstId + numOps; ++id) {
+                    ops.push_back(_makeDelete(id));
+                }
+                break;
+            case Workload::kTransaction:
+                for (int id = firstId; id < firstId + numOps; id += kOpsPerTransaction) {
+                    ops.push_back(_makeTransaction(id));
+                }
+                break;
+            case Workload::kMixed: {
+                // Half inserts, a quarter updates and a quarter deletes, interleaved.
+                const int half = numOps / 2;
+                _populate(firstId, half);
+                for (int i = 0; i < half; ++i) {
+                    ops.push_back(_makeInsert(firstId + half + i));
+                    ops.push_back((i % 2) ? _makeUpdate(firstId + i) : _makeDelete(firstId + i));
+                }
+                break;
+            }
+        }
+        return ops;
+    }
+
+    /**
+     * Pushes 'ops' into an oplog buffer and applies them through the batcher and applier until the
+     * buffer is drained. When 'controller' is given, it picks the number of operations in each
+     * batch; otherwise every batch is limited to 'batchLimitOps'.
+     */
+    ReplayStats replay(const std::vector<OplogEntry>& ops,
+                       TimedOplogApplier* applier,
+                       OplogBufferBlockingQueue* buffer,
+                       std::size_t batchLimitOps,
+                       OplogBatchSizeController* controller) {
+        std::vector<BSONObj> docs;
+        docs.reserve(ops.size());
+        for (const auto& op : ops) {
+            docs.push_back(op.getRaw());
+        }
+        buffer->push(_opCtx.get(), docs.cbegin(), docs.cend());
+
+        OplogApplier::BatchLimits limits;
+        limits.bytes = replBatchLimitBytes.load();
+
+        ReplayStats stats;
+        while (!buffer->isEmpty()) {
+            limits.ops = controller
+                ? controller->getTargetBatchOps(
+                      batchLimitOps,
+                      buffer->getCount(),
+                      Milliseconds(replBatchTargetLatencyMillis.load()))
+                : batchLimitOps;
+
+            Timer batchTimer;
+            auto batch = uassertStatusOK(applier->getNextApplierBatch(_opCtx.get(), limits));
+            stats.batchingMicros += batchTimer.micros();
+
+            const auto numOpsInBatch = batch.size();
+            Timer applyTimer;
+            uassertStatusOK(applier->applyOplogBatch(_opCtx.get(), std::move(batch)));
+            const auto applyMicros = applyTimer.micros();
+            stats.applyMicros += applyMicros;
+            ++stats.batches;
+
+            if (controller) {
+                controller->recordBatch(numOpsInBatch, Microseconds(applyMicros));
+            }
+        }
+        return stats;
+    }
+
+private:
+    void _doTest() override {}
+
+    const std::pair<NamespaceString, UUID>& _collectionFor(int id) const {
+        return _collections[id % kNumCollections];
+    }
+
+    void _populate(int firstId, int numDocs) {
+        std::vector<OplogEntry> inserts;
+        for (int id = firstId; id < firstId + numDocs; ++id) {
+            inserts.push_back(_makeInsert(id));
+        }
+        uassertStatusOK(runOpsSteadyState(std::move(inserts)));
+    }
+
+    OplogEntry _makeInsert(int id) {
+        const auto& [nss, uuid] = _collectionFor(id);
+        return makeOplogEntry(nextOpTime(),
+                              OpTypeEnum::kInsert,
+                              nss,
+                              BSON("_id" << id << "a" << id << "payload" << std::string(64, 'x')),
+                              boost::none,
+                              {},
+                              Date_t::now(),
+                              boost::none,
+                              uuid);
+    }
+
+    OplogEntry _makeUpdate(int id) {
+        // A $v:2 delta update, as produced by the primary's update system.
+        const auto& [nss, uuid] = _collectionFor(id);
+        return makeOplogEntry(nextOpTime(),
+                              OpTypeEnum::kUpdate,
+                              nss,
+                              BSON("$v" << 2 << "diff" << BSON("u" << BSON("a" << id + 1))),
+                              BSON("_id" << id),
+                              {},
+                              Date_t::now(),
+                              boost::none,
+                              uuid);
+    }
+
+    OplogEntry _makeDelete(int id) {
+        const auto& [nss, uuid] = _collectionFor(id);
+        return makeOplogEntry(nextOpTime(),
+                              OpTypeEnum::kDelete,
+                              nss,
+                              BSON("_id" << id),
+                              boost::none,
+                              {},
+                              Date_t::now(),
+                              boost::none,
+                              uuid);
+    }
+
+    OplogEntry _makeTransaction(int firstId) {
+        BSONArrayBuilder applyOpsBab;
+        for (int id = firstId; id < firstId + kOpsPerTransaction; ++id) {
+            const auto& [nss, uuid] = _collectionFor(id);
+            applyOpsBab.append(BSON("op"
+                                    << "i"
+                                    << "ns" << nss.ns() << "ui" << uuid << "o"
+                                    << BSON("_id" << id << "a" << id)));
+        }
+        return makeCommandOplogEntryWithSessionInfoAndStmtId(
+            nextOpTime(),
+            NamespaceString("admin", "$cmd"),
+            BSON("applyOps" << applyOpsBab.arr()),
+            makeLogicalSessionIdForTest(),
+            TxnNumber(1),
+            StmtId(0),
+            OpTime());
+    }
+
+    std::vector<std::pair<NamespaceString, UUID>> _collections;
+    int _nextId = 0;
+};
+
+/**
+ * Arguments: number of operations to apply per iteration, number of writer threads and the batch
+ * limit in operations. A batch limit of 0 lets the OplogBatchSizeController choose the batch size.
+ */
+void BM_OplogApplication(benchmark::State& state, Workload workload) {
+    const int numOps = state.range(0);
+    const int writerThreads = state.range(1);
+    const std::size_t batchLimitOps = state.range(2);
+
+    OplogApplierBenchmarkFixture fixture;
+    auto opCtx = fixture.getOperationContext();
+
+    NoopOplogApplierObserver observer;
+    OplogBufferBlockingQueue buffer;
+    buffer.startup(opCtx);
+    auto writerPool = makeReplWriterPool(writerThreads);
+    TimedOplogApplier applier(nullptr,  // executor
+                              &buffer,
+                              &observer,
+                              ReplicationCoordinator::get(opCtx),
+                              fixture.getConsistencyMarkers(),
+                              fixture.getStorageInterface(),
+                              OplogApplier::Options(OplogApplication::Mode::kSecondary),
+                              writerPool.get());
+
+    OplogBatchSizeController controller;
+    ReplayStats total;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto ops = fixture.makeWorkload(workload, numOps);
+        state.ResumeTiming();
+
+        auto stats = fixture.replay(ops,
+                                    &applier,
+                                    &buffer,
+                                    batchLimitOps ? batchLimitOps : getBatchLimitOplogEntries(),
+                                    batchLimitOps ? nullptr : &controller);
+        total.batches += stats.batches;
+        total.batchingMicros += stats.batchingMicros;
+        total.applyMicros += stats.applyMicros;
+    }
+    buffer.shutdown(opCtx);
+
+    state.SetItemsProcessed(state.iterations() * numOps);
+    state.counters["batches"] =
+        benchmark::Counter(total.batches, benchmark::Counter::kAvgIterations);
+    state.counters["batchingMicros"] =
+        benchmark::Counter(total.batchingMicros, benchmark::Counter::kAvgIterations);
+    state.counters["applyMicros"] =
+        benchmark::Counter(total.applyMicros, benchmark::Counter::kAvgIterations);
+    if (total.applyMicros) {
+        state.counters["writerUtilization"] = double(applier.getWriterBusyMicros()) /
+            (double(total.applyMicros) * writerThreads);
+    }
+}
+
+void OplogApplicationArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"ops", "writers", "batchLimit"});
+    for (int writers : {1, 4, 16}) {
+        b->Args({10 * 1000, writers, 5000});
+    }
+
+    // Compare fixed batch limits against adaptive batch sizing with the default writer count.
+    for (int batchLimit : {100, 1000, 0}) {
+        b->Args({10 * 1000, 16, batchLimit});
+    }
+    b->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_CAPTURE(BM_OplogApplication, Insert, Workload::kInsert)->Apply(OplogApplicationArgs);
+BENCHMARK_CAPTURE(BM_OplogApplication, Update, Workload::kUpdate)->Apply(OplogApplicationArgs);
+BENCHMARK_CAPTURE(BM_OplogApplication, Delete, Workload::kDelete)->Apply(OplogApplicationArgs);
+BENCHMARK_CAPTURE(BM_OplogApplication, Transaction, Workload::kTransaction)
+    ->Apply(OplogApplicationArgs);
+BENCHMARK_CAPTURE(BM_OplogApplication, Mixed, Workload::kMixed)->Apply(OplogApplicationArgs);
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,256 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_batch_encoding.h"
+
+#include <array>
+#include <limits>
+#include <utility>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/logv2/redaction.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+constexpr int kEncodingVersion = 1;
+
+constexpr StringData kVersionFieldName = "v"_sd;
+constexpr StringData kDictionaryFieldName = "dict"_sd;
+constexpr StringData kOpsFieldName = "ops"_sd;
+
+constexpr StringData kWallClockTimeFieldName = "wall"_sd;
+constexpr StringData kEncodedWallClockTimeFieldName = "$_wall"_sd;
+
+/**
+ * The fields whose values are stored in the batch dictionary, along with the names of the fields
+ * which replace them in encoded entries.
+ */
+constexpr std::array<std::pair<StringData, StringData>, 3> kDictionaryFields{{
+    {"ns"_sd, "$_ns"_sd},
+    {"ui"_sd, "$_ui"_sd},
+    {"lsid"_sd, "$_lsid"_sd},
+}};
+
+/**
+ * Returns the name of the field which replaces 'name' in encoded entries if its value is stored
+ * in the dictionary, or an empty StringData otherwise.
+ */
+StringData encodedFieldName(StringData name) {
+    for (auto&& [fieldName, encodedName] : kDictionaryFields) {
+        if (name == fieldName) {
+            return encodedName;
+        }
+    }
+    return StringData();
+}
+
+/**
+ * Returns the name of the field which 'encodedName' replaces in encoded entries, or an empty
+ * StringData if 'encodedName' does not hold a dictionary index.
+ */
+StringData decodedFieldName(StringData encodedName) {
+    for (auto&& [fieldName, name] : kDictionaryFields) {
+        if (encodedName == name) {
+            return fieldName;
+        }
+    }
+    return StringData();
+}
+
+bool isReservedFieldName(StringData name) {
+    return name == kEncodedWallClockTimeFieldName || !decodedFieldName(name).empty();
+}
+
+class DictionaryBuilder {
+public:
+    explicit DictionaryBuilder(BSONArrayBuilder* builder) : _builder(builder) {}
+
+    /**
+     * Returns the index of the value of 'elem' in the dictionary, adding it if it was not seen
+     * before. Values are keyed on their type and raw bytes, so equal values of different fields
+     * share a single dictionary slot.
+     */
+    int indexOf(const BSONElement& elem) {
+        std::string key;
+        key.reserve(elem.valuesize() + 1);
+        key.push_back(static_cast<char>(elem.type()));
+        key.append(elem.value(), elem.valuesize());
+
+        auto [it, inserted] = _indexes.emplace(std::move(key), static_cast<int>(_indexes.size()));
+        if (inserted) {
+            _builder->append(elem);
+        }
+        return it->second;
+    }
+
+private:
+    BSONArrayBuilder* _builder;
+    stdx::unordered_map<std::string, int> _indexes;
+};
+
+}  // namespace
+
+StatusWith<BSONObj> encodeOplogBatch(const std::vector<BSONObj>& entries) {
+    BSONObjBuilder bob;
+    BSONObjBuilder batchBob(bob.subobjStart(kEncodedOplogBatchFieldName));
+    batchBob.append(kVersionFieldName, kEncodingVersion);
+
+    // The dictionary must precede the entries so it can be resolved in a single pass while
+    // decoding, but it is only complete once every entry has been visited. Build it separately.
+    BSONArrayBuilder dictBab;
+    DictionaryBuilder dictionary(&dictBab);
+
+    BSONArrayBuilder opsBab;
+    long long lastWallMillis = 0;
+    for (const auto& entry : entries) {
+        BSONObjBuilder entryBob(opsBab.subobjStart());
+        for (auto&& elem : entry) {
+            auto name = elem.fieldNameStringData();
+            if (isReservedFieldName(name)) {
+                return {ErrorCodes::BadValue,
+                        str::stream() << "Cannot encode an oplog entry with the reserved field '"
+                                      << name << "': " << redact(entry)};
+            }
+
+            if (auto encodedName = encodedFieldName(name); !encodedName.empty()) {
+                entryBob.append(encodedName, dictionary.indexOf(elem));
+            } else if (name == kWallClockTimeFieldName && elem.type() == Date) {
+                auto wallMillis = elem.date().toMillisSinceEpoch();
+                auto delta = wallMillis - lastWallMillis;
+                if (delta >= std::numeric_limits<int>::min() &&
+                    delta <= std::numeric_limits<int>::max()) {
+                    entryBob.append(kEncodedWallClockTimeFieldName, static_cast<int>(delta));
+                } else {
+                    entryBob.append(kEncodedWallClockTimeFieldName, delta);
+                }
+                lastWallMillis = wallMillis;
+            } else {
+                entryBob.append(elem);
+            }
+        }
+    }
+
+    batchBob.append(kDictionaryFieldName, dictBab.arr());
+    batchBob.append(kOpsFieldName, opsBab.arr());
+    batchBob.doneFast();
+    return bob.obj();
+}
+
+bool isEncodedOplogBatch(const BSONObj& doc) {
+    return doc.firstElementFieldNameStringData() == kEncodedOplogBatchFieldName;
+}
+
+StatusWith<std::vector<BSONObj>> decodeOplogBatch(const BSONObj& doc) {
+    auto batchElem = doc.firstElement();
+    if (batchElem.fieldNameStringData() != kEncodedOplogBatchFieldName ||
+        batchElem.type() != Object) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "Expected an encoded oplog batch, got: " << doc};
+    }
+
+    auto batch = batchElem.Obj();
+    auto versionElem = batch[kVersionFieldName];
+    if (!versionElem.isNumber() || versionElem.numberInt() != kEncodingVersion) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "Unsupported oplog batch encoding version: " << versionElem};
+    }
+
+    auto dictElem = batch[kDictionaryFieldName];
+    auto opsElem = batch[kOpsFieldName];
+    if (dictElem.type() != Array || opsElem.type() != Array) {
+        return {ErrorCodes::BadValue,
+                str::stream() << "Malformed encoded oplog batch: " << batch};
+    }
+
+    std::vector<BSONElement> dictionary;
+    for (auto&& value : dictElem.Obj()) {
+        dictionary.push_back(value);
+    }
+
+    std::vector<BSONObj> entries;
+    long long lastWallMillis = 0;
+    for (auto&& opElem : opsElem.Obj()) {
+        if (opElem.type() != Object) {
+            return {ErrorCodes::BadValue,
+                    str::stream() << "Malformed entry in encoded oplog batch: " << opElem};
+        }
+
+        BSONObjBuilder entryBob;
+        for (auto&& elem : opElem.Obj()) {
+            auto name = elem.fieldNameStringData();
+            if (auto fieldName = decodedFieldName(name); !fieldName.empty()) {
+                if (elem.type() != NumberInt || elem.numberInt() < 0 ||
+                    static_cast<size_t>(elem.numberInt()) >= dictionary.size()) {
+                    return {ErrorCodes::BadValue,
+                            str::stream() << "Invalid dictionary index in encoded oplog batch: "
+                                          << elem};
+                }
+                entryBob.appendAs(dictionary[elem.numberInt()], fieldName);
+            } else if (name == kEncodedWallClockTimeFieldName) {
+                if (elem.type() != NumberInt && elem.type() != NumberLong) {
+                    return {ErrorCodes::BadValue,
+                            str::stream() << "Invalid wall clock time delta in encoded oplog "
+                                             "batch: "
+                                          << elem};
+                }
+                lastWallMillis += elem.numberLong();
+                entryBob.appendDate(kWallClockTimeFieldName,
+                                    Date_t::fromMillisSinceEpoch(lastWallMillis));
+            } else {
+                entryBob.append(elem);
+            }
+        }
+        entries.push_back(entryBob.obj());
+    }
+
+    return entries;
+}
+
+std::vector<BSONObj> EncodedOplogBatchBuilder::done() {
+    if (!_entries.empty()) {
+        auto swEncoded = encodeOplogBatch(_entries);
+        if (swEncoded.isOK() && swEncoded.getValue().objsize() < _bytes) {
+            _entries.clear();
+            _bytes = 0;
+            return {std::move(swEncoded.getValue())};
+        }
+    }
+
+    _bytes = 0;
+    return std::exchange(_entries, {});
+}
+
+}  // namespace repl
+}  // namespace mongo
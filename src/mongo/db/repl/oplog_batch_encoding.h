@@ -0,0 +1,112 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/base/string_data.h"
+#include "mongo/bson/bsonobj.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Compact representation of a batch of oplog entries, used to reduce the size of oplog batches
+ * shipped from a sync source to its secondaries.
+ *
+ * Consecutive oplog entries repeat the same namespace, collection UUID and logical session id,
+ * and have wall clock times that are close to each other. The encoded batch stores each distinct
+ * 'ns', 'ui' and 'lsid' value once in a dictionary and replaces the field in the entries with a
+ * '$_ns', '$_ui' or '$_lsid' field holding an index into that dictionary. A 'wall' date is
+ * replaced with a '$_wall' field holding the delta, in milliseconds, from the wall clock time of
+ * the previous entry in the batch. Fields are only ever recognized as encoded by these reserved
+ * names, never by their values, so fields of any other type are left untouched. Field order is
+ * preserved, so decoding yields entries which are byte-for-byte identical to the original ones.
+ *
+ * The encoded batch is a single document of the form:
+ *
+ * {$_encodedOplogBatch: {v: 1, dict: [<value>, ...], ops: [<encoded entry>, ...]}}
+ *
+ * A secondary requests encoded batches by setting '$_requestEncodedOplogBatches' on its find
+ * command on the oplog. The sync source then returns each find and getMore batch either as a
+ * single encoded document or, if that would not be smaller, as plain oplog entries.
+ */
+constexpr StringData kEncodedOplogBatchFieldName = "$_encodedOplogBatch"_sd;
+
+/**
+ * Encodes 'entries' into a single document. Returns an error status if an entry has a top-level
+ * field with one of the names reserved for encoded fields. The caller is responsible for ensuring
+ * that the result fits within the maximum BSON document size.
+ */
+StatusWith<BSONObj> encodeOplogBatch(const std::vector<BSONObj>& entries);
+
+/**
+ * Returns true if 'doc' was produced by encodeOplogBatch().
+ */
+bool isEncodedOplogBatch(const BSONObj& doc);
+
+/**
+ * Reconstructs the oplog entries from a document produced by encodeOplogBatch(). The returned
+ * entries are owned. Returns an error status if 'doc' is malformed.
+ */
+StatusWith<std::vector<BSONObj>> decodeOplogBatch(const BSONObj& doc);
+
+/**
+ * Collects the oplog entries of a find or getMore batch which were requested as an encoded
+ * batch.
+ */
+class EncodedOplogBatchBuilder {
+public:
+    void append(const BSONObj& entry) {
+        _bytes += entry.objsize();
+        _entries.push_back(entry.getOwned());
+    }
+
+    /**
+     * Returns the total size of the entries appended so far.
+     */
+    int bytesUsed() const {
+        return _bytes;
+    }
+
+    /**
+     * Returns the documents to return in the batch: a single encoded document if that is smaller
+     * than the entries themselves, and the entries otherwise.
+     */
+    std::vector<BSONObj> done();
+
+private:
+    std::vector<BSONObj> _entries;
+    int _bytes = 0;
+};
+
+}  // namespace repl
+}  // namespace mongo
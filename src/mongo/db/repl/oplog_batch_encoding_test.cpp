@@ -0,0 +1,195 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/repl/oplog_batch_encoding.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/uuid.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+BSONObj makeEntry(long long secs,
+                  StringData ns,
+                  const UUID& uuid,
+                  const BSONObj& lsid,
+                  long long wallMillis) {
+    BSONObjBuilder bob;
+    bob.append("lsid", lsid);
+    bob.append("txnNumber", secs);
+    bob.append("op", "i");
+    bob.append("ns", ns);
+    uuid.appendToBuilder(&bob, "ui");
+    bob.append("o", BSON("_id" << secs << "x" << ns));
+    bob.append("ts", Timestamp(secs, 1));
+    bob.append("t", 1LL);
+    bob.append("v", 2);
+    bob.appendDate("wall", Date_t::fromMillisSinceEpoch(wallMillis));
+    return bob.obj();
+}
+
+std::vector<BSONObj> roundTrip(const std::vector<BSONObj>& entries) {
+    auto encoded = unittest::assertGet(encodeOplogBatch(entries));
+    ASSERT(isEncodedOplogBatch(encoded));
+    return unittest::assertGet(decodeOplogBatch(encoded));
+}
+
+TEST(OplogBatchEncodingTest, EmptyBatchRoundTrips) {
+    ASSERT(roundTrip({}).empty());
+}
+
+TEST(OplogBatchEncodingTest, RoundTripPreservesEntriesExactly) {
+    const auto uuidA = UUID::gen();
+    const auto uuidB = UUID::gen();
+    const auto lsid = BSON("id" << UUID::gen() << "uid" << BSONBinData("abc", 3, BinDataGeneral));
+
+    std::vector<BSONObj> entries{makeEntry(1, "test.a", uuidA, lsid, 1000),
+                                 makeEntry(2, "test.a", uuidA, lsid, 1003),
+                                 makeEntry(3, "test.b", uuidB, lsid, 1002),
+                                 makeEntry(4, "test.a", uuidA, BSONObj(), 5000)};
+
+    auto decoded = roundTrip(entries);
+    ASSERT_EQ(entries.size(), decoded.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        ASSERT(entries[i].binaryEqual(decoded[i])) << entries[i] << " != " << decoded[i];
+    }
+}
+
+TEST(OplogBatchEncodingTest, RepeatedValuesAreStoredOnce) {
+    const auto uuid = UUID::gen();
+    const auto lsid = BSON("id" << UUID::gen());
+
+    std::vector<BSONObj> entries;
+    int totalSize = 0;
+    for (long long i = 0; i < 100; ++i) {
+        entries.push_back(makeEntry(i, "test.coll", uuid, lsid, 1000 + i));
+        totalSize += entries.back().objsize();
+    }
+
+    auto encoded = unittest::assertGet(encodeOplogBatch(entries));
+    auto dict = encoded.firstElement().Obj()["dict"].Obj();
+    ASSERT_EQ(3, dict.nFields());
+    ASSERT_LT(encoded.objsize(), totalSize);
+}
+
+TEST(OplogBatchEncodingTest, FieldsWithUnexpectedTypesRoundTrip) {
+    // Encoded fields are recognized by name, so values which look like dictionary indexes or
+    // wall clock time deltas are not mistaken for them.
+    std::vector<BSONObj> entries{BSON("ns" << 1 << "ui"
+                                           << "notAUUID"
+                                           << "lsid" << 2 << "wall" << 5LL),
+                                 BSON("ns" << 0 << "wall" << 7)};
+
+    auto decoded = roundTrip(entries);
+    ASSERT_EQ(entries.size(), decoded.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        ASSERT(entries[i].binaryEqual(decoded[i])) << entries[i] << " != " << decoded[i];
+    }
+}
+
+TEST(OplogBatchEncodingTest, EncodingRejectsReservedFieldNames) {
+    for (auto&& name : {"$_ns", "$_ui", "$_lsid", "$_wall"}) {
+        ASSERT_EQ(ErrorCodes::BadValue,
+                  encodeOplogBatch({BSON("op"
+                                         << "n" << name << 1)})
+                      .getStatus());
+    }
+}
+
+TEST(OplogBatchEncodingTest, BuilderEncodesOnlyWhenSmaller) {
+    const auto uuid = UUID::gen();
+    const auto lsid = BSON("id" << UUID::gen());
+
+    EncodedOplogBatchBuilder builder;
+    int totalSize = 0;
+    std::vector<BSONObj> entries;
+    for (long long i = 0; i < 10; ++i) {
+        entries.push_back(makeEntry(i, "test.coll", uuid, lsid, 1000 + i));
+        builder.append(entries.back());
+        totalSize += entries.back().objsize();
+    }
+    ASSERT_EQ(totalSize, builder.bytesUsed());
+
+    auto docs = builder.done();
+    ASSERT_EQ(1U, docs.size());
+    ASSERT(isEncodedOplogBatch(docs[0]));
+    ASSERT_EQ(entries.size(), unittest::assertGet(decodeOplogBatch(docs[0])).size());
+    ASSERT_EQ(0, builder.bytesUsed());
+
+    // A single small entry grows when encoded, so it is returned as is.
+    auto entry = BSON("op"
+                      << "n"
+                      << "ns"
+                      << "");
+    builder.append(entry);
+    docs = builder.done();
+    ASSERT_EQ(1U, docs.size());
+    ASSERT_BSONOBJ_EQ(entry, docs[0]);
+
+    ASSERT(builder.done().empty());
+}
+
+TEST(OplogBatchEncodingTest, PlainOplogEntryIsNotAnEncodedBatch) {
+    auto entry = makeEntry(1, "test.a", UUID::gen(), BSONObj(), 1000);
+    ASSERT_FALSE(isEncodedOplogBatch(entry));
+    ASSERT_EQ(ErrorCodes::BadValue, decodeOplogBatch(entry).getStatus());
+}
+
+TEST(OplogBatchEncodingTest, DecodingRejectsMalformedBatches) {
+    ASSERT_EQ(ErrorCodes::BadValue,
+              decodeOplogBatch(BSON(kEncodedOplogBatchFieldName << 1)).getStatus());
+    ASSERT_EQ(ErrorCodes::BadValue,
+              decodeOplogBatch(BSON(kEncodedOplogBatchFieldName
+                                    << BSON("v" << 2 << "dict" << BSONArray() << "ops"
+                                                << BSONArray())))
+                  .getStatus());
+    ASSERT_EQ(ErrorCodes::BadValue,
+              decodeOplogBatch(BSON(kEncodedOplogBatchFieldName
+                                    << BSON("v" << 1 << "dict" << BSONArray() << "ops"
+                                                << BSON_ARRAY(BSON("$_ns" << 0)))))
+                  .getStatus());
+    ASSERT_EQ(ErrorCodes::BadValue,
+              decodeOplogBatch(BSON(kEncodedOplogBatchFieldName
+                                    << BSON("v" << 1 << "dict" << BSON_ARRAY("test.a") << "ops"
+                                                << BSON_ARRAY(BSON("$_ns" << 0LL)))))
+                  .getStatus());
+    ASSERT_EQ(ErrorCodes::BadValue,
+              decodeOplogBatch(BSON(kEncodedOplogBatchFieldName
+                                    << BSON("v" << 1 << "dict" << BSONArray() << "ops"
+                                                << BSON_ARRAY(BSON("$_wall"
+                                                                   << "x")))))
+                  .getStatus());
+}
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
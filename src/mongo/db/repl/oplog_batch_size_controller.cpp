@@ -0,0 +1,128 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_batch_size_controller.h"
+
+#include <algorithm>
+
+namespace mongo {
+namespace repl {
+namespace {
+
+// If the variance of the recent batch sizes is below this fraction of the squared mean batch size,
+// the batches are considered to all have the same size.
+constexpr double kMinRelativeVariance = 0.01;
+
+}  // namespace
+
+void OplogBatchSizeController::recordBatch(std::size_t numOps, Microseconds duration) {
+    if (numOps == 0) {
+        return;
+    }
+
+    const double ops = numOps;
+    const double micros = durationCount<Microseconds>(duration);
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _weight = _weight * kDecayFactor + 1;
+    _sumOps = _sumOps * kDecayFactor + ops;
+    _sumMicros = _sumMicros * kDecayFactor + micros;
+    _sumOpsSquared = _sumOpsSquared * kDecayFactor + ops * ops;
+    _sumOpsTimesMicros = _sumOpsTimesMicros * kDecayFactor + ops * micros;
+    ++_numSamples;
+
+    if (auto model = _fitModel(lk)) {
+        _model = model;
+        _needsProbe = false;
+    } else {
+        _needsProbe = true;
+    }
+}
+
+std::size_t OplogBatchSizeController::getTargetBatchOps(std::size_t maxOps,
+                                                        std::size_t bufferedEntries,
+                                                        Milliseconds targetLatency) const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_numSamples < kMinSamples || maxOps <= kMinBatchOps) {
+        return maxOps;
+    }
+
+    double target = maxOps;
+    if (_model) {
+        const double latencyMicros = durationCount<Microseconds>(targetLatency);
+        const double latencyBound =
+            (latencyMicros - _model->fixedCostMicros) / _model->perOpMicros;
+
+        target = latencyBound;
+        if (bufferedEntries > latencyBound) {
+            // We are falling behind. Grow the batch towards the size that amortizes the fixed
+            // cost, but not beyond what is actually buffered.
+            const double throughputBound = _model->fixedCostMicros * (1 - kMaxFixedCostFraction) /
+                (kMaxFixedCostFraction * _model->perOpMicros);
+            target = std::max(latencyBound, std::min(throughputBound, double(bufferedEntries)));
+        }
+        target = std::min(target, double(maxOps));
+    }
+
+    if (_needsProbe && _numSamples % 2) {
+        // Vary the batch size so that the next samples can tell the fixed and per-operation
+        // costs apart again.
+        target *= 1 - kProbeFraction;
+    }
+
+    target = std::max(target, double(kMinBatchOps));
+    target = std::min(target, double(maxOps));
+    return static_cast<std::size_t>(target);
+}
+
+boost::optional<OplogBatchSizeController::Model> OplogBatchSizeController::_fitModel(
+    WithLock) const {
+    const double meanOps = _sumOps / _weight;
+    const double meanMicros = _sumMicros / _weight;
+    const double varianceOps = _sumOpsSquared / _weight - meanOps * meanOps;
+    const double covariance = _sumOpsTimesMicros / _weight - meanOps * meanMicros;
+
+    if (varianceOps <= kMinRelativeVariance * meanOps * meanOps) {
+        return boost::none;
+    }
+
+    Model model;
+    model.perOpMicros = covariance / varianceOps;
+    model.fixedCostMicros = meanMicros - model.perOpMicros * meanOps;
+    if (model.perOpMicros <= 0 || model.fixedCostMicros < 0) {
+        // Noisy samples can produce a fit that makes no physical sense.
+        return boost::none;
+    }
+    return model;
+}
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,141 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstddef>
+
+#include "mongo/platform/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/duration.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Chooses the number of operations the OplogBatcher should put into the next batch from the
+ * observed cost of applying previous batches.
+ *
+ * Applying a batch costs a fixed amount (writing the truncate-after point and minValid, waiting for
+ * the writer pool to drain, journaling) plus an amount proportional to the number of operations in
+ * it. The controller fits 'duration = fixedCost + numOps * perOpCost' over an exponentially
+ * decaying window of recently applied batches and derives two candidate sizes from that model:
+ *
+ *  - the largest batch that still completes within the configured target latency, which bounds
+ *    how long majority commit waits on this node;
+ *  - the smallest batch for which the fixed cost stays a small fraction of the batch duration,
+ *    which is the size that maximizes apply throughput.
+ *
+ * When the node is keeping up, the latency bound is used. When more entries are buffered than fit
+ * in a latency-bound batch, the node is lagging and the batch may grow up to the throughput-optimal
+ * size to catch up.
+ *
+ * The fixed and per-operation costs can only be told apart when recent batches differ in size. If
+ * they stop varying, the last model that could be fitted is kept and every other target is shrunk
+ * by kProbeFraction, so that the following batches provide the variation needed for a new fit.
+ *
+ * This class is thread-safe: batches are recorded by the applier thread while the target is read
+ * by the batcher thread.
+ */
+class OplogBatchSizeController {
+    OplogBatchSizeController(const OplogBatchSizeController&) = delete;
+    OplogBatchSizeController& operator=(const OplogBatchSizeController&) = delete;
+
+public:
+    // Weight kept by the existing samples each time a new batch is recorded.
+    static constexpr double kDecayFactor = 0.9;
+
+    // Number of batches that must be observed before the model is trusted.
+    static constexpr int kMinSamples = 8;
+
+    // Fraction of a batch's duration that the fixed cost may account for in a throughput-optimal
+    // batch.
+    static constexpr double kMaxFixedCostFraction = 0.05;
+
+    // Lower bound on the computed target, so that a single slow batch cannot collapse batching.
+    static constexpr std::size_t kMinBatchOps = 16;
+
+    // Fraction by which every other target is shrunk while the batch sizes do not vary enough to
+    // fit the model.
+    static constexpr double kProbeFraction = 0.25;
+
+    OplogBatchSizeController() = default;
+
+    /**
+     * Records that a batch of 'numOps' operations took 'duration' to apply, including the per-batch
+     * bookkeeping done after the operations themselves were applied.
+     */
+    void recordBatch(std::size_t numOps, Microseconds duration);
+
+    /**
+     * Returns the number of operations to put in the next batch, never more than 'maxOps'.
+     * 'bufferedEntries' is the number of oplog entries waiting in the oplog buffer and is used as
+     * a measure of the current lag. It is a lower bound on the number of buffered operations, as
+     * an applyOps entry counts once however many operations it holds. Returns 'maxOps' until
+     * enough batches have been observed to fit the model.
+     */
+    std::size_t getTargetBatchOps(std::size_t maxOps,
+                                  std::size_t bufferedEntries,
+                                  Milliseconds targetLatency) const;
+
+private:
+    struct Model {
+        double fixedCostMicros = 0;
+        double perOpMicros = 0;
+    };
+
+    /**
+     * Solves the weighted least squares fit for the current samples. Returns boost::none if all
+     * recent batches had roughly the same size, as the fixed and per-operation costs cannot be
+     * told apart then, or if the samples are too noisy to produce a meaningful fit.
+     */
+    boost::optional<Model> _fitModel(WithLock) const;
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("OplogBatchSizeController::_mutex");
+
+    // Exponentially decayed sums over the recorded batches, used to fit the cost model.
+    double _weight = 0;
+    double _sumOps = 0;
+    double _sumMicros = 0;
+    double _sumOpsSquared = 0;
+    double _sumOpsTimesMicros = 0;
+
+    int _numSamples = 0;
+
+    // The most recent meaningful fit, kept while the batch sizes do not vary enough to refit.
+    boost::optional<Model> _model;
+
+    // Whether the last recorded batches were too alike to fit the model, in which case the targets
+    // are varied to probe the costs.
+    bool _needsProbe = false;
+};
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,165 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_batch_size_controller.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+const std::size_t kMaxOps = 5000;
+
+/**
+ * Records batches of alternating sizes whose duration follows 'fixedCost + numOps * perOpCost'.
+ */
+void recordLinearBatches(OplogBatchSizeController* controller,
+                         Microseconds fixedCost,
+                         Microseconds perOpCost,
+                         int numBatches) {
+    for (int i = 0; i < numBatches; ++i) {
+        int numOps = (i % 2) ? 100 : 1000;
+        controller->recordBatch(numOps, fixedCost + perOpCost * numOps);
+    }
+}
+
+TEST(OplogBatchSizeControllerTest, ReturnsMaxOpsBeforeEnoughSamples) {
+    OplogBatchSizeController controller;
+    ASSERT_EQ(kMaxOps, controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100)));
+
+    recordLinearBatches(
+        &controller, Milliseconds(1), Microseconds(10), OplogBatchSizeController::kMinSamples - 1);
+    ASSERT_EQ(kMaxOps, controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100)));
+}
+
+TEST(OplogBatchSizeControllerTest, IgnoresEmptyBatches) {
+    OplogBatchSizeController controller;
+    for (int i = 0; i < 2 * OplogBatchSizeController::kMinSamples; ++i) {
+        controller.recordBatch(0, Milliseconds(10));
+    }
+    ASSERT_EQ(kMaxOps, controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100)));
+}
+
+TEST(OplogBatchSizeControllerTest, LatencyBoundWhenNotLagging) {
+    OplogBatchSizeController controller;
+    recordLinearBatches(&controller, Milliseconds(10), Microseconds(30), 20);
+
+    // (100ms - 10ms) / 30us = 3000 operations.
+    auto target = controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100));
+    ASSERT_GTE(target, 2990U);
+    ASSERT_LTE(target, 3000U);
+}
+
+TEST(OplogBatchSizeControllerTest, GrowsTowardsThroughputBoundWhenLagging) {
+    OplogBatchSizeController controller;
+    recordLinearBatches(&controller, Milliseconds(10), Microseconds(30), 20);
+
+    // The latency bound is 3000 operations, but a 10ms fixed cost is only amortized down to 5% of
+    // the batch duration at 10ms * 0.95 / (0.05 * 30us) = ~6333 operations.
+    const std::size_t maxOps = 100 * 1000;
+    auto target = controller.getTargetBatchOps(maxOps, 50 * 1000, Milliseconds(100));
+    ASSERT_GT(target, 6000U);
+    ASSERT_LT(target, 6500U);
+
+    // The batch never grows beyond what is buffered.
+    ASSERT_EQ(4000U, controller.getTargetBatchOps(maxOps, 4000, Milliseconds(100)));
+
+    // Nor beyond the configured maximum.
+    ASSERT_EQ(kMaxOps, controller.getTargetBatchOps(kMaxOps, 50 * 1000, Milliseconds(100)));
+}
+
+TEST(OplogBatchSizeControllerTest, KeepsLastFitWhenBatchSizesStopVarying) {
+    OplogBatchSizeController controller;
+    recordLinearBatches(&controller, Milliseconds(10), Microseconds(30), 20);
+
+    // Once the batches all have the same size the costs cannot be refitted, but the fixed cost is
+    // not forgotten: the target stays at (100ms - 10ms) / 30us rather than 100ms / 40us.
+    for (int i = 0; i < 60; ++i) {
+        controller.recordBatch(1000, Milliseconds(40));
+    }
+    auto target = controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100));
+    ASSERT_GTE(target, 2990U);
+    ASSERT_LTE(target, 3000U);
+
+    // Every other target is shrunk to probe the costs.
+    controller.recordBatch(1000, Milliseconds(40));
+    target = controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100));
+    ASSERT_GTE(target, 2240U);
+    ASSERT_LTE(target, 2250U);
+}
+
+TEST(OplogBatchSizeControllerTest, ProbesWhenBatchSizesNeverVary) {
+    OplogBatchSizeController controller;
+    for (int i = 0; i < 20; ++i) {
+        controller.recordBatch(1000, Milliseconds(50));
+    }
+    ASSERT_EQ(kMaxOps, controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100)));
+
+    controller.recordBatch(1000, Milliseconds(50));
+    ASSERT_EQ(3750U, controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100)));
+
+    // The probed batches vary enough to fit the model: 10ms fixed cost and 40us per operation.
+    for (int i = 0; i < 40; ++i) {
+        int numOps = controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100));
+        controller.recordBatch(numOps, Milliseconds(10) + Microseconds(40) * numOps);
+    }
+    controller.recordBatch(1000, Milliseconds(50));
+    auto target = controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100));
+    ASSERT_GTE(target, 2240U);
+    ASSERT_LTE(target, 2250U);
+}
+
+TEST(OplogBatchSizeControllerTest, NeverGoesBelowMinimumBatchSize) {
+    OplogBatchSizeController controller;
+    recordLinearBatches(&controller, Milliseconds(500), Microseconds(30), 20);
+
+    // The fixed cost alone exceeds the target latency.
+    ASSERT_EQ(OplogBatchSizeController::kMinBatchOps,
+              controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100)));
+}
+
+TEST(OplogBatchSizeControllerTest, AdaptsToChangingCosts) {
+    OplogBatchSizeController controller;
+    recordLinearBatches(&controller, Milliseconds(10), Microseconds(30), 20);
+    auto before = controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100));
+
+    // Applying operations became three times as expensive.
+    recordLinearBatches(&controller, Milliseconds(10), Microseconds(90), 100);
+    auto after = controller.getTargetBatchOps(kMaxOps, 0, Milliseconds(100));
+
+    ASSERT_LT(after, before);
+    ASSERT_GTE(after, 990U);
+    ASSERT_LTE(after, 1000U);
+}
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -34,6 +34,7 @@
 #include "mongo/db/catalog_raii.h"
 #include "mongo/db/commands/txn_cmds_gen.h"
 #include "mongo/db/repl/oplog_applier.h"
+#include "mongo/db/repl/oplog_prefetcher.h"
 #include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/logv2/log.h"
 
@@ -71,6 +72,13 @@ OplogBatch OplogBatcher::getNextBatch(Seconds maxWaitTime) {
 }
 
 void OplogBatcher::startup(StorageInterface* storageInterface) {
+    // Only prefetch during steady state replication. During recovery and initial sync the
+    // collections are still being rebuilt or cloned, so lookups would mostly miss and only compete
+    // with application for the cache.
+    if (replPrefetcherThreadCount > 0 &&
+        _oplogApplier->getOptions().mode == OplogApplication::Mode::kSecondary) {
+        _prefetcher = std::make_unique<OplogPrefetcher>(replPrefetcherThreadCount);
+    }
     _thread = std::make_unique<stdx::thread>([this, storageInterface] { _run(storageInterface); });
 }
 
@@ -78,6 +86,7 @@ void OplogBatcher::shutdown() {
     if (_thread) {
         _thread->join();
         _thread.reset();
+        _prefetcher.reset();
     }
 }
 
@@ -240,6 +249,20 @@ boost::optional<Date_t> OplogBatcher::_calculateSlaveDelayLatestTimestamp() {
     return fastClockSource->now() - slaveDelay;
 }
 
+void OplogBatcher::recordAppliedBatch(std::size_t numOps, Microseconds duration) {
+    _batchSizeController.recordBatch(numOps, duration);
+}
+
+std::size_t OplogBatcher::_calculateBatchLimitOps() const {
+    auto maxOps = getBatchLimitOplogEntries();
+    if (!replBatchLimitAdaptive.load()) {
+        return maxOps;
+    }
+    // The buffer counts oplog entries rather than operations, which the controller accounts for.
+    return _batchSizeController.getTargetBatchOps(
+        maxOps, _oplogBuffer->getCount(), Milliseconds(replBatchTargetLatencyMillis.load()));
+}
+
 void OplogBatcher::_consume(OperationContext* opCtx, OplogBuffer* oplogBuffer) {
     // This is just to get the op off the buffer; it's been peeked at and queued for application
     // already.
@@ -262,7 +285,7 @@ void OplogBatcher::_run(StorageInterface* storageInterface) {
         batchLimits.slaveDelayLatestTimestamp = _calculateSlaveDelayLatestTimestamp();
 
         // Check the limits once per batch since users can change them at runtime.
-        batchLimits.ops = getBatchLimitOplogEntries();
+        batchLimits.ops = _calculateBatchLimitOps();
 
         // Use the OplogBuffer to populate a local OplogBatch. Note that the buffer may be empty.
         OplogBatch ops(batchLimits.ops);
@@ -329,6 +352,11 @@ void OplogBatcher::_run(StorageInterface* storageInterface) {
             }
         }
 
+        // Warm the cache for this batch while the applier is still working on the previous one.
+        if (_prefetcher && !ops.empty()) {
+            _prefetcher->prefetch(ops.getBatch());
+        }
+
         stdx::unique_lock<Latch> lk(_mutex);
         // Block until the previous batch has been taken.
         _cv.wait(lk, [&] { return _ops.empty() && !_ops.termWhenExhausted(); });
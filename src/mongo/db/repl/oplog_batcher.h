@@ -29,8 +29,10 @@
 
 #pragma once
 
+#include "mongo/db/repl/oplog_batch_size_controller.h"
 #include "mongo/db/repl/oplog_buffer.h"
 #include "mongo/db/repl/oplog_entry.h"
+#include "mongo/db/repl/oplog_prefetcher.h"
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/util/fail_point.h"
@@ -173,6 +175,12 @@ public:
     StatusWith<std::vector<OplogEntry>> getNextApplierBatch(OperationContext* opCtx,
                                                             const BatchLimits& batchLimits);
 
+    /**
+     * Reports how long the applier took to apply a batch of 'numOps' operations. Used to size
+     * subsequent batches when replBatchLimitAdaptive is enabled.
+     */
+    void recordAppliedBatch(std::size_t numOps, Microseconds duration);
+
     /**
      * Helper method indicating that this oplog entry must be in a batch of its own.
      */
@@ -192,6 +200,12 @@ private:
      */
     boost::optional<Date_t> _calculateSlaveDelayLatestTimestamp();
 
+    /**
+     * Returns the maximum number of operations for the next batch. This is replBatchLimitOperations
+     * unless adaptive batch sizing is enabled, in which case it may be lower.
+     */
+    std::size_t _calculateBatchLimitOps() const;
+
     /**
      * Pops the operation at the front of the OplogBuffer.
      */
@@ -202,6 +216,8 @@ private:
     OplogApplier* _oplogApplier;
     OplogBuffer* const _oplogBuffer;
 
+    OplogBatchSizeController _batchSizeController;
+
     Mutex _mutex = MONGO_MAKE_LATCH("OplogBatcher::_mutex");
     stdx::condition_variable _cv;
 
@@ -211,6 +227,11 @@ private:
     OplogBatch _ops;
 
     std::unique_ptr<stdx::thread> _thread;
+
+    // Looks up the documents targeted by each batch before it is handed to the applier. Only
+    // created when replPrefetcherThreadCount is non-zero and the applier is in steady state
+    // replication.
+    std::unique_ptr<OplogPrefetcher> _prefetcher;
 };
 
 /**
@@ -35,6 +35,8 @@
 #include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/matcher.h"
+#include "mongo/db/query/query_request.h"
+#include "mongo/db/repl/oplog_batch_encoding.h"
 #include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/replication_auth.h"
 #include "mongo/db/repl/replication_coordinator.h"
@@ -95,6 +97,13 @@ ServerStatusMetricField<Counter64> displayOpsRead("repl.network.ops", &opsReadSt
 // The bytes read via the oplog reader
 Counter64 networkByteStats;
 ServerStatusMetricField<Counter64> displayBytesRead("repl.network.bytes", &networkByteStats);
+// The documents and bytes received by the oplog reader, in which an encoded batch of oplog entries
+// is a single document
+Counter64 wireDocumentStats;
+ServerStatusMetricField<Counter64> displayWireDocumentsRead("repl.network.wireDocuments",
+                                                            &wireDocumentStats);
+Counter64 wireByteStats;
+ServerStatusMetricField<Counter64> displayWireBytesRead("repl.network.wireBytes", &wireByteStats);
 
 Counter64 readersCreatedStats;
 ServerStatusMetricField<Counter64> displayReadersCreated("repl.network.readersCreated",
@@ -517,6 +526,14 @@ BSONObj OplogFetcher::_makeFindQuery(long long findTimeout) const {
         queryBob.append("$_requestResumeToken", true);
     }
 
+    // Only ask for encoded batches once every member of the set understands the request.
+    if (oplogFetcherRequestsEncodedBatches.load() &&
+        serverGlobalParams.featureCompatibility.isVersionInitialized() &&
+        serverGlobalParams.featureCompatibility.isGreaterThanOrEqualTo(
+            ServerGlobalParams::FeatureCompatibility::kLatest)) {
+        queryBob.append(QueryRequest::kRequestEncodedOplogBatchesField, true);
+    }
+
     auto lastCommittedWithCurrentTerm =
         _dataReplicatorExternalState->getCurrentTermAndLastCommittedOpTime();
     auto term = lastCommittedWithCurrentTerm.value;
@@ -565,6 +582,8 @@ void OplogFetcher::_createNewCursor(bool initialFind) {
 
 StatusWith<OplogFetcher::Documents> OplogFetcher::_getNextBatch() {
     Documents batch;
+    _lastBatchWireDocumentCount = 0;
+    _lastBatchWireDocumentBytes = 0;
     try {
         Timer timer;
         // If it is the first batch, we should initialize the cursor, which will run the find query.
@@ -605,7 +624,18 @@ StatusWith<OplogFetcher::Documents> OplogFetcher::_getNextBatch() {
         }
 
         while (_cursor->moreInCurrentBatch()) {
-            batch.emplace_back(_cursor->nextSafe());
+            auto doc = _cursor->nextSafe();
+            ++_lastBatchWireDocumentCount;
+            _lastBatchWireDocumentBytes += doc.objsize();
+
+            // A sync source may ship several oplog entries as a single dictionary-encoded
+            // document. Expand it so the rest of the fetcher only ever sees plain oplog entries.
+            if (isEncodedOplogBatch(doc)) {
+                auto entries = uassertStatusOK(decodeOplogBatch(doc));
+                std::move(entries.begin(), entries.end(), std::back_inserter(batch));
+                continue;
+            }
+            batch.emplace_back(std::move(doc));
         }
 
         // This value is only used on a successful batch for metrics.repl.network.getmores. This
@@ -745,6 +775,9 @@ Status OplogFetcher::_onSuccessfulBatch(const Documents& documents) {
         return validateResult.getStatus();
     }
     auto info = validateResult.getValue();
+    info.wireDocumentCount = _lastBatchWireDocumentCount;
+    info.wireDocumentBytes = _lastBatchWireDocumentBytes;
+
     // If the batch is empty, set 'lastDocOpTime' to the lastFetched from the previous batch.
     auto lastDocOpTime = info.lastDocument.isNull() ? previousOpTimeFetched : info.lastDocument;
 
@@ -786,6 +819,8 @@ Status OplogFetcher::_onSuccessfulBatch(const Documents& documents) {
     // Increment stats. We read all of the docs in the query.
     opsReadStats.increment(info.networkDocumentCount);
     networkByteStats.increment(info.networkDocumentBytes);
+    wireDocumentStats.increment(info.wireDocumentCount);
+    wireByteStats.increment(info.wireDocumentBytes);
 
     oplogBatchStats.recordMillis(_lastBatchElapsedMS, documents.empty());
 
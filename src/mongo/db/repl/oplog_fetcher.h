@@ -112,6 +112,10 @@ public:
     struct DocumentsInfo {
         size_t networkDocumentCount = 0;
         size_t networkDocumentBytes = 0;
+        // The documents as they were received from the sync source, in which an encoded batch is
+        // a single document. The same as the network counts when no batch was encoded.
+        size_t wireDocumentCount = 0;
+        size_t wireDocumentBytes = 0;
         size_t toApplyDocumentCount = 0;
         size_t toApplyDocumentBytes = 0;
         OpTime lastDocument = OpTime();
@@ -456,6 +460,11 @@ private:
     executor::TaskExecutor::CallbackHandle _runQueryHandle;
 
     int _lastBatchElapsedMS = 0;
+
+    // The number and total size of the documents received in the last batch, before encoded
+    // batches were expanded.
+    size_t _lastBatchWireDocumentCount = 0;
+    size_t _lastBatchWireDocumentBytes = 0;
 };
 
 class OplogFetcherFactory {
@@ -29,7 +29,10 @@
 
 #include <memory>
 
+#include "mongo/db/commands/server_status_internal.h"
+#include "mongo/db/query/query_request.h"
 #include "mongo/db/repl/data_replicator_external_state_mock.h"
+#include "mongo/db/repl/oplog_batch_encoding.h"
 #include "mongo/db/repl/oplog_fetcher.h"
 #include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/task_executor_mock.h"
@@ -121,6 +124,13 @@ BSONObj makeOplogBatchMetadata(boost::optional<const rpc::ReplSetMetadata&> repl
     return bob.obj();
 }
 
+long long getNetworkMetric(StringData name) {
+    BSONObjBuilder bob;
+    MetricTree::theMetricTree->appendTo(bob);
+    auto metrics = bob.obj();
+    return metrics["metrics"]["repl"]["network"][name].numberLong();
+}
+
 Message makeFirstBatch(CursorId cursorId,
                        const OplogFetcher::Documents& oplogEntries,
                        const BSONObj& metadata) {
@@ -823,6 +833,22 @@ TEST_F(OplogFetcherTest,
     ASSERT_FALSE(queryObj.hasField("term"));
 }
 
+TEST_F(OplogFetcherTest, FindQueryRequestsEncodedOplogBatchesOnlyOnLatestFCV) {
+    auto oplogFetcher = makeOplogFetcher();
+    auto findTimeout = durationCount<Milliseconds>(oplogFetcher->getInitialFindMaxTime_forTest());
+
+    serverGlobalParams.mutableFeatureCompatibility.setVersion(
+        ServerGlobalParams::FeatureCompatibility::kLastLTS);
+    ON_BLOCK_EXIT([] { serverGlobalParams.mutableFeatureCompatibility.reset(); });
+    auto queryObj = oplogFetcher->getFindQuery_forTest(findTimeout);
+    ASSERT_FALSE(queryObj.hasField(QueryRequest::kRequestEncodedOplogBatchesField));
+
+    serverGlobalParams.mutableFeatureCompatibility.setVersion(
+        ServerGlobalParams::FeatureCompatibility::kLatest);
+    queryObj = oplogFetcher->getFindQuery_forTest(findTimeout);
+    ASSERT_TRUE(queryObj[QueryRequest::kRequestEncodedOplogBatchesField].trueValue());
+}
+
 TEST_F(
     OplogFetcherTest,
     GetMoreQueryDoesNotContainTermIfGetCurrentTermAndLastCommittedOpTimeReturnsUninitializedTerm) {
@@ -1778,6 +1804,65 @@ TEST_F(OplogFetcherTest, OplogFetcherShouldExcludeFirstDocumentInFirstBatchWhenE
     ASSERT_EQUALS(ErrorCodes::CallbackCanceled, shutdownState->getStatus());
 }
 
+TEST_F(OplogFetcherTest, OplogFetcherShouldExpandEncodedOplogBatches) {
+    CursorId cursorId = 22LL;
+    auto firstEntry = makeNoopOplogEntry(lastFetched);
+    auto secondEntry = makeNoopOplogEntry({{Seconds(456), 0}, lastFetched.getTerm()});
+    auto thirdEntry = makeNoopOplogEntry({{Seconds(789), 0}, lastFetched.getTerm()});
+    auto metadataObj = makeOplogBatchMetadata(replSetMetadata, oqMetadata);
+
+    auto encodedEntries = unittest::assertGet(encodeOplogBatch({secondEntry, thirdEntry}));
+
+    auto shutdownState = processSingleBatch(
+        makeFirstBatch(cursorId, {firstEntry, encodedEntries}, metadataObj),
+        true /* shouldShutdown */,
+        true /* requireFresherSyncSource */,
+        true /* lastFetchedShouldAdvance */);
+
+    ASSERT_EQUALS(2U, lastEnqueuedDocuments.size());
+    ASSERT_BSONOBJ_EQ(secondEntry, lastEnqueuedDocuments[0]);
+    ASSERT_BSONOBJ_EQ(thirdEntry, lastEnqueuedDocuments[1]);
+    ASSERT_EQUALS(3U, lastEnqueuedDocumentsInfo.networkDocumentCount);
+    ASSERT_EQUALS(size_t(firstEntry.objsize() + secondEntry.objsize() + thirdEntry.objsize()),
+                  lastEnqueuedDocumentsInfo.networkDocumentBytes);
+    ASSERT_EQUALS(2U, lastEnqueuedDocumentsInfo.wireDocumentCount);
+    ASSERT_EQUALS(size_t(firstEntry.objsize() + encodedEntries.objsize()),
+                  lastEnqueuedDocumentsInfo.wireDocumentBytes);
+    ASSERT_EQUALS(unittest::assertGet(OpTime::parseFromOplogEntry(thirdEntry)),
+                  lastEnqueuedDocumentsInfo.lastDocument);
+
+    ASSERT_EQUALS(ErrorCodes::CallbackCanceled, shutdownState->getStatus());
+}
+
+TEST_F(OplogFetcherTest, OplogFetcherShouldCountEachEntryOfEncodedOplogBatchesInOpsMetric) {
+    CursorId cursorId = 22LL;
+    auto firstEntry = makeNoopOplogEntry(lastFetched);
+    auto secondEntry = makeNoopOplogEntry({{Seconds(456), 0}, lastFetched.getTerm()});
+    auto thirdEntry = makeNoopOplogEntry({{Seconds(789), 0}, lastFetched.getTerm()});
+    auto metadataObj = makeOplogBatchMetadata(replSetMetadata, oqMetadata);
+
+    auto encodedEntries = unittest::assertGet(encodeOplogBatch({secondEntry, thirdEntry}));
+
+    auto opsBefore = getNetworkMetric("ops");
+    auto bytesBefore = getNetworkMetric("bytes");
+    auto wireDocumentsBefore = getNetworkMetric("wireDocuments");
+    auto wireBytesBefore = getNetworkMetric("wireBytes");
+
+    auto shutdownState = processSingleBatch(
+        makeFirstBatch(cursorId, {firstEntry, encodedEntries}, metadataObj),
+        true /* shouldShutdown */,
+        true /* requireFresherSyncSource */,
+        true /* lastFetchedShouldAdvance */);
+    ASSERT_EQUALS(ErrorCodes::CallbackCanceled, shutdownState->getStatus());
+
+    ASSERT_EQUALS(3, getNetworkMetric("ops") - opsBefore);
+    ASSERT_EQUALS(firstEntry.objsize() + secondEntry.objsize() + thirdEntry.objsize(),
+                  getNetworkMetric("bytes") - bytesBefore);
+    ASSERT_EQUALS(2, getNetworkMetric("wireDocuments") - wireDocumentsBefore);
+    ASSERT_EQUALS(firstEntry.objsize() + encodedEntries.objsize(),
+                  getNetworkMetric("wireBytes") - wireBytesBefore);
+}
+
 TEST_F(OplogFetcherTest,
        OplogFetcherShouldNotDuplicateFirstDocWithEnqueueFirstDocOnErrorAfterFirstDoc) {
 
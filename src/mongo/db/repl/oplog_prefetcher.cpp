@@ -0,0 +1,195 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_prefetcher.h"
+
+#include <algorithm>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/dbhelpers.h"
+#include "mongo/db/repl/oplog_applier.h"
+#include "mongo/db/stats/timer_stats.h"
+#include "mongo/util/fail_point.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+MONGO_FAIL_POINT_DEFINE(hangBeforeOplogPrefetchLookup);
+
+// Documents looked up ahead of application, and how many of them were found.
+Counter64 prefetchLookups;
+ServerStatusMetricField<Counter64> displayPrefetchLookups("repl.apply.prefetch.lookups",
+                                                          &prefetchLookups);
+Counter64 prefetchFound;
+ServerStatusMetricField<Counter64> displayPrefetchFound("repl.apply.prefetch.found",
+                                                        &prefetchFound);
+
+// Batches not prefetched because the lookups for the previous batch were still running.
+Counter64 prefetchSkippedBatches;
+ServerStatusMetricField<Counter64> displayPrefetchSkippedBatches(
+    "repl.apply.prefetch.skippedBatches", &prefetchSkippedBatches);
+
+// Number and time of prefetch rounds, one per prefetched batch.
+TimerStats prefetchBatchStats;
+ServerStatusMetricField<TimerStats> displayPrefetchBatches("repl.apply.prefetch.batches",
+                                                           &prefetchBatchStats);
+
+/**
+ * A document to look up. Holds its own copy of the target, as the batch it was taken from may be
+ * applied and destroyed before the lookup runs.
+ */
+struct Lookup {
+    NamespaceStringOrUUID nsOrUUID;
+    BSONObj idQuery;
+};
+
+/**
+ * The lookups for one batch, shared by the pool tasks that perform them.
+ */
+struct PrefetchRound {
+    std::vector<Lookup> lookups;
+    Timer timer;
+};
+
+bool shouldPrefetch(const OplogEntry& entry) {
+    auto opType = entry.getOpType();
+    return (opType == OpTypeEnum::kUpdate || opType == OpTypeEnum::kDelete) &&
+        !entry.getIdElement().eoo();
+}
+
+Lookup makeLookup(const OplogEntry& entry) {
+    const auto& nss = entry.getNss();
+    auto uuid = entry.getUuid();
+    return {uuid ? NamespaceStringOrUUID(nss.db().toString(), *uuid) : NamespaceStringOrUUID(nss),
+            entry.getIdElement().wrap()};
+}
+
+void prefetchDocument(OperationContext* opCtx, const Lookup& lookup) {
+    hangBeforeOplogPrefetchLookup.pauseWhileSet();
+
+    // Batch application holds the ParallelBatchWriterMode lock in MODE_X while the writers run,
+    // which is exactly when the next batch should be prefetched. The lookup only warms the cache,
+    // so it has no need for the consistent view that lock protects.
+    ShouldNotConflictWithSecondaryBatchApplicationBlock noPBWMBlock(opCtx->lockState());
+    AutoGetCollection coll(opCtx, lookup.nsOrUUID, MODE_IS);
+    if (!coll) {
+        return;
+    }
+
+    prefetchLookups.increment();
+    auto recordId = Helpers::findById(opCtx, *coll, lookup.idQuery);
+    if (recordId.isNull()) {
+        return;
+    }
+
+    Snapshotted<BSONObj> doc;
+    if (coll->findDoc(opCtx, recordId, &doc)) {
+        prefetchFound.increment();
+    }
+}
+
+}  // namespace
+
+OplogPrefetcher::OplogPrefetcher(int threadCount)
+    : _threadCount(threadCount), _pool(makeReplWriterPool(threadCount, "ReplPrefetcher")) {}
+
+OplogPrefetcher::~OplogPrefetcher() {
+    _pool->shutdown();
+    _pool->join();
+}
+
+void OplogPrefetcher::prefetch(const std::vector<OplogEntry>& batch) {
+    if (_pendingTasks.load() > 0) {
+        // Still looking up the previous batch. Falling further behind the applier would only warm
+        // the cache for operations that have already been applied.
+        prefetchSkippedBatches.increment();
+        return;
+    }
+
+    auto round = std::make_shared<PrefetchRound>();
+    for (const auto& entry : batch) {
+        if (shouldPrefetch(entry)) {
+            round->lookups.push_back(makeLookup(entry));
+        }
+    }
+    if (round->lookups.empty()) {
+        return;
+    }
+
+    // Spread the lookups round-robin across the pool. The last task to finish records the round.
+    const int numTasks = std::min<std::size_t>(_threadCount, round->lookups.size());
+    _pendingTasks.store(numTasks);
+    for (int task = 0; task < numTasks; ++task) {
+        _pool->schedule([this, round, task, numTasks](auto status) {
+            ON_BLOCK_EXIT([&] {
+                if (_pendingTasks.subtractAndFetch(1) == 0) {
+                    prefetchBatchStats.record(round->timer);
+                }
+            });
+            if (!status.isOK()) {
+                return;
+            }
+
+            auto opCtx = cc().makeOperationContext();
+            opCtx->setShouldParticipateInFlowControl(false);
+            for (std::size_t i = task; i < round->lookups.size(); i += numTasks) {
+                try {
+                    prefetchDocument(opCtx.get(), round->lookups[i]);
+                } catch (const DBException&) {
+                    // Prefetching is only an optimization; the writer will surface any real error.
+                }
+                opCtx->recoveryUnit()->abandonSnapshot();
+            }
+        });
+    }
+}
+
+void OplogPrefetcher::waitForIdle_forTest() {
+    _pool->waitForIdle();
+}
+
+OplogPrefetcher::Stats OplogPrefetcher::getStats_forTest() {
+    Stats stats;
+    stats.lookups = prefetchLookups.get();
+    stats.found = prefetchFound.get();
+    stats.skippedBatches = prefetchSkippedBatches.get();
+    return stats;
+}
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,98 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mongo/db/repl/oplog_entry.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/thread_pool.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Warms the storage engine cache ahead of oplog application.
+ *
+ * Writer threads apply updates and deletes by looking up the target document by _id, and on data
+ * sets much larger than the cache each of those lookups may stall on a read from disk. The
+ * OplogBatcher hands each batch to the prefetcher before publishing it to the applier, so the
+ * prefetcher can look up the target documents of the next batch concurrently, on its own threads,
+ * while the writers are still applying the previous one.
+ *
+ * Prefetching is best effort. prefetch() only schedules the lookups and never waits for them, and
+ * at most one batch is looked up at a time: a batch handed over while the lookups for the previous
+ * one are still running is skipped. Lookups do not conflict with the ParallelBatchWriterMode lock
+ * held by batch application, and any error, including a collection that does not exist yet
+ * because it is created by an earlier unapplied batch, simply skips the operation.
+ */
+class OplogPrefetcher {
+    OplogPrefetcher(const OplogPrefetcher&) = delete;
+    OplogPrefetcher& operator=(const OplogPrefetcher&) = delete;
+
+public:
+    struct Stats {
+        long long lookups = 0;
+        long long found = 0;
+        long long skippedBatches = 0;
+    };
+
+    explicit OplogPrefetcher(int threadCount);
+    ~OplogPrefetcher();
+
+    /**
+     * Schedules lookups of the documents targeted by the updates and deletes in 'batch' and
+     * returns without waiting for them. Does nothing if the lookups for the previous batch have
+     * not completed yet.
+     */
+    void prefetch(const std::vector<OplogEntry>& batch);
+
+    /**
+     * Waits for all scheduled lookups to complete.
+     */
+    void waitForIdle_forTest();
+
+    /**
+     * Returns the process-wide prefetch counters reported in serverStatus.
+     */
+    static Stats getStats_forTest();
+
+private:
+    const int _threadCount;
+
+    // Number of pool tasks still looking up documents for the current batch.
+    AtomicWord<int> _pendingTasks{0};
+
+    std::unique_ptr<ThreadPool> _pool;
+};
+
+}  // namespace repl
+}  // namespace mongo
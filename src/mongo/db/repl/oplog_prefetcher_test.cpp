@@ -0,0 +1,117 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/repl/oplog_applier_impl_test_fixture.h"
+#include "mongo/db/repl/oplog_entry_test_helpers.h"
+#include "mongo/db/repl/oplog_prefetcher.h"
+#include "mongo/db/repl/storage_interface.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/fail_point.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+class OplogPrefetcherTest : public OplogApplierImplTest {
+protected:
+    void setUp() override {
+        OplogApplierImplTest::setUp();
+        createCollection(_opCtx.get(), _nss, {});
+        ASSERT_OK(getStorageInterface()->insertDocument(
+            _opCtx.get(), _nss, {BSON("_id" << 0 << "x" << 1)}, 0));
+    }
+
+    std::vector<OplogEntry> makeBatch() {
+        return {makeInsertDocumentOplogEntry(nextOpTime(), _nss, BSON("_id" << 1)),
+                makeUpdateDocumentOplogEntry(
+                    nextOpTime(), _nss, BSON("_id" << 0), BSON("$set" << BSON("x" << 2))),
+                makeDeleteDocumentOplogEntry(nextOpTime(), _nss, BSON("_id" << 2))};
+    }
+
+    const NamespaceString _nss{"test.prefetch"};
+};
+
+TEST_F(OplogPrefetcherTest, LooksUpUpdatesAndDeletes) {
+    OplogPrefetcher prefetcher(2);
+    auto before = OplogPrefetcher::getStats_forTest();
+
+    prefetcher.prefetch(makeBatch());
+    prefetcher.waitForIdle_forTest();
+
+    // The insert is not looked up, and only the updated document exists.
+    auto after = OplogPrefetcher::getStats_forTest();
+    ASSERT_EQ(before.lookups + 2, after.lookups);
+    ASSERT_EQ(before.found + 1, after.found);
+}
+
+TEST_F(OplogPrefetcherTest, IgnoresMissingCollections) {
+    OplogPrefetcher prefetcher(2);
+    auto before = OplogPrefetcher::getStats_forTest();
+
+    NamespaceString missingNss("test.missing");
+    prefetcher.prefetch({makeDeleteDocumentOplogEntry(nextOpTime(), missingNss, BSON("_id" << 0))});
+    prefetcher.waitForIdle_forTest();
+
+    auto after = OplogPrefetcher::getStats_forTest();
+    ASSERT_EQ(before.lookups, after.lookups);
+    ASSERT_EQ(before.found, after.found);
+}
+
+TEST_F(OplogPrefetcherTest, DoesNotConflictWithBatchApplication) {
+    OplogPrefetcher prefetcher(2);
+    auto before = OplogPrefetcher::getStats_forTest();
+
+    // Batch application holds the ParallelBatchWriterMode lock exclusively while it runs.
+    Lock::ParallelBatchWriterMode pbwm(_opCtx->lockState());
+    prefetcher.prefetch(makeBatch());
+    prefetcher.waitForIdle_forTest();
+
+    auto after = OplogPrefetcher::getStats_forTest();
+    ASSERT_EQ(before.found + 1, after.found);
+}
+
+TEST_F(OplogPrefetcherTest, SkipsBatchWhilePreviousBatchIsStillLookedUp) {
+    OplogPrefetcher prefetcher(2);
+    auto before = OplogPrefetcher::getStats_forTest();
+
+    // prefetch() returns while the lookups are still blocked.
+    FailPointEnableBlock fp("hangBeforeOplogPrefetchLookup");
+    prefetcher.prefetch(makeBatch());
+    fp->waitForTimesEntered(fp.initialTimesEntered() + 1);
+
+    prefetcher.prefetch(makeBatch());
+    ASSERT_EQ(before.skippedBatches + 1, OplogPrefetcher::getStats_forTest().skippedBatches);
+}
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -64,11 +64,17 @@ namespace {
 const auto kRecoveryBatchLogLevel = logv2::LogSeverity::Debug(2);
 const auto kRecoveryOperationLogLevel = logv2::LogSeverity::Debug(3);
 
+// How often to report the progress of a long running oplog replay.
+const auto kRecoveryProgressLogIntervalSecs = 10;
+
 /**
  * Tracks and logs operations applied during recovery.
  */
 class RecoveryOplogApplierStats : public OplogApplier::Observer {
 public:
+    RecoveryOplogApplierStats(Timestamp startPoint, Timestamp endPoint)
+        : _startPoint(startPoint), _endPoint(endPoint) {}
+
     void onBatchBegin(const std::vector<OplogEntry>& batch) final {
         _numBatches++;
         LOGV2_FOR_RECOVERY(24098,
@@ -102,7 +108,14 @@ public:
         }
     }
 
-    void onBatchEnd(const StatusWith<OpTime>&, const std::vector<OplogEntry>&) final {}
+    void onBatchEnd(const StatusWith<OpTime>& lastApplied, const std::vector<OplogEntry>&) final {
+        if (!lastApplied.isOK() ||
+            _sinceLastProgressLog.seconds() < kRecoveryProgressLogIntervalSecs) {
+            return;
+        }
+        _sinceLastProgressLog.reset();
+        _logProgress(lastApplied.getValue().getTimestamp());
+    }
 
     void complete(const OpTime& applyThroughOpTime) const {
         LOGV2(21536,
@@ -115,6 +128,39 @@ public:
     }
 
 private:
+    /**
+     * Estimates how much of the replay is left from how far 'lastApplied' has advanced between the
+     * start and end points. This assumes a uniform rate of writes over that range of the oplog,
+     * which is good enough to tell a stalled replay from one that is about to finish.
+     */
+    void _logProgress(Timestamp lastApplied) const {
+        const double totalSecs = double(_endPoint.getSecs()) - _startPoint.getSecs();
+        const double appliedSecs = double(lastApplied.getSecs()) - _startPoint.getSecs();
+        if (totalSecs <= 0 || appliedSecs <= 0) {
+            return;
+        }
+
+        const double fractionApplied = std::min(appliedSecs / totalSecs, 1.0);
+        const double remainingRatio = (1 - fractionApplied) / fractionApplied;
+        LOGV2(5338700,
+              "Oplog application for recovery in progress",
+              "numOpsApplied"_attr = _numOpsApplied,
+              "numBatches"_attr = _numBatches,
+              "lastAppliedTimestamp"_attr = lastApplied,
+              "endPoint"_attr = _endPoint,
+              "percentComplete"_attr = static_cast<int>(fractionApplied * 100),
+              "estimatedOpsRemaining"_attr =
+                  static_cast<long long>(_numOpsApplied * remainingRatio),
+              "estimatedTimeRemaining"_attr =
+                  Seconds(static_cast<long long>(_elapsed.seconds() * remainingRatio)));
+    }
+
+    const Timestamp _startPoint;
+    const Timestamp _endPoint;
+
+    Timer _elapsed;
+    Timer _sinceLastProgressLog;
+
     std::size_t _numBatches = 0;
     std::size_t _numOpsApplied = 0;
 };
@@ -589,7 +635,7 @@ Timestamp ReplicationRecoveryImpl::_applyOplogOperations(OperationContext* opCtx
     OplogBufferLocalOplog oplogBuffer(startPoint, endPoint);
     oplogBuffer.startup(opCtx);
 
-    RecoveryOplogApplierStats stats;
+    RecoveryOplogApplierStats stats(startPoint, endPoint);
 
     auto writerPool = makeReplWriterPool();
     OplogApplierImpl oplogApplier(nullptr,
@@ -600,6 +600,12 @@ void ShardServerCatalogCacheLoader::waitForDatabaseFlush(OperationContext* opCtx
     }
 }
 
+void ShardServerCatalogCacheLoader::reportStats(BSONObjBuilder* builder) const {
+    // Only the primary loads from the config server. Secondaries wait for the primary to persist
+    // its refreshes, which are coalesced there by its CatalogCache.
+    _configServerLoader->reportStats(builder);
+}
+
 StatusWith<CollectionAndChangedChunks> ShardServerCatalogCacheLoader::_runSecondaryGetChunksSince(
     OperationContext* opCtx,
     const NamespaceString& nss,
@@ -86,6 +86,8 @@ public:
 
     void waitForDatabaseFlush(OperationContext* opCtx, StringData dbName) override;
 
+    void reportStats(BSONObjBuilder* builder) const override;
+
 private:
     // Differentiates the server's role in the replica set so that the chunk loader knows whether to
     // load metadata locally or remotely.
@@ -98,6 +98,7 @@ struct ServerGlobalParams {
 
     bool logAppend = false;         // True if logging to a file in append mode.
     bool logRenameOnRotate = true;  // True if logging should rename log files on rotate
+    bool logAsyncWrites = false;    // True if the log file is written from a background thread.
     bool logWithSyslog = false;     // True if logging to syslog; must not be set if logpath is set.
     int syslogFacility;             // Facility used when appending messages to the syslog.
 
@@ -381,6 +381,11 @@ Status storeBaseOptions(const moe::Environment& params) {
         serverGlobalParams.logAppend = true;
     }
 
+    if (params.count("systemLog.asyncWrites") &&
+        params["systemLog.asyncWrites"].as<bool>() == true) {
+        serverGlobalParams.logAsyncWrites = true;
+    }
+
     if (params.count("systemLog.logRotate")) {
         std::string logRotateParam = params["systemLog.logRotate"].as<string>();
         if (logRotateParam == "reopen") {
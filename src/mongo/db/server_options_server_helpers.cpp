@@ -51,6 +51,7 @@
 #include "mongo/logv2/log.h"
 #include "mongo/logv2/log_component.h"
 #include "mongo/transport/message_compressor_registry.h"
+#include "mongo/transport/message_compressor_zstd.h"
 #include "mongo/util/cmdline_utils/censor_cmdline.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/net/sock.h"
@@ -450,6 +451,19 @@ Status storeServerOptions(const moe::Environment& params) {
         }
     }
 
+    if (params.count("net.compression.zstdDictionaryFile")) {
+        const auto ret = storeZstdMessageCompressionDictionaryFile(
+            params["net.compression.zstdDictionaryFile"].as<string>());
+        if (!ret.isOK()) {
+            return ret;
+        }
+    }
+
+    if (params.count("net.compression.streaming")) {
+        MessageCompressorRegistry::get().setStreamingEnabled(
+            params["net.compression.streaming"].as<bool>());
+    }
+
     return Status::OK();
 }
 
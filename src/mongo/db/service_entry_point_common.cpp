@@ -1835,6 +1835,7 @@ DbResponse makeCommandResponse(std::shared_ptr<HandleRequest::ExecutionContext>
         if (responseObj.getField("ok").trueValue()) {
             dbResponse.shouldRunAgainForExhaust = replyBuilder->shouldRunAgainForExhaust();
             dbResponse.nextInvocation = replyBuilder->getNextInvocation();
+            dbResponse.canDeferExhaustReply = replyBuilder->canDeferExhaustReply();
         }
     }
 
@@ -44,6 +44,7 @@
 #include "mongo/util/assert_util.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/destructor_guard.h"
+#include "mongo/util/fail_point.h"
 #include "mongo/util/hierarchical_acquisition.h"
 #include "mongo/util/lru_cache.h"
 #include "mongo/util/scopeguard.h"
@@ -51,7 +52,7 @@
 using namespace fmt::literals;
 
 // One interesting implementation note herein concerns how setup() and
-// refresh() are invoked outside of the global lock, but setTimeout is not.
+// refresh() are invoked outside of the specific pool's lock, but setTimeout is not.
 // This implementation detail simplifies mocks, allowing them to return
 // synchronously sometimes, whereas having timeouts fire instantly adds little
 // value. In practice, dumping the locks is always safe (because we restrict
@@ -88,6 +89,9 @@ bool shouldInvariantOnPoolCorrectness() noexcept {
 
 namespace executor {
 
+MONGO_FAIL_POINT_DEFINE(connectionPoolHangBeforeLockingPool);
+MONGO_FAIL_POINT_DEFINE(connectionPoolHangBeforeUpdatingHostGroup);
+
 void ConnectionPool::ConnectionInterface::indicateUsed() {
     // It is illegal to attempt to use a connection after calling indicateFailure().
     invariant(_status.isOK() || _status == ConnectionPool::kConnectionStateUnknown);
@@ -226,7 +230,7 @@ class ConnectionPool::SpecificPool final
 
 public:
     /**
-     * Whenever a function enters a specific pool, the function needs to be guarded by the lock.
+     * Whenever a function enters a specific pool, the function needs to be guarded by its lock.
      *
      * This callback also (perhaps overly aggressively) binds a shared pointer to the guard.
      * It is *always* safe to reference the original specific pool in the guarded function object.
@@ -241,7 +245,7 @@ public:
     auto guardCallback(Callback&& cb) {
         return
             [this, cb = std::forward<Callback>(cb), anchor = shared_from_this()](auto&&... args) {
-                stdx::lock_guard lk(_parent->_mutex);
+                stdx::lock_guard lk(_mutex);
                 cb(std::forward<decltype(args)>(args)...);
                 updateState();
             };
@@ -253,12 +257,26 @@ public:
     ~SpecificPool();
 
     /**
-     * Create and initialize a SpecificPool
+     * Create and register a SpecificPool. The parent's mutex must be held. Its timers and health
+     * are initialized by the first call to updateState().
      */
     static auto make(std::shared_ptr<ConnectionPool> parent,
                      const HostAndPort& hostAndPort,
                      transport::ConnectSSLMode sslMode);
 
+    /**
+     * Locks this pool. All of the state of a specific pool is guarded by its own mutex, so that
+     * requests to different hosts do not contend. It must be acquired before the parent's mutex if
+     * both are held, and no two specific pools may be locked at once.
+     */
+    stdx::unique_lock<Latch> lock() {
+        return stdx::unique_lock<Latch>(_mutex);
+    }
+
+    bool isShutdown() const {
+        return _health.isShutdown;
+    }
+
     /**
      * Triggers a controller update, potentially changes the request timer,
      * and maybe delists from pool
@@ -273,6 +291,12 @@ public:
      */
     Future<ConnectionHandle> getConnection(Milliseconds timeout);
 
+    /**
+     * Triggers shutdown if the pool is expired. Called when the controller reports that the host
+     * group of this pool can shutdown.
+     */
+    void shutdownIfExpired();
+
     /**
      * Triggers the shutdown procedure. This function sets isShutdown to true
      * and calls processFailure below with the status provided. This immediately removes this pool
@@ -390,12 +414,16 @@ private:
     // Update the event timer for this host pool
     void updateEventTimer();
 
-    // Update the controller and potentially change the controls
-    void updateController();
+    // Update the controller and potentially change the controls. Returns the other hosts in the
+    // group of this pool, which must be updated without holding this pool's lock.
+    HostGroupState updateController();
 
 private:
     const std::shared_ptr<ConnectionPool> _parent;
 
+    mutable Mutex _mutex = MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(2),
+                                            "ExecutorConnectionPool::SpecificPool::_mutex");
+
     const transport::ConnectSSLMode _sslMode;
     const HostAndPort _hostAndPort;
 
@@ -440,10 +468,6 @@ auto ConnectionPool::SpecificPool::make(std::shared_ptr<ConnectionPool> parent,
 
     // Inform the controller that we exist
     controller.addHost(pool->_id, hostAndPort);
-
-    // Set our timers and health
-    pool->updateEventTimer();
-    pool->updateHealth();
     return pool;
 }
 
@@ -479,37 +503,51 @@ ConnectionPool::~ConnectionPool() {
 void ConnectionPool::shutdown() {
     _factory->shutdown();
 
-    // Grab all current pools (under the lock)
+    // Grab all current pools (under the lock), and make sure that no more are created
     auto pools = [&] {
         stdx::lock_guard lk(_mutex);
+        _isShutDown = true;
         return _pools;
     }();
 
     for (const auto& pair : pools) {
-        stdx::lock_guard lk(_mutex);
+        auto lk = pair.second->lock();
         pair.second->triggerShutdown(
             Status(ErrorCodes::ShutdownInProgress, "Shutting down the connection pool"));
     }
 }
 
-void ConnectionPool::dropConnections(const HostAndPort& hostAndPort) {
+std::shared_ptr<ConnectionPool::SpecificPool> ConnectionPool::_findPool(
+    const HostAndPort& hostAndPort) const {
     stdx::lock_guard lk(_mutex);
 
     auto iter = _pools.find(hostAndPort);
+    if (iter == _pools.end()) {
+        return nullptr;
+    }
 
-    if (iter == _pools.end())
+    return iter->second;
+}
+
+void ConnectionPool::dropConnections(const HostAndPort& hostAndPort) {
+    auto pool = _findPool(hostAndPort);
+    if (!pool)
         return;
 
-    auto& pool = iter->second;
+    auto lk = pool->lock();
     pool->triggerShutdown(
         Status(ErrorCodes::PooledConnectionsDropped, "Pooled connections dropped"));
 }
 
 void ConnectionPool::dropConnections(transport::Session::TagMask tags) {
-    stdx::lock_guard lk(_mutex);
+    auto pools = [&] {
+        stdx::lock_guard lk(_mutex);
+        return _pools;
+    }();
 
-    for (const auto& pair : _pools) {
+    for (const auto& pair : pools) {
         auto& pool = pair.second;
+        auto lk = pool->lock();
 
         if (pool->matchesTags(tags))
             continue;
@@ -522,14 +560,11 @@ void ConnectionPool::dropConnections(transport::Session::TagMask tags) {
 void ConnectionPool::mutateTags(
     const HostAndPort& hostAndPort,
     const std::function<transport::Session::TagMask(transport::Session::TagMask)>& mutateFunc) {
-    stdx::lock_guard lk(_mutex);
-
-    auto iter = _pools.find(hostAndPort);
-
-    if (iter == _pools.end())
+    auto pool = _findPool(hostAndPort);
+    if (!pool)
         return;
 
-    auto pool = iter->second;
+    auto lk = pool->lock();
     pool->mutateTags(mutateFunc);
 }
 
@@ -548,7 +583,34 @@ void ConnectionPool::get_forTest(const HostAndPort& hostAndPort,
 SemiFuture<ConnectionPool::ConnectionHandle> ConnectionPool::get(const HostAndPort& hostAndPort,
                                                                  transport::ConnectSSLMode sslMode,
                                                                  Milliseconds timeout) {
+    while (true) {
+        auto pool = _getOrMakePool(hostAndPort, sslMode);
+        if (!pool) {
+            return SemiFuture<ConnectionHandle>::makeReady(
+                Status(ErrorCodes::ShutdownInProgress, "Connection pool has been shut down"));
+        }
+
+        connectionPoolHangBeforeLockingPool.pauseWhileSet();
+
+        auto lk = pool->lock();
+        if (pool->isShutdown()) {
+            // The pool was delisted between finding it and locking it, so look for its successor.
+            continue;
+        }
+
+        auto connFuture = pool->getConnection(timeout);
+        pool->updateState();
+
+        return std::move(connFuture).semi();
+    }
+}
+
+std::shared_ptr<ConnectionPool::SpecificPool> ConnectionPool::_getOrMakePool(
+    const HostAndPort& hostAndPort, transport::ConnectSSLMode sslMode) {
     stdx::lock_guard lk(_mutex);
+    if (_isShutDown) {
+        return nullptr;
+    }
 
     auto& pool = _pools[hostAndPort];
     if (!pool) {
@@ -557,21 +619,60 @@ SemiFuture<ConnectionPool::ConnectionHandle> ConnectionPool::get(const HostAndPo
         pool->fassertSSLModeIs(sslMode);
     }
 
-    invariant(pool);
+    return pool;
+}
+
+void ConnectionPool::_updateHostGroup(const HostGroupState& hostGroup,
+                                      transport::ConnectSSLMode sslMode) {
+    connectionPoolHangBeforeUpdatingHostGroup.pauseWhileSet();
+
+    for (const auto& host : hostGroup.hosts) {
+        // Either find the pool to expire, or make sure that the related host exists. Once the
+        // ConnectionPool is shut down, its pools are already gone and no new ones may be made.
+        auto pool = [&]() -> std::shared_ptr<SpecificPool> {
+            stdx::lock_guard lk(_mutex);
+            if (_isShutDown) {
+                return nullptr;
+            }
+
+            if (hostGroup.canShutdown) {
+                auto iter = _pools.find(host);
+                return iter == _pools.end() ? nullptr : iter->second;
+            }
 
-    auto connFuture = pool->getConnection(timeout);
-    pool->updateState();
+            auto& pool = _pools[host];
+            if (pool) {
+                return nullptr;
+            }
+
+            pool = SpecificPool::make(shared_from_this(), host, sslMode);
+            return pool;
+        }();
+
+        if (!pool) {
+            continue;
+        }
 
-    return std::move(connFuture).semi();
+        auto lk = pool->lock();
+        if (hostGroup.canShutdown) {
+            pool->shutdownIfExpired();
+        } else {
+            pool->updateState();
+        }
+    }
 }
 
 void ConnectionPool::appendConnectionStats(ConnectionPoolStats* stats) const {
-    stdx::lock_guard lk(_mutex);
+    auto pools = [&] {
+        stdx::lock_guard lk(_mutex);
+        return _pools;
+    }();
 
-    for (const auto& kv : _pools) {
+    for (const auto& kv : pools) {
         HostAndPort host = kv.first;
 
         auto& pool = kv.second;
+        auto lk = pool->lock();
         ConnectionStatsPer hostStats{pool->inUseConnections(),
                                      pool->availableConnections(),
                                      pool->createdConnections(),
@@ -581,10 +682,9 @@ void ConnectionPool::appendConnectionStats(ConnectionPoolStats* stats) const {
 }
 
 size_t ConnectionPool::getNumConnectionsPerHost(const HostAndPort& hostAndPort) const {
-    stdx::lock_guard lk(_mutex);
-    auto iter = _pools.find(hostAndPort);
-    if (iter != _pools.end()) {
-        return iter->second->openConnections();
+    if (auto pool = _findPool(hostAndPort)) {
+        auto lk = pool->lock();
+        return pool->openConnections();
     }
 
     return 0;
@@ -678,7 +778,7 @@ Future<ConnectionPool::ConnectionHandle> ConnectionPool::SpecificPool::getConnec
 
 auto ConnectionPool::SpecificPool::makeHandle(ConnectionInterface* connection) -> ConnectionHandle {
     auto deleter = [this, anchor = shared_from_this()](ConnectionInterface* connection) {
-        stdx::lock_guard lk(_parent->_mutex);
+        stdx::lock_guard lk(_mutex);
         returnConnection(connection);
         _lastActiveTime = _parent->_factory->now();
         updateState();
@@ -902,7 +1002,13 @@ void ConnectionPool::SpecificPool::triggerShutdown(const Status& status) {
     // it could be only in the map of pools
     auto anchor = shared_from_this();
     _parent->_controller->removeHost(_id);
-    _parent->_pools.erase(_hostAndPort);
+    {
+        stdx::lock_guard lk(_parent->_mutex);
+        if (auto it = _parent->_pools.find(_hostAndPort);
+            it != _parent->_pools.end() && it->second.get() == this) {
+            _parent->_pools.erase(it);
+        }
+    }
 
     processFailure(status);
 
@@ -1145,11 +1251,42 @@ void ConnectionPool::SpecificPool::updateEventTimer() {
     _eventTimer->setTimeout(timeout, std::move(deferredStateUpdateFunc));
 }
 
-void ConnectionPool::SpecificPool::updateController() {
+void ConnectionPool::SpecificPool::shutdownIfExpired() {
     if (_health.isShutdown) {
         return;
     }
 
+    if (!_health.isExpired) {
+        // Just because a HostGroup "canShutdown" doesn't mean that a SpecificPool should
+        // shutdown. For example, it is always inappropriate to shutdown a SpecificPool with
+        // connections in use or requests outstanding unless its parent ConnectionPool is
+        // also shutting down.
+        LOGV2_WARNING(4293001,
+                      "Controller requested shutdown but connections still in use, "
+                      "connection pool will stay active.",
+                      "hostAndPort"_attr = _hostAndPort);
+        return;
+    }
+
+    // At the moment, controllers will never mark for shutdown a pool with active
+    // connections or pending requests. isExpired is never true if these invariants are
+    // false. That's not to say that it's a terrible idea, but if this happens then we
+    // should review what it means to be expired.
+
+    if (shouldInvariantOnPoolCorrectness()) {
+        invariant(_checkedOutPool.empty());
+        invariant(_requests.empty());
+    }
+
+    triggerShutdown(Status(ErrorCodes::ConnectionPoolExpired,
+                           str::stream() << "Pool for " << _hostAndPort << " has expired."));
+}
+
+auto ConnectionPool::SpecificPool::updateController() -> HostGroupState {
+    if (_health.isShutdown) {
+        return {};
+    }
+
     auto& controller = *_parent->_controller;
 
     // Update our own state
@@ -1168,52 +1305,24 @@ void ConnectionPool::SpecificPool::updateController() {
                 "poolState"_attr = state);
     auto hostGroup = controller.updateHost(_id, std::move(state));
 
+    // Only this pool is locked, so leave the other hosts in the group to the caller.
+    auto isThisHost = [&](const HostAndPort& host) { return host == _hostAndPort; };
+    const bool includesThisHost =
+        std::any_of(hostGroup.hosts.begin(), hostGroup.hosts.end(), isThisHost);
+    hostGroup.hosts.erase(
+        std::remove_if(hostGroup.hosts.begin(), hostGroup.hosts.end(), isThisHost),
+        hostGroup.hosts.end());
+
     // If we can shutdown, then do so
     if (hostGroup.canShutdown) {
-        for (const auto& host : hostGroup.hosts) {
-            auto it = _parent->_pools.find(host);
-            if (it == _parent->_pools.end()) {
-                continue;
-            }
-
-            auto& pool = it->second;
-            if (!pool->_health.isExpired) {
-                // Just because a HostGroup "canShutdown" doesn't mean that a SpecificPool should
-                // shutdown. For example, it is always inappropriate to shutdown a SpecificPool with
-                // connections in use or requests outstanding unless its parent ConnectionPool is
-                // also shutting down.
-                LOGV2_WARNING(4293001,
-                              "Controller requested shutdown but connections still in use, "
-                              "connection pool will stay active.",
-                              "hostAndPort"_attr = pool->_hostAndPort);
-                continue;
-            }
-
-            // At the moment, controllers will never mark for shutdown a pool with active
-            // connections or pending requests. isExpired is never true if these invariants are
-            // false. That's not to say that it's a terrible idea, but if this happens then we
-            // should review what it means to be expired.
-
-            if (shouldInvariantOnPoolCorrectness()) {
-                invariant(pool->_checkedOutPool.empty());
-                invariant(pool->_requests.empty());
-            }
-
-            pool->triggerShutdown(Status(ErrorCodes::ConnectionPoolExpired,
-                                         str::stream() << "Pool for " << host << " has expired."));
-        }
-        return;
-    }
-
-
-    // Make sure all related hosts exist
-    for (const auto& host : hostGroup.hosts) {
-        if (auto& pool = _parent->_pools[host]; !pool) {
-            pool = SpecificPool::make(_parent, host, _sslMode);
+        if (includesThisHost) {
+            shutdownIfExpired();
         }
+        return hostGroup;
     }
 
     spawnConnections();
+    return hostGroup;
 }
 
 // Updates our state and manages the request timer
@@ -1239,9 +1348,13 @@ void ConnectionPool::SpecificPool::updateState() {
         .getAsync([this, anchor = shared_from_this()](Status&& status) mutable {
             invariant(status);
 
-            stdx::lock_guard lk(_parent->_mutex);
-            _updateScheduled = false;
-            updateController();
+            auto hostGroup = [&] {
+                stdx::lock_guard lk(_mutex);
+                _updateScheduled = false;
+                return updateController();
+            }();
+
+            _parent->_updateHostGroup(hostGroup, _sslMode);
         });
 }
 
@@ -264,6 +264,25 @@ public:
     size_t getNumConnectionsPerHost(const HostAndPort& hostAndPort) const;
 
 private:
+    /**
+     * Returns the pool for the given host, or nullptr if there is none.
+     */
+    std::shared_ptr<SpecificPool> _findPool(const HostAndPort& hostAndPort) const;
+
+    /**
+     * Returns the pool for the given host, creating it if there is none. Returns nullptr once the
+     * ConnectionPool has been shut down.
+     */
+    std::shared_ptr<SpecificPool> _getOrMakePool(const HostAndPort& hostAndPort,
+                                                 transport::ConnectSSLMode sslMode);
+
+    /**
+     * Applies a controller's decision for a group of hosts to their pools, creating them or
+     * shutting them down. Each pool is locked in turn. Does nothing once the ConnectionPool has
+     * been shut down.
+     */
+    void _updateHostGroup(const HostGroupState& hostGroup, transport::ConnectSSLMode sslMode);
+
     std::string _name;
 
     const std::shared_ptr<DependentTypeFactoryInterface> _factory;
@@ -271,11 +290,14 @@ private:
 
     std::shared_ptr<ControllerInterface> _controller;
 
-    // The global mutex for specific pool access and the generation counter
+    // Guards the map of specific pools, the pool id counter and the shutdown flag. Each specific
+    // pool guards its own state with a mutex which is acquired before this one, so that getting
+    // and returning connections to different hosts does not contend on a single lock.
     mutable Mutex _mutex =
         MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(1), "ExecutorConnectionPool::_mutex");
     PoolId _nextPoolId = 0;
     stdx::unordered_map<HostAndPort, std::shared_ptr<SpecificPool>> _pools;
+    bool _isShutDown = false;
 
     EgressTagCloserManager* _manager;
 };
@@ -0,0 +1,199 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/executor/connection_pool.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace executor {
+namespace {
+
+/**
+ * A timer which never fires. Connections are checked out and returned far more often than any of
+ * the pool's timeouts elapse.
+ */
+class BenchmarkTimer final : public ConnectionPool::TimerInterface {
+public:
+    void setTimeout(Milliseconds timeout, TimeoutCallback cb) override {}
+
+    void cancelTimeout() override {}
+
+    Date_t now() override {
+        return Date_t::now();
+    }
+};
+
+/**
+ * A connection which is established without any network traffic. Its setup and refresh callbacks
+ * run on the pool's executor, as they would for a real connection.
+ */
+class BenchmarkConnection final : public ConnectionPool::ConnectionInterface,
+                                  public std::enable_shared_from_this<BenchmarkConnection> {
+public:
+    BenchmarkConnection(const HostAndPort& hostAndPort,
+                        transport::ConnectSSLMode sslMode,
+                        size_t generation,
+                        std::shared_ptr<OutOfLineExecutor> executor)
+        : ConnectionInterface(generation),
+          _hostAndPort(hostAndPort),
+          _sslMode(sslMode),
+          _executor(std::move(executor)) {}
+
+    const HostAndPort& getHostAndPort() const override {
+        return _hostAndPort;
+    }
+
+    transport::ConnectSSLMode getSslMode() const override {
+        return _sslMode;
+    }
+
+    bool isHealthy() override {
+        return true;
+    }
+
+    void setTimeout(Milliseconds timeout, TimeoutCallback cb) override {}
+
+    void cancelTimeout() override {}
+
+    Date_t now() override {
+        return Date_t::now();
+    }
+
+protected:
+    void setup(Milliseconds timeout, SetupCallback cb) override {
+        complete(std::move(cb));
+    }
+
+    void refresh(Milliseconds timeout, RefreshCallback cb) override {
+        complete(std::move(cb));
+    }
+
+private:
+    template <typename Callback>
+    void complete(Callback cb) {
+        _executor->schedule(
+            [self = shared_from_this(), cb = std::move(cb)](Status status) mutable {
+                if (!status.isOK()) {
+                    return;
+                }
+
+                self->indicateUsed();
+                cb(self.get(), Status::OK());
+            });
+    }
+
+    const HostAndPort _hostAndPort;
+    const transport::ConnectSSLMode _sslMode;
+    const std::shared_ptr<OutOfLineExecutor> _executor;
+};
+
+class BenchmarkFactory final : public ConnectionPool::DependentTypeFactoryInterface {
+public:
+    explicit BenchmarkFactory(std::shared_ptr<OutOfLineExecutor> executor)
+        : _executor(std::move(executor)) {}
+
+    std::shared_ptr<ConnectionPool::ConnectionInterface> makeConnection(
+        const HostAndPort& hostAndPort,
+        transport::ConnectSSLMode sslMode,
+        size_t generation) override {
+        return std::make_shared<BenchmarkConnection>(hostAndPort, sslMode, generation, _executor);
+    }
+
+    const std::shared_ptr<OutOfLineExecutor>& getExecutor() override {
+        return _executor;
+    }
+
+    std::shared_ptr<ConnectionPool::TimerInterface> makeTimer() override {
+        return std::make_shared<BenchmarkTimer>();
+    }
+
+    Date_t now() override {
+        return Date_t::now();
+    }
+
+    // The executor outlives the pool, so that callbacks which are still queued can run.
+    void shutdown() override {}
+
+private:
+    const std::shared_ptr<OutOfLineExecutor> _executor;
+};
+
+std::shared_ptr<ThreadPool> executor;
+std::shared_ptr<ConnectionPool> pool;
+
+/**
+ * Checks out and returns a connection in each iteration. Each thread uses one of the hosts given
+ * by the argument, so that the contention between threads using the same host and threads using
+ * different hosts can be compared.
+ */
+void BM_GetAndReturnConnection(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        ThreadPool::Options options;
+        options.poolName = "ConnectionPoolBenchmark";
+        options.minThreads = 1;
+        options.maxThreads = 4;
+        executor = std::make_shared<ThreadPool>(std::move(options));
+        executor->startup();
+
+        pool = std::make_shared<ConnectionPool>(std::make_shared<BenchmarkFactory>(executor),
+                                                "ConnectionPoolBenchmark");
+    }
+
+    const HostAndPort host(str::stream() << "host" << (state.thread_index % state.range(0)), 27017);
+
+    for (auto keepRunning : state) {
+        auto conn = pool->get(host, transport::kGlobalSSLMode, Seconds(10)).get();
+        conn->indicateSuccess();
+    }
+
+    if (state.thread_index == 0) {
+        pool->shutdown();
+        pool.reset();
+
+        executor->shutdown();
+        executor->join();
+        executor.reset();
+    }
+}
+
+BENCHMARK(BM_GetAndReturnConnection)
+    ->ThreadRange(1, ProcessInfo::getNumAvailableCores())
+    ->ArgName("hosts")
+    ->Arg(1)
+    ->Arg(16);
+
+}  // namespace
+}  // namespace executor
+}  // namespace mongo
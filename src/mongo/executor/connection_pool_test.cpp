@@ -41,14 +41,75 @@
 #include <fmt/ostream.h>
 
 #include "mongo/executor/connection_pool.h"
+#include "mongo/platform/mutex.h"
 #include "mongo/stdx/future.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/stdx/unordered_map.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/fail_point.h"
 #include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace executor {
 namespace connection_pool_test_details {
 
+/**
+ * A controller which places all of the given hosts in one group, so that using any of them makes a
+ * pool for each, and the group can only shut down once all of their pools have expired. Every pool
+ * keeps at least one connection.
+ */
+class HostGroupController final : public ConnectionPool::ControllerInterface {
+public:
+    explicit HostGroupController(std::vector<HostAndPort> hosts) : _hosts(std::move(hosts)) {}
+
+    void addHost(PoolId id, const HostAndPort& host) override {
+        stdx::lock_guard lk(_mutex);
+        _hostStates.emplace(id, HostState{});
+    }
+    HostGroupState updateHost(PoolId id, const HostState& stats) override {
+        stdx::lock_guard lk(_mutex);
+        _hostStates[id] = stats;
+
+        const bool canShutdown =
+            std::all_of(_hostStates.begin(), _hostStates.end(), [](const auto& pair) {
+                return pair.second.health.isExpired;
+            });
+        return {_hosts, canShutdown};
+    }
+    void removeHost(PoolId id) override {
+        stdx::lock_guard lk(_mutex);
+        _hostStates.erase(id);
+    }
+
+    ConnectionControls getControls(PoolId id) override {
+        stdx::lock_guard lk(_mutex);
+        const auto& stats = _hostStates[id];
+        return {ConnectionPool::kDefaultMaxConnecting,
+                std::max<size_t>(1, stats.requests + stats.active)};
+    }
+
+    Milliseconds hostTimeout() const override {
+        return Milliseconds(1000);
+    }
+    Milliseconds pendingTimeout() const override {
+        return Milliseconds(5000);
+    }
+    Milliseconds toRefreshTimeout() const override {
+        return Milliseconds(5000);
+    }
+
+    StringData name() const override {
+        return "HostGroupController"_sd;
+    }
+
+private:
+    const std::vector<HostAndPort> _hosts;
+
+    Mutex _mutex =
+        MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "HostGroupController::_mutex");
+    stdx::unordered_map<PoolId, HostState> _hostStates;
+};
+
 class ConnectionPoolTest : public unittest::Test {
 public:
 protected:
@@ -1530,6 +1591,147 @@ TEST_F(ConnectionPoolTest, ReturnAfterShutdown) {
     pool->shutdown();
 }
 
+/**
+ * Verify that get() looks for a new pool if the one it found is delisted before it can be locked.
+ */
+TEST_F(ConnectionPoolTest, GetRetriesIfPoolIsDelistedBeforeLocking) {
+    auto pool = makePool();
+
+    ConnectionImpl::pushSetup(Status::OK());
+    auto conn = getFromPool(HostAndPort(), transport::kGlobalSSLMode, Seconds(1)).get();
+    auto connId = getId(conn);
+    doneWith(conn);
+
+    SemiFuture<ConnectionPool::ConnectionHandle> connFuture;
+    stdx::thread getThread;
+    {
+        FailPointEnableBlock fpb("connectionPoolHangBeforeLockingPool");
+        getThread = stdx::thread([&] {
+            connFuture = getFromPool(HostAndPort(), transport::kGlobalSSLMode, Seconds(1));
+        });
+        fpb->waitForTimesEntered(fpb.initialTimesEntered() + 1);
+
+        pool->dropConnections(HostAndPort());
+    }
+    getThread.join();
+
+    // The request went to a new pool, which has to make a new connection.
+    ASSERT_FALSE(connFuture.isReady());
+    ConnectionImpl::pushSetup(Status::OK());
+    ASSERT_TRUE(connFuture.isReady());
+
+    auto newConn = std::move(connFuture).get();
+    ASSERT_NE(connId, getId(newConn));
+    ASSERT_EQ(1ul, pool->getNumConnectionsPerHost(HostAndPort()));
+    doneWith(newConn);
+}
+
+/**
+ * Verify that get() fails rather than making a new pool if the one it found is delisted by a
+ * shutdown before it can be locked.
+ */
+TEST_F(ConnectionPoolTest, GetFailsIfPoolIsShutDownBeforeLocking) {
+    auto pool = makePool();
+
+    ConnectionImpl::pushSetup(Status::OK());
+    auto conn = getFromPool(HostAndPort(), transport::kGlobalSSLMode, Seconds(1)).get();
+    doneWith(conn);
+
+    SemiFuture<ConnectionPool::ConnectionHandle> connFuture;
+    stdx::thread getThread;
+    {
+        FailPointEnableBlock fpb("connectionPoolHangBeforeLockingPool");
+        getThread = stdx::thread([&] {
+            connFuture = getFromPool(HostAndPort(), transport::kGlobalSSLMode, Seconds(1));
+        });
+        fpb->waitForTimesEntered(fpb.initialTimesEntered() + 1);
+
+        pool->shutdown();
+    }
+    getThread.join();
+
+    ASSERT_TRUE(connFuture.isReady());
+    ASSERT_THROWS_CODE(std::move(connFuture).get(), DBException, ErrorCodes::ShutdownInProgress);
+    ASSERT_EQ(0ul, pool->getNumConnectionsPerHost(HostAndPort()));
+}
+
+/**
+ * Verify that get() does not make a new pool once the ConnectionPool is shut down.
+ */
+TEST_F(ConnectionPoolTest, GetAfterShutdownFails) {
+    auto pool = makePool();
+    pool->shutdown();
+
+    auto connFuture = getFromPool(HostAndPort(), transport::kGlobalSSLMode, Seconds(1));
+    ASSERT_TRUE(connFuture.isReady());
+    ASSERT_THROWS_CODE(std::move(connFuture).get(), DBException, ErrorCodes::ShutdownInProgress);
+    ASSERT_EQ(0ul, pool->getNumConnectionsPerHost(HostAndPort()));
+}
+
+/**
+ * Verify that using one host of a group makes pools for the others, and that the pools of the group
+ * are shut down together once all of them have expired.
+ */
+TEST_F(ConnectionPoolTest, HostGroupPoolsAreMadeAndExpiredTogether) {
+    const HostAndPort hostA("localhost", 30000);
+    const HostAndPort hostB("localhost", 30001);
+
+    ConnectionPool::Options options;
+    options.controllerFactory = [&] {
+        return std::make_shared<HostGroupController>(std::vector<HostAndPort>{hostA, hostB});
+    };
+    auto pool = makePool(options);
+
+    auto now = Date_t::now();
+    PoolImpl::setNow(now);
+
+    ConnectionImpl::pushSetup(Status::OK());
+    ConnectionImpl::pushSetup(Status::OK());
+    auto conn = getFromPool(hostA, transport::kGlobalSSLMode, Seconds(1)).get();
+    doneWith(conn);
+
+    ASSERT_EQ(1ul, pool->getNumConnectionsPerHost(hostA));
+    ASSERT_EQ(1ul, pool->getNumConnectionsPerHost(hostB));
+
+    PoolImpl::setNow(now + Milliseconds(1000));
+
+    ASSERT_EQ(0ul, pool->getNumConnectionsPerHost(hostA));
+    ASSERT_EQ(0ul, pool->getNumConnectionsPerHost(hostB));
+}
+
+/**
+ * Verify that the pools of a group are not made once the ConnectionPool is shut down, even if the
+ * controller asked for them before the shutdown.
+ */
+TEST_F(ConnectionPoolTest, HostGroupPoolsAreNotMadeAfterShutdown) {
+    const HostAndPort hostA("localhost", 30000);
+    const HostAndPort hostB("localhost", 30001);
+
+    ConnectionPool::Options options;
+    options.controllerFactory = [&] {
+        return std::make_shared<HostGroupController>(std::vector<HostAndPort>{hostA, hostB});
+    };
+    auto pool = makePool(options);
+
+    SemiFuture<ConnectionPool::ConnectionHandle> connFuture;
+    stdx::thread getThread;
+    {
+        FailPointEnableBlock fpb("connectionPoolHangBeforeUpdatingHostGroup");
+        getThread = stdx::thread([&] {
+            connFuture = getFromPool(hostA, transport::kGlobalSSLMode, Seconds(1));
+        });
+        fpb->waitForTimesEntered(fpb.initialTimesEntered() + 1);
+
+        pool->shutdown();
+    }
+    getThread.join();
+
+    ASSERT_TRUE(connFuture.isReady());
+    ASSERT_THROWS_CODE(std::move(connFuture).get(), DBException, ErrorCodes::ShutdownInProgress);
+    ASSERT_EQ(0ul, pool->getNumConnectionsPerHost(hostA));
+    ASSERT_EQ(0ul, pool->getNumConnectionsPerHost(hostB));
+}
+
 }  // namespace connection_pool_test_details
 }  // namespace executor
 }  // namespace mongo
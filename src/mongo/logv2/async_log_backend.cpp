@@ -0,0 +1,352 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/logv2/async_log_backend.h"
+
+#include <algorithm>
+#include <boost/log/attributes/value_extraction.hpp>
+#include <cstring>
+#include <fmt/format.h>
+
+#include "mongo/logv2/attributes.h"
+#include "mongo/logv2/json_formatter.h"
+#include "mongo/logv2/log_severity.h"
+#include "mongo/stdx/new.h"
+#include "mongo/util/duration.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo::logv2 {
+namespace {
+
+// Upper bound on how long a record can wait in a buffer when the writer misses a wakeup.
+constexpr Milliseconds kMaxWriteDelay{100};
+
+AtomicWord<unsigned long long> nextInstanceId{1};
+
+// Every live AsyncLogBackend, for flushAllBeforeExit.
+stdx::mutex instancesMutex;  // NOLINT
+std::vector<AsyncLogBackend*> instances;
+AtomicWord<int> instanceCount{0};
+
+// Set while the calling thread writes to the sink of a backend, including for the whole lifetime
+// of a writer thread, so that exiting from within a write does not wait for itself.
+thread_local bool isWritingThread = false;
+
+// Set once the calling thread's buffers have been destroyed during thread exit. Trivially
+// destructible so that it stays readable from the destructors of other thread_locals.
+thread_local bool threadBufferDestroyed = false;
+
+}  // namespace
+
+/**
+ * Single-producer, single-consumer queue of formatted records. Each record is stored as a 32-bit
+ * length followed by its bytes and may wrap around the end of the storage. Only the owning thread
+ * pushes, and only a holder of the backend's write mutex drains.
+ */
+class AsyncLogBackend::RingBuffer {
+public:
+    explicit RingBuffer(size_t capacity)
+        : _capacity(capacity), _data(std::make_unique<char[]>(capacity)) {}
+
+    bool fits(size_t recordSize) const {
+        return sizeof(uint32_t) + recordSize <= _capacity;
+    }
+
+    /**
+     * Returns false without queueing anything if there is not enough free space for the record.
+     */
+    bool push(StringData record) {
+        const uint32_t size = record.size();
+        const size_t needed = sizeof(size) + size;
+        const auto tail = _tail.loadRelaxed();
+        if (needed > _capacity - (tail - _head.load()))
+            return false;
+
+        _copyIn(tail, reinterpret_cast<const char*>(&size), sizeof(size));
+        _copyIn(tail + sizeof(size), record.rawData(), size);
+        _tail.store(tail + needed);
+        return true;
+    }
+
+    bool empty() const {
+        return _head.load() == _tail.load();
+    }
+
+    /**
+     * Passes each queued record to 'cb', reusing 'scratch' to hold it. Returns false if the
+     * buffer was empty.
+     */
+    template <typename Callback>
+    bool drain(std::string& scratch, Callback&& cb) {
+        auto head = _head.loadRelaxed();
+        const auto tail = _tail.load();
+        if (head == tail)
+            return false;
+
+        while (head != tail) {
+            uint32_t size;
+            _copyOut(head, reinterpret_cast<char*>(&size), sizeof(size));
+            scratch.resize(size);
+            _copyOut(head + sizeof(size), &scratch[0], size);
+            head += sizeof(size) + size;
+            // Release the space before writing, so the producer is not held up by the file.
+            _head.store(head);
+            cb(scratch);
+        }
+        return true;
+    }
+
+private:
+    void _copyIn(unsigned long long pos, const char* src, size_t size) {
+        const size_t offset = pos % _capacity;
+        const size_t first = std::min(size, _capacity - offset);
+        std::memcpy(_data.get() + offset, src, first);
+        std::memcpy(_data.get(), src + first, size - first);
+    }
+
+    void _copyOut(unsigned long long pos, char* dst, size_t size) const {
+        const size_t offset = pos % _capacity;
+        const size_t first = std::min(size, _capacity - offset);
+        std::memcpy(dst, _data.get() + offset, first);
+        std::memcpy(dst + first, _data.get(), size - first);
+    }
+
+    const size_t _capacity;
+    const std::unique_ptr<char[]> _data;
+
+    // Total bytes consumed and produced. Kept on separate cache lines so that the writer and the
+    // logging thread do not contend on them.
+    alignas(stdx::hardware_destructive_interference_size) AtomicWord<unsigned long long> _head{0};
+    alignas(stdx::hardware_destructive_interference_size) AtomicWord<unsigned long long> _tail{0};
+};
+
+AsyncLogBackend::AsyncLogBackend(boost::shared_ptr<FileRotateSink> target,
+                                 LogTimestampFormat timestampFormat,
+                                 size_t bufferSizeBytes)
+    : _target(std::move(target)),
+      _timestampFormat(timestampFormat),
+      _bufferSizeBytes(bufferSizeBytes),
+      _instanceId(nextInstanceId.fetchAndAdd(1)) {
+    _writer = stdx::thread([this] { _run(); });
+
+    stdx::lock_guard lk(instancesMutex);
+    instances.push_back(this);
+    instanceCount.fetchAndAdd(1);
+}
+
+AsyncLogBackend::~AsyncLogBackend() {
+    {
+        stdx::lock_guard lk(instancesMutex);
+        instances.erase(std::find(instances.begin(), instances.end(), this));
+        instanceCount.fetchAndSubtract(1);
+    }
+    {
+        stdx::lock_guard lk(_writeMutex);
+        _shutdown = true;
+    }
+    _wakeWriter.notify_one();
+    _writer.join();
+}
+
+void AsyncLogBackend::consume(const boost::log::record_view& rec,
+                              const string_type& formatted_string) {
+    auto severity = boost::log::extract<LogSeverity>(attributes::severity(), rec);
+    if (!severity || severity.get() < LogSeverity::Severe()) {
+        auto buffer = _threadBuffer();
+        if (buffer && buffer->fits(formatted_string.size())) {
+            if (!buffer->push(formatted_string)) {
+                _droppedRecords.fetchAndAdd(1);
+                return;
+            }
+            if (_writerWaiting.load())
+                _wakeWriter.notify_one();
+            return;
+        }
+    }
+
+    stdx::lock_guard lk(_writeMutex);
+    isWritingThread = true;
+    ON_BLOCK_EXIT([] { isWritingThread = false; });
+    _drain(lk);
+    _target->consume(rec, formatted_string);
+    _target->flush();
+}
+
+Status AsyncLogBackend::rotate(bool rename, StringData renameSuffix) {
+    stdx::lock_guard lk(_writeMutex);
+    isWritingThread = true;
+    ON_BLOCK_EXIT([] { isWritingThread = false; });
+    _drain(lk);
+    return _target->rotate(rename, renameSuffix);
+}
+
+void AsyncLogBackend::flush() {
+    stdx::lock_guard lk(_writeMutex);
+    isWritingThread = true;
+    ON_BLOCK_EXIT([] { isWritingThread = false; });
+    _drain(lk);
+    _target->flush();
+}
+
+void AsyncLogBackend::flushAllBeforeExit(Milliseconds timeout) {
+    if (instanceCount.load() == 0 || isWritingThread)
+        return;
+
+    const auto deadline = Date_t::now() + timeout;
+    stdx::unique_lock instancesLock(instancesMutex, stdx::defer_lock);
+    while (!instancesLock.try_lock()) {
+        if (Date_t::now() >= deadline)
+            return;
+        sleepmillis(1);
+    }
+
+    for (auto instance : instances) {
+        // The writer may be stuck on the file; exiting matters more than the last records.
+        stdx::unique_lock lk(instance->_writeMutex, stdx::defer_lock);
+        while (!lk.try_lock() && Date_t::now() < deadline)
+            sleepmillis(1);
+        if (!lk.owns_lock())
+            continue;
+
+        isWritingThread = true;
+        ON_BLOCK_EXIT([] { isWritingThread = false; });
+        instance->_drain(lk);
+        instance->_target->flush();
+    }
+}
+
+AsyncLogBackend::RingBuffer* AsyncLogBackend::_threadBuffer() {
+    // The registry keeps a buffer alive after its thread exits, until the writer has drained it.
+    struct ThreadBuffer {
+        ~ThreadBuffer() {
+            threadBufferDestroyed = true;
+        }
+
+        unsigned long long instanceId = 0;
+        std::shared_ptr<RingBuffer> buffer;
+    };
+
+    if (threadBufferDestroyed)
+        return nullptr;
+
+    thread_local ThreadBuffer local;
+    if (local.instanceId != _instanceId) {
+        local.buffer = std::make_shared<RingBuffer>(_bufferSizeBytes);
+        local.instanceId = _instanceId;
+
+        stdx::lock_guard lk(_buffersMutex);
+        _buffers.push_back(local.buffer);
+    }
+    return local.buffer.get();
+}
+
+bool AsyncLogBackend::_hasPendingRecords() {
+    stdx::lock_guard lk(_buffersMutex);
+    return std::any_of(
+        _buffers.begin(), _buffers.end(), [](auto&& buffer) { return !buffer->empty(); });
+}
+
+bool AsyncLogBackend::_drain(WithLock lk) {
+    {
+        stdx::lock_guard buffersLock(_buffersMutex);
+        _drainingBuffers = _buffers;
+    }
+
+    bool wrote = false;
+    for (auto&& buffer : _drainingBuffers) {
+        wrote |= buffer->drain(_scratch, [&](const std::string& record) {
+            _target->consume(boost::log::record_view(), record);
+        });
+    }
+    _drainingBuffers.clear();
+
+    {
+        // Only the registry refers to a buffer once its thread has exited.
+        stdx::lock_guard buffersLock(_buffersMutex);
+        _buffers.erase(std::remove_if(_buffers.begin(),
+                                      _buffers.end(),
+                                      [](auto&& buffer) {
+                                          return buffer.use_count() == 1 && buffer->empty();
+                                      }),
+                       _buffers.end());
+    }
+
+    wrote |= _reportDroppedRecords(lk);
+    if (wrote)
+        _target->flush();
+    return wrote;
+}
+
+bool AsyncLogBackend::_reportDroppedRecords(WithLock) {
+    auto dropped = _droppedRecords.load();
+    if (dropped == _reportedDroppedRecords)
+        return false;
+
+    DynamicAttributes attrs;
+    attrs.add("dropped", dropped - _reportedDroppedRecords);
+    _reportedDroppedRecords = dropped;
+
+    fmt::memory_buffer buffer;
+    JSONFormatter(nullptr, _timestampFormat)
+        .format(buffer,
+                LogSeverity::Warning(),
+                LogComponent::kControl,
+                Date_t::now(),
+                5338718,
+                "AsyncLogWriter",
+                "Dropped log records because the buffer of the logging thread was full",
+                TypeErasedAttributeStorage(attrs),
+                LogTag::kNone,
+                LogTruncation::Disabled);
+    // Commented out log line below to get validation of the log id with the errorcodes linter
+    // LOGV2(5338718, "Dropped log records because the buffer of the logging thread was full");
+    _target->consume(boost::log::record_view(), std::string(buffer.data(), buffer.size()));
+    return true;
+}
+
+void AsyncLogBackend::_run() {
+    isWritingThread = true;
+    stdx::unique_lock lk(_writeMutex);
+    while (!_shutdown) {
+        if (_drain(lk))
+            continue;
+
+        // Announce the wait before looking at the buffers one last time, so that a record pushed
+        // concurrently is either seen here or followed by a notification. A notification sent
+        // just before the wait starts is covered by the timeout.
+        _writerWaiting.store(true);
+        if (!_hasPendingRecords())
+            _wakeWriter.wait_for(lk, kMaxWriteDelay.toSystemDuration());
+        _writerWaiting.store(false);
+    }
+    _drain(lk);
+}
+
+}  // namespace mongo::logv2
@@ -0,0 +1,146 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/log/detail/locking_ptr.hpp>
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/sinks/frontend_requirements.hpp>
+#include <boost/shared_ptr.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/logv2/file_rotate_sink.h"
+#include "mongo/logv2/log_format.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/mutex.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/duration.h"
+
+namespace mongo::logv2 {
+
+/**
+ * boost::log backend that takes the writes to a FileRotateSink off the logging threads.
+ *
+ * Records are formatted by the thread that logs them, since the attributes refer to that thread's
+ * stack, and then appended to a lock-free ring buffer owned by that thread. A background thread
+ * drains the buffers into the file and flushes it once per batch. Memory is bounded by the size
+ * of the buffers: records which do not fit are dropped and counted, and the writer reports the
+ * count in the log once it has caught up.
+ *
+ * Records from different threads can be written in a different order than they were logged.
+ * Fatal records are written synchronously, after everything that was queued before them, so the
+ * reason for an abort is never left behind in a buffer.
+ */
+class AsyncLogBackend
+    : public boost::log::sinks::basic_formatted_sink_backend<
+          char,
+          boost::log::sinks::combine_requirements<boost::log::sinks::concurrent_feeding,
+                                                  boost::log::sinks::flushing>::type> {
+public:
+    static constexpr size_t kDefaultBufferSizeBytes = 64 * 1024;
+
+    AsyncLogBackend(boost::shared_ptr<FileRotateSink> target,
+                    LogTimestampFormat timestampFormat,
+                    size_t bufferSizeBytes = kDefaultBufferSizeBytes);
+    ~AsyncLogBackend();
+
+    /**
+     * Locking accessor to the wrapped sink. The writer thread does not write while it is held.
+     */
+    auto lockedTarget() {
+        return boost::log::aux::locking_ptr(_target, _writeMutex);
+    }
+
+    /**
+     * Writes every queued record to the current file before rotating it.
+     */
+    Status rotate(bool rename, StringData renameSuffix);
+
+    void consume(const boost::log::record_view& rec, const string_type& formatted_string);
+
+    /**
+     * Writes every queued record and flushes the wrapped sink before returning.
+     */
+    void flush();
+
+    /**
+     * Writes the queued records of every AsyncLogBackend and flushes their sinks, for use right
+     * before the process exits. Does nothing if no AsyncLogBackend exists or if called from a
+     * thread which is writing for one of them, and gives up on a backend whose writer does not
+     * let go of its sink within 'timeout'.
+     */
+    static void flushAllBeforeExit(Milliseconds timeout);
+
+    /**
+     * Number of records dropped so far because the buffer of the logging thread was full.
+     */
+    long long droppedRecords() const {
+        return _droppedRecords.load();
+    }
+
+private:
+    class RingBuffer;
+
+    RingBuffer* _threadBuffer();
+    bool _hasPendingRecords();
+    bool _drain(WithLock);
+    bool _reportDroppedRecords(WithLock);
+    void _run();
+
+    const boost::shared_ptr<FileRotateSink> _target;
+    const LogTimestampFormat _timestampFormat;
+    const size_t _bufferSizeBytes;
+    const unsigned long long _instanceId;
+
+    // Held by the writer while it writes to '_target'.
+    stdx::mutex _writeMutex;  // NOLINT
+    stdx::condition_variable _wakeWriter;
+    AtomicWord<bool> _writerWaiting{false};
+    bool _shutdown = false;
+    std::string _scratch;
+    long long _reportedDroppedRecords = 0;
+
+    // Guards registration of new buffers. Not held while writing, so that a thread logging for
+    // the first time does not wait for the file.
+    stdx::mutex _buffersMutex;  // NOLINT
+    std::vector<std::shared_ptr<RingBuffer>> _buffers;
+
+    // Copy of '_buffers' taken by '_drain' under '_writeMutex', reused to avoid allocating.
+    std::vector<std::shared_ptr<RingBuffer>> _drainingBuffers;
+
+    AtomicWord<long long> _droppedRecords{0};
+
+    stdx::thread _writer;
+};
+
+}  // namespace mongo::logv2
@@ -36,6 +36,7 @@
 #include <boost/log/sinks/basic_sink_backend.hpp>
 #include <boost/log/sinks/frontend_requirements.hpp>
 #include <tuple>
+#include <type_traits>
 
 namespace mongo::logv2 {
 
@@ -141,9 +142,15 @@ private:
     void consumeAt(boost::log::record_view const& rec, string_type const& formatted_string) {
         auto& trait = getTrait<I>();
         if (!trait._filter || trait._filter(rec.attribute_values())) {
-            stdx::lock_guard lock(trait._mutex);
-
-            trait._backend->consume(rec, formatted_string);
+            // Backends that support concurrent feeding are fed without taking any lock here.
+            if constexpr (std::is_same_v<typename std::decay_t<decltype(trait)>::backend_mutex_type,
+                                         boost::log::aux::fake_mutex>) {
+                trait._backend->consume(rec, formatted_string);
+            } else {
+                stdx::lock_guard lock(trait._mutex);
+
+                trait._backend->consume(rec, formatted_string);
+            }
         }
     }
 
@@ -30,6 +30,7 @@
 #include "log_domain_global.h"
 
 #include "mongo/config.h"
+#include "mongo/logv2/async_log_backend.h"
 #include "mongo/logv2/component_settings_filter.h"
 #include "mongo/logv2/composite_backend.h"
 #include "mongo/logv2/console.h"
@@ -68,6 +69,8 @@ struct LogDomainGlobal::Impl {
 #endif
     typedef CompositeBackend<FileRotateSink, RamLogSink, RamLogSink, UserAssertSink>
         RotatableFileBackend;
+    typedef CompositeBackend<AsyncLogBackend, RamLogSink, RamLogSink, UserAssertSink>
+        AsyncRotatableFileBackend;
 
     Impl(LogDomainGlobal& parent);
     Status configure(LogDomainGlobal::ConfigurationOptions const& options);
@@ -82,6 +85,8 @@ struct LogDomainGlobal::Impl {
     ConfigurationOptions _config;
     boost::shared_ptr<boost::log::sinks::unlocked_sink<ConsoleBackend>> _consoleSink;
     boost::shared_ptr<boost::log::sinks::unlocked_sink<RotatableFileBackend>> _rotatableFileSink;
+    boost::shared_ptr<boost::log::sinks::unlocked_sink<AsyncRotatableFileBackend>>
+        _asyncRotatableFileSink;
 #ifndef _WIN32
     boost::shared_ptr<boost::log::sinks::unlocked_sink<SyslogBackend>> _syslogSink;
 #endif
@@ -157,35 +162,69 @@ Status LogDomainGlobal::Impl::configure(LogDomainGlobal::ConfigurationOptions co
     }
 #endif
 
+    auto removeFileSinks = [this] {
+        if (_rotatableFileSink) {
+            boost::log::core::get()->remove_sink(_rotatableFileSink);
+            _rotatableFileSink.reset();
+        }
+        if (_asyncRotatableFileSink) {
+            boost::log::core::get()->remove_sink(_asyncRotatableFileSink);
+            _asyncRotatableFileSink.reset();
+        }
+    };
+
     if (options.fileEnabled) {
-        auto backend = boost::make_shared<RotatableFileBackend>(
-            boost::make_shared<FileRotateSink>(options.timestampFormat),
-            boost::make_shared<RamLogSink>(RamLog::get("global")),
-            boost::make_shared<RamLogSink>(RamLog::get("startupWarnings")),
-            boost::make_shared<UserAssertSink>());
-        Status ret = backend->lockedBackend<0>()->addFile(
+        auto fileSink = boost::make_shared<FileRotateSink>(options.timestampFormat);
+        Status ret = fileSink->addFile(
             options.filePath,
             options.fileOpenMode == ConfigurationOptions::OpenMode::kAppend ? true : false);
         if (!ret.isOK())
             return ret;
-        backend->lockedBackend<0>()->auto_flush(true);
-        backend->setFilter<2>(
-            TaggedSeverityFilter(_parent, {LogTag::kStartupWarnings}, LogSeverity::Log()));
-
-        _rotatableFileSink =
-            boost::make_shared<boost::log::sinks::unlocked_sink<RotatableFileBackend>>(backend);
-        _rotatableFileSink->set_filter(ComponentSettingsFilter(_parent, _settings));
-
-        boost::log::core::get()->add_sink(_rotatableFileSink);
-    } else if (_rotatableFileSink) {
-        boost::log::core::get()->remove_sink(_rotatableFileSink);
-        _rotatableFileSink.reset();
+        removeFileSinks();
+
+        if (options.fileAsyncWrites) {
+            // The writer thread flushes once per batch of records instead.
+            auto backend = boost::make_shared<AsyncRotatableFileBackend>(
+                boost::make_shared<AsyncLogBackend>(std::move(fileSink), options.timestampFormat),
+                boost::make_shared<RamLogSink>(RamLog::get("global")),
+                boost::make_shared<RamLogSink>(RamLog::get("startupWarnings")),
+                boost::make_shared<UserAssertSink>());
+            backend->setFilter<2>(
+                TaggedSeverityFilter(_parent, {LogTag::kStartupWarnings}, LogSeverity::Log()));
+
+            _asyncRotatableFileSink =
+                boost::make_shared<boost::log::sinks::unlocked_sink<AsyncRotatableFileBackend>>(
+                    backend);
+            _asyncRotatableFileSink->set_filter(ComponentSettingsFilter(_parent, _settings));
+
+            boost::log::core::get()->add_sink(_asyncRotatableFileSink);
+        } else {
+            fileSink->auto_flush(true);
+            auto backend = boost::make_shared<RotatableFileBackend>(
+                std::move(fileSink),
+                boost::make_shared<RamLogSink>(RamLog::get("global")),
+                boost::make_shared<RamLogSink>(RamLog::get("startupWarnings")),
+                boost::make_shared<UserAssertSink>());
+            backend->setFilter<2>(
+                TaggedSeverityFilter(_parent, {LogTag::kStartupWarnings}, LogSeverity::Log()));
+
+            _rotatableFileSink =
+                boost::make_shared<boost::log::sinks::unlocked_sink<RotatableFileBackend>>(
+                    backend);
+            _rotatableFileSink->set_filter(ComponentSettingsFilter(_parent, _settings));
+
+            boost::log::core::get()->add_sink(_rotatableFileSink);
+        }
+    } else {
+        removeFileSinks();
     }
 
     auto setFormatters = [this](auto&& mkFmt) {
         _consoleSink->set_formatter(mkFmt());
         if (_rotatableFileSink)
             _rotatableFileSink->set_formatter(mkFmt());
+        if (_asyncRotatableFileSink)
+            _asyncRotatableFileSink->set_formatter(mkFmt());
 #ifndef _WIN32
         if (_syslogSink)
             _syslogSink->set_formatter(mkFmt());
@@ -227,6 +266,10 @@ Status LogDomainGlobal::Impl::rotate(bool rename, StringData renameSuffix) {
         auto backend = _rotatableFileSink->locked_backend()->lockedBackend<0>();
         return backend->rotate(rename, renameSuffix);
     }
+    if (_asyncRotatableFileSink) {
+        auto backend = _asyncRotatableFileSink->locked_backend()->lockedBackend<0>();
+        return backend->rotate(rename, renameSuffix);
+    }
     return Status::OK();
 }
 
@@ -31,6 +31,7 @@
 
 #include "mongo/logv2/log_util.h"
 
+#include "mongo/logv2/async_log_backend.h"
 #include "mongo/logv2/log.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/time_support.h"
@@ -40,6 +41,9 @@
 
 namespace mongo::logv2 {
 namespace {
+// Bounds how long exiting waits for a log writer which is stuck on its file.
+constexpr Milliseconds kFlushLogsTimeout{1000};
+
 AtomicWord<bool> redactionEnabled{false};
 std::vector<LogRotateCallback> logRotateCallbacks;
 }  // namespace
@@ -68,6 +72,10 @@ bool rotateLogs(bool renameFiles) {
     return success;
 }
 
+void flushLogs() {
+    AsyncLogBackend::flushAllBeforeExit(kFlushLogsTimeout);
+}
+
 bool shouldRedactLogs() {
     return redactionEnabled.loadRelaxed();
 }
@@ -52,6 +52,13 @@ void addLogRotator(LogRotateCallback cb);
  */
 bool rotateLogs(bool renameFiles);
 
+/**
+ * Writes out the log records which asynchronous sinks have not written yet, before the process
+ * exits. Returns immediately if asynchronous writes are not in use, and waits a bounded time for
+ * a writer which is busy.
+ */
+void flushLogs();
+
 /**
  * Returns true if system logs should be redacted.
  */
@@ -36,6 +36,7 @@
 #include "mongo/platform/basic.h"
 
 #include <benchmark/benchmark.h>
+#include <boost/filesystem/operations.hpp>
 #include <boost/iostreams/device/null.hpp>
 #include <boost/iostreams/stream.hpp>
 #include <boost/log/sinks/sync_frontend.hpp>
@@ -97,6 +98,38 @@ private:
     bool _shouldInit;
 };
 
+// RAII style helper class to log to a file through the global log domain, as the server does
+class ScopedLogV2FileBench {
+public:
+    ScopedLogV2FileBench(benchmark::State& state, bool asyncWrites) {
+        _shouldInit = state.thread_index == 0;
+        if (_shouldInit) {
+            _path = (boost::filesystem::temp_directory_path() /
+                     boost::filesystem::unique_path("logv2_bm-%%%%-%%%%.log"))
+                        .string();
+
+            logv2::LogDomainGlobal::ConfigurationOptions config;
+            config.makeDisabled();
+            config.fileEnabled = true;
+            config.filePath = _path;
+            config.fileAsyncWrites = asyncWrites;
+            invariant(
+                logv2::LogManager::global().getGlobalDomainInternal().configure(config).isOK());
+        }
+    }
+
+    ~ScopedLogV2FileBench() {
+        if (_shouldInit) {
+            invariant(logv2::LogManager::global().getGlobalDomainInternal().configure({}).isOK());
+            boost::filesystem::remove(_path);
+        }
+    }
+
+private:
+    std::string _path;
+    bool _shouldInit;
+};
+
 // "Expensive" way to create a string.
 std::string createLongString() {
     return std::string(1000, 'a') + std::string(1000, 'b') + std::string(1000, 'c') +
@@ -150,6 +183,20 @@ void BM_EnabledLogV2ManySmallArg(benchmark::State& state) {
     }
 }
 
+void BM_FileLogV2(benchmark::State& state) {
+    ScopedLogV2FileBench init(state, state.range(0));
+
+    for (auto _ : state)
+        LOGV2(5338723, "file log", "thread"_attr = state.thread_index, "i"_attr = 1);
+}
+
+void BM_FileLogV2ExpensiveArg(benchmark::State& state) {
+    ScopedLogV2FileBench init(state, state.range(0));
+
+    for (auto _ : state)
+        LOGV2(5338724, "file log", "str"_attr = createLongString());
+}
+
 void ThreadCounts(benchmark::internal::Benchmark* b) {
     int tc[] = {1, 2, 4, 8};
     for (int t : tc)
@@ -161,6 +208,8 @@ BENCHMARK(BM_NoopLogV2Arg)->Apply(ThreadCounts);
 BENCHMARK(BM_EnabledLogV2)->Apply(ThreadCounts);
 BENCHMARK(BM_EnabledLogV2ExpensiveArg)->Apply(ThreadCounts);
 BENCHMARK(BM_EnabledLogV2ManySmallArg)->Apply(ThreadCounts);
+BENCHMARK(BM_FileLogV2)->Apply(ThreadCounts)->ArgName("async")->Arg(0)->Arg(1);
+BENCHMARK(BM_FileLogV2ExpensiveArg)->Apply(ThreadCounts)->ArgName("async")->Arg(0)->Arg(1);
 
 }  // namespace
 }  // namespace mongo
@@ -40,10 +40,12 @@
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/bson/json.h"
 #include "mongo/bson/oid.h"
+#include "mongo/logv2/async_log_backend.h"
 #include "mongo/logv2/bson_formatter.h"
 #include "mongo/logv2/component_settings_filter.h"
 #include "mongo/logv2/composite_backend.h"
 #include "mongo/logv2/constants.h"
+#include "mongo/logv2/file_rotate_sink.h"
 #include "mongo/logv2/json_formatter.h"
 #include "mongo/logv2/log.h"
 #include "mongo/logv2/log_capture_backend.h"
@@ -1705,6 +1707,84 @@ TEST_F(LogV2Test, FileLogging) {
     ASSERT(before_rotation == after_rotation);
 }
 
+std::vector<std::string> readLines(const std::string& filename) {
+    std::vector<std::string> lines;
+    std::ifstream file(filename);
+    for (std::string line; std::getline(file, line, '\n');)
+        lines.push_back(std::move(line));
+    return lines;
+}
+
+TEST_F(LogV2Test, AsyncFileLogging) {
+    auto logv2_dir = std::make_unique<mongo::unittest::TempDir>("logv2");
+    std::string file_name = logv2_dir->path() + "/file.log";
+
+    auto fileSink = boost::make_shared<FileRotateSink>(LogTimestampFormat::kISO8601UTC);
+    ASSERT_OK(fileSink->addFile(file_name, false));
+    auto backend = boost::make_shared<AsyncLogBackend>(fileSink, LogTimestampFormat::kISO8601UTC);
+
+    auto sink = wrapInUnlockedSink(backend);
+    applyDefaultFilterToSink(sink);
+    sink->set_formatter(PlainFormatter());
+    attachSink(sink);
+
+    constexpr int kNumThreads = 4;
+    constexpr int kNumPerThread = 1000;
+    std::vector<stdx::thread> threads;
+    for (int t = 0; t < kNumThreads; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < kNumPerThread; ++i)
+                LOGV2(5338719, "async");
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    backend->flush();
+    auto lines = readLines(file_name);
+    ASSERT_EQ(backend->droppedRecords(), 0);
+    ASSERT_EQ(lines.size(), static_cast<size_t>(kNumThreads * kNumPerThread));
+    ASSERT(std::all_of(lines.begin(), lines.end(), [](auto&& line) { return line == "async"; }));
+
+    // Records logged before a rotation are written to the file that is rotated away.
+    LOGV2(5338720, "before rotation");
+    ASSERT_OK(backend->rotate(true, ".rotated"));
+    LOGV2(5338721, "after rotation");
+    backend->flush();
+    ASSERT_EQ(readLines(file_name + ".rotated").back(), "before rotation");
+    ASSERT_EQ(readLines(file_name).back(), "after rotation");
+}
+
+TEST_F(LogV2Test, AsyncFileLoggingDropsWhenBufferIsFull) {
+    auto logv2_dir = std::make_unique<mongo::unittest::TempDir>("logv2");
+    std::string file_name = logv2_dir->path() + "/file.log";
+
+    auto fileSink = boost::make_shared<FileRotateSink>(LogTimestampFormat::kISO8601UTC);
+    ASSERT_OK(fileSink->addFile(file_name, false));
+    auto backend =
+        boost::make_shared<AsyncLogBackend>(fileSink, LogTimestampFormat::kISO8601UTC, 64);
+
+    auto sink = wrapInUnlockedSink(backend);
+    applyDefaultFilterToSink(sink);
+    sink->set_formatter(PlainFormatter());
+    attachSink(sink);
+
+    {
+        // Keep the writer from draining the buffer while it fills up.
+        auto locked = backend->lockedTarget();
+        for (int i = 0; i < 10; ++i)
+            LOGV2(5338722, "dropped {i}", "i"_attr = i);
+    }
+    ASSERT_GT(backend->droppedRecords(), 0);
+
+    backend->flush();
+    auto lines = readLines(file_name);
+    ASSERT_EQ(lines.size(), static_cast<size_t>(10 - backend->droppedRecords() + 1));
+    ASSERT_EQ(lines.front(), "dropped 0");
+    ASSERT_NE(lines.back().find("5338718"), std::string::npos);
+}
+
 TEST_F(LogV2Test, UserAssert) {
     std::vector<std::string> lines;
     auto sink = wrapInSynchronousSink(wrapInCompositeBackend(
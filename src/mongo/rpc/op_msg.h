@@ -205,7 +205,7 @@ class OpMsgBuilder {
     OpMsgBuilder& operator=(const OpMsgBuilder&) = delete;
 
 public:
-    OpMsgBuilder() {
+    OpMsgBuilder() : _buf(SharedBuffer::allocatePooled(BufBuilder::kDefaultInitSizeBytes)) {
         skipHeaderAndFlags();
     }
 
@@ -115,5 +115,13 @@ void ReplyBuilderInterface::setNextInvocation(boost::optional<BSONObj> nextInvoc
     _nextInvocation = nextInvocation;
 }
 
+bool ReplyBuilderInterface::canDeferExhaustReply() const {
+    return _canDeferExhaustReply;
+}
+
+void ReplyBuilderInterface::setCanDeferExhaustReply() {
+    _canDeferExhaustReply = true;
+}
+
 }  // namespace rpc
 }  // namespace mongo
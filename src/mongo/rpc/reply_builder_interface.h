@@ -155,6 +155,17 @@ public:
      */
     virtual void setNextInvocation(boost::optional<BSONObj> nextInvocation);
 
+    /**
+     * For exhaust commands, returns whether the next invocation returns without waiting for new
+     * data, so that this reply may be held back and sent together with the next one.
+     */
+    virtual bool canDeferExhaustReply() const;
+
+    /**
+     * For exhaust commands, indicates that the next invocation will not wait for new data.
+     */
+    virtual void setCanDeferExhaustReply();
+
 protected:
     ReplyBuilderInterface() = default;
 
@@ -165,6 +176,10 @@ private:
     // The next invocation for an exhaust command. If this is boost::none, the previous invocation
     // should be reused for the next invocation.
     boost::optional<BSONObj> _nextInvocation;
+
+    // For exhaust commands, indicates whether the next invocation returns without waiting for new
+    // data.
+    bool _canDeferExhaustReply = false;
 };
 
 }  // namespace rpc
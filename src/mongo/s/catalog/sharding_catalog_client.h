@@ -155,6 +155,15 @@ public:
         StringData db,
         repl::ReadConcernLevel readConcernLevel = repl::ReadConcernLevel::kMajorityReadConcern) = 0;
 
+    /**
+     * Retrieves the entries for the given collections with a single query, in no particular order.
+     * Collections which do not exist have no entry.
+     */
+    virtual std::vector<CollectionType> getCollectionsForNamespaces(
+        OperationContext* opCtx,
+        const std::vector<NamespaceString>& nssList,
+        repl::ReadConcernLevel readConcernLevel = repl::ReadConcernLevel::kMajorityReadConcern) = 0;
+
     /**
      * Returns the set of collections for the specified database, which have been marked as sharded.
      * Goes directly to the config server's metadata, without checking the local cache so it should
@@ -315,6 +315,31 @@ std::vector<CollectionType> ShardingCatalogClientImpl::getCollections(
     return collections;
 }
 
+std::vector<CollectionType> ShardingCatalogClientImpl::getCollectionsForNamespaces(
+    OperationContext* opCtx,
+    const std::vector<NamespaceString>& nssList,
+    repl::ReadConcernLevel readConcernLevel) {
+    BSONArrayBuilder namespaces;
+    for (const auto& nss : nssList) {
+        namespaces.append(nss.ns());
+    }
+
+    const auto query = BSON(CollectionType::kNssFieldName << BSON("$in" << namespaces.arr()));
+    auto collDocs = uassertStatusOK(_exhaustiveFindOnConfig(opCtx,
+                                                            kConfigReadSelector,
+                                                            readConcernLevel,
+                                                            CollectionType::ConfigNS,
+                                                            query,
+                                                            BSONObj(),
+                                                            boost::none))
+                        .value;
+    std::vector<CollectionType> collections;
+    for (const BSONObj& obj : collDocs)
+        collections.emplace_back(obj);
+
+    return collections;
+}
+
 std::vector<NamespaceString> ShardingCatalogClientImpl::getAllShardedCollectionsForDb(
     OperationContext* opCtx, StringData dbName, repl::ReadConcernLevel readConcern) {
     auto collectionsOnConfig = getCollections(opCtx, dbName, readConcern);
@@ -87,6 +87,11 @@ public:
                                                StringData db,
                                                repl::ReadConcernLevel readConcernLevel) override;
 
+    std::vector<CollectionType> getCollectionsForNamespaces(
+        OperationContext* opCtx,
+        const std::vector<NamespaceString>& nssList,
+        repl::ReadConcernLevel readConcernLevel) override;
+
     std::vector<NamespaceString> getAllShardedCollectionsForDb(
         OperationContext* opCtx, StringData dbName, repl::ReadConcernLevel readConcern) override;
 
@@ -84,6 +84,13 @@ std::vector<CollectionType> ShardingCatalogClientMock::getCollections(
     uasserted(ErrorCodes::InternalError, "Method not implemented");
 }
 
+std::vector<CollectionType> ShardingCatalogClientMock::getCollectionsForNamespaces(
+    OperationContext* opCtx,
+    const std::vector<NamespaceString>& nssList,
+    repl::ReadConcernLevel readConcernLevel) {
+    uasserted(ErrorCodes::InternalError, "Method not implemented");
+}
+
 std::vector<NamespaceString> ShardingCatalogClientMock::getAllShardedCollectionsForDb(
     OperationContext* opCtx, StringData dbName, repl::ReadConcernLevel readConcern) {
     return {};
@@ -370,6 +370,7 @@ void CatalogCache::report(BSONObjBuilder* builder) const {
 
     _stats.report(&cacheStatsBuilder);
     _collectionCache.reportStats(&cacheStatsBuilder);
+    _cacheLoader.reportStats(&cacheStatsBuilder);
 }
 
 void CatalogCache::checkAndRecordOperationBlockedByRefresh(OperationContext* opCtx,
@@ -159,6 +159,11 @@ public:
 
     virtual void waitForDatabaseFlush(OperationContext* opCtx, StringData dbName) = 0;
 
+    /**
+     * Appends statistics about the loads performed by this loader, if it keeps any.
+     */
+    virtual void reportStats(BSONObjBuilder* builder) const {}
+
     /**
      * Only used for unit-tests, clears a previously-created catalog cache loader from the specified
      * service context, so that 'create' can be called again.
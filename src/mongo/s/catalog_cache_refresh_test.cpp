@@ -39,7 +39,10 @@
 #include "mongo/s/catalog_cache.h"
 #include "mongo/s/catalog_cache_test_fixture.h"
 #include "mongo/s/database_version.h"
+#include "mongo/s/grid.h"
+#include "mongo/s/mongod_and_mongos_server_parameters_gen.h"
 #include "mongo/unittest/death_test.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -139,6 +142,46 @@ TEST_F(CatalogCacheRefreshTest, FullLoad) {
     ASSERT_EQ(reshardingUUID, cm.getReshardingFields()->getUuid());
 }
 
+TEST_F(CatalogCacheRefreshTest, FullLoadInBatch) {
+    const auto originalMaxBatchSize = gCatalogCacheRefreshMaxBatchSize.load();
+    gCatalogCacheRefreshMaxBatchSize.store(10);
+    ON_BLOCK_EXIT([&] { gCatalogCacheRefreshMaxBatchSize.store(originalMaxBatchSize); });
+
+    const OID epoch = OID::gen();
+    const ShardKeyPattern shardKeyPattern(BSON("_id" << 1));
+
+    auto future = scheduleRoutingInfoUnforcedRefresh(kNss);
+
+    expectGetDatabase();
+
+    // The batch reads config.collections and config.chunks once for all of its collections.
+    expectGetCollection(epoch, shardKeyPattern);
+    expectFindSendBSONObjVector(kConfigHostAndPort, [&]() {
+        ChunkVersion version(1, 0, epoch);
+
+        ChunkType chunk1(
+            kNss, {shardKeyPattern.getKeyPattern().globalMin(), BSON("_id" << 0)}, version, {"0"});
+        chunk1.setName(OID::gen());
+        version.incMinor();
+
+        ChunkType chunk2(
+            kNss, {BSON("_id" << 0), shardKeyPattern.getKeyPattern().globalMax()}, version, {"1"});
+        chunk2.setName(OID::gen());
+
+        return std::vector<BSONObj>{chunk1.toConfigBSON(), chunk2.toConfigBSON()};
+    }());
+
+    auto cm = *future.default_timed_get();
+    ASSERT(cm.isSharded());
+    ASSERT_EQ(2, cm.numChunks());
+
+    BSONObjBuilder statsBuilder;
+    Grid::get(operationContext())->catalogCache()->report(&statsBuilder);
+    const auto batchStats = statsBuilder.obj()["catalogCache"]["batchedCollectionRefreshes"];
+    ASSERT_EQ(1, batchStats["countBatches"].numberLong());
+    ASSERT_EQ(1, batchStats["countRefreshes"].numberLong());
+}
+
 TEST_F(CatalogCacheRefreshTest, NoLoadIfShardNotMarkedStaleInOperationContext) {
     const ShardKeyPattern shardKeyPattern(BSON("_id" << 1));
     auto initialRoutingInfo(
@@ -64,6 +64,96 @@ void checkAllElementsAreOfType(BSONType type, const BSONObj& o) {
             allElementsAreOfType(type, o));
 }
 
+/**
+ * Returns the first 8 bytes of 'keyString' as a big-endian integer, padded with zeroes if the
+ * KeyString is shorter. If prefix(a) < prefix(b) then a < b, so these can be compared in place of
+ * the KeyStrings whenever they differ.
+ */
+uint64_t makeKeyStringPrefix(const std::string& keyString) {
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(prefix); ++i) {
+        prefix <<= 8;
+        if (i < keyString.size()) {
+            prefix |= static_cast<unsigned char>(keyString[i]);
+        }
+    }
+    return prefix;
+}
+
+/**
+ * Returns the index of the first entry in [first, last) whose max KeyString is greater than
+ * 'keyString', or greater than or equal to it if 'isMaxInclusive' is false, or 'last' if there is
+ * none. 'prefixes' holds the packed prefixes of the entries' max KeyStrings and 'getMaxKeyString'
+ * is only called for the entries whose prefix ties with 'keyPrefix'.
+ */
+template <typename GetMaxKeyStringFn>
+size_t findByMaxKeyString(const std::vector<uint64_t>& prefixes,
+                          size_t first,
+                          size_t last,
+                          const std::string& keyString,
+                          uint64_t keyPrefix,
+                          bool isMaxInclusive,
+                          GetMaxKeyStringFn getMaxKeyString) {
+    // Entries whose prefix is below the key's end before the key and entries whose prefix is above
+    // it end after the key, so only the run of entries with an equal prefix needs their full max
+    // KeyString compared.
+    const auto begin = prefixes.begin();
+    size_t low = std::lower_bound(begin + first, begin + last, keyPrefix) - begin;
+    if (low == last || prefixes[low] != keyPrefix) {
+        return low;
+    }
+    size_t high = std::upper_bound(begin + low, begin + last, keyPrefix) - begin;
+
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        const auto& maxKeyString = getMaxKeyString(mid);
+        const bool endsBeforeKey =
+            isMaxInclusive ? !(keyString < maxKeyString) : maxKeyString < keyString;
+        if (endsBeforeKey) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * Probes 'prefixes' at exponentially increasing distances from 'first' and returns the first probed
+ * index whose prefix is above 'keyPrefix', or the size of 'prefixes'. For a key which is known not
+ * to end before entry 'first', this bounds its search to a range proportional to the distance
+ * between 'first' and the key's entry.
+ */
+size_t gallopPastPrefix(const std::vector<uint64_t>& prefixes, size_t first, uint64_t keyPrefix) {
+    size_t last = first;
+    for (size_t step = 1; last < prefixes.size() && prefixes[last] <= keyPrefix; step *= 2) {
+        last += step;
+    }
+    return std::min(last, prefixes.size());
+}
+
+/**
+ * Throws ConflictingOperationInProgress unless 'next' starts exactly where 'prev' ends.
+ */
+void checkContiguous(const ChunkInfo& prev, const ChunkInfo& next) {
+    const auto& lastMax = prev.getMax();
+    const auto& nextMin = next.getMin();
+    if (SimpleBSONObjComparator::kInstance.evaluate(lastMax == nextMin)) {
+        return;
+    }
+
+    if (SimpleBSONObjComparator::kInstance.evaluate(lastMax < nextMin))
+        uasserted(ErrorCodes::ConflictingOperationInProgress,
+                  str::stream() << "Gap exists in the routing table between chunks "
+                                << prev.getRange().toString() << " and "
+                                << next.getRange().toString());
+    else
+        uasserted(ErrorCodes::ConflictingOperationInProgress,
+                  str::stream() << "Overlap exists in the routing table between chunks "
+                                << prev.getRange().toString() << " and "
+                                << next.getRange().toString());
+}
+
 void appendChunkTo(std::vector<std::shared_ptr<ChunkInfo>>& chunks,
                    const std::shared_ptr<ChunkInfo>& chunk) {
     if (!chunks.empty() && chunk->getRange().overlaps(chunks.back()->getRange())) {
@@ -115,93 +205,199 @@ std::vector<std::shared_ptr<ChunkInfo>> flatten(const std::vector<ChunkType>& ch
 
 ShardVersionMap ChunkMap::constructShardVersionMap() const {
     ShardVersionMap shardVersions;
-    ChunkVector::const_iterator current = _chunkMap.cbegin();
 
-    boost::optional<BSONObj> firstMin = boost::none;
-    boost::optional<BSONObj> lastMax = boost::none;
+    for (size_t i = 0; i < _blocks.size(); ++i) {
+        const auto& block = *_blocks[i];
 
-    while (current != _chunkMap.cend()) {
-        const auto& firstChunkInRange = *current;
-        const auto& currentRangeShardId = firstChunkInRange->getShardIdAt(boost::none);
-
-        // Tracks the max shard version for the shard on which the current range will reside
-        auto shardVersionIt = shardVersions.find(currentRangeShardId);
-        if (shardVersionIt == shardVersions.end()) {
-            shardVersionIt =
-                shardVersions.emplace(currentRangeShardId, _collectionVersion.epoch()).first;
+        // The chunks within each block were checked when it was sealed, so only the boundaries
+        // between blocks remain to be checked for the continuity of the chunks map.
+        if (i > 0) {
+            checkContiguous(*_blocks[i - 1]->chunks.back(), *block.chunks.front());
         }
 
-        auto& maxShardVersion = shardVersionIt->second.shardVersion;
-
-        current =
-            std::find_if(current,
-                         _chunkMap.cend(),
-                         [&currentRangeShardId, &maxShardVersion](const auto& currentChunk) {
-                             if (currentChunk->getShardIdAt(boost::none) != currentRangeShardId)
-                                 return true;
-
-                             if (currentChunk->getLastmod() > maxShardVersion)
-                                 maxShardVersion = currentChunk->getLastmod();
-
-                             return false;
-                         });
-
-        const auto rangeLast = *std::prev(current);
-
-        const auto& rangeMin = firstChunkInRange->getMin();
-        const auto& rangeMax = rangeLast->getMax();
-
-        // Check the continuity of the chunks map
-        if (lastMax && !SimpleBSONObjComparator::kInstance.evaluate(*lastMax == rangeMin)) {
-            if (SimpleBSONObjComparator::kInstance.evaluate(*lastMax < rangeMin))
-                uasserted(ErrorCodes::ConflictingOperationInProgress,
-                          str::stream() << "Gap exists in the routing table between chunks "
-                                        << findIntersectingChunk(*lastMax)->getRange().toString()
-                                        << " and " << rangeLast->getRange().toString());
-            else
-                uasserted(ErrorCodes::ConflictingOperationInProgress,
-                          str::stream() << "Overlap exists in the routing table between chunks "
-                                        << findIntersectingChunk(*lastMax)->getRange().toString()
-                                        << " and " << rangeLast->getRange().toString());
+        for (const auto& [shardId, blockShardVersion] : block.shardVersions) {
+            auto shardVersionIt = shardVersions.find(shardId);
+            if (shardVersionIt == shardVersions.end()) {
+                shardVersionIt = shardVersions.emplace(shardId, _collectionVersion.epoch()).first;
+            }
+
+            auto& maxShardVersion = shardVersionIt->second.shardVersion;
+            if (blockShardVersion > maxShardVersion)
+                maxShardVersion = blockShardVersion;
         }
+    }
 
-        if (!firstMin)
-            firstMin = rangeMin;
+    if (!_blocks.empty()) {
+        invariant(!shardVersions.empty());
 
-        lastMax = rangeMax;
+        checkAllElementsAreOfType(MinKey, _blocks.front()->chunks.front()->getMin());
+        checkAllElementsAreOfType(MaxKey, _blocks.back()->chunks.back()->getMax());
+    }
 
-        // If a shard has chunks it must have a shard version, otherwise we have an invalid chunk
-        // somewhere, which should have been caught at chunk load time
-        invariant(maxShardVersion.isSet());
+    return shardVersions;
+}
+
+void ChunkMap::_appendChunk(const std::shared_ptr<ChunkInfo>& chunk, size_t maxChunksPerBlock) {
+    _collectionVersion = std::max(_collectionVersion, chunk->getLastmod());
+
+    const auto maxKeyPrefix = makeKeyStringPrefix(chunk->getMaxKeyString());
+
+    if (!_blocks.empty()) {
+        const auto& lastChunk = _blocks.back()->chunks.back();
+        if (chunk->getRange().overlaps(lastChunk->getRange())) {
+            if (chunk->getLastmod() > lastChunk->getLastmod()) {
+                // The last block may be shared with another map, in which case it must be copied
+                // before it can be modified.
+                if (!_lastBlockIsOpen) {
+                    auto copy = std::make_shared<Block>(*_blocks.back());
+                    copy->shardVersions.clear();
+                    _blocks.back() = std::move(copy);
+                    _lastBlockIsOpen = true;
+                }
+
+                auto& block = *_blocks.back();
+                block.chunks.back() = chunk;
+                block.maxKeyPrefixes.back() = maxKeyPrefix;
+                _blockMaxKeyPrefixes.back() = maxKeyPrefix;
+            }
+            return;
+        }
     }
 
-    if (!_chunkMap.empty()) {
-        invariant(!shardVersions.empty());
-        invariant(firstMin.is_initialized());
-        invariant(lastMax.is_initialized());
+    if (!_lastBlockIsOpen || _blocks.back()->chunks.size() >= maxChunksPerBlock) {
+        _sealLastBlock();
+        _blocks.push_back(std::make_shared<Block>());
+        _blockMaxKeyPrefixes.push_back(maxKeyPrefix);
+        _lastBlockIsOpen = true;
+    }
+
+    auto& block = *_blocks.back();
+    block.chunks.push_back(chunk);
+    block.maxKeyPrefixes.push_back(maxKeyPrefix);
+    _blockMaxKeyPrefixes.back() = maxKeyPrefix;
+    ++_size;
+}
 
-        checkAllElementsAreOfType(MinKey, firstMin.get());
-        checkAllElementsAreOfType(MaxKey, lastMax.get());
+void ChunkMap::_appendBlock(const std::shared_ptr<Block>& block) {
+    if (_lastBlockIsOpen && _blocks.back()->chunks.size() < kMinChunksPerBlock) {
+        // Sharing the block would leave the small block being built behind it, and repeated
+        // updates would fragment the map into many small blocks. Combine the two instead, split
+        // evenly in two if they do not fit in one block so that neither half is small.
+        const size_t numChunks = _blocks.back()->chunks.size() + block->chunks.size();
+        const size_t maxChunksPerBlock =
+            numChunks <= kMaxChunksPerBlock ? kMaxChunksPerBlock : numChunks - numChunks / 2;
+        for (const auto& chunk : block->chunks) {
+            _appendChunk(chunk, maxChunksPerBlock);
+        }
+        return;
     }
 
-    return shardVersions;
+    _sealLastBlock();
+
+    _blocks.push_back(block);
+    _blockMaxKeyPrefixes.push_back(block->maxKeyPrefixes.back());
+    _size += block->chunks.size();
+
+    for (const auto& shardVersion : block->shardVersions) {
+        _collectionVersion = std::max(_collectionVersion, shardVersion.second);
+    }
 }
 
-void ChunkMap::appendChunk(const std::shared_ptr<ChunkInfo>& chunk) {
-    appendChunkTo(_chunkMap, chunk);
+void ChunkMap::_sealLastBlock() {
+    if (!_lastBlockIsOpen) {
+        return;
+    }
 
-    _collectionVersion = std::max(_collectionVersion, chunk->getLastmod());
+    auto& block = *_blocks.back();
+
+    stdx::unordered_map<ShardId, ChunkVersion, ShardId::Hasher> shardVersions;
+    for (size_t i = 0; i < block.chunks.size(); ++i) {
+        const auto& chunk = block.chunks[i];
+        if (i > 0) {
+            checkContiguous(*block.chunks[i - 1], *chunk);
+        }
+
+        auto [it, inserted] =
+            shardVersions.emplace(chunk->getShardIdAt(boost::none), chunk->getLastmod());
+        if (!inserted && chunk->getLastmod() > it->second) {
+            it->second = chunk->getLastmod();
+        }
+    }
+
+    block.shardVersions.assign(shardVersions.begin(), shardVersions.end());
+    for (const auto& shardVersion : block.shardVersions) {
+        // If a shard has chunks it must have a shard version, otherwise we have an invalid chunk
+        // somewhere, which should have been caught at chunk load time
+        invariant(shardVersion.second.isSet());
+    }
+
+    _lastBlockIsOpen = false;
 }
 
 std::shared_ptr<ChunkInfo> ChunkMap::findIntersectingChunk(const BSONObj& shardKey) const {
     const auto it = _findIntersectingChunk(shardKey);
 
-    if (it != _chunkMap.end())
+    if (it != _end())
         return *it;
 
     return std::shared_ptr<ChunkInfo>();
 }
 
+std::vector<std::shared_ptr<ChunkInfo>> ChunkMap::findIntersectingChunks(
+    const std::vector<BSONObj>& shardKeys) const {
+    std::vector<std::pair<std::string, size_t>> sortedKeyStrings;
+    sortedKeyStrings.reserve(shardKeys.size());
+    for (size_t i = 0; i < shardKeys.size(); ++i) {
+        sortedKeyStrings.emplace_back(ShardKeyPattern::toKeyString(shardKeys[i]), i);
+    }
+    std::sort(sortedKeyStrings.begin(), sortedKeyStrings.end());
+
+    const auto blockMaxKeyString = [&](size_t i) -> const std::string& {
+        return _blocks[i]->chunks.back()->getMaxKeyString();
+    };
+
+    std::vector<std::shared_ptr<ChunkInfo>> chunks(shardKeys.size());
+    size_t blockIndex = 0;
+    size_t chunkIndex = 0;
+    for (const auto& [shardKeyString, index] : sortedKeyStrings) {
+        const auto shardKeyPrefix = makeKeyStringPrefix(shardKeyString);
+
+        // The keys are visited in increasing order, so the chunk for this key cannot precede the
+        // chunk found for the previous key. Gallop forward from there, first through the blocks
+        // and then through the chunks of the block which holds the key.
+        const auto nextBlockIndex =
+            findByMaxKeyString(_blockMaxKeyPrefixes,
+                               blockIndex,
+                               gallopPastPrefix(_blockMaxKeyPrefixes, blockIndex, shardKeyPrefix),
+                               shardKeyString,
+                               shardKeyPrefix,
+                               true,
+                               blockMaxKeyString);
+        if (nextBlockIndex == _blocks.size()) {
+            break;
+        }
+        if (nextBlockIndex != blockIndex) {
+            blockIndex = nextBlockIndex;
+            chunkIndex = 0;
+        }
+
+        const auto& block = *_blocks[blockIndex];
+        chunkIndex =
+            findByMaxKeyString(block.maxKeyPrefixes,
+                               chunkIndex,
+                               gallopPastPrefix(block.maxKeyPrefixes, chunkIndex, shardKeyPrefix),
+                               shardKeyString,
+                               shardKeyPrefix,
+                               true,
+                               [&](size_t i) -> const std::string& {
+                                   return block.chunks[i]->getMaxKeyString();
+                               });
+        chunks[index] = block.chunks[chunkIndex];
+    }
+
+    return chunks;
+}
+
 void validateChunk(const std::shared_ptr<ChunkInfo>& chunk, const ChunkVersion& version) {
     uassert(ErrorCodes::ConflictingOperationInProgress,
             str::stream() << "Changed chunk " << chunk->toString()
@@ -213,86 +409,128 @@ void validateChunk(const std::shared_ptr<ChunkInfo>& chunk, const ChunkVersion&
 
 ChunkMap ChunkMap::createMerged(
     const std::vector<std::shared_ptr<ChunkInfo>>& changedChunks) const {
-    size_t chunkMapIndex = 0;
     size_t changedChunkIndex = 0;
 
-    ChunkMap updatedChunkMap(getVersion().epoch(), _chunkMap.size() + changedChunks.size());
-
-    while (chunkMapIndex < _chunkMap.size() || changedChunkIndex < changedChunks.size()) {
-        if (chunkMapIndex >= _chunkMap.size()) {
-            validateChunk(changedChunks[changedChunkIndex], getVersion());
-            updatedChunkMap.appendChunk(changedChunks[changedChunkIndex++]);
+    ChunkMap updatedChunkMap(getVersion().epoch());
+
+    for (const auto& block : _blocks) {
+        // Share the block if none of its chunks are replaced, which is the case unless it overlaps
+        // the changed chunk appended last or the next one to be appended, since the changed chunks
+        // are ordered.
+        const bool overlapsLastAppended = updatedChunkMap.size() > 0 &&
+            updatedChunkMap._blocks.back()->chunks.back()->getRange().overlaps(
+                block->chunks.front()->getRange());
+        const bool overlapsNextChanged = changedChunkIndex < changedChunks.size() &&
+            SimpleBSONObjComparator::kInstance.evaluate(
+                changedChunks[changedChunkIndex]->getMin() < block->chunks.back()->getMax());
+
+        if (!overlapsLastAppended && !overlapsNextChanged) {
+            updatedChunkMap._appendBlock(block);
             continue;
         }
 
-        if (changedChunkIndex >= changedChunks.size()) {
-            updatedChunkMap.appendChunk(_chunkMap[chunkMapIndex++]);
-            continue;
-        }
+        size_t chunkIndex = 0;
 
-        auto overlap = _chunkMap[chunkMapIndex]->getRange().overlaps(
-            changedChunks[changedChunkIndex]->getRange());
+        while (chunkIndex < block->chunks.size()) {
+            const auto& chunkInfo = block->chunks[chunkIndex];
 
-        if (overlap) {
-            auto& changedChunk = changedChunks[changedChunkIndex++];
-            auto& chunkInfo = _chunkMap[chunkMapIndex];
+            if (changedChunkIndex >= changedChunks.size()) {
+                updatedChunkMap._appendChunk(chunkInfo);
+                ++chunkIndex;
+                continue;
+            }
 
-            auto bytesInReplacedChunk = chunkInfo->getWritesTracker()->getBytesWritten();
-            changedChunk->getWritesTracker()->addBytesWritten(bytesInReplacedChunk);
+            auto overlap = chunkInfo->getRange().overlaps(
+                changedChunks[changedChunkIndex]->getRange());
 
-            validateChunk(changedChunk, getVersion());
-            updatedChunkMap.appendChunk(changedChunk);
-        } else {
-            updatedChunkMap.appendChunk(_chunkMap[chunkMapIndex++]);
+            if (overlap) {
+                auto& changedChunk = changedChunks[changedChunkIndex++];
+
+                auto bytesInReplacedChunk = chunkInfo->getWritesTracker()->getBytesWritten();
+                changedChunk->getWritesTracker()->addBytesWritten(bytesInReplacedChunk);
+
+                validateChunk(changedChunk, getVersion());
+                updatedChunkMap._appendChunk(changedChunk);
+            } else {
+                updatedChunkMap._appendChunk(chunkInfo);
+                ++chunkIndex;
+            }
         }
     }
 
+    while (changedChunkIndex < changedChunks.size()) {
+        validateChunk(changedChunks[changedChunkIndex], getVersion());
+        updatedChunkMap._appendChunk(changedChunks[changedChunkIndex++]);
+    }
+
+    updatedChunkMap._sealLastBlock();
+
     return updatedChunkMap;
 }
 
+size_t ChunkMap::numSharedBlocksWith_forTest(const ChunkMap& other) const {
+    size_t numSharedBlocks = 0;
+    for (const auto& block : _blocks) {
+        numSharedBlocks += std::count(other._blocks.begin(), other._blocks.end(), block);
+    }
+    return numSharedBlocks;
+}
+
 BSONObj ChunkMap::toBSON() const {
     BSONObjBuilder builder;
 
     builder.append("startingVersion"_sd, getVersion().toBSON());
-    builder.append("chunkCount", static_cast<int64_t>(_chunkMap.size()));
+    builder.append("chunkCount", static_cast<int64_t>(size()));
 
     {
         BSONArrayBuilder arrayBuilder(builder.subarrayStart("chunks"_sd));
-        for (const auto& chunk : _chunkMap) {
-            arrayBuilder.append(chunk->toString());
+        for (auto it = _begin(); it != _end(); ++it) {
+            arrayBuilder.append((*it)->toString());
         }
     }
 
     return builder.obj();
 }
 
-ChunkMap::ChunkVector::const_iterator ChunkMap::_findIntersectingChunk(const BSONObj& shardKey,
-                                                                       bool isMaxInclusive) const {
-    auto shardKeyString = ShardKeyPattern::toKeyString(shardKey);
-
-    if (!isMaxInclusive) {
-        return std::lower_bound(_chunkMap.begin(),
-                                _chunkMap.end(),
-                                shardKey,
-                                [&shardKeyString](const auto& chunkInfo, const BSONObj& shardKey) {
-                                    return chunkInfo->getMaxKeyString() < shardKeyString;
-                                });
-    } else {
-        return std::upper_bound(_chunkMap.begin(),
-                                _chunkMap.end(),
-                                shardKey,
-                                [&shardKeyString](const BSONObj& shardKey, const auto& chunkInfo) {
-                                    return shardKeyString < chunkInfo->getMaxKeyString();
-                                });
+ChunkMap::const_iterator ChunkMap::_findIntersectingChunk(const BSONObj& shardKey,
+                                                          bool isMaxInclusive) const {
+    const auto shardKeyString = ShardKeyPattern::toKeyString(shardKey);
+    const auto shardKeyPrefix = makeKeyStringPrefix(shardKeyString);
+
+    // The key's chunk is in the first block whose last chunk ends after the key.
+    const auto blockMaxKeyString = [&](size_t i) -> const std::string& {
+        return _blocks[i]->chunks.back()->getMaxKeyString();
+    };
+    const auto blockIndex = findByMaxKeyString(_blockMaxKeyPrefixes,
+                                               0,
+                                               _blocks.size(),
+                                               shardKeyString,
+                                               shardKeyPrefix,
+                                               isMaxInclusive,
+                                               blockMaxKeyString);
+    if (blockIndex == _blocks.size()) {
+        return _end();
     }
+
+    const auto& block = *_blocks[blockIndex];
+    const auto chunkIndex = findByMaxKeyString(block.maxKeyPrefixes,
+                                               0,
+                                               block.chunks.size(),
+                                               shardKeyString,
+                                               shardKeyPrefix,
+                                               isMaxInclusive,
+                                               [&](size_t i) -> const std::string& {
+                                                   return block.chunks[i]->getMaxKeyString();
+                                               });
+    return const_iterator(&_blocks, blockIndex, chunkIndex);
 }
 
-std::pair<ChunkMap::ChunkVector::const_iterator, ChunkMap::ChunkVector::const_iterator>
-ChunkMap::_overlappingBounds(const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const {
+std::pair<ChunkMap::const_iterator, ChunkMap::const_iterator> ChunkMap::_overlappingBounds(
+    const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const {
     const auto itMin = _findIntersectingChunk(min);
     const auto itMax = [&]() {
         auto it = _findIntersectingChunk(max, isMaxInclusive);
-        return it == _chunkMap.end() ? it : ++it;
+        return it == _end() ? it : ++it;
     }();
 
     return {itMin, itMax};
@@ -360,6 +598,23 @@ Chunk ChunkManager::findIntersectingChunk(const BSONObj& shardKey, const BSONObj
     return Chunk(*chunkInfo, _clusterTime);
 }
 
+std::vector<boost::optional<Chunk>> ChunkManager::findIntersectingChunksWithSimpleCollation(
+    const std::vector<BSONObj>& shardKeys) const {
+    auto chunkInfos = _rt->optRt->findIntersectingChunks(shardKeys);
+
+    std::vector<boost::optional<Chunk>> chunks;
+    chunks.reserve(chunkInfos.size());
+    for (size_t i = 0; i < chunkInfos.size(); ++i) {
+        if (chunkInfos[i] && chunkInfos[i]->containsKey(shardKeys[i])) {
+            chunks.emplace_back(Chunk(*chunkInfos[i], _clusterTime));
+        } else {
+            chunks.emplace_back(boost::none);
+        }
+    }
+
+    return chunks;
+}
+
 bool ChunkManager::keyBelongsToShard(const BSONObj& shardKey, const ShardId& shardId) const {
     if (shardKey.isEmpty())
         return false;
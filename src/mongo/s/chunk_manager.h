@@ -72,16 +72,75 @@ using ShardVersionMap = stdx::unordered_map<ShardId, ShardVersionTargetingInfo,
  * underlying implementation.
  */
 class ChunkMap {
-    // Vector of chunks ordered by max key.
     using ChunkVector = std::vector<std::shared_ptr<ChunkInfo>>;
 
+    // Chunks are stored ordered by max key in a sequence of blocks of up to kMaxChunksPerBlock
+    // chunks each. A block is never modified once the map which built it is complete, so
+    // createMerged() shares every block that an update does not touch with the map it was created
+    // from, rather than copying all of the chunks.
+    struct Block {
+        ChunkVector chunks;
+
+        // The first bytes of each chunk's max KeyString, packed into an integer so that comparing
+        // two prefixes orders them the same way as the KeyStrings themselves. Lookups
+        // binary-search this contiguous array first and only compare the full KeyStrings of the
+        // chunks whose prefix ties with the key's, which avoids chasing a pointer per probe.
+        std::vector<uint64_t> maxKeyPrefixes;
+
+        // The max version of the chunks in this block on each shard which owns any of them, so
+        // that constructShardVersionMap() only needs to visit each block rather than each chunk.
+        std::vector<std::pair<ShardId, ChunkVersion>> shardVersions;
+    };
+    using BlockVector = std::vector<std::shared_ptr<Block>>;
+
 public:
-    explicit ChunkMap(OID epoch, size_t initialCapacity = 0) : _collectionVersion(0, 0, epoch) {
-        _chunkMap.reserve(initialCapacity);
-    }
+    static constexpr size_t kMaxChunksPerBlock = 1024;
+    static constexpr size_t kMinChunksPerBlock = kMaxChunksPerBlock / 4;
+
+    /**
+     * Iterates over the chunks in order of their max key.
+     */
+    class const_iterator {
+    public:
+        const std::shared_ptr<ChunkInfo>& operator*() const {
+            return (*_blocks)[_blockIndex]->chunks[_chunkIndex];
+        }
+
+        const std::shared_ptr<ChunkInfo>* operator->() const {
+            return &operator*();
+        }
+
+        const_iterator& operator++() {
+            if (++_chunkIndex == (*_blocks)[_blockIndex]->chunks.size()) {
+                ++_blockIndex;
+                _chunkIndex = 0;
+            }
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return _blockIndex == other._blockIndex && _chunkIndex == other._chunkIndex;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        friend class ChunkMap;
+
+        const_iterator(const BlockVector* blocks, size_t blockIndex, size_t chunkIndex)
+            : _blocks(blocks), _blockIndex(blockIndex), _chunkIndex(chunkIndex) {}
+
+        const BlockVector* _blocks;
+        size_t _blockIndex;
+        size_t _chunkIndex;
+    };
+
+    explicit ChunkMap(OID epoch) : _collectionVersion(0, 0, epoch) {}
 
     size_t size() const {
-        return _chunkMap.size();
+        return _size;
     }
 
     ChunkVersion getVersion() const {
@@ -90,9 +149,9 @@ public:
 
     template <typename Callable>
     void forEach(Callable&& handler, const BSONObj& shardKey = BSONObj()) const {
-        auto it = shardKey.isEmpty() ? _chunkMap.begin() : _findIntersectingChunk(shardKey);
+        auto it = shardKey.isEmpty() ? _begin() : _findIntersectingChunk(shardKey);
 
-        for (; it != _chunkMap.end(); ++it) {
+        for (; it != _end(); ++it) {
             if (!handler(*it))
                 break;
         }
@@ -114,19 +173,74 @@ public:
     ShardVersionMap constructShardVersionMap() const;
     std::shared_ptr<ChunkInfo> findIntersectingChunk(const BSONObj& shardKey) const;
 
-    void appendChunk(const std::shared_ptr<ChunkInfo>& chunk);
+    /**
+     * Returns the result of findIntersectingChunk() for each key in 'shardKeys', in the same order.
+     * The keys are sorted first so that the chunk map is walked forward once for the whole batch
+     * rather than searched from scratch for every key.
+     */
+    std::vector<std::shared_ptr<ChunkInfo>> findIntersectingChunks(
+        const std::vector<BSONObj>& shardKeys) const;
 
+    /**
+     * Returns a new map with 'changedChunks', which must be ordered by max key and not overlap each
+     * other, replacing the chunks they overlap in this map. Blocks of this map which contain none
+     * of the replaced chunks are shared with the new map.
+     */
     ChunkMap createMerged(const std::vector<std::shared_ptr<ChunkInfo>>& changedChunks) const;
 
+    /**
+     * Returns the number of blocks in this map which are also referenced by 'other'. For testing.
+     */
+    size_t numSharedBlocksWith_forTest(const ChunkMap& other) const;
+
     BSONObj toBSON() const;
 
 private:
-    ChunkVector::const_iterator _findIntersectingChunk(const BSONObj& shardKey,
-                                                       bool isMaxInclusive = true) const;
-    std::pair<ChunkVector::const_iterator, ChunkVector::const_iterator> _overlappingBounds(
-        const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const;
+    const_iterator _begin() const {
+        return const_iterator(&_blocks, 0, 0);
+    }
+
+    const_iterator _end() const {
+        return const_iterator(&_blocks, _blocks.size(), 0);
+    }
+
+    /**
+     * Appends 'chunk' to the last block, starting a new one if it already holds 'maxChunksPerBlock'
+     * chunks. If 'chunk' overlaps the last chunk in the map, the one with the higher version is
+     * kept.
+     */
+    void _appendChunk(const std::shared_ptr<ChunkInfo>& chunk,
+                      size_t maxChunksPerBlock = kMaxChunksPerBlock);
 
-    ChunkVector _chunkMap;
+    /**
+     * Appends a complete block from another map, sharing it rather than copying its chunks unless
+     * that would leave a small block behind it.
+     */
+    void _appendBlock(const std::shared_ptr<Block>& block);
+
+    /**
+     * Validates the chunks of the block being built and summarizes their versions per shard. No
+     * more chunks may be added to it afterwards.
+     */
+    void _sealLastBlock();
+
+    const_iterator _findIntersectingChunk(const BSONObj& shardKey,
+                                          bool isMaxInclusive = true) const;
+    std::pair<const_iterator, const_iterator> _overlappingBounds(const BSONObj& min,
+                                                                 const BSONObj& max,
+                                                                 bool isMaxInclusive) const;
+
+    BlockVector _blocks;
+
+    // The packed prefix of the max KeyString of the last chunk in each block, parallel to
+    // '_blocks', used to find the block which holds a key.
+    std::vector<uint64_t> _blockMaxKeyPrefixes;
+
+    // Whether the last block is still being built by this map, and so may still be modified.
+    bool _lastBlockIsOpen{false};
+
+    // Total number of chunks across all blocks
+    size_t _size{0};
 
     // Max version across all chunks
     ChunkVersion _collectionVersion;
@@ -253,6 +367,11 @@ public:
         return _chunkMap.findIntersectingChunk(shardKey);
     }
 
+    std::vector<std::shared_ptr<ChunkInfo>> findIntersectingChunks(
+        const std::vector<BSONObj>& shardKeys) const {
+        return _chunkMap.findIntersectingChunks(shardKeys);
+    }
+
     /**
      * Returns the ids of all shards on which the collection has any chunks.
      */
@@ -566,6 +685,14 @@ public:
         return findIntersectingChunk(shardKey, CollationSpec::kSimpleSpec);
     }
 
+    /**
+     * Batched form of findIntersectingChunkWithSimpleCollation(), for targeting many documents at
+     * once. Returns one entry per key in 'shardKeys', in the same order, which is boost::none
+     * instead of throwing if no chunk contains that key.
+     */
+    std::vector<boost::optional<Chunk>> findIntersectingChunksWithSimpleCollation(
+        const std::vector<BSONObj>& shardKeys) const;
+
     /**
      * Finds the shard id of the shard that owns the chunk minKey belongs to, assuming the simple
      * collation because shard keys do not support non-simple collations.
@@ -403,6 +403,23 @@ MONGO_INITIALIZER(RegisterBenchmarks)(InitializerContext* context) {
             ->Args({2, 2});
     }
 
+    // Point lookups on large routing tables, where the cost of searching the chunk map is
+    // dominated by cache misses.
+    std::initializer_list<benchmark::internal::Benchmark*> largeTableLookupCases{
+        REGISTER_BENCHMARK_CAPTURE(BM_FindIntersectingChunk,
+                                   PessimalLargeTable,
+                                   makeChunkManagerWithPessimalBalancedDistribution),
+        REGISTER_BENCHMARK_CAPTURE(BM_FindIntersectingChunk,
+                                   OptimalLargeTable,
+                                   makeChunkManagerWithOptimalBalancedDistribution),
+        REGISTER_BENCHMARK_CAPTURE(
+            BM_KeyBelongsToMe, OptimalLargeTable, makeChunkManagerWithOptimalBalancedDistribution),
+    };
+
+    for (auto bmCase : largeTableLookupCases) {
+        bmCase->Args({10, 250000})->Args({10, 500000})->Args({100, 1000000});
+    }
+
     return Status::OK();
 }
 
@@ -165,4 +165,155 @@ TEST_F(ChunkMapTest, TestEnumerateOverlappingChunks) {
     ASSERT_EQ(count, 3);
 }
 
+TEST_F(ChunkMapTest, TestIntersectingChunkWithCommonKeyPrefix) {
+    const OID epoch = OID::gen();
+    ChunkMap chunkMap{epoch};
+    ChunkVersion version{1, 0, epoch};
+
+    // String bounds sharing a long common prefix, so that lookups must fall back to comparing the
+    // full KeyStrings.
+    auto key = [](int i) { return BSON("a" << ("user_" + std::to_string(1000 + i * 10))); };
+
+    std::vector<std::shared_ptr<ChunkInfo>> chunks;
+    chunks.push_back(std::make_shared<ChunkInfo>(ChunkType{
+        kNss, ChunkRange{getShardKeyPattern().globalMin(), key(0)}, version, kThisShard}));
+    for (int i = 0; i < 10; ++i) {
+        chunks.push_back(std::make_shared<ChunkInfo>(
+            ChunkType{kNss, ChunkRange{key(i), key(i + 1)}, version, kThisShard}));
+    }
+    chunks.push_back(std::make_shared<ChunkInfo>(ChunkType{
+        kNss, ChunkRange{key(10), getShardKeyPattern().globalMax()}, version, kThisShard}));
+
+    auto newChunkMap = chunkMap.createMerged(chunks);
+    ASSERT_EQ(newChunkMap.size(), 12);
+
+    for (int i = 0; i < 10; ++i) {
+        // A chunk's min bound belongs to it.
+        auto intersectingChunk = newChunkMap.findIntersectingChunk(key(i));
+        ASSERT(intersectingChunk);
+        ASSERT_BSONOBJ_EQ(intersectingChunk->getMin(), key(i));
+
+        // So does a key strictly inside it.
+        intersectingChunk = newChunkMap.findIntersectingChunk(
+            BSON("a" << ("user_" + std::to_string(1000 + i * 10) + "5")));
+        ASSERT(intersectingChunk);
+        ASSERT_BSONOBJ_EQ(intersectingChunk->getMin(), key(i));
+    }
+
+    auto intersectingChunk = newChunkMap.findIntersectingChunk(BSON("a"
+                                                                    << "user_"));
+    ASSERT(intersectingChunk);
+    ASSERT_BSONOBJ_EQ(intersectingChunk->getMax(), key(0));
+
+    int count = 0;
+    newChunkMap.forEachOverlappingChunk(key(2), key(5), false, [&](const auto& chunk) {
+        count++;
+        return true;
+    });
+    ASSERT_EQ(count, 3);
+}
+
+TEST_F(ChunkMapTest, TestIntersectingChunksForBatchOfKeys) {
+    const OID epoch = OID::gen();
+    ChunkMap chunkMap{epoch};
+    ChunkVersion version{1, 0, epoch};
+
+    std::vector<std::shared_ptr<ChunkInfo>> chunks;
+    chunks.push_back(std::make_shared<ChunkInfo>(ChunkType{
+        kNss, ChunkRange{getShardKeyPattern().globalMin(), BSON("a" << 0)}, version, kThisShard}));
+    for (int i = 0; i < 100; ++i) {
+        chunks.push_back(std::make_shared<ChunkInfo>(
+            ChunkType{kNss,
+                      ChunkRange{BSON("a" << i * 10), BSON("a" << (i + 1) * 10)},
+                      version,
+                      kThisShard}));
+    }
+    chunks.push_back(std::make_shared<ChunkInfo>(
+        ChunkType{kNss,
+                  ChunkRange{BSON("a" << 1000), getShardKeyPattern().globalMax()},
+                  version,
+                  kThisShard}));
+
+    auto newChunkMap = chunkMap.createMerged(chunks);
+
+    // Unsorted keys, with duplicates and keys at chunk boundaries.
+    std::vector<BSONObj> keys{BSON("a" << 995),
+                              BSON("a" << -5),
+                              BSON("a" << 10),
+                              BSON("a" << 5000),
+                              BSON("a" << 10),
+                              BSON("a" << 0),
+                              BSON("a" << 437),
+                              BSON("a" << 9)};
+
+    auto intersectingChunks = newChunkMap.findIntersectingChunks(keys);
+    ASSERT_EQ(intersectingChunks.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ASSERT(intersectingChunks[i]);
+        ASSERT_EQ(intersectingChunks[i], newChunkMap.findIntersectingChunk(keys[i]));
+    }
+}
+
+TEST_F(ChunkMapTest, TestIncrementalUpdateSharesUnchangedBlocks) {
+    const OID epoch = OID::gen();
+    ChunkMap chunkMap{epoch};
+    ChunkVersion version{1, 0, epoch};
+
+    const int numChunks = ChunkMap::kMaxChunksPerBlock * 8;
+    auto bound = [&](int i) {
+        if (i == 0)
+            return getShardKeyPattern().globalMin();
+        if (i == numChunks)
+            return getShardKeyPattern().globalMax();
+        return BSON("a" << i * 10);
+    };
+
+    std::vector<std::shared_ptr<ChunkInfo>> chunks;
+    for (int i = 0; i < numChunks; ++i) {
+        chunks.push_back(std::make_shared<ChunkInfo>(
+            ChunkType{kNss, ChunkRange{bound(i), bound(i + 1)}, version, kThisShard}));
+    }
+    auto initialChunkMap = chunkMap.createMerged(chunks);
+    ASSERT_EQ(initialChunkMap.size(), numChunks);
+
+    // Split one chunk in the middle of the map.
+    const int splitChunk = numChunks / 2;
+    const auto splitPoint = BSON("a" << splitChunk * 10 + 5);
+    version.incMajor();
+    auto updatedChunkMap = initialChunkMap.createMerged(
+        {std::make_shared<ChunkInfo>(
+             ChunkType{kNss, ChunkRange{bound(splitChunk), splitPoint}, version, kThisShard}),
+         std::make_shared<ChunkInfo>(
+             ChunkType{kNss, ChunkRange{splitPoint, bound(splitChunk + 1)}, version, kThisShard})});
+
+    ASSERT_EQ(updatedChunkMap.size(), numChunks + 1);
+    ASSERT_EQ(updatedChunkMap.getVersion(), version);
+
+    // Only the blocks around the split chunk should have been rebuilt.
+    ASSERT_GTE(updatedChunkMap.numSharedBlocksWith_forTest(initialChunkMap), 6);
+
+    const auto keyAfterSplitPoint = BSON("a" << splitChunk * 10 + 7);
+    auto intersectingChunk = updatedChunkMap.findIntersectingChunk(keyAfterSplitPoint);
+    ASSERT(intersectingChunk);
+    ASSERT_BSONOBJ_EQ(intersectingChunk->getMin(), splitPoint);
+    ASSERT_EQ(intersectingChunk->getLastmod(), version);
+
+    // The original map is unchanged.
+    ASSERT_EQ(initialChunkMap.size(), numChunks);
+    intersectingChunk = initialChunkMap.findIntersectingChunk(keyAfterSplitPoint);
+    ASSERT(intersectingChunk);
+    ASSERT_BSONOBJ_EQ(intersectingChunk->getMin(), bound(splitChunk));
+
+    int count = 0;
+    auto lastMax = getShardKeyPattern().globalMin();
+    updatedChunkMap.forEach([&](const auto& chunkInfo) {
+        ASSERT_BSONOBJ_EQ(chunkInfo->getMin(), lastMax);
+        lastMax = chunkInfo->getMax();
+        count++;
+        return true;
+    });
+    ASSERT_EQ(count, numChunks + 1);
+    ASSERT_EQ(updatedChunkMap.constructShardVersionMap().size(), 1);
+}
+
 }  // namespace mongo
\ No newline at end of file
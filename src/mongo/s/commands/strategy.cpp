@@ -1315,6 +1315,7 @@ DbResponse ClientCommand::_produceResponse() {
         if (responseObj.getField("ok").trueValue()) {
             dbResponse.shouldRunAgainForExhaust = reply->shouldRunAgainForExhaust();
             dbResponse.nextInvocation = reply->getNextInvocation();
+            dbResponse.canDeferExhaustReply = reply->canDeferExhaustReply();
         }
     }
     dbResponse.response = reply->done();
@@ -39,7 +39,9 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/s/catalog/sharding_catalog_client.h"
 #include "mongo/s/grid.h"
+#include "mongo/s/mongod_and_mongos_server_parameters_gen.h"
 #include "mongo/util/fail_point.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -119,6 +121,111 @@ CollectionAndChangedChunks getChangedChunks(OperationContext* opCtx,
                                       std::move(changedChunks)};
 }
 
+/**
+ * Blocking method, which returns the chunks which changed since the specified version for each of
+ * the 'refreshes'. All of them are loaded with one query against config.collections and one against
+ * config.chunks. The result for each refresh is the same as getChangedChunks would return for it.
+ */
+std::vector<StatusWith<CollectionAndChangedChunks>> getChangedChunksForBatch(
+    OperationContext* opCtx,
+    const std::vector<std::pair<NamespaceString, ChunkVersion>>& refreshes) {
+    const auto catalogClient = Grid::get(opCtx)->catalogClient();
+
+    std::vector<NamespaceString> nssList;
+    for (const auto& refresh : refreshes) {
+        nssList.push_back(refresh.first);
+    }
+
+    StringMap<CollectionType> collections;
+    for (auto&& coll : catalogClient->getCollectionsForNamespaces(
+             opCtx, nssList, repl::ReadConcernLevel::kMajorityReadConcern)) {
+        auto ns = coll.getNss().ns();
+        collections.emplace(std::move(ns), std::move(coll));
+    }
+
+    std::vector<StatusWith<CollectionAndChangedChunks>> results;
+    std::vector<boost::optional<ChunkVersion>> startingCollectionVersions;
+    BSONArrayBuilder diffQueries;
+    for (const auto& [nss, sinceVersion] : refreshes) {
+        auto it = collections.find(nss.ns());
+        if (it == collections.end() || it->second.getDropped()) {
+            results.emplace_back(Status(ErrorCodes::NamespaceNotFound,
+                                        str::stream() << "Collection " << nss.ns()
+                                                      << " is dropped."));
+            startingCollectionVersions.push_back(boost::none);
+            continue;
+        }
+
+        // If the collection's epoch has changed, do a full refresh
+        const auto& coll = it->second;
+        const ChunkVersion startingCollectionVersion = (sinceVersion.epoch() == coll.getEpoch())
+            ? sinceVersion
+            : ChunkVersion(0, 0, coll.getEpoch());
+
+        results.emplace_back(Status(ErrorCodes::ConflictingOperationInProgress,
+                                    "No chunks were found for the collection"));
+        startingCollectionVersions.push_back(startingCollectionVersion);
+        diffQueries.append(createConfigDiffQuery(nss, startingCollectionVersion).query);
+    }
+
+    if (diffQueries.arrSize() == 0) {
+        return results;
+    }
+
+    // Query the chunks which have changed for all of the collections at once
+    repl::OpTime opTime;
+    const auto changedChunks = uassertStatusOK(
+        catalogClient->getChunks(opCtx,
+                                 BSON("$or" << diffQueries.arr()),
+                                 BSON(ChunkType::lastmod() << 1),
+                                 boost::none,
+                                 &opTime,
+                                 repl::ReadConcernLevel::kMajorityReadConcern));
+
+    StringMap<std::vector<ChunkType>> changedChunksByNs;
+    for (const auto& chunk : changedChunks) {
+        changedChunksByNs[chunk.getNS().ns()].push_back(chunk);
+    }
+
+    for (size_t i = 0; i < refreshes.size(); ++i) {
+        if (!startingCollectionVersions[i]) {
+            continue;
+        }
+
+        const auto& nss = refreshes[i].first;
+        auto chunksIt = changedChunksByNs.find(nss.ns());
+        if (chunksIt == changedChunksByNs.end()) {
+            continue;
+        }
+
+        // The same collection may have been requested more than once, since different versions.
+        const Timestamp startingTimestamp(startingCollectionVersions[i]->toLong());
+        std::vector<ChunkType> chunks;
+        for (const auto& chunk : chunksIt->second) {
+            if (Timestamp(chunk.getVersion().toLong()) >= startingTimestamp) {
+                chunks.push_back(chunk);
+            }
+        }
+
+        if (chunks.empty()) {
+            continue;
+        }
+
+        const auto& coll = collections.find(nss.ns())->second;
+        results[i] = CollectionAndChangedChunks{coll.getEpoch(),
+                                                coll.getTimestamp(),
+                                                coll.getUuid(),
+                                                coll.getKeyPattern().toBSON(),
+                                                coll.getDefaultCollation(),
+                                                coll.getUnique(),
+                                                coll.getReshardingFields(),
+                                                coll.getAllowMigrations(),
+                                                std::move(chunks)};
+    }
+
+    return results;
+}
+
 }  // namespace
 
 ConfigServerCatalogCacheLoader::ConfigServerCatalogCacheLoader()
@@ -165,6 +272,16 @@ void ConfigServerCatalogCacheLoader::waitForDatabaseFlush(OperationContext* opCt
 
 SemiFuture<CollectionAndChangedChunks> ConfigServerCatalogCacheLoader::getChunksSince(
     const NamespaceString& nss, ChunkVersion version) {
+    if (gCatalogCacheRefreshMaxBatchSize.load() > 1) {
+        auto pf = makePromiseFuture<CollectionAndChangedChunks>();
+        {
+            stdx::lock_guard<Latch> lg(_mutex);
+            _pendingRefreshes.push_back({nss, version, std::move(pf.promise)});
+        }
+
+        _scheduleBatch();
+        return std::move(pf.future).semi();
+    }
 
     return ExecutorFuture<void>(_executor)
         .then([=]() {
@@ -177,6 +294,78 @@ SemiFuture<CollectionAndChangedChunks> ConfigServerCatalogCacheLoader::getChunks
         .semi();
 }
 
+void ConfigServerCatalogCacheLoader::_scheduleBatch() {
+    {
+        stdx::lock_guard<Latch> lg(_mutex);
+        if (_batchScheduled || _pendingRefreshes.empty()) {
+            return;
+        }
+        _batchScheduled = true;
+    }
+
+    // The task runs inline with an error if the executor has been shut down, so it must be
+    // scheduled without holding the mutex.
+    _executor->schedule([this](Status status) { _runBatch(std::move(status)); });
+}
+
+void ConfigServerCatalogCacheLoader::_runBatch(Status status) {
+    std::vector<PendingRefresh> batch;
+    {
+        stdx::lock_guard<Latch> lg(_mutex);
+        _batchScheduled = false;
+
+        const auto maxBatchSize = static_cast<size_t>(gCatalogCacheRefreshMaxBatchSize.load());
+        const auto batchSize = std::min(_pendingRefreshes.size(), maxBatchSize);
+        std::move(_pendingRefreshes.begin(),
+                  _pendingRefreshes.begin() + batchSize,
+                  std::back_inserter(batch));
+        _pendingRefreshes.erase(_pendingRefreshes.begin(), _pendingRefreshes.begin() + batchSize);
+    }
+
+    // Refreshes beyond the batch size start their own batch on another thread.
+    _scheduleBatch();
+
+    if (!status.isOK()) {
+        for (auto& refresh : batch) {
+            refresh.promise.setError(status);
+        }
+        return;
+    }
+
+    if (batch.empty()) {
+        return;
+    }
+
+    _stats.countBatches.addAndFetch(1);
+    _stats.countBatchedRefreshes.addAndFetch(batch.size());
+
+    std::vector<std::pair<NamespaceString, ChunkVersion>> refreshes;
+    for (const auto& refresh : batch) {
+        refreshes.emplace_back(refresh.nss, refresh.sinceVersion);
+    }
+
+    try {
+        ThreadClient tc("ConfigServerCatalogCacheLoader::getChunksSince",
+                        getGlobalServiceContext());
+        auto opCtx = tc->makeOperationContext();
+
+        auto results = getChangedChunksForBatch(opCtx.get(), refreshes);
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i].promise.setFrom(std::move(results[i]));
+        }
+    } catch (const DBException& ex) {
+        for (auto& refresh : batch) {
+            refresh.promise.setError(ex.toStatus());
+        }
+    }
+}
+
+void ConfigServerCatalogCacheLoader::reportStats(BSONObjBuilder* builder) const {
+    BSONObjBuilder batchesBuilder(builder->subobjStart("batchedCollectionRefreshes"));
+    batchesBuilder.append("countBatches", _stats.countBatches.load());
+    batchesBuilder.append("countRefreshes", _stats.countBatchedRefreshes.load());
+}
+
 SemiFuture<DatabaseType> ConfigServerCatalogCacheLoader::getDatabase(StringData dbName) {
     return ExecutorFuture<void>(_executor)
         .then([name = dbName.toString()] {
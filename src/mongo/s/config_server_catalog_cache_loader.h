@@ -29,8 +29,14 @@
 
 #pragma once
 
+#include <vector>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
 #include "mongo/s/catalog_cache_loader.h"
 #include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/future.h"
 
 namespace mongo {
 
@@ -55,9 +61,49 @@ public:
                                                           ChunkVersion version) override;
     SemiFuture<DatabaseType> getDatabase(StringData dbName) override;
 
+    void reportStats(BSONObjBuilder* builder) const override;
+
 private:
+    /**
+     * A getChunksSince request waiting to be loaded as part of a batch.
+     */
+    struct PendingRefresh {
+        NamespaceString nss;
+        ChunkVersion sinceVersion;
+        Promise<CollectionAndChangedChunks> promise;
+    };
+
+    /**
+     * Queues a task which loads the pending refreshes, if there are any and no such task is
+     * already queued.
+     */
+    void _scheduleBatch();
+
+    /**
+     * Loads up to gCatalogCacheRefreshMaxBatchSize of the pending refreshes together.
+     */
+    void _runBatch(Status status);
+
     // Thread pool to be used to perform metadata load
     std::shared_ptr<ThreadPool> _executor;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("ConfigServerCatalogCacheLoader::_mutex");
+
+    // Refreshes waiting for a batch, in the order they were requested
+    std::vector<PendingRefresh> _pendingRefreshes;
+
+    // Whether a task which will take the next batch of '_pendingRefreshes' has been queued but has
+    // not yet started. Refreshes requested while the loader's threads are all busy accumulate in
+    // '_pendingRefreshes' until it runs.
+    bool _batchScheduled = false;
+
+    struct Stats {
+        // Number of batches loaded, each with one query to config.collections and config.chunks
+        AtomicWord<long long> countBatches{0};
+
+        // Number of collection refreshes served by those batches
+        AtomicWord<long long> countBatchedRefreshes{0};
+    } _stats;
 };
 
 }  // namespace mongo
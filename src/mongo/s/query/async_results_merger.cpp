@@ -42,6 +42,7 @@
 #include "mongo/executor/remote_command_request.h"
 #include "mongo/executor/remote_command_response.h"
 #include "mongo/s/catalog/type_shard.h"
+#include "mongo/s/query/async_results_merger_params_gen.h"
 #include "mongo/util/assert_util.h"
 
 namespace mongo {
@@ -105,13 +106,18 @@ AsyncResultsMerger::AsyncResultsMerger(OperationContext* opCtx,
       // since that is not supported we treat boost::none (unspecified) to mean 'kNormal'.
       _tailableMode(params.getTailableMode().value_or(TailableModeEnum::kNormal)),
       _params(std::move(params)),
-      _mergeQueue(MergingComparator(
-          _remotes, _params.getSort().value_or(BSONObj()), _params.getCompareWholeSortKey())),
+      _mergeTree(
+          _remotes, _params.getSort().value_or(BSONObj()), _params.getCompareWholeSortKey()),
       _promisedMinSortKeys(PromisedMinSortKeyComparator(_params.getSort().value_or(BSONObj()))) {
     if (params.getTxnNumber()) {
         invariant(params.getSessionId());
     }
 
+    if (auto sort = _params.getSort();
+        sort && static_cast<size_t>(sort->nFields()) <= Ordering::kMaxCompoundIndexKeys) {
+        _sortKeyOrdering = Ordering::make(*sort);
+    }
+
     size_t remoteIndex = 0;
     for (const auto& remote : _params.getRemotes()) {
         _remotes.emplace_back(remote.getHostAndPort(),
@@ -127,6 +133,9 @@ AsyncResultsMerger::AsyncResultsMerger(OperationContext* opCtx,
         _addBatchToBuffer(WithLock::withoutLock(), remoteIndex, remote.getCursorResponse());
         ++remoteIndex;
     }
+    if (_params.getSort()) {
+        _mergeTree.reset();
+    }
     // If this is a change stream, then we expect to have already received PBRTs from every shard.
     invariant(_promisedMinSortKeys.empty() || _promisedMinSortKeys.size() == _remotes.size());
     _setInitialHighWaterMark();
@@ -221,6 +230,9 @@ void AsyncResultsMerger::addNewShardCursors(std::vector<RemoteCursor>&& newCurso
                               remote.getCursorResponse().getPartialResultsReturned());
         _addBatchToBuffer(lk, newIndex, remote.getCursorResponse());
     }
+    if (_params.getSort()) {
+        _mergeTree.reset();
+    }
 }
 
 bool AsyncResultsMerger::partialResultsReturned() const {
@@ -307,12 +319,12 @@ bool AsyncResultsMerger::_readySorted(WithLock lk) {
 }
 
 bool AsyncResultsMerger::_readySortedTailable(WithLock lk) {
-    if (_mergeQueue.empty()) {
+    auto smallestRemote = _mergeTree.top();
+    if (!smallestRemote) {
         return false;
     }
 
-    auto smallestRemote = _mergeQueue.top();
-    auto smallestResult = _remotes[smallestRemote].docBuffer.front();
+    const auto& smallestResult = _remotes[*smallestRemote].docBuffer.front();
     auto keyWeWantToReturn =
         extractSortKey(*smallestResult.getResult(), _params.getCompareWholeSortKey());
     // We should always have a minPromisedSortKey from every shard in the sorted tailable case.
@@ -355,28 +367,29 @@ StatusWith<ClusterQueryResult> AsyncResultsMerger::nextReady() {
     return _params.getSort() ? _nextReadySorted(lk) : _nextReadyUnsorted(lk);
 }
 
-ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
+ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock lk) {
     // Tailable non-awaitData cursors cannot have a sort.
     invariant(_tailableMode != TailableModeEnum::kTailable);
 
-    if (_mergeQueue.empty()) {
+    auto top = _mergeTree.top();
+    if (!top) {
         return {};
     }
 
-    size_t smallestRemote = _mergeQueue.top();
-    _mergeQueue.pop();
+    const size_t smallestRemote = *top;
+    auto& remote = _remotes[smallestRemote];
+    invariant(remote.status.isOK());
 
-    invariant(!_remotes[smallestRemote].docBuffer.empty());
-    invariant(_remotes[smallestRemote].status.isOK());
+    ClusterQueryResult front = std::move(remote.docBuffer.front());
+    remote.docBuffer.pop();
+    if (!remote.sortKeyBuffer.empty()) {
+        remote.sortKeyBuffer.pop();
+    }
 
-    ClusterQueryResult front = _remotes[smallestRemote].docBuffer.front();
-    _remotes[smallestRemote].docBuffer.pop();
+    // The front of the winner's buffer has changed, so it has to replay its way back up the tree.
+    _mergeTree.replayWinner();
 
-    // Re-populate the merging queue with the next result from 'smallestRemote', if it has a
-    // next result.
-    if (!_remotes[smallestRemote].docBuffer.empty()) {
-        _mergeQueue.push(smallestRemote);
-    }
+    _prefetchIfBelowLowWatermark(lk, smallestRemote);
 
     // For sorted tailable awaitData cursors, update the high water mark to the document's sort key.
     if (_tailableMode == TailableModeEnum::kTailableAndAwaitData) {
@@ -389,15 +402,16 @@ ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
     return front;
 }
 
-ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
+ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock lk) {
     size_t remotesAttempted = 0;
     while (remotesAttempted < _remotes.size()) {
         // It is illegal to call this method if there is an error received from any shard.
         invariant(_remotes[_gettingFromRemote].status.isOK());
 
         if (_remotes[_gettingFromRemote].hasNext()) {
-            ClusterQueryResult front = _remotes[_gettingFromRemote].docBuffer.front();
+            ClusterQueryResult front = std::move(_remotes[_gettingFromRemote].docBuffer.front());
             _remotes[_gettingFromRemote].docBuffer.pop();
+            _prefetchIfBelowLowWatermark(lk, _gettingFromRemote);
 
             if (_tailableMode == TailableModeEnum::kTailable &&
                 !_remotes[_gettingFromRemote].hasNext()) {
@@ -420,6 +434,28 @@ ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
     return {};
 }
 
+void AsyncResultsMerger::_prefetchIfBelowLowWatermark(WithLock lk, size_t remoteIndex) {
+    // Batches from tailable cursors are passed through to the client as-is, and awaitData getMores
+    // block on the remote, so only normal cursors fetch ahead of the caller. Scheduling a remote
+    // command also requires an OperationContext.
+    const auto lowWatermarkPercent = internalQueryARMPrefetchLowWatermarkPercent.load();
+    if (lowWatermarkPercent == 0 || _tailableMode != TailableModeEnum::kNormal || !_opCtx) {
+        return;
+    }
+
+    auto& remote = _remotes[remoteIndex];
+    if (remote.exhausted() || remote.cbHandle.isValid() || !remote.status.isOK()) {
+        return;
+    }
+
+    if (remote.docBuffer.size() * 100 > remote.lastBatchSize * lowWatermarkPercent) {
+        return;
+    }
+
+    // If the getMore cannot be scheduled, the error is reported by the next call to ready().
+    remote.status = _askForNextBatch(lk, remoteIndex);
+}
+
 Status AsyncResultsMerger::_askForNextBatch(WithLock, size_t remoteIndex) {
     invariant(_opCtx, "Cannot schedule a getMore without an OperationContext");
     auto& remote = _remotes[remoteIndex];
@@ -709,8 +745,16 @@ void AsyncResultsMerger::_cleanUpFailedBatch(WithLock lk, Status status, size_t
         remote.partialResultsReturned = (remote.status != ErrorCodes::ExchangePassthrough);
         std::queue<ClusterQueryResult> emptyBuffer;
         std::swap(remote.docBuffer, emptyBuffer);
+        std::queue<KeyString::Value> emptySortKeyBuffer;
+        std::swap(remote.sortKeyBuffer, emptySortKeyBuffer);
         remote.status = Status::OK();
         remote.cursorId = 0;
+
+        // A getMore may have been prefetched while results were still buffered, in which case
+        // this remote may hold a place in the merge tree that it no longer has results for.
+        if (_params.getSort()) {
+            _mergeTree.reset();
+        }
     }
 }
 
@@ -736,8 +780,15 @@ void AsyncResultsMerger::_processBatchResults(WithLock lk,
     // Update the cursorId; it is sent as '0' when the cursor has been exhausted on the shard.
     remote.cursorId = cursorResponse.getCursorId();
 
-    // Save the batch in the remote's buffer.
-    if (!_addBatchToBuffer(lk, remoteIndex, cursorResponse)) {
+    // Save the batch in the remote's buffer. If the remote previously had nothing buffered, the
+    // front of its buffer has changed and the merge tree must be rebuilt; otherwise the batch was
+    // prefetched and the new results simply queue up behind those already buffered.
+    const bool hadBufferedResults = remote.hasNext();
+    const bool addedBatch = _addBatchToBuffer(lk, remoteIndex, cursorResponse);
+    if (_params.getSort() && !hadBufferedResults && remote.hasNext()) {
+        _mergeTree.reset();
+    }
+    if (!addedBatch) {
         return;
     }
 
@@ -783,16 +834,19 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
             }
         }
 
+        // Encode the sort key once here, so that the merge only ever compares raw bytes.
+        if (_sortKeyOrdering) {
+            KeyString::Builder sortKey(KeyString::Version::kLatestVersion,
+                                       extractSortKey(obj, _params.getCompareWholeSortKey()),
+                                       *_sortKeyOrdering);
+            remote.sortKeyBuffer.push(sortKey.getValueCopy());
+        }
+
         ClusterQueryResult result(obj);
         remote.docBuffer.push(result);
         ++remote.fetchedCount;
     }
-
-    // If we're doing a sorted merge, then we have to make sure to put this remote onto the merge
-    // queue.
-    if (_params.getSort() && !response.getBatch().empty()) {
-        _mergeQueue.push(remoteIndex);
-    }
+    remote.lastBatchSize = response.getBatch().size();
     return true;
 }
 
@@ -894,16 +948,65 @@ bool AsyncResultsMerger::RemoteCursorData::exhausted() const {
 }
 
 //
-// AsyncResultsMerger::MergingComparator
+// AsyncResultsMerger::MergeTree
 //
 
-bool AsyncResultsMerger::MergingComparator::operator()(const size_t& lhs, const size_t& rhs) {
-    const ClusterQueryResult& leftDoc = _remotes[lhs].docBuffer.front();
-    const ClusterQueryResult& rightDoc = _remotes[rhs].docBuffer.front();
+void AsyncResultsMerger::MergeTree::reset() {
+    const size_t numLeaves = _remotes.size();
+    _nodes.assign(std::max(numLeaves, size_t{1}), 0);
+
+    // Play the tournament bottom-up, recording the winner of each internal match so that it can be
+    // sent on to the match above. The leaf for remote 'i' sits at position 'numLeaves + i'.
+    std::vector<size_t> winners(numLeaves);
+    auto winnerAt = [&](size_t node) {
+        return node >= numLeaves ? node - numLeaves : winners[node];
+    };
+    for (size_t node = numLeaves; node-- > 1;) {
+        const size_t left = winnerAt(2 * node);
+        const size_t right = winnerAt(2 * node + 1);
+        const bool leftWins = _precedes(left, right);
+        winners[node] = leftWins ? left : right;
+        _nodes[node] = leftWins ? right : left;
+    }
+    _nodes[0] = numLeaves > 1 ? winners[1] : 0;
+}
+
+void AsyncResultsMerger::MergeTree::replayWinner() {
+    dassert(_nodes.size() == std::max(_remotes.size(), size_t{1}));
+
+    size_t winner = _nodes[0];
+    for (size_t node = (_remotes.size() + winner) / 2; node >= 1; node /= 2) {
+        if (_precedes(_nodes[node], winner)) {
+            std::swap(_nodes[node], winner);
+        }
+    }
+    _nodes[0] = winner;
+}
+
+boost::optional<size_t> AsyncResultsMerger::MergeTree::top() const {
+    if (_remotes.empty() || !_remotes[_nodes[0]].hasNext()) {
+        return boost::none;
+    }
+    return _nodes[0];
+}
+
+bool AsyncResultsMerger::MergeTree::_precedes(size_t lhs, size_t rhs) const {
+    const auto& left = _remotes[lhs];
+    const auto& right = _remotes[rhs];
+    if (!left.hasNext() || !right.hasNext()) {
+        return left.hasNext() || (!right.hasNext() && lhs < rhs);
+    }
 
-    return compareSortKeys(extractSortKey(*leftDoc.getResult(), _compareWholeSortKey),
-                           extractSortKey(*rightDoc.getResult(), _compareWholeSortKey),
-                           _sort) > 0;
+    int cmp;
+    if (!left.sortKeyBuffer.empty()) {
+        cmp = left.sortKeyBuffer.front().compare(right.sortKeyBuffer.front());
+    } else {
+        cmp = compareSortKeys(
+            extractSortKey(*left.docBuffer.front().getResult(), _compareWholeSortKey),
+            extractSortKey(*right.docBuffer.front().getResult(), _compareWholeSortKey),
+            _sort);
+    }
+    return cmp < 0 || (cmp == 0 && lhs < rhs);
 }
 
 bool AsyncResultsMerger::PromisedMinSortKeyComparator::operator()(
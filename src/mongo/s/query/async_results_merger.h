@@ -35,7 +35,9 @@
 
 #include "mongo/base/status_with.h"
 #include "mongo/bson/bsonobj.h"
+#include "mongo/bson/ordering.h"
 #include "mongo/db/cursor_id.h"
+#include "mongo/db/storage/key_string.h"
 #include "mongo/executor/task_executor.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/s/query/async_results_merger_params_gen.h"
@@ -68,6 +70,10 @@ class CursorResponse;
  * This requires waiting until we have a response from every remote before returning results.
  * Without a sort, we are ready to return results as soon as we have *any* response from a remote.
  *
+ * For non-tailable cursors, the next getMore against a remote may be scheduled from nextReady()
+ * once its buffer drops below a low watermark (see internalQueryARMPrefetchLowWatermarkPercent),
+ * so that the next batch is in flight while the buffered results are still being consumed.
+ *
  * On any error, the caller is responsible for shutting down the ARM using the kill() method.
  *
  * Does not throw exceptions.
@@ -89,8 +95,8 @@ public:
      * the hosts on which they exist in _remotes.
      *
      * Additionally copies each remote's first batch of results, if one exists, into that remote's
-     * docBuffer. If a sort is specified in the ClusterClientCursorParams, places the remotes with
-     * buffered results onto _mergeQueue.
+     * docBuffer. If a sort is specified in the ClusterClientCursorParams, builds _mergeTree over
+     * the remotes.
      *
      * The TaskExecutor* must remain valid for the lifetime of the ARM.
      *
@@ -306,6 +312,15 @@ private:
         // The buffer of results that have been retrieved but not yet returned to the caller.
         std::queue<ClusterQueryResult> docBuffer;
 
+        // The sort keys of the results in 'docBuffer', in the same order, encoded as KeyStrings so
+        // that they can be compared with memcmp. Only populated for sorted merges whose sort
+        // pattern can be expressed as an Ordering.
+        std::queue<KeyString::Value> sortKeyBuffer;
+
+        // The number of results in the last batch received from this remote. Used to decide when
+        // the buffer has dropped low enough to schedule the next getMore.
+        size_t lastBatchSize = 0;
+
         // Is valid if there is currently a pending request to this remote.
         executor::TaskExecutor::CallbackHandle cbHandle;
 
@@ -318,16 +333,44 @@ private:
         long long fetchedCount = 0;
     };
 
-    class MergingComparator {
+    /**
+     * A loser tree over the remotes, keyed by the sort key of the first result in each remote's
+     * buffer. A remote with nothing buffered sorts after every remote that has a buffered result,
+     * and ties are broken by remote index. Each internal node holds the loser of the match played
+     * there, so when the winner's buffer is advanced only the matches on the path from its leaf to
+     * the root have to be replayed.
+     */
+    class MergeTree {
     public:
-        MergingComparator(const std::vector<RemoteCursorData>& remotes,
-                          const BSONObj& sort,
-                          bool compareWholeSortKey)
+        MergeTree(const std::vector<RemoteCursorData>& remotes,
+                  const BSONObj& sort,
+                  bool compareWholeSortKey)
             : _remotes(remotes), _sort(sort), _compareWholeSortKey(compareWholeSortKey) {}
 
-        bool operator()(const size_t& lhs, const size_t& rhs);
+        /**
+         * Rebuilds the tree from the current fronts of all the remotes' buffers. Must be called
+         * whenever a remote is added, or the front of a remote other than the winner changes.
+         */
+        void reset();
+
+        /**
+         * Replays the matches of the current winner after the front of its buffer has changed.
+         */
+        void replayWinner();
+
+        /**
+         * Returns the index of the remote whose next buffered result sorts first, or boost::none if
+         * no remote has a buffered result.
+         */
+        boost::optional<size_t> top() const;
 
     private:
+        /**
+         * Returns true if the next result of remote 'lhs' should be returned before the next
+         * result of remote 'rhs'.
+         */
+        bool _precedes(size_t lhs, size_t rhs) const;
+
         const std::vector<RemoteCursorData>& _remotes;
 
         const BSONObj _sort;
@@ -336,6 +379,10 @@ private:
         // We extract the sort key {$sortKey: <value>}. The sort key pattern '_sort' is verified to
         // be {$sortKey: 1}.
         const bool _compareWholeSortKey;
+
+        // Slot zero holds the index of the overall winner. Slots [1, _remotes.size()) hold the
+        // loser of each internal match, with the leaf for remote 'i' at position _remotes.size()+i.
+        std::vector<size_t> _nodes;
     };
 
     using MinSortKeyRemoteIdPair = std::pair<BSONObj, size_t>;
@@ -391,6 +438,12 @@ private:
     ClusterQueryResult _nextReadySorted(WithLock);
     ClusterQueryResult _nextReadyUnsorted(WithLock);
 
+    /**
+     * Schedules the next getMore against the given remote if prefetching is enabled and the
+     * number of results still buffered for it has fallen to the low watermark.
+     */
+    void _prefetchIfBelowLowWatermark(WithLock, size_t remoteIndex);
+
     using CbData = executor::TaskExecutor::RemoteCommandCallbackArgs;
     using CbResponse = executor::TaskExecutor::ResponseStatus;
 
@@ -484,9 +537,14 @@ private:
     // Data tracking the state of our communication with each of the remote nodes.
     std::vector<RemoteCursorData> _remotes;
 
-    // The top of this priority queue is the index into '_remotes' for the remote host that has the
-    // next document to return, according to the sort order. Used only if there is a sort.
-    std::priority_queue<size_t, std::vector<size_t>, MergingComparator> _mergeQueue;
+    // The winner of this tree is the index into '_remotes' for the remote host that has the next
+    // document to return, according to the sort order. Used only if there is a sort.
+    MergeTree _mergeTree;
+
+    // The Ordering used to encode sort keys as KeyStrings. Unset if there is no sort, or if the
+    // sort pattern has too many fields to be expressed as an Ordering, in which case the merge
+    // falls back to comparing the sort keys as BSON.
+    boost::optional<Ordering> _sortKeyOrdering;
 
     // The index into '_remotes' for the remote from which we are currently retrieving results.
     // Used only if there is *not* a sort.
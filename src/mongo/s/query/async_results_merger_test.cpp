@@ -45,6 +45,7 @@
 #include "mongo/s/query/results_merger_test_fixture.h"
 #include "mongo/unittest/death_test.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -385,6 +386,62 @@ TEST_F(AsyncResultsMergerTest, MultiShardMultipleGets) {
     ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
 }
 
+TEST_F(AsyncResultsMergerTest, SortedPrefetchesGetMoreAtLowWatermark) {
+    const auto originalLowWatermark = internalQueryARMPrefetchLowWatermarkPercent.load();
+    internalQueryARMPrefetchLowWatermarkPercent.store(50);
+    ON_BLOCK_EXIT([&] { internalQueryARMPrefetchLowWatermarkPercent.store(originalLowWatermark); });
+
+    BSONObj findCmd = fromjson("{find: 'testcoll', sort: {_id: 1}}");
+    std::vector<RemoteCursor> cursors;
+    std::vector<BSONObj> batch1 = {fromjson("{$sortKey: [1]}"),
+                                   fromjson("{$sortKey: [3]}"),
+                                   fromjson("{$sortKey: [5]}"),
+                                   fromjson("{$sortKey: [7]}")};
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, batch1)));
+    std::vector<BSONObj> batch2 = {fromjson("{$sortKey: [2]}"),
+                                   fromjson("{$sortKey: [4]}"),
+                                   fromjson("{$sortKey: [6]}"),
+                                   fromjson("{$sortKey: [8]}")};
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[1], kTestShardHosts[1], CursorResponse(kTestNss, 0, batch2)));
+    auto arm = makeARMFromExistingCursors(std::move(cursors), findCmd);
+
+    // The first shard still has three of its four results buffered, which is above the watermark.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{$sortKey: [1]}"),
+                      *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{$sortKey: [2]}"),
+                      *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    // Returning the second result from the first shard leaves half of its batch buffered, so the
+    // next getMore is sent even though there are still results to return from it.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{$sortKey: [3]}"),
+                      *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(networkHasReadyRequests());
+    ASSERT_EQ(getNthPendingRequest(0u).cmdObj["getMore"].numberLong(), 5);
+
+    // The prefetched batch is merged behind the results which were already buffered.
+    std::vector<CursorResponse> responses;
+    std::vector<BSONObj> batch3 = {fromjson("{$sortKey: [9]}"), fromjson("{$sortKey: [10]}")};
+    responses.emplace_back(kTestNss, CursorId(0), batch3);
+    scheduleNetworkResponses(std::move(responses));
+
+    for (auto expected : {4, 5, 6, 7, 8, 9, 10}) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(BSON("$sortKey" << BSON_ARRAY(expected)),
+                          *unittest::assertGet(arm->nextReady()).getResult());
+    }
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(arm->remotesExhausted());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
 TEST_F(AsyncResultsMergerTest, CompoundSortKey) {
     BSONObj findCmd = fromjson("{find: 'testcoll', sort: {a: -1, b: 1}}");
     std::vector<RemoteCursor> cursors;
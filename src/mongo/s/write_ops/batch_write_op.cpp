@@ -301,6 +301,29 @@ Status BatchWriteOp::targetBatch(const NSTargeter& targeter,
 
     const size_t numWriteOps = _clientRequest.sizeWriteOps();
 
+    // Unordered inserts are all targeted in this round, so look up their endpoints together, which
+    // lets the targeter share work across documents. Ordered batches stop at the first change of
+    // shard, so they keep targeting one op at a time rather than redo the whole batch every round.
+    std::vector<boost::optional<StatusWith<ShardEndpoint>>> insertEndpoints;
+    if (!ordered && _clientRequest.getBatchType() == BatchedCommandRequest::BatchType_Insert) {
+        std::vector<BSONObj> docs;
+        for (size_t i = 0; i < numWriteOps; ++i) {
+            if (_writeOps[i].getWriteState() == WriteOpState_Ready) {
+                docs.push_back(_writeOps[i].getWriteItem().getDocument());
+            }
+        }
+
+        if (docs.size() > 1) {
+            auto endpoints = targeter.targetInserts(_opCtx, docs);
+            insertEndpoints.resize(numWriteOps);
+            for (size_t i = 0, j = 0; i < numWriteOps; ++i) {
+                if (_writeOps[i].getWriteState() == WriteOpState_Ready) {
+                    insertEndpoints[i] = std::move(endpoints[j++]);
+                }
+            }
+        }
+    }
+
     for (size_t i = 0; i < numWriteOps; ++i) {
         WriteOp& writeOp = _writeOps[i];
 
@@ -318,7 +341,13 @@ Status BatchWriteOp::targetBatch(const NSTargeter& targeter,
 
         Status targetStatus = Status::OK();
         try {
-            writeOp.targetWrites(_opCtx, targeter, &writes);
+            if (!insertEndpoints.empty()) {
+                auto& endpoint = *insertEndpoints[i];
+                uassertStatusOK(endpoint.getStatus());
+                writeOp.targetWrites(_opCtx, std::move(endpoint.getValue()), &writes);
+            } else {
+                writeOp.targetWrites(_opCtx, targeter, &writes);
+            }
         } catch (const DBException& ex) {
             targetStatus = ex.toStatus();
         }
@@ -383,6 +383,45 @@ ShardEndpoint ChunkManagerTargeter::targetInsert(OperationContext* opCtx,
     return ShardEndpoint(_cm->dbPrimary(), ChunkVersion::UNSHARDED(), _cm->dbVersion());
 }
 
+std::vector<StatusWith<ShardEndpoint>> ChunkManagerTargeter::targetInserts(
+    OperationContext* opCtx, const std::vector<BSONObj>& docs) const {
+    std::vector<StatusWith<ShardEndpoint>> endpoints;
+    endpoints.reserve(docs.size());
+
+    if (!_cm->isSharded()) {
+        for (size_t i = 0; i < docs.size(); ++i) {
+            endpoints.emplace_back(
+                ShardEndpoint(_cm->dbPrimary(), ChunkVersion::UNSHARDED(), _cm->dbVersion()));
+        }
+        return endpoints;
+    }
+
+    std::vector<BSONObj> shardKeys;
+    shardKeys.reserve(docs.size());
+    for (const auto& doc : docs) {
+        shardKeys.push_back(_cm->getShardKeyPattern().extractShardKeyFromDoc(doc));
+    }
+
+    auto chunks = _cm->findIntersectingChunksWithSimpleCollation(shardKeys);
+
+    for (size_t i = 0; i < docs.size(); ++i) {
+        // See targetInsert() for why an empty shard key means that extraction failed.
+        if (shardKeys[i].isEmpty()) {
+            endpoints.emplace_back(ErrorCodes::ShardKeyNotFound,
+                                   "Shard key cannot contain array values or array descendants.");
+        } else if (!chunks[i]) {
+            endpoints.emplace_back(ErrorCodes::ShardKeyNotFound,
+                                   str::stream() << "Cannot target single shard using key "
+                                                 << shardKeys[i] << " for namespace " << _nss);
+        } else {
+            const auto& shardId = chunks[i]->getShardId();
+            endpoints.emplace_back(ShardEndpoint(shardId, _cm->getVersion(shardId)));
+        }
+    }
+
+    return endpoints;
+}
+
 std::vector<ShardEndpoint> ChunkManagerTargeter::targetUpdate(OperationContext* opCtx,
                                                               const BatchItemRef& itemRef) const {
     // If the update is replacement-style:
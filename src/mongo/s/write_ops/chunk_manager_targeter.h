@@ -76,6 +76,14 @@ public:
 
     ShardEndpoint targetInsert(OperationContext* opCtx, const BSONObj& doc) const override;
 
+    /**
+     * Extracts the shard keys of all of 'docs' up front and looks up their chunks in a single pass
+     * over the routing table. This includes hashed shard keys, whose hashed values are sorted and
+     * looked up together like any other key.
+     */
+    std::vector<StatusWith<ShardEndpoint>> targetInserts(
+        OperationContext* opCtx, const std::vector<BSONObj>& docs) const override;
+
     std::vector<ShardEndpoint> targetUpdate(OperationContext* opCtx,
                                             const BatchItemRef& itemRef) const override;
 
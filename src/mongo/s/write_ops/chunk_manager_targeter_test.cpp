@@ -29,12 +29,14 @@
 
 #include "mongo/platform/basic.h"
 
+#include "mongo/base/owned_pointer_map.h"
 #include "mongo/db/hasher.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
 #include "mongo/db/service_context_test_fixture.h"
 #include "mongo/s/catalog_cache_test_fixture.h"
 #include "mongo/s/session_catalog_router.h"
 #include "mongo/s/transaction_router.h"
+#include "mongo/s/write_ops/batch_write_op.h"
 #include "mongo/s/write_ops/batched_command_request.h"
 #include "mongo/s/write_ops/chunk_manager_targeter.h"
 #include "mongo/unittest/unittest.h"
@@ -72,6 +74,28 @@ public:
             makeChunkManager(kNss, ShardKeyPattern(shardKeyPattern), nullptr, false, splitPoints);
         return ChunkManagerTargeter(operationContext(), kNss);
     }
+
+    /**
+     * Asserts that targeting 'docs' together gives each document the shard endpoint, or the error,
+     * which targeting it on its own gives.
+     */
+    void assertTargetInsertsMatchesTargetInsert(const ChunkManagerTargeter& cmTargeter,
+                                                const std::vector<BSONObj>& docs) {
+        auto endpoints = cmTargeter.targetInserts(operationContext(), docs);
+        ASSERT_EQ(endpoints.size(), docs.size());
+
+        for (size_t i = 0; i < docs.size(); ++i) {
+            try {
+                auto endpoint = cmTargeter.targetInsert(operationContext(), docs[i]);
+                ASSERT_OK(endpoints[i].getStatus()) << docs[i];
+                ASSERT_EQ(endpoints[i].getValue().shardName, endpoint.shardName) << docs[i];
+                ASSERT_EQ(endpoints[i].getValue().shardVersion, endpoint.shardVersion) << docs[i];
+            } catch (const DBException& ex) {
+                ASSERT_EQ(endpoints[i].getStatus().code(), ex.code()) << docs[i];
+            }
+        }
+    }
+
     boost::optional<ChunkManager> chunkManager;
 };
 
@@ -185,6 +209,114 @@ TEST_F(ChunkManagerTargeterTest, TargetInsertsWithConstantHashedPrefixAndVarying
     ASSERT_EQUALS(res.shardName, "1");
 }
 
+TEST_F(ChunkManagerTargeterTest, TargetInsertsMatchesTargetInsertWithRangeShardKey) {
+    // Create 5 chunks and 5 shards such that shardId '0' has chunk [MinKey, null), '1' has chunk
+    // [null, -100), '2' has chunk [-100, 0), '3' has chunk ['0', 100) and '4' has chunk
+    // [100, MaxKey).
+    std::vector<BSONObj> splitPoints = {
+        BSON("a" << BSONNULL), BSON("a" << -100), BSON("a" << 0), BSON("a" << 100)};
+    auto cmTargeter = prepare(BSON("a" << 1), splitPoints);
+
+    // The documents are out of shard key order, repeat keys, and mix in documents whose shard key
+    // is missing, null, of another type or an array.
+    std::vector<BSONObj> docs = {fromjson("{a: 1000}"),
+                                 fromjson("{a: -111}"),
+                                 BSONObj(),
+                                 fromjson("{a: 5}"),
+                                 fromjson("{a: null}"),
+                                 fromjson("{a: [1, 2]}"),
+                                 fromjson("{a: -111}"),
+                                 fromjson("{a: 'str'}"),
+                                 fromjson("{b: 1}"),
+                                 fromjson("{a: -100}"),
+                                 fromjson("{a: {b: 1}}"),
+                                 fromjson("{a: 100}")};
+    assertTargetInsertsMatchesTargetInsert(cmTargeter, docs);
+
+    // Missing and null shard keys are both targeted to the chunk which holds null.
+    auto endpoints = cmTargeter.targetInserts(operationContext(), docs);
+    ASSERT_EQ(assertGet(endpoints[2]).shardName, "1");
+    ASSERT_EQ(assertGet(endpoints[4]).shardName, "1");
+    ASSERT_EQ(assertGet(endpoints[8]).shardName, "1");
+    ASSERT_EQ(endpoints[5].getStatus(), ErrorCodes::ShardKeyNotFound);
+}
+
+TEST_F(ChunkManagerTargeterTest, TargetInsertsMatchesTargetInsertWithRangePrefixHashedShardKey) {
+    std::vector<BSONObj> splitPoints = {
+        BSON("a.b" << BSONNULL), BSON("a.b" << -100), BSON("a.b" << 0), BSON("a.b" << 100)};
+    auto cmTargeter = prepare(BSON("a.b" << 1 << "c.d"
+                                         << "hashed"),
+                              splitPoints);
+
+    std::vector<BSONObj> docs = {fromjson("{a: {b: 1000}, c: null, d: {}}"),
+                                 fromjson("{a: {b: -111}, c: {d: '1'}}"),
+                                 BSONObj(),
+                                 fromjson("{a: {b: 0}, c: {d: 4}}"),
+                                 fromjson("{a: {b: null}, c: {d: null}}"),
+                                 fromjson("{c: [1, 2]}"),
+                                 fromjson("{a: {b: -10}}"),
+                                 BSON("a" << 10),
+                                 fromjson("{a: {b: -111}, c: {d: '1'}}")};
+    assertTargetInsertsMatchesTargetInsert(cmTargeter, docs);
+}
+
+TEST_F(ChunkManagerTargeterTest, TargetInsertsMatchesTargetInsertWithHashedShardKey) {
+    std::vector<BSONObj> splitPoints = {
+        BSON("a.b" << -(1LL << 62)), BSON("a.b" << 0LL), BSON("a.b" << (1LL << 62))};
+    auto cmTargeter = prepare(BSON("a.b"
+                                   << "hashed"
+                                   << "c.d" << 1),
+                              splitPoints);
+
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 1000; i++) {
+        docs.push_back(BSON("a" << BSON("b" << i) << "c" << BSON("d" << 10)));
+    }
+    docs.push_back(BSONObj());
+    docs.push_back(fromjson("{a: {b: null}}"));
+    docs.push_back(fromjson("{a: [1, 2]}"));
+    docs.push_back(fromjson("{a: {b: 0}, c: {d: null}}"));
+    assertTargetInsertsMatchesTargetInsert(cmTargeter, docs);
+}
+
+TEST_F(ChunkManagerTargeterTest, UnorderedInsertBatchIsTargetedLikeEachDocument) {
+    std::vector<BSONObj> splitPoints = {
+        BSON("a" << BSONNULL), BSON("a" << -100), BSON("a" << 0), BSON("a" << 100)};
+    auto cmTargeter = prepare(BSON("a" << 1), splitPoints);
+
+    std::vector<BSONObj> docs = {fromjson("{a: 1000}"),
+                                 fromjson("{a: -111}"),
+                                 BSONObj(),
+                                 fromjson("{a: 5}"),
+                                 fromjson("{a: null}"),
+                                 fromjson("{a: -111}"),
+                                 fromjson("{a: 'str'}")};
+    BatchedCommandRequest request([&] {
+        write_ops::Insert insertOp(kNss);
+        insertOp.getWriteCommandBase().setOrdered(false);
+        insertOp.setDocuments(docs);
+        return insertOp;
+    }());
+
+    BatchWriteOp batchOp(operationContext(), request);
+
+    OwnedPointerMap<ShardId, TargetedWriteBatch> targetedOwned;
+    std::map<ShardId, TargetedWriteBatch*>& targeted = targetedOwned.mutableMap();
+    ASSERT_OK(batchOp.targetBatch(cmTargeter, false, &targeted));
+
+    size_t numTargeted = 0;
+    for (const auto& [shardId, batch] : targeted) {
+        for (const auto& write : batch->getWrites()) {
+            const auto& doc = docs[write->writeOpRef.first];
+            auto endpoint = cmTargeter.targetInsert(operationContext(), doc);
+            ASSERT_EQ(write->endpoint.shardName, endpoint.shardName) << doc;
+            ASSERT_EQ(write->endpoint.shardVersion, endpoint.shardVersion) << doc;
+            ++numTargeted;
+        }
+    }
+    ASSERT_EQ(numTargeted, docs.size());
+}
+
 TEST_F(ChunkManagerTargeterTest, TargetUpdateWithRangePrefixHashedShardKey) {
     // Create 5 chunks and 5 shards such that shardId '0' has chunk [MinKey, null), '1' has chunk
     // [null, -100), '2' has chunk [-100, 0), '3' has chunk ['0', 100) and '4' has chunk
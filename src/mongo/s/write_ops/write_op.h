@@ -123,6 +123,14 @@ public:
                       const NSTargeter& targeter,
                       std::vector<TargetedWrite*>* targetedWrites);
 
+    /**
+     * Same as above, for an insert whose endpoint the caller has already obtained from
+     * NSTargeter::targetInserts().
+     */
+    void targetWrites(OperationContext* opCtx,
+                      ShardEndpoint endpoint,
+                      std::vector<TargetedWrite*>* targetedWrites);
+
     /**
      * Returns the number of child writes that were last targeted.
      */
@@ -166,6 +174,13 @@ private:
      */
     void _updateOpState();
 
+    /**
+     * Creates a pending child write for each of 'endpoints' that has not already succeeded.
+     */
+    void _createChildOps(std::vector<ShardEndpoint> endpoints,
+                         bool inTransaction,
+                         std::vector<TargetedWrite*>* targetedWrites);
+
     // Owned elsewhere, reference to a batch with a write item
     const BatchItemRef _itemRef;
 
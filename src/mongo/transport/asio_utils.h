@@ -43,6 +43,7 @@
 #endif  // ndef _WIN32
 
 #include <asio.hpp>
+#include <vector>
 
 namespace mongo {
 namespace transport {
@@ -90,6 +91,46 @@ inline Status errorCodeToStatus(const std::error_code& ec) {
     return {errorCode, ec.message()};
 }
 
+/**
+ * A sequence of buffers which is sent with a single vectored write. Like asio::const_buffer, it
+ * can be advanced past the bytes which have already been written.
+ */
+class ConstBufferVector {
+public:
+    using value_type = asio::const_buffer;
+    using const_iterator = std::vector<asio::const_buffer>::const_iterator;
+
+    explicit ConstBufferVector(std::vector<asio::const_buffer> buffers)
+        : _buffers(std::move(buffers)) {}
+
+    const_iterator begin() const {
+        return _buffers.begin() + _first;
+    }
+
+    const_iterator end() const {
+        return _buffers.end();
+    }
+
+    ConstBufferVector& operator+=(std::size_t n) {
+        for (; n && _first < _buffers.size(); ++_first) {
+            auto& buffer = _buffers[_first];
+            if (n < buffer.size()) {
+                buffer += n;
+                break;
+            }
+            n -= buffer.size();
+        }
+
+        return *this;
+    }
+
+private:
+    std::vector<asio::const_buffer> _buffers;
+
+    // The index of the first buffer which has not been completely written.
+    std::size_t _first = 0;
+};
+
 /*
  * The ASIO implementation of poll (i.e. socket.wait()) cannot poll for a mask of events, and
  * doesn't support timeouts.
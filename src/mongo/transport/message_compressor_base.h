@@ -34,6 +34,7 @@
 #include "mongo/base/string_data.h"
 #include "mongo/platform/atomic_word.h"
 
+#include <memory>
 #include <type_traits>
 
 namespace mongo {
@@ -42,6 +43,9 @@ enum class MessageCompressor : uint8_t {
     kSnappy = 1,
     kZlib = 2,
     kZstd = 3,
+    // Identifies messages compressed by a session's zstd stream (see MessageCompressorBase::Stream)
+    // in the compression header. It is not the ID of a registered compressor.
+    kZstdStream = 4,
     kExtended = 255,
 };
 
@@ -55,6 +59,23 @@ class MessageCompressorBase {
 public:
     virtual ~MessageCompressorBase() = default;
 
+    /*
+     * Compression state kept by one session across messages, so that each message can refer back
+     * to data in the ones before it. The messages a Stream compresses must be decompressed by the
+     * peer's Stream in the same order. Each message records whether it starts a new stream, so that
+     * a Stream which hit an error can start over with its next message.
+     */
+    class Stream {
+    public:
+        virtual ~Stream() = default;
+
+        virtual std::size_t getMaxCompressedSize(size_t inputSize) = 0;
+
+        virtual StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) = 0;
+
+        virtual StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) = 0;
+    };
+
     /*
      * Returns the name for subclass compressors (e.g. "snappy", "zlib", "zstd" or "noop")
      */
@@ -89,6 +110,31 @@ public:
      */
     virtual StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) = 0;
 
+    /*
+     * Returns the ID of the dictionary this compressor was configured with, or 0 if it has none.
+     * When both sides of a session advertise the same ID during negotiation, messages on that
+     * session are compressed with the dictionary.
+     */
+    virtual uint32_t getDictionaryId() const {
+        return 0;
+    }
+
+    /*
+     * Like compressData, but compresses with the dictionary from getDictionaryId(). This is only
+     * called for sessions whose peer has negotiated the same dictionary.
+     */
+    virtual StatusWith<std::size_t> compressDataWithDictionary(ConstDataRange input,
+                                                               DataRange output) {
+        return compressData(input, output);
+    }
+
+    /*
+     * Returns a new Stream for a session, or nullptr if this compressor does not support streaming.
+     */
+    virtual std::unique_ptr<Stream> makeStream() {
+        return nullptr;
+    }
+
     /*
      * This returns the number of bytes passed in the input for compressData
      */
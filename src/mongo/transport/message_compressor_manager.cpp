@@ -74,6 +74,47 @@ struct CompressionHeader {
 
 const transport::Session::Decoration<MessageCompressorManager> getForSession =
     transport::Session::declareDecoration<MessageCompressorManager>();
+
+// Maps the names of compressors configured with a dictionary to the dictionary's ID.
+constexpr auto kDictionariesFieldName = "compressionDictionaries"_sd;
+
+void appendDictionaryId(MessageCompressorBase* compressor, BSONObjBuilder* output) {
+    BSONObjBuilder sub(output->subobjStart(kDictionariesFieldName));
+    sub.append(compressor->getName(), static_cast<long long>(compressor->getDictionaryId()));
+}
+
+// Set by a client which can compress all of a session's messages as one zstd stream, and echoed
+// by a server which agrees to.
+constexpr auto kStreamingFieldName = "compressionStreaming"_sd;
+
+constexpr auto kZstdId = static_cast<MessageCompressorId>(MessageCompressor::kZstd);
+constexpr auto kZstdStreamId = static_cast<MessageCompressorId>(MessageCompressor::kZstdStream);
+
+bool isZstd(MessageCompressorBase* compressor) {
+    return compressor->getId() == kZstdId;
+}
+
+/**
+ * Returns the first of 'compressors' whose dictionary the peer listed in its 'input', or nullptr
+ * if there is none.
+ */
+MessageCompressorBase* findSharedDictionary(const std::vector<MessageCompressorBase*>& compressors,
+                                            const BSONObj& input) {
+    auto elem = input.getField(kDictionariesFieldName);
+    if (elem.type() != Object) {
+        return nullptr;
+    }
+
+    auto theirDictionaries = elem.Obj();
+    for (auto compressor : compressors) {
+        auto theirId = theirDictionaries.getField(compressor->getName());
+        if (compressor->getDictionaryId() != 0 && theirId.isNumber() &&
+            theirId.safeNumberLong() == compressor->getDictionaryId()) {
+            return compressor;
+        }
+    }
+    return nullptr;
+}
 }  // namespace
 
 MessageCompressorManager::MessageCompressorManager()
@@ -82,15 +123,35 @@ MessageCompressorManager::MessageCompressorManager()
 MessageCompressorManager::MessageCompressorManager(MessageCompressorRegistry* factory)
     : _registry{factory} {}
 
+MessageCompressorBase::Stream* MessageCompressorManager::_getStream() {
+    if (!_stream) {
+        auto zstd = _registry->getCompressor(kZstdId);
+        if (!zstd) {
+            return nullptr;
+        }
+        _stream = zstd->makeStream();
+    }
+    return _stream.get();
+}
+
 StatusWith<Message> MessageCompressorManager::compressMessage(
     const Message& msg, const MessageCompressorId* compressorId) {
 
     MessageCompressorBase* compressor = nullptr;
-    if (compressorId) {
+    MessageCompressorBase::Stream* stream = nullptr;
+    if (compressorId && *compressorId == kZstdStreamId) {
+        // Only echoed back from decompressMessage, which has already created the stream.
+        stream = _getStream();
+        invariant(stream);
+        compressor = _registry->getCompressor(kZstdId);
+    } else if (compressorId) {
         compressor = _registry->getCompressor(*compressorId);
         invariant(compressor);
     } else if (!_negotiated.empty()) {
         compressor = _negotiated[0];
+        if (_streamingNegotiated && isZstd(compressor)) {
+            stream = _getStream();
+        }
     } else {
         return {msg};
     }
@@ -102,11 +163,14 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
                 "compressor"_attr = compressor->getName());
 
     auto inputHeader = msg.header();
-    size_t bufferSize = compressor->getMaxCompressedSize(msg.dataSize()) +
+    size_t bufferSize =
+        (stream ? stream->getMaxCompressedSize(msg.dataSize())
+                : compressor->getMaxCompressedSize(msg.dataSize())) +
         CompressionHeader::size() + MsgData::MsgDataHeaderSize;
 
-    CompressionHeader compressionHeader(
-        inputHeader.getNetworkOp(), inputHeader.dataLen(), compressor->getId());
+    CompressionHeader compressionHeader(inputHeader.getNetworkOp(),
+                                        inputHeader.dataLen(),
+                                        stream ? kZstdStreamId : compressor->getId());
 
     if (bufferSize > MaxMessageSizeBytes) {
         LOGV2_DEBUG(22926,
@@ -119,7 +183,7 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
         return {msg};
     }
 
-    auto outputMessageBuffer = SharedBuffer::allocate(bufferSize);
+    auto outputMessageBuffer = SharedBuffer::allocatePooled(bufferSize);
 
     MsgData::View outMessage(outputMessageBuffer.get());
     outMessage.setId(inputHeader.getId());
@@ -131,7 +195,14 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
     compressionHeader.serialize(&output);
     ConstDataRange input(inputHeader.data(), inputHeader.data() + inputHeader.dataLen());
 
-    auto sws = compressor->compressData(input, output);
+    auto sws = [&] {
+        if (stream) {
+            return stream->compressData(input, output);
+        }
+        return compressor == _dictionaryCompressor
+            ? compressor->compressDataWithDictionary(input, output)
+            : compressor->compressData(input, output);
+    }();
 
     if (!sws.isOK())
         return sws.getStatus();
@@ -151,14 +222,26 @@ StatusWith<Message> MessageCompressorManager::decompressMessage(const Message& m
     }
     CompressionHeader compressionHeader(&input);
 
-    auto compressor = _registry->getCompressor(compressionHeader.compressorId);
+    MessageCompressorBase* compressor = nullptr;
+    MessageCompressorBase::Stream* stream = nullptr;
+    if (compressionHeader.compressorId == kZstdStreamId) {
+        if (!_streamingNegotiated) {
+            return {ErrorCodes::BadValue,
+                    "Received a message compressed as a stream without negotiating streaming"};
+        }
+        compressor = _registry->getCompressor(kZstdId);
+        stream = _getStream();
+    } else {
+        compressor = _registry->getCompressor(compressionHeader.compressorId);
+    }
+
     if (!compressor) {
         return {ErrorCodes::InternalError,
                 "Compression algorithm specified in message is not available"};
     }
 
     if (compressorId) {
-        *compressorId = compressor->getId();
+        *compressorId = compressionHeader.compressorId;
     }
 
     LOGV2_DEBUG(22927,
@@ -180,7 +263,7 @@ StatusWith<Message> MessageCompressorManager::decompressMessage(const Message& m
                 "Decompressed message would be larger than maximum message size"};
     }
 
-    auto outputMessageBuffer = SharedBuffer::allocate(bufferSize);
+    auto outputMessageBuffer = SharedBuffer::allocatePooled(bufferSize);
     MsgData::View outMessage(outputMessageBuffer.get());
     outMessage.setId(inputHeader.getId());
     outMessage.setResponseToMsgId(inputHeader.getResponseToMsgId());
@@ -189,7 +272,8 @@ StatusWith<Message> MessageCompressorManager::decompressMessage(const Message& m
 
     DataRangeCursor output(outMessage.data(), outMessage.data() + outMessage.dataLen());
 
-    auto sws = compressor->decompressData(input, output);
+    auto sws = stream ? stream->decompressData(input, output)
+                      : compressor->decompressData(input, output);
 
     if (!sws.isOK())
         return sws.getStatus();
@@ -208,11 +292,16 @@ void MessageCompressorManager::clientBegin(BSONObjBuilder* output) {
 
     // We're about to update the compressor list with the negotiation result from the server.
     _negotiated.clear();
+    _dictionaryCompressor = nullptr;
+    _streamingNegotiated = false;
+    _stream.reset();
 
     auto& compressorList = _registry->getCompressorNames();
     if (compressorList.size() == 0)
         return;
 
+    MessageCompressorBase* dictionaryCompressor = nullptr;
+    bool offerStreaming = false;
     BSONArrayBuilder sub(output->subarrayStart("compression"));
     for (const auto& e : _registry->getCompressorNames()) {
         LOGV2_DEBUG(22929,
@@ -221,8 +310,30 @@ void MessageCompressorManager::clientBegin(BSONObjBuilder* output) {
                     "Offering compressor to server",
                     "compressor"_attr = e);
         sub.append(e);
+
+        auto compressor = _registry->getCompressor(e);
+        if (!dictionaryCompressor && compressor->getDictionaryId() != 0) {
+            dictionaryCompressor = compressor;
+        }
+        if (isZstd(compressor) && _registry->isStreamingEnabled()) {
+            offerStreaming = true;
+        }
     }
     sub.doneFast();
+
+    if (dictionaryCompressor) {
+        LOGV2_DEBUG(5338706,
+                    3,
+                    "Offering compression dictionary to server",
+                    "compressor"_attr = dictionaryCompressor->getName(),
+                    "dictionaryId"_attr = dictionaryCompressor->getDictionaryId());
+        appendDictionaryId(dictionaryCompressor, output);
+    }
+
+    if (offerStreaming) {
+        LOGV2_DEBUG(5338709, 3, "Offering streaming compression to server");
+        output->append(kStreamingFieldName, true);
+    }
 }
 
 void MessageCompressorManager::clientFinish(const BSONObj& input) {
@@ -254,6 +365,21 @@ void MessageCompressorManager::clientFinish(const BSONObj& input) {
                     "compressor"_attr = ret->getName());
         _negotiated.push_back(ret);
     }
+
+    _dictionaryCompressor = findSharedDictionary(_negotiated, input);
+    if (_dictionaryCompressor) {
+        LOGV2_DEBUG(5338707,
+                    3,
+                    "Compressing with dictionary shared with server",
+                    "compressor"_attr = _dictionaryCompressor->getName(),
+                    "dictionaryId"_attr = _dictionaryCompressor->getDictionaryId());
+    }
+
+    _streamingNegotiated = !_negotiated.empty() && isZstd(_negotiated[0]) &&
+        _registry->isStreamingEnabled() && input.getBoolField(kStreamingFieldName);
+    if (_streamingNegotiated) {
+        LOGV2_DEBUG(5338710, 3, "Compressing messages to server as a stream");
+    }
 }
 
 void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuilder* output) {
@@ -272,6 +398,14 @@ void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuil
                 sub.append(algo->getName());
             }
             sub.doneFast();
+
+            if (_dictionaryCompressor) {
+                appendDictionaryId(_dictionaryCompressor, output);
+            }
+
+            if (_streamingNegotiated) {
+                output->append(kStreamingFieldName, true);
+            }
         } else {
             LOGV2_DEBUG(22935, 3, "Compression negotiation not requested by client");
         }
@@ -281,6 +415,9 @@ void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuil
     // If compression has already been negotiated, then this is a renegotiation, so we should
     // reset the state of the manager.
     _negotiated.clear();
+    _dictionaryCompressor = nullptr;
+    _streamingNegotiated = false;
+    _stream.reset();
 
     // First we go through all the compressor names that the client has requested support for
     BSONObj theirObj = elem.Obj();
@@ -319,6 +456,25 @@ void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuil
             sub.append(algo->getName());
         }
         sub.doneFast();
+
+        // Only compress with a dictionary which the client also has.
+        _dictionaryCompressor = findSharedDictionary(_negotiated, input);
+        if (_dictionaryCompressor) {
+            LOGV2_DEBUG(5338708,
+                        3,
+                        "Compressing with dictionary shared with client",
+                        "compressor"_attr = _dictionaryCompressor->getName(),
+                        "dictionaryId"_attr = _dictionaryCompressor->getDictionaryId());
+            appendDictionaryId(_dictionaryCompressor, output);
+        }
+
+        // The client compresses with its preferred compressor, so only stream if that is zstd.
+        if (isZstd(_negotiated[0]) && _registry->isStreamingEnabled() &&
+            input.getBoolField(kStreamingFieldName)) {
+            LOGV2_DEBUG(5338711, 3, "Compressing messages to client as a stream");
+            _streamingNegotiated = true;
+            output->append(kStreamingFieldName, true);
+        }
     } else {
         LOGV2_DEBUG(22939, 3, "Could not agree on compressor to use");
     }
@@ -33,6 +33,7 @@
 #include "mongo/transport/message_compressor_base.h"
 #include "mongo/transport/session.h"
 
+#include <memory>
 #include <vector>
 
 namespace mongo {
@@ -65,6 +66,10 @@ public:
      * Called by a client constructing an isMaster request. This function will append the result
      * of _registry->getCompressorNames() to the BSONObjBuilder as a BSON array. If no compressors
      * are configured, it won't append anything.
+     *
+     * If one of the compressors has a dictionary, its ID is offered to the server in a
+     * "compressionDictionaries" document, keyed by the compressor's name. If the registry has
+     * streaming enabled and zstd is configured, "compressionStreaming" is offered as well.
      */
     void clientBegin(BSONObjBuilder* output);
 
@@ -74,7 +79,9 @@ public:
      *
      * This looks for a BSON array called "compression" with the server's list of
      * requested algorithms. The first algorithm in that array will be used in subsequent calls
-     * to compressMessage.
+     * to compressMessage. If the server accepted the dictionary offered by clientBegin, messages
+     * compressed with that compressor use the dictionary. If the server accepted streaming, every
+     * message is compressed by this session's zstd stream.
      */
     void clientFinish(const BSONObj& input);
 
@@ -87,6 +94,13 @@ public:
      *
      * If no compressors are configured that match those requested by the client, then it will
      * not append anything to the BSONObjBuilder output.
+     *
+     * If the client offered a dictionary which a negotiated compressor also has, the server echoes
+     * it back in "compressionDictionaries", and compresses messages with it.
+     *
+     * If the client offered "compressionStreaming", streaming is enabled on this registry and the
+     * client's preferred compressor is zstd, the server echoes it back. The client then compresses
+     * every message with this session's zstd stream, and the server answers each one in kind.
      */
     void serverNegotiate(const BSONObj& input, BSONObjBuilder* output);
 
@@ -127,7 +141,23 @@ public:
     static MessageCompressorManager& forSession(const transport::SessionHandle& session);
 
 private:
+    /*
+     * Returns this session's zstd stream, creating it if needed, or nullptr if zstd is not
+     * registered.
+     */
+    MessageCompressorBase::Stream* _getStream();
+
     std::vector<MessageCompressorBase*> _negotiated;
+
+    // The negotiated compressor whose dictionary the peer also has, if any. Messages compressed
+    // with it use the dictionary.
+    MessageCompressorBase* _dictionaryCompressor = nullptr;
+
+    // Whether the peer agreed to compress all messages as one zstd stream. Takes precedence over
+    // _dictionaryCompressor.
+    bool _streamingNegotiated = false;
+    std::unique_ptr<MessageCompressorBase::Stream> _stream;
+
     MessageCompressorRegistry* _registry;
 };
 
@@ -35,6 +35,8 @@
 #include <string>
 #include <vector>
 
+#include <zdict.h>
+
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/rpc/message.h"
 #include "mongo/transport/message_compressor_manager.h"
@@ -180,6 +182,65 @@ Message buildMessage() {
     return Message{buf};
 }
 
+Message buildMessage(const BSONObj& obj) {
+    const auto bufferSize = MsgData::MsgDataHeaderSize + obj.objsize();
+    auto buf = SharedBuffer::allocate(bufferSize);
+    MsgData::View testView(buf.get());
+    testView.setId(123456);
+    testView.setResponseToMsgId(654321);
+    testView.setOperation(dbMsg);
+    testView.setLen(bufferSize);
+    memcpy(testView.data(), obj.objdata(), obj.objsize());
+    return Message{buf};
+}
+
+BSONObj buildInsertCommand(int i) {
+    return BSON("insert"
+                << "coll"
+                << "documents"
+                << BSON_ARRAY(BSON("_id" << i << "name" << ("user" + std::to_string(i)) << "zip"
+                                         << 10000 + i * 31))
+                << "$db"
+                << "test");
+}
+
+std::string trainDictionary() {
+    std::string samples;
+    std::vector<size_t> sampleSizes;
+    for (int i = 0; i < 1000; ++i) {
+        auto obj = buildInsertCommand(i);
+        samples.append(obj.objdata(), obj.objsize());
+        sampleSizes.push_back(obj.objsize());
+    }
+
+    std::string dictionary(16 * 1024, '\0');
+    auto size = ZDICT_trainFromBuffer(&dictionary[0],
+                                      dictionary.size(),
+                                      samples.data(),
+                                      sampleSizes.data(),
+                                      sampleSizes.size());
+    ASSERT_FALSE(ZDICT_isError(size)) << ZDICT_getErrorName(size);
+    dictionary.resize(size);
+    return dictionary;
+}
+
+MessageCompressorRegistry buildZstdRegistry(const std::string* dictionary) {
+    std::unique_ptr<MessageCompressorBase> compressor;
+    if (dictionary) {
+        auto swCompressor = ZstdMessageCompressor::makeWithDictionary(*dictionary);
+        ASSERT_OK(swCompressor.getStatus());
+        compressor = std::move(swCompressor.getValue());
+    } else {
+        compressor = std::make_unique<ZstdMessageCompressor>();
+    }
+
+    MessageCompressorRegistry registry;
+    registry.setSupportedCompressors({compressor->getName()});
+    registry.registerImplementation(std::move(compressor));
+    ASSERT_OK(registry.finalizeSupportedCompressors());
+    return registry;
+}
+
 TEST(MessageCompressorManager, NoCompressionRequested) {
     auto input = BSON("isMaster" << 1);
     checkServerNegotiation(input, {});
@@ -322,6 +383,112 @@ TEST(MessageCompressorManager, SERVER_28008) {
     ASSERT_EQ(compressorId, zstdId);
 }
 
+TEST(ZstdMessageCompressor, DictionaryMustBeTrained) {
+    auto swCompressor = ZstdMessageCompressor::makeWithDictionary("not a trained dictionary");
+    ASSERT_NOT_OK(swCompressor.getStatus());
+}
+
+TEST(MessageCompressorManager, ZstdDictionaryNegotiated) {
+    const auto dictionary = trainDictionary();
+    auto registry = buildZstdRegistry(&dictionary);
+    const auto dictionaryId =
+        static_cast<long long>(registry.getCompressor("zstd")->getDictionaryId());
+    ASSERT_NE(dictionaryId, 0);
+
+    MessageCompressorManager clientManager(&registry);
+    MessageCompressorManager serverManager(&registry);
+
+    BSONObjBuilder clientOutput;
+    clientManager.clientBegin(&clientOutput);
+    auto clientObj = clientOutput.done();
+    ASSERT_EQ(clientObj["compressionDictionaries"]["zstd"].numberLong(), dictionaryId);
+
+    BSONObjBuilder serverOutput;
+    serverManager.serverNegotiate(clientObj, &serverOutput);
+    auto serverObj = serverOutput.done();
+    checkNegotiationResult(serverObj, {"zstd"});
+    ASSERT_EQ(serverObj["compressionDictionaries"]["zstd"].numberLong(), dictionaryId);
+    clientManager.clientFinish(serverObj);
+
+    auto toSend = buildMessage(buildInsertCommand(5000));
+    auto compressed = assertOk(clientManager.compressMessage(toSend));
+
+    // A server without the dictionary ignores the client's offer, and its messages can still be
+    // decompressed by the client.
+    auto plainRegistry = buildZstdRegistry(nullptr);
+    MessageCompressorManager plainManager(&plainRegistry);
+    BSONObjBuilder plainOutput;
+    plainManager.serverNegotiate(clientObj, &plainOutput);
+    ASSERT_FALSE(plainOutput.done().hasField("compressionDictionaries"));
+    auto withoutDictionary = assertOk(plainManager.compressMessage(toSend));
+    ASSERT_EQ(assertOk(clientManager.decompressMessage(withoutDictionary)).size(), toSend.size());
+
+    // Messages like the ones the dictionary was trained on compress better than without it.
+    ASSERT_LT(compressed.size(), withoutDictionary.size());
+
+    MessageCompressorId compressorId;
+    auto recvd = assertOk(serverManager.decompressMessage(compressed, &compressorId));
+    ASSERT_EQ(recvd.size(), toSend.size());
+    ASSERT_EQ(memcmp(recvd.singleData().data(), toSend.singleData().data(), toSend.dataSize()), 0);
+
+    auto reply = assertOk(serverManager.compressMessage(recvd, &compressorId));
+    recvd = assertOk(clientManager.decompressMessage(reply));
+    ASSERT_EQ(recvd.size(), toSend.size());
+}
+
+TEST(MessageCompressorManager, ZstdStreamingNegotiated) {
+    auto registry = buildZstdRegistry(nullptr);
+    registry.setStreamingEnabled(true);
+
+    MessageCompressorManager clientManager(&registry);
+    MessageCompressorManager serverManager(&registry);
+
+    BSONObjBuilder clientOutput;
+    clientManager.clientBegin(&clientOutput);
+    auto clientObj = clientOutput.done();
+    ASSERT_TRUE(clientObj["compressionStreaming"].trueValue());
+
+    BSONObjBuilder serverOutput;
+    serverManager.serverNegotiate(clientObj, &serverOutput);
+    auto serverObj = serverOutput.done();
+    checkNegotiationResult(serverObj, {"zstd"});
+    ASSERT_TRUE(serverObj["compressionStreaming"].trueValue());
+    clientManager.clientFinish(serverObj);
+
+    // A server without streaming enabled ignores the client's offer.
+    auto plainRegistry = buildZstdRegistry(nullptr);
+    MessageCompressorManager plainManager(&plainRegistry);
+    BSONObjBuilder plainOutput;
+    plainManager.serverNegotiate(clientObj, &plainOutput);
+    ASSERT_FALSE(plainOutput.done().hasField("compressionStreaming"));
+
+    for (int i = 0; i < 10; i++) {
+        auto toSend = buildMessage(buildInsertCommand(i));
+        auto compressed = assertOk(clientManager.compressMessage(toSend));
+
+        // After the first message, each one can refer back to the similar ones before it.
+        auto withoutStreaming = assertOk(plainManager.compressMessage(toSend));
+        if (i > 0) {
+            ASSERT_LT(compressed.size(), withoutStreaming.size());
+        }
+
+        MessageCompressorId compressorId;
+        auto recvd = assertOk(serverManager.decompressMessage(compressed, &compressorId));
+        ASSERT_EQ(recvd.size(), toSend.size());
+        ASSERT_EQ(
+            memcmp(recvd.singleData().data(), toSend.singleData().data(), toSend.dataSize()), 0);
+
+        auto reply = assertOk(serverManager.compressMessage(recvd, &compressorId));
+        recvd = assertOk(clientManager.decompressMessage(reply));
+        ASSERT_EQ(recvd.size(), toSend.size());
+        ASSERT_EQ(
+            memcmp(recvd.singleData().data(), toSend.singleData().data(), toSend.dataSize()), 0);
+
+        // Streamed messages can't be decompressed by a session which didn't negotiate streaming.
+        ASSERT_NOT_OK(plainManager.decompressMessage(compressed).getStatus());
+    }
+}
+
 TEST(MessageCompressorManager, MessageSizeTooLarge) {
     auto registry = buildRegistry();
     MessageCompressorManager compManager(&registry);
@@ -110,12 +110,25 @@ public:
      */
     Status finalizeSupportedCompressors();
 
+    /*
+     * Sets whether connections may compress all of their messages as one stream, which lets each
+     * message refer back to the ones before it. Should be called during option parsing.
+     */
+    void setStreamingEnabled(bool enabled) {
+        _streamingEnabled = enabled;
+    }
+
+    bool isStreamingEnabled() const {
+        return _streamingEnabled;
+    }
+
 private:
     StringMap<MessageCompressorBase*> _compressorsByName;
     std::array<std::unique_ptr<MessageCompressorBase>,
                std::numeric_limits<MessageCompressorId>::max() + 1>
         _compressorsByIds;
     std::vector<std::string> _compressorNames;
+    bool _streamingEnabled = false;
 };
 
 Status storeMessageCompressionOptions(const std::string& compressors);
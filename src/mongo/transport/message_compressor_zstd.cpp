@@ -29,6 +29,8 @@
 
 #include "mongo/platform/basic.h"
 
+#include <fstream>
+#include <iterator>
 #include <memory>
 
 #include <zstd.h>
@@ -38,24 +40,155 @@
 #include "mongo/transport/message_compressor_zstd.h"
 
 namespace mongo {
+namespace {
+
+// The dictionary file given at startup, if any.
+std::string zstdDictionaryFile;
+
+struct CCtxDeleter {
+    void operator()(ZSTD_CCtx* cctx) const {
+        ZSTD_freeCCtx(cctx);
+    }
+};
+
+struct DCtxDeleter {
+    void operator()(ZSTD_DCtx* dctx) const {
+        ZSTD_freeDCtx(dctx);
+    }
+};
+
+Status makeContextStatus(StringData operation) {
+    return Status{ErrorCodes::ExceededMemoryLimit,
+                  str::stream() << "Could not " << operation
+                                << ": failed to allocate a zstd context"};
+}
+
+/**
+ * Each thread keeps its compression and decompression contexts, so that they are only initialized
+ * once rather than for every message. A thread holds its contexts from its first compressed message
+ * until it exits, so with a thread per connection every connection which has used zstd holds them,
+ * idle or not.
+ */
+StatusWith<ZSTD_CCtx*> getCompressionContext() {
+    thread_local std::unique_ptr<ZSTD_CCtx, CCtxDeleter> cctx;
+    if (!cctx) {
+        cctx.reset(ZSTD_createCCtx());
+        if (!cctx) {
+            return makeContextStatus("compress input");
+        }
+    }
+    return cctx.get();
+}
+
+StatusWith<ZSTD_DCtx*> getDecompressionContext() {
+    thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> dctx;
+    if (!dctx) {
+        dctx.reset(ZSTD_createDCtx());
+        if (!dctx) {
+            return makeContextStatus("decompress message");
+        }
+    }
+    return dctx.get();
+}
+
+Status makeCompressStatus(size_t ret) {
+    return Status{ErrorCodes::BadValue,
+                  str::stream() << "Could not compress input: " << ZSTD_getErrorName(ret)};
+}
+
+Status makeDecompressStatus(size_t ret) {
+    return Status{ErrorCodes::BadValue,
+                  str::stream() << "Could not decompress message: " << ZSTD_getErrorName(ret)};
+}
+
+}  // namespace
+
+struct ZstdMessageCompressor::Dictionary {
+    struct CDictDeleter {
+        void operator()(ZSTD_CDict* cdict) const {
+            ZSTD_freeCDict(cdict);
+        }
+    };
+
+    struct DDictDeleter {
+        void operator()(ZSTD_DDict* ddict) const {
+            ZSTD_freeDDict(ddict);
+        }
+    };
+
+    uint32_t id;
+    std::unique_ptr<ZSTD_CDict, CDictDeleter> cdict;
+    std::unique_ptr<ZSTD_DDict, DDictDeleter> ddict;
+};
 
 ZstdMessageCompressor::ZstdMessageCompressor() : MessageCompressorBase(MessageCompressor::kZstd) {}
 
+ZstdMessageCompressor::~ZstdMessageCompressor() = default;
+
+StatusWith<std::unique_ptr<ZstdMessageCompressor>> ZstdMessageCompressor::makeWithDictionary(
+    const std::string& dictionary) {
+    const auto id = ZSTD_getDictID_fromDict(dictionary.data(), dictionary.size());
+    if (id == 0) {
+        return Status{ErrorCodes::BadValue,
+                      "The zstd message compression dictionary is not a trained zstd dictionary"};
+    }
+
+    auto compressor = std::make_unique<ZstdMessageCompressor>();
+    compressor->_dictionary = std::make_unique<Dictionary>();
+    compressor->_dictionary->id = id;
+    compressor->_dictionary->cdict.reset(
+        ZSTD_createCDict(dictionary.data(), dictionary.size(), ZSTD_CLEVEL_DEFAULT));
+    compressor->_dictionary->ddict.reset(ZSTD_createDDict(dictionary.data(), dictionary.size()));
+    if (!compressor->_dictionary->cdict || !compressor->_dictionary->ddict) {
+        return Status{ErrorCodes::BadValue,
+                      "Could not load the zstd message compression dictionary"};
+    }
+
+    return {std::move(compressor)};
+}
+
 std::size_t ZstdMessageCompressor::getMaxCompressedSize(size_t inputSize) {
     return ZSTD_compressBound(inputSize);
 }
 
 StatusWith<std::size_t> ZstdMessageCompressor::compressData(ConstDataRange input,
                                                             DataRange output) {
-    size_t ret = ZSTD_compress(const_cast<char*>(output.data()),
-                               output.length(),
-                               input.data(),
-                               input.length(),
-                               ZSTD_CLEVEL_DEFAULT);
+    auto cctx = getCompressionContext();
+    if (!cctx.isOK()) {
+        return cctx.getStatus();
+    }
+
+    size_t ret = ZSTD_compressCCtx(cctx.getValue(),
+                                   const_cast<char*>(output.data()),
+                                   output.length(),
+                                   input.data(),
+                                   input.length(),
+                                   ZSTD_CLEVEL_DEFAULT);
 
     if (ZSTD_isError(ret)) {
-        return Status{ErrorCodes::BadValue,
-                      str::stream() << "Could not compress input: " << ZSTD_getErrorName(ret)};
+        return makeCompressStatus(ret);
+    }
+    counterHitCompress(input.length(), ret);
+    return {ret};
+}
+
+StatusWith<std::size_t> ZstdMessageCompressor::compressDataWithDictionary(ConstDataRange input,
+                                                                          DataRange output) {
+    invariant(_dictionary);
+    auto cctx = getCompressionContext();
+    if (!cctx.isOK()) {
+        return cctx.getStatus();
+    }
+
+    size_t ret = ZSTD_compress_usingCDict(cctx.getValue(),
+                                          const_cast<char*>(output.data()),
+                                          output.length(),
+                                          input.data(),
+                                          input.length(),
+                                          _dictionary->cdict.get());
+
+    if (ZSTD_isError(ret)) {
+        return makeCompressStatus(ret);
     }
     counterHitCompress(input.length(), ret);
     return {ret};
@@ -63,25 +196,198 @@ StatusWith<std::size_t> ZstdMessageCompressor::compressData(ConstDataRange input
 
 StatusWith<std::size_t> ZstdMessageCompressor::decompressData(ConstDataRange input,
                                                               DataRange output) {
-    size_t ret = ZSTD_decompress(
-        const_cast<char*>(output.data()), output.length(), input.data(), input.length());
+    // Messages from peers which negotiated our dictionary name it in their frame header. Any
+    // message can be decompressed without negotiation, as long as the dictionary is ours.
+    const auto dictionaryId = ZSTD_getDictID_fromFrame(input.data(), input.length());
+    auto dctx = getDecompressionContext();
+    if (!dctx.isOK()) {
+        return dctx.getStatus();
+    }
 
-    if (ZSTD_isError(ret)) {
+    size_t ret;
+    if (dictionaryId == 0) {
+        ret = ZSTD_decompressDCtx(dctx.getValue(),
+                                  const_cast<char*>(output.data()),
+                                  output.length(),
+                                  input.data(),
+                                  input.length());
+    } else if (_dictionary && dictionaryId == _dictionary->id) {
+        ret = ZSTD_decompress_usingDDict(dctx.getValue(),
+                                         const_cast<char*>(output.data()),
+                                         output.length(),
+                                         input.data(),
+                                         input.length(),
+                                         _dictionary->ddict.get());
+    } else {
         return Status{ErrorCodes::BadValue,
-                      str::stream() << "Could not decompress message: " << ZSTD_getErrorName(ret)};
+                      str::stream() << "Could not decompress message: it was compressed with "
+                                       "unknown zstd dictionary "
+                                    << dictionaryId};
+    }
+
+    if (ZSTD_isError(ret)) {
+        return makeDecompressStatus(ret);
     }
 
     counterHitDecompress(input.length(), ret);
     return {ret};
 }
 
+uint32_t ZstdMessageCompressor::getDictionaryId() const {
+    return _dictionary ? _dictionary->id : 0;
+}
+
+/**
+ * Compresses all of a session's messages into one zstd frame, flushing at the end of each message
+ * so that the peer can decompress it without waiting for the next one. Each message starts with a
+ * byte which is 1 if the message begins a new frame, and 0 if it continues the previous one.
+ */
+class ZstdMessageCompressor::StreamImpl final : public MessageCompressorBase::Stream {
+public:
+    explicit StreamImpl(ZstdMessageCompressor* compressor) : _compressor(compressor) {}
+
+    std::size_t getMaxCompressedSize(size_t inputSize) override {
+        return kHeaderSize + ZSTD_compressBound(inputSize);
+    }
+
+    StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) override {
+        if (output.length() < kHeaderSize) {
+            return Status{ErrorCodes::BadValue,
+                          "Could not compress input: output buffer is too small"};
+        }
+
+        const bool newFrame = !_compressing;
+        if (newFrame) {
+            if (!_cctx) {
+                _cctx.reset(ZSTD_createCCtx());
+                if (!_cctx) {
+                    return makeContextStatus("compress input");
+                }
+                ZSTD_CCtx_setParameter(_cctx.get(), ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+                ZSTD_CCtx_setParameter(_cctx.get(), ZSTD_c_windowLog, kWindowLog);
+            }
+            ZSTD_CCtx_reset(_cctx.get(), ZSTD_reset_session_only);
+        }
+
+        // The frame is left in an unknown state if compression fails, so start a new one with the
+        // next message.
+        _compressing = false;
+
+        char* out = const_cast<char*>(output.data());
+        ZSTD_outBuffer outBuffer{out + kHeaderSize, output.length() - kHeaderSize, 0};
+        ZSTD_inBuffer inBuffer{input.data(), input.length(), 0};
+        size_t ret;
+        do {
+            ret = ZSTD_compressStream2(_cctx.get(), &outBuffer, &inBuffer, ZSTD_e_flush);
+            if (ZSTD_isError(ret)) {
+                return makeCompressStatus(ret);
+            }
+        } while (ret != 0 && outBuffer.pos < outBuffer.size);
+
+        if (ret != 0) {
+            return Status{ErrorCodes::BadValue,
+                          "Could not compress input: output buffer is too small"};
+        }
+
+        out[0] = newFrame;
+        _compressing = true;
+
+        const auto compressedSize = kHeaderSize + outBuffer.pos;
+        _compressor->counterHitCompress(input.length(), compressedSize);
+        return {compressedSize};
+    }
+
+    StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) override {
+        if (input.length() < kHeaderSize) {
+            return Status{ErrorCodes::BadValue, "Could not decompress message: it is empty"};
+        }
+
+        if (input.data()[0]) {
+            if (!_dctx) {
+                _dctx.reset(ZSTD_createDCtx());
+                if (!_dctx) {
+                    return makeContextStatus("decompress message");
+                }
+            }
+            ZSTD_DCtx_reset(_dctx.get(), ZSTD_reset_session_only);
+            _decompressing = true;
+        } else if (!_decompressing) {
+            return Status{ErrorCodes::BadValue,
+                          "Could not decompress message: it continues a zstd stream which was not "
+                          "started"};
+        }
+
+        // The peer starts a new frame after it fails, so there is nothing to recover here.
+        _decompressing = false;
+
+        ZSTD_outBuffer outBuffer{const_cast<char*>(output.data()), output.length(), 0};
+        ZSTD_inBuffer inBuffer{input.data() + kHeaderSize, input.length() - kHeaderSize, 0};
+        while (inBuffer.pos < inBuffer.size) {
+            const auto inPos = inBuffer.pos;
+            const auto outPos = outBuffer.pos;
+            size_t ret = ZSTD_decompressStream(_dctx.get(), &outBuffer, &inBuffer);
+            if (ZSTD_isError(ret)) {
+                return makeDecompressStatus(ret);
+            }
+            if (inBuffer.pos == inPos && outBuffer.pos == outPos) {
+                return Status{ErrorCodes::BadValue,
+                              "Could not decompress message: output buffer is too small"};
+            }
+        }
+
+        _decompressing = true;
+        _compressor->counterHitDecompress(input.length(), outBuffer.pos);
+        return {outBuffer.pos};
+    }
+
+private:
+    static constexpr size_t kHeaderSize = 1;
+
+    // Keeps 128KB of history, which spans a few typical batches while bounding the memory each
+    // session needs for its contexts.
+    static constexpr int kWindowLog = 17;
+
+    ZstdMessageCompressor* const _compressor;
+
+    std::unique_ptr<ZSTD_CCtx, CCtxDeleter> _cctx;
+    bool _compressing = false;
+
+    std::unique_ptr<ZSTD_DCtx, DCtxDeleter> _dctx;
+    bool _decompressing = false;
+};
+
+std::unique_ptr<MessageCompressorBase::Stream> ZstdMessageCompressor::makeStream() {
+    return std::make_unique<StreamImpl>(this);
+}
+
+Status storeZstdMessageCompressionDictionaryFile(const std::string& path) {
+    zstdDictionaryFile = path;
+    return Status::OK();
+}
 
 MONGO_INITIALIZER_GENERAL(ZstdMessageCompressorInit,
                           ("EndStartupOptionHandling"),
                           ("AllCompressorsRegistered"))
 (InitializerContext* context) {
     auto& compressorRegistry = MessageCompressorRegistry::get();
-    compressorRegistry.registerImplementation(std::make_unique<ZstdMessageCompressor>());
+    if (zstdDictionaryFile.empty()) {
+        compressorRegistry.registerImplementation(std::make_unique<ZstdMessageCompressor>());
+        return Status::OK();
+    }
+
+    std::ifstream file(zstdDictionaryFile, std::ios::binary);
+    std::string dictionary{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (!file.good() && !file.eof()) {
+        return Status{ErrorCodes::FileNotOpen,
+                      str::stream() << "Could not read the zstd message compression dictionary "
+                                    << zstdDictionaryFile};
+    }
+
+    auto swCompressor = ZstdMessageCompressor::makeWithDictionary(dictionary);
+    if (!swCompressor.isOK()) {
+        return swCompressor.getStatus();
+    }
+    compressorRegistry.registerImplementation(std::move(swCompressor.getValue()));
     return Status::OK();
 }
 }  // namespace mongo
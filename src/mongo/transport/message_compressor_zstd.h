@@ -27,19 +27,49 @@
  *    it in the license file.
  */
 
+#include <memory>
+#include <string>
+
 #include "mongo/transport/message_compressor_base.h"
 
 namespace mongo {
 class ZstdMessageCompressor final : public MessageCompressorBase {
 public:
     ZstdMessageCompressor();
+    ~ZstdMessageCompressor();
+
+    /*
+     * Returns a compressor which can also compress and decompress with 'dictionary', which must be
+     * a dictionary trained by zstd (e.g. with "zstd --train") so that it carries a dictionary ID.
+     */
+    static StatusWith<std::unique_ptr<ZstdMessageCompressor>> makeWithDictionary(
+        const std::string& dictionary);
 
     std::size_t getMaxCompressedSize(size_t inputSize) override;
 
     StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) override;
 
     StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) override;
+
+    uint32_t getDictionaryId() const override;
+
+    StatusWith<std::size_t> compressDataWithDictionary(ConstDataRange input,
+                                                       DataRange output) override;
+
+    std::unique_ptr<Stream> makeStream() override;
+
+private:
+    struct Dictionary;
+    class StreamImpl;
+
+    std::unique_ptr<Dictionary> _dictionary;
 };
 
+/*
+ * Sets the file the zstd compressor loads its dictionary from. Must be called during option
+ * storage, before the compressor is registered.
+ */
+Status storeZstdMessageCompressionDictionaryFile(const std::string& path);
+
 
 }  // namespace mongo
@@ -39,6 +39,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/logv2/log.h"
 #include "mongo/transport/hello_metrics.h"
+#include "mongo/transport/service_executor_work_stealing.h"
 #include "mongo/transport/service_state_machine.h"
 #include "mongo/transport/session.h"
 #include "mongo/util/processinfo.h"
@@ -132,6 +133,12 @@ Status ServiceEntryPointImpl::start() {
         }
     }
 
+    if (auto exec = transport::ServiceExecutorWorkStealing::get(_svcCtx)) {
+        if (auto status = exec->start(); !status.isOK()) {
+            return status;
+        }
+    }
+
     // TODO: Reintroduce SEF once it is attached as initial SE in SERVER-49109
     // if (auto status = transport::ServiceExecutorFixed::get(_svcCtx)->start(); !status.isOK()) {
     //     return status;
@@ -157,6 +164,7 @@ void ServiceEntryPointImpl::startSession(transport::SessionHandle session) {
 
     auto ssm = ServiceStateMachine::create(_svcCtx, session, transportMode);
     auto usingMaxConnOverride = false;
+    auto usingSharedThreads = false;
     {
         stdx::lock_guard<decltype(_sessionsMutex)> lk(_sessionsMutex);
         connectionCount = _sessions.size() + 1;
@@ -184,6 +192,9 @@ void ServiceEntryPointImpl::startSession(transport::SessionHandle session) {
     } else if (auto exec = transport::ServiceExecutorReserved::get(_svcCtx);
                usingMaxConnOverride && exec) {
         ssm->setServiceExecutor(exec);
+    } else if (auto exec = transport::ServiceExecutorWorkStealing::get(_svcCtx)) {
+        ssm->setServiceExecutor(exec);
+        usingSharedThreads = true;
     }
 
     if (!quiet) {
@@ -214,8 +225,9 @@ void ServiceEntryPointImpl::startSession(transport::SessionHandle session) {
         }
     });
 
+    // Sessions which share their executor's threads must hand the thread back between tasks.
     auto ownership = ServiceStateMachine::Ownership::kOwned;
-    if (transportMode == transport::Mode::kSynchronous) {
+    if (transportMode == transport::Mode::kSynchronous && !usingSharedThreads) {
         ownership = ServiceStateMachine::Ownership::kStatic;
     }
     ssm->start(ownership);
@@ -296,6 +308,14 @@ bool ServiceEntryPointImpl::shutdown(Milliseconds timeout) {
         }
     }
 
+    timeSpent = _svcCtx->getPreciseClockSource()->now() - start;
+    timeout = std::max(Milliseconds{0}, timeout - timeSpent);
+    if (auto exec = transport::ServiceExecutorWorkStealing::get(_svcCtx)) {
+        if (auto status = exec->shutdown(timeout); !status.isOK()) {
+            LOGV2(5338717, "Failed to shutdown ServiceExecutorWorkStealing", "error"_attr = status);
+        }
+    }
+
     timeSpent = _svcCtx->getPreciseClockSource()->now() - start;
     timeout = std::max(Milliseconds{0}, timeout - timeSpent);
     if (auto status =
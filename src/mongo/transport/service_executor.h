@@ -104,6 +104,15 @@ public:
     virtual void runOnDataAvailable(Session* session,
                                     OutOfLineExecutor::Task onCompletionCallback) = 0;
 
+    /*
+     * Returns true if sessions should wait for incoming data with runOnDataAvailable() before
+     * reading each message, rather than holding an executor thread in a blocking read while the
+     * client is idle.
+     */
+    virtual bool waitsForDataBeforeSourcing() const {
+        return false;
+    }
+
     /*
      * Stops and joins the ServiceExecutor. Any outstanding tasks will not be executed, and any
      * associated callbacks waiting on I/O may get called with an error code.
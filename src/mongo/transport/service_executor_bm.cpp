@@ -0,0 +1,127 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/transport/service_executor_fixed.h"
+#include "mongo/transport/service_executor_work_stealing.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/future.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+constexpr int kTasksPerChain = 100;
+
+/**
+ * Chains of tasks, each of which schedules the next one in its chain, as a session's
+ * ServiceStateMachine does. One in every 'blockEvery' tasks sleeps for a millisecond, as if it
+ * waited on a lock.
+ */
+struct Chains {
+    ServiceExecutor* executor;
+    int blockEvery;
+    AtomicWord<long long> remaining;
+    Promise<void> done;
+
+    static void run(std::shared_ptr<Chains> chains, int tasksLeft) {
+        if (tasksLeft == 0) {
+            if (chains->remaining.subtractAndFetch(1) == 0) {
+                chains->done.emplaceValue();
+            }
+            return;
+        }
+
+        if (chains->blockEvery && tasksLeft % chains->blockEvery == 0) {
+            ServiceExecutorWorkStealing::markCurrentThreadBlocked();
+            sleepmillis(1);
+            ServiceExecutorWorkStealing::markCurrentThreadUnblocked();
+        }
+
+        auto executor = chains->executor;
+        invariant(executor->scheduleTask(
+            [chains = std::move(chains), tasksLeft] { run(std::move(chains), tasksLeft - 1); },
+            ServiceExecutor::kEmptyFlags));
+    }
+};
+
+void runChains(benchmark::State& state, ServiceExecutor* executor) {
+    invariant(executor->start());
+
+    for (auto keepRunning : state) {
+        auto pf = makePromiseFuture<void>();
+        auto chains = std::make_shared<Chains>();
+        chains->executor = executor;
+        chains->blockEvery = state.range(1);
+        chains->remaining.store(state.range(0));
+        chains->done = std::move(pf.promise);
+
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            Chains::run(chains, kTasksPerChain);
+        }
+        pf.future.get();
+    }
+
+    invariant(executor->shutdown(Seconds(10)));
+    state.SetItemsProcessed(state.iterations() * state.range(0) * kTasksPerChain);
+}
+
+void BM_Fixed(benchmark::State& state) {
+    ThreadPool::Options options;
+    options.poolName = "ServiceExecutorBenchmark";
+    options.minThreads = options.maxThreads = ProcessInfo::getNumAvailableCores();
+    runChains(state, std::make_shared<ServiceExecutorFixed>(std::move(options)).get());
+}
+
+void BM_WorkStealing(benchmark::State& state) {
+    runChains(state,
+              std::make_shared<ServiceExecutorWorkStealing>(
+                  nullptr, ServiceExecutorWorkStealing::Options{})
+                  .get());
+}
+
+void chainArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"chains", "blockEvery"});
+    for (int chains : {1, 64, 1024}) {
+        b->Args({chains, 0});
+    }
+    b->Args({64, 10});
+}
+
+BENCHMARK(BM_Fixed)->Apply(chainArgs)->UseRealTime();
+BENCHMARK(BM_WorkStealing)->Apply(chainArgs)->UseRealTime();
+
+}  // namespace
+}  // namespace transport
+}  // namespace mongo
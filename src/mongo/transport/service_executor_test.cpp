@@ -41,6 +41,7 @@
 #include "mongo/transport/service_executor_fixed.h"
 #include "mongo/transport/service_executor_gen.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_work_stealing.h"
 #include "mongo/transport/transport_layer.h"
 #include "mongo/transport/transport_layer_mock.h"
 #include "mongo/unittest/barrier.h"
@@ -398,5 +399,148 @@ TEST_F(ServiceExecutorFixedFixture, StartAndShutdownAreDeterministic) {
     shutdownThread.join();
 }
 
+class ServiceExecutorWorkStealingFixture : public unittest::Test {
+protected:
+    std::shared_ptr<ServiceExecutorWorkStealing> startExecutor(size_t numWorkers) {
+        ServiceExecutorWorkStealing::Options options;
+        options.numWorkers = numWorkers;
+        auto executor = std::make_shared<ServiceExecutorWorkStealing>(nullptr, options);
+        ASSERT_OK(executor->start());
+        _executors.push_back(executor);
+        return executor;
+    }
+
+    void tearDown() override {
+        for (auto& executor : _executors) {
+            ASSERT_OK(executor->shutdown(kShutdownTime));
+        }
+    }
+
+private:
+    std::vector<std::shared_ptr<ServiceExecutorWorkStealing>> _executors;
+};
+
+TEST_F(ServiceExecutorWorkStealingFixture, ScheduleFailsBeforeStartup) {
+    auto executor = std::make_shared<ServiceExecutorWorkStealing>(
+        nullptr, ServiceExecutorWorkStealing::Options{});
+    scheduleBasicTask(executor.get(), false);
+}
+
+TEST_F(ServiceExecutorWorkStealingFixture, BasicTaskRuns) {
+    auto executor = startExecutor(2);
+    scheduleBasicTask(executor.get(), true);
+}
+
+TEST_F(ServiceExecutorWorkStealingFixture, RecursiveTask) {
+    auto executor = startExecutor(2);
+    auto barrier = std::make_shared<unittest::Barrier>(2);
+
+    std::function<void()> recursiveTask;
+    recursiveTask = [&, barrier] {
+        if (executor->getRecursionDepthForExecutorThread() <
+            workStealingServiceExecutorRecursionLimit.load()) {
+            ASSERT_OK(executor->scheduleTask(recursiveTask, ServiceExecutor::kMayRecurse));
+        } else {
+            barrier->countDownAndWait();
+        }
+    };
+
+    ASSERT_OK(executor->scheduleTask(recursiveTask, ServiceExecutor::kMayRecurse));
+    barrier->countDownAndWait();
+}
+
+TEST_F(ServiceExecutorWorkStealingFixture, IdleWorkerStealsTasks) {
+    auto executor = startExecutor(2);
+    auto barrier = std::make_shared<unittest::Barrier>(2);
+    auto done = std::make_shared<unittest::Barrier>(2);
+
+    // The second task is queued on the first one's worker, which is busy until the second task
+    // runs, so only the other worker can run it.
+    ASSERT_OK(executor->scheduleTask(
+        [executor, barrier, done] {
+            ASSERT_OK(executor->scheduleTask([barrier] { barrier->countDownAndWait(); },
+                                             ServiceExecutor::kEmptyFlags));
+            barrier->countDownAndWait();
+            done->countDownAndWait();
+        },
+        ServiceExecutor::kEmptyFlags));
+    done->countDownAndWait();
+
+    BSONObjBuilder bob;
+    executor->appendStats(&bob);
+    ASSERT_GTE(bob.obj()["stolenTasks"].numberLong(), 1);
+}
+
+TEST_F(ServiceExecutorWorkStealingFixture, SpareThreadRunsTasksWhileWorkerBlocked) {
+    auto executor = startExecutor(1);
+    auto blocked = std::make_shared<unittest::Barrier>(2);
+    auto unblock = std::make_shared<SharedPromise<void>>();
+    auto done = std::make_shared<unittest::Barrier>(2);
+
+    ASSERT_OK(executor->scheduleTask(
+        [blocked, unblock, done] {
+            ServiceExecutorWorkStealing::markCurrentThreadBlocked();
+            blocked->countDownAndWait();
+            unblock->getFuture().get();
+            ServiceExecutorWorkStealing::markCurrentThreadUnblocked();
+            done->countDownAndWait();
+        },
+        ServiceExecutor::kEmptyFlags));
+    blocked->countDownAndWait();
+
+    // The only worker is blocked, so this task runs on a spare thread.
+    ASSERT_OK(executor->scheduleTask([unblock] { unblock->emplaceValue(); },
+                                     ServiceExecutor::kEmptyFlags));
+    done->countDownAndWait();
+
+    BSONObjBuilder bob;
+    executor->appendStats(&bob);
+    auto stats = bob.obj();
+    ASSERT_EQ(stats.getIntField("workers"), 1);
+    ASSERT_EQ(stats.getIntField("blockedThreads"), 0);
+}
+
+TEST_F(ServiceExecutorWorkStealingFixture, DeferredTaskRunsWhenWorkerBlocksAfterScheduling) {
+    auto executor = startExecutor(1);
+    auto unblock = std::make_shared<SharedPromise<void>>();
+    auto done = std::make_shared<unittest::Barrier>(2);
+
+    // The deferred task is queued before its worker blocks, so only the controller, which keeps
+    // checking while tasks are queued, can start a spare thread to run it.
+    ASSERT_OK(executor->scheduleTask(
+        [executor, unblock, done] {
+            ASSERT_OK(executor->scheduleTask([unblock] { unblock->emplaceValue(); },
+                                             ServiceExecutor::kDeferredTask));
+            ServiceExecutorWorkStealing::markCurrentThreadBlocked();
+            unblock->getFuture().get();
+            ServiceExecutorWorkStealing::markCurrentThreadUnblocked();
+            done->countDownAndWait();
+        },
+        ServiceExecutor::kEmptyFlags));
+    done->countDownAndWait();
+}
+
+TEST_F(ServiceExecutorWorkStealingFixture, RunTaskAfterWaitingForData) {
+    auto tl = std::make_unique<TransportLayerMock>();
+    auto session = tl->createSession();
+    auto executor = startExecutor(2);
+    ASSERT_TRUE(executor->waitsForDataBeforeSourcing());
+
+    const auto mainThreadId = stdx::this_thread::get_id();
+    AtomicWord<bool> ranOnDataAvailable{false};
+    auto barrier = std::make_shared<unittest::Barrier>(2);
+    executor->runOnDataAvailable(
+        session.get(), [&ranOnDataAvailable, mainThreadId, barrier](Status) mutable -> void {
+            ranOnDataAvailable.store(true);
+            ASSERT(stdx::this_thread::get_id() != mainThreadId);
+            barrier->countDownAndWait();
+        });
+
+    ASSERT(!ranOnDataAvailable.load());
+    reinterpret_cast<MockSession*>(session.get())->signalAvailableData();
+    barrier->countDownAndWait();
+    ASSERT(ranOnDataAvailable.load());
+}
+
 }  // namespace
 }  // namespace mongo
@@ -158,4 +158,14 @@ void scheduleCallbackOnDataAvailable(transport::Session* session,
     }
 }
 
+Status validateServiceExecutor(const std::string& name) {
+    if (name != "synchronous" && name != "workStealing") {
+        return {ErrorCodes::BadValue,
+                format(FMT_STRING("Unknown service executor \"{}\", expected \"synchronous\" or "
+                                  "\"workStealing\""),
+                       name)};
+    }
+    return Status::OK();
+}
+
 }  // namespace mongo
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <functional>
+#include <string>
 
 #include "mongo/transport/session.h"
 #include "mongo/util/functional.h"
@@ -50,4 +51,8 @@ void scheduleCallbackOnDataAvailable(transport::Session* session,
                                      unique_function<void(Status)> callback,
                                      transport::ServiceExecutor* executor) noexcept;
 
+/* Validates the "serviceExecutor" server parameter, which must be "synchronous" or "workStealing".
+ */
+Status validateServiceExecutor(const std::string& name);
+
 }  // namespace mongo
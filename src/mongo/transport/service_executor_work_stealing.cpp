@@ -0,0 +1,560 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOGV2_DEFAULT_COMPONENT ::mongo::logv2::LogComponent::kExecutor
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/service_executor_work_stealing.h"
+
+#include <fmt/format.h>
+
+#include "mongo/base/init.h"
+#include "mongo/logv2/log.h"
+#include "mongo/transport/service_executor_gen.h"
+#include "mongo/transport/service_executor_utils.h"
+#include "mongo/transport/session.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/interruptible.h"
+#include "mongo/util/processinfo.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace mongo {
+namespace transport {
+namespace {
+constexpr auto kThreadsRunning = "threadsRunning"_sd;
+constexpr auto kExecutorLabel = "executor"_sd;
+constexpr auto kExecutorName = "workStealing"_sd;
+constexpr auto kWorkers = "workers"_sd;
+constexpr auto kSpareThreads = "spareThreads"_sd;
+constexpr auto kBlockedThreads = "blockedThreads"_sd;
+constexpr auto kQueuedTasks = "queuedTasks"_sd;
+constexpr auto kStolenTasks = "stolenTasks"_sd;
+
+const auto getServiceExecutorWorkStealing =
+    ServiceContext::declareDecoration<std::shared_ptr<ServiceExecutorWorkStealing>>();
+
+const auto serviceExecutorWorkStealingRegisterer = ServiceContext::ConstructorActionRegisterer{
+    "ServiceExecutorWorkStealing", [](ServiceContext* ctx) {
+        if (gServiceExecutor != kExecutorName) {
+            return;
+        }
+
+        ServiceExecutorWorkStealing::Options options;
+        options.pinWorkers = workStealingServiceExecutorPinWorkers;
+        getServiceExecutorWorkStealing(ctx) =
+            std::make_shared<ServiceExecutorWorkStealing>(ctx, std::move(options));
+    }};
+
+// How often the controller thread checks whether to start a spare thread while tasks are queued
+// and every thread is busy.
+constexpr auto kSpareThreadCheckInterval = Milliseconds(10);
+
+/**
+ * Counts the threads of a ServiceExecutorWorkStealing which wait on a condition for long as
+ * blocked, so that the executor can run another thread in their place. Listeners are called with
+ * the waiting thread's latch held, so this only updates counters; the executor's controller thread
+ * starts the spare threads.
+ */
+class BlockedThreadListener final : public Interruptible::WaitListener {
+public:
+    void onLongSleep(const StringData& name) override {
+        ServiceExecutorWorkStealing::markCurrentThreadBlocked();
+    }
+
+    void onWake(const StringData& name,
+                Interruptible::WakeReason reason,
+                Interruptible::WakeSpeed speed) override {
+        // Only waits which outlasted Interruptible::kFastWakeTimeout called onLongSleep().
+        if (speed == Interruptible::WakeSpeed::kSlow) {
+            ServiceExecutorWorkStealing::markCurrentThreadUnblocked();
+        }
+    }
+};
+
+// Wait listeners can only be installed by initializers, so this is done once the startup options
+// are known, and only if they select this executor.
+MONGO_INITIALIZER_WITH_PREREQUISITES(ServiceExecutorWorkStealingWaitListener,
+                                     ("EndStartupOptionHandling"))
+(InitializerContext*) {
+    if (gServiceExecutor == kExecutorName) {
+        Interruptible::installWaitListener<BlockedThreadListener>();
+    }
+}
+
+#if defined(__linux__)
+std::vector<int> getAllowedCpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<int> cpus;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+void setThreadAffinity(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    if (int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) {
+        LOGV2_WARNING(5338712,
+                      "Failed to set the CPU affinity of a service executor thread",
+                      "error"_attr = errnoWithDescription(err));
+    }
+}
+#else
+std::vector<int> getAllowedCpus() {
+    return {};
+}
+
+void setThreadAffinity(const std::vector<int>& cpus) {}
+#endif
+}  // namespace
+
+/**
+ * The state of one of the executor's threads. Installed as the thread's IdleThreadBlock observer,
+ * so that a worker waiting in an IdleThreadBlock counts as blocked.
+ */
+class ServiceExecutorWorkStealing::ThreadContext final : public IdleThreadBlock::Observer {
+public:
+    ThreadContext(ServiceExecutorWorkStealing* executor, boost::optional<size_t> queue)
+        : _executor(executor), _queue(queue) {
+        _threadContext = this;
+        IdleThreadBlock::setObserverForThread(this);
+    }
+
+    ~ThreadContext() {
+        IdleThreadBlock::setObserverForThread(nullptr);
+        _threadContext = nullptr;
+    }
+
+    ThreadContext(const ThreadContext&) = delete;
+    ThreadContext& operator=(const ThreadContext&) = delete;
+
+    ServiceExecutorWorkStealing* getExecutor() const {
+        return _executor;
+    }
+
+    // The thread's own run queue, or none for a spare thread.
+    const boost::optional<size_t>& getQueue() const {
+        return _queue;
+    }
+
+    void run(Task task) {
+        _recursionDepth++;
+        task();
+        _recursionDepth--;
+    }
+
+    int getRecursionDepth() const {
+        return _recursionDepth;
+    }
+
+    void markBlocked() {
+        if (_blockedDepth++ == 0) {
+            _executor->_onThreadBlocked();
+        }
+    }
+
+    void markUnblocked() {
+        invariant(_blockedDepth > 0);
+        if (--_blockedDepth == 0) {
+            _executor->_onThreadUnblocked();
+        }
+    }
+
+    void onBeginIdle() override {
+        markBlocked();
+    }
+
+    void onEndIdle() override {
+        markUnblocked();
+    }
+
+private:
+    ServiceExecutorWorkStealing* const _executor;
+    const boost::optional<size_t> _queue;
+    int _recursionDepth = 0;
+    int _blockedDepth = 0;
+};
+
+ServiceExecutorWorkStealing::ServiceExecutorWorkStealing(ServiceContext* ctx, Options options)
+    : _svcCtx(ctx), _options(std::move(options)) {
+    if (!_options.numWorkers) {
+        _options.numWorkers = static_cast<size_t>(ProcessInfo::getNumAvailableCores());
+    }
+
+    for (size_t i = 0; i < _options.numWorkers; ++i) {
+        _runQueues.push_back(std::make_unique<RunQueue>());
+    }
+}
+
+ServiceExecutorWorkStealing::~ServiceExecutorWorkStealing() {
+    invariant(!_stillRunning.load());
+    if (_controllerThread.joinable()) {
+        _wakeController();
+        _controllerThread.join();
+    }
+    if (_reactorThread.joinable()) {
+        _reactor->stop();
+        _reactorThread.join();
+    }
+}
+
+ServiceExecutorWorkStealing* ServiceExecutorWorkStealing::get(ServiceContext* ctx) {
+    // The ServiceExecutorWorkStealing is absent unless the "serviceExecutor" parameter selects it.
+    return getServiceExecutorWorkStealing(ctx).get();
+}
+
+Status ServiceExecutorWorkStealing::start() {
+    if (_options.pinWorkers) {
+        _cpus = getAllowedCpus();
+        if (_cpus.empty()) {
+            LOGV2_WARNING(5338713,
+                          "Cannot pin service executor workers to cores on this platform");
+        }
+    }
+
+    if (auto tl = _svcCtx ? _svcCtx->getTransportLayer() : nullptr) {
+        _reactor = tl->getReactor(TransportLayer::kIngress);
+        _reactorThread = stdx::thread([reactor = _reactor] {
+            setThreadName("workStealingReactor");
+            reactor->run();
+        });
+    }
+
+    _stillRunning.store(true);
+    _controllerThread = stdx::thread([this] { _runController(); });
+    for (size_t i = 0; i < _options.numWorkers; ++i) {
+        if (auto status = _startThread(i); !status.isOK()) {
+            return status;
+        }
+    }
+
+    LOGV2_DEBUG(5338714,
+                3,
+                "Started work-stealing service executor",
+                "workers"_attr = _options.numWorkers,
+                "pinWorkers"_attr = !_cpus.empty());
+    return Status::OK();
+}
+
+Status ServiceExecutorWorkStealing::shutdown(Milliseconds timeout) {
+    LOGV2_DEBUG(5338715, 3, "Shutting down work-stealing service executor");
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stillRunning.store(false);
+        _workAvailable.notify_all();
+    }
+
+    // The reactor thread may be scheduling tasks, and the controller thread starting spare
+    // threads, so they must be joined without holding _mutex.
+    if (_controllerThread.joinable()) {
+        _wakeController();
+        _controllerThread.join();
+    }
+    if (_reactorThread.joinable()) {
+        _reactor->stop();
+        _reactorThread.join();
+    }
+
+    stdx::unique_lock<Latch> lk(_mutex);
+    bool result = _shutdownCondition.wait_for(lk, timeout.toSystemDuration(), [this] {
+        return _numRunningThreads.load() == 0;
+    });
+
+    return result
+        ? Status::OK()
+        : Status(ErrorCodes::ExceededTimeLimit,
+                 "work-stealing executor couldn't shutdown all worker threads within time limit.");
+}
+
+Status ServiceExecutorWorkStealing::scheduleTask(Task task, ScheduleFlags flags) {
+    if (!_stillRunning.load()) {
+        return Status(ErrorCodes::ShutdownInProgress, "Executor is not running");
+    }
+
+    const bool onOwnThread = _threadContext && _threadContext->getExecutor() == this;
+    if (onOwnThread && (flags & ScheduleFlags::kMayRecurse) &&
+        _threadContext->getRecursionDepth() <
+            workStealingServiceExecutorRecursionLimit.loadRelaxed()) {
+        // Recursively executing the task on the executor thread.
+        _threadContext->run(std::move(task));
+        return Status::OK();
+    }
+
+    // Workers keep the tasks they schedule, which likely touch the same session, to themselves
+    // unless another thread runs out of work.
+    auto queue = onOwnThread && _threadContext->getQueue()
+        ? *_threadContext->getQueue()
+        : _nextQueue.fetchAndAdd(1) % _runQueues.size();
+    _push(queue, std::move(task));
+
+    if (_numSleepingThreads.load() > 0) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _workAvailable.notify_one();
+    } else if (_controllerIdle.load()) {
+        // Every thread is busy. The controller starts a spare thread if some of them are blocked,
+        // whether or not this task is deferred.
+        _wakeController();
+    }
+
+    return Status::OK();
+}
+
+void ServiceExecutorWorkStealing::runOnDataAvailable(Session* session,
+                                                     OutOfLineExecutor::Task onCompletionCallback) {
+    invariant(session);
+    session->waitForData().thenRunOn(shared_from_this()).getAsync(std::move(onCompletionCallback));
+}
+
+void ServiceExecutorWorkStealing::appendStats(BSONObjBuilder* bob) const {
+    *bob << kExecutorLabel << kExecutorName << kThreadsRunning
+         << static_cast<int>(_numRunningThreads.load()) << kWorkers
+         << static_cast<int>(_options.numWorkers) << kSpareThreads
+         << static_cast<int>(_numSpareThreads.load()) << kBlockedThreads
+         << static_cast<int>(_numBlockedThreads.load()) << kQueuedTasks
+         << static_cast<int>(_numQueuedTasks.load()) << kStolenTasks << _numStolenTasks.load();
+}
+
+void ServiceExecutorWorkStealing::markCurrentThreadBlocked() {
+    if (_threadContext) {
+        _threadContext->markBlocked();
+    }
+}
+
+void ServiceExecutorWorkStealing::markCurrentThreadUnblocked() {
+    if (_threadContext) {
+        _threadContext->markUnblocked();
+    }
+}
+
+int ServiceExecutorWorkStealing::getRecursionDepthForExecutorThread() const {
+    invariant(_threadContext);
+    return _threadContext->getRecursionDepth();
+}
+
+void ServiceExecutorWorkStealing::_push(size_t queue, Task task) {
+    auto& runQueue = *_runQueues[queue];
+    stdx::lock_guard<Latch> lk(runQueue.mutex);
+    runQueue.tasks.push_back(std::move(task));
+    _numQueuedTasks.addAndFetch(1);
+}
+
+boost::optional<ServiceExecutor::Task> ServiceExecutorWorkStealing::_pop(size_t queue) {
+    auto& runQueue = *_runQueues[queue];
+    stdx::lock_guard<Latch> lk(runQueue.mutex);
+    if (runQueue.tasks.empty()) {
+        return boost::none;
+    }
+
+    auto task = std::move(runQueue.tasks.front());
+    runQueue.tasks.pop_front();
+    _numQueuedTasks.subtractAndFetch(1);
+    return std::move(task);
+}
+
+boost::optional<ServiceExecutor::Task> ServiceExecutorWorkStealing::_popOrSteal(
+    boost::optional<size_t> ownQueue) {
+    if (ownQueue) {
+        if (auto task = _pop(*ownQueue)) {
+            return task;
+        }
+    }
+
+    // Start from a different queue on each thread, so that thieves don't all contend on the same
+    // one.
+    const auto numQueues = _runQueues.size();
+    const auto first = ownQueue ? *ownQueue + 1 : _nextQueue.fetchAndAdd(1);
+    for (size_t i = 0; i < numQueues && _numQueuedTasks.load() > 0; ++i) {
+        auto queue = (first + i) % numQueues;
+        if (queue == ownQueue) {
+            continue;
+        }
+
+        if (auto task = _pop(queue)) {
+            _numStolenTasks.addAndFetch(1);
+            return task;
+        }
+    }
+
+    return boost::none;
+}
+
+Status ServiceExecutorWorkStealing::_startThread(boost::optional<size_t> queue) {
+    _numRunningThreads.addAndFetch(1);
+
+    auto status =
+        launchServiceWorkerThread([this, self = shared_from_this(), queue] { _runThread(queue); });
+    if (!status.isOK()) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (_numRunningThreads.subtractAndFetch(1) == 0) {
+            _shutdownCondition.notify_all();
+        }
+    }
+
+    return status;
+}
+
+void ServiceExecutorWorkStealing::_runThread(boost::optional<size_t> queue) {
+    if (queue) {
+        setThreadName(fmt::format("workStealingWorker-{}", *queue));
+    } else {
+        setThreadName("workStealingSpare");
+    }
+
+    if (!_cpus.empty()) {
+        // Spare threads may run on any of the CPUs the workers are pinned to.
+        setThreadAffinity(queue ? std::vector<int>{_cpus[*queue % _cpus.size()]} : _cpus);
+    }
+
+    bool spareRetired = false;
+    {
+        ThreadContext context(this, queue);
+        while (_stillRunning.load()) {
+            auto task = _popOrSteal(queue);
+            if (task) {
+                context.run(std::move(*task));
+            } else if (queue) {
+                _sleepUntilWorkAvailable();
+                continue;
+            } else {
+                break;
+            }
+
+            if (!queue) {
+                // A spare thread exits once it no longer stands in for a blocked worker.
+                auto spares = _numSpareThreads.load();
+                while (spares > _numBlockedThreads.load()) {
+                    if (_numSpareThreads.compareAndSwap(&spares, spares - 1)) {
+                        spareRetired = true;
+                        break;
+                    }
+                }
+                if (spareRetired) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (!queue && !spareRetired) {
+        _numSpareThreads.subtractAndFetch(1);
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_numRunningThreads.subtractAndFetch(1) == 0) {
+        _shutdownCondition.notify_all();
+    }
+}
+
+void ServiceExecutorWorkStealing::_sleepUntilWorkAvailable() {
+    stdx::unique_lock<Latch> lk(_mutex);
+    _numSleepingThreads.addAndFetch(1);
+    _workAvailable.wait(
+        lk, [this] { return _numQueuedTasks.load() > 0 || !_stillRunning.load(); });
+    _numSleepingThreads.subtractAndFetch(1);
+}
+
+void ServiceExecutorWorkStealing::_onThreadBlocked() {
+    _numBlockedThreads.addAndFetch(1);
+}
+
+void ServiceExecutorWorkStealing::_onThreadUnblocked() {
+    _numBlockedThreads.subtractAndFetch(1);
+}
+
+void ServiceExecutorWorkStealing::_runController() {
+    setThreadName("workStealingController");
+
+    stdx::unique_lock<Latch> lk(_controllerMutex);
+    while (_stillRunning.load()) {
+        _maybeStartSpareThread();
+
+        // Threads become blocked without waking the controller, so it checks again after a while
+        // even when nothing wakes it: soon while tasks are queued, and otherwise after about as
+        // long as it takes a waiting thread to count as blocked. Announce that the controller is
+        // idle before looking at the queues, so that a task scheduled after the check wakes it.
+        _controllerIdle.store(true);
+        auto interval = Interruptible::kFastWakeTimeout;
+        if (_numQueuedTasks.load() > 0) {
+            _controllerIdle.store(false);
+            interval = kSpareThreadCheckInterval;
+        }
+
+        _controllerWakeup.wait_for(lk, interval.toSystemDuration(), [this] {
+            return _controllerWoken || !_stillRunning.load();
+        });
+        _controllerIdle.store(false);
+        _controllerWoken = false;
+    }
+}
+
+void ServiceExecutorWorkStealing::_wakeController() {
+    stdx::lock_guard<Latch> lk(_controllerMutex);
+    _controllerWoken = true;
+    _controllerWakeup.notify_one();
+}
+
+void ServiceExecutorWorkStealing::_maybeStartSpareThread() {
+    auto spares = _numSpareThreads.load();
+    while (_stillRunning.load() && _numQueuedTasks.load() > 0 &&
+           _numSleepingThreads.load() == 0 && spares < _numBlockedThreads.load() &&
+           spares < static_cast<size_t>(workStealingServiceExecutorMaxSpareThreads.load())) {
+        if (!_numSpareThreads.compareAndSwap(&spares, spares + 1)) {
+            continue;
+        }
+
+        LOGV2_DEBUG(5338716,
+                    3,
+                    "Starting spare thread in work-stealing service executor",
+                    "blockedThreads"_attr = _numBlockedThreads.load());
+        if (!_startThread(boost::none).isOK()) {
+            _numSpareThreads.subtractAndFetch(1);
+        }
+        return;
+    }
+}
+
+}  // namespace transport
+}  // namespace mongo
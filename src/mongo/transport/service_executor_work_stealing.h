@@ -0,0 +1,198 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/db/service_context.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_executor.h"
+#include "mongo/transport/transport_layer.h"
+#include "mongo/util/hierarchical_acquisition.h"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * A service executor which runs tasks on a worker thread per core. Each worker has its own run
+ * queue: tasks scheduled from a worker go to its own queue, and tasks scheduled from other threads
+ * are spread across the queues. A worker whose queue is empty steals the oldest task from another
+ * queue before it goes to sleep. Sessions wait for data with runOnDataAvailable() instead of in a
+ * blocking read, so idle connections do not hold a thread.
+ *
+ * A worker which waits inside a task for long (see Interruptible::WaitListener), or enters an
+ * IdleThreadBlock, no longer counts against its core: while tasks are queued, the executor's
+ * controller thread starts a spare thread in its place. Spare threads exit once they run out of
+ * work or the blocked workers resume.
+ *
+ * Like ServiceExecutorFixed, this executor never yields before scheduling new tasks.
+ */
+class ServiceExecutorWorkStealing final
+    : public ServiceExecutor,
+      public std::enable_shared_from_this<ServiceExecutorWorkStealing> {
+public:
+    struct Options {
+        // The number of workers, each with its own run queue. Zero means one per available core.
+        size_t numWorkers = 0;
+
+        // Whether each worker is pinned to its own core.
+        bool pinWorkers = false;
+    };
+
+    ServiceExecutorWorkStealing(ServiceContext* ctx, Options options);
+    ~ServiceExecutorWorkStealing();
+
+    /**
+     * Returns the executor if the "serviceExecutor" server parameter selected it, or nullptr.
+     */
+    static ServiceExecutorWorkStealing* get(ServiceContext* ctx);
+
+    Status start() override;
+    Status shutdown(Milliseconds timeout) override;
+    Status scheduleTask(Task task, ScheduleFlags flags) override;
+
+    void runOnDataAvailable(Session* session,
+                            OutOfLineExecutor::Task onCompletionCallback) override;
+
+    bool waitsForDataBeforeSourcing() const override {
+        return true;
+    }
+
+    Mode transportMode() const override {
+        return Mode::kSynchronous;
+    }
+
+    void appendStats(BSONObjBuilder* bob) const override;
+
+    /**
+     * Marks the current thread as waiting on something other than this executor's work, e.g. a
+     * lock, until the matching call to markCurrentThreadUnblocked(). Does nothing unless the
+     * current thread belongs to a ServiceExecutorWorkStealing. Calls may nest.
+     */
+    static void markCurrentThreadBlocked();
+    static void markCurrentThreadUnblocked();
+
+    /**
+     * Returns the recursion depth of the active executor thread.
+     * It is forbidden to invoke this method outside scheduled tasks.
+     */
+    int getRecursionDepthForExecutorThread() const;
+
+private:
+    class ThreadContext;
+
+    struct RunQueue {
+        Mutex mutex = MONGO_MAKE_LATCH("ServiceExecutorWorkStealing::RunQueue::mutex");
+        std::deque<Task> tasks;
+    };
+
+    void _push(size_t queue, Task task);
+    boost::optional<Task> _pop(size_t queue);
+
+    /**
+     * Pops a task from the thread's own queue, if it has one, or steals one from the others.
+     */
+    boost::optional<Task> _popOrSteal(boost::optional<size_t> ownQueue);
+
+    /**
+     * Starts a thread which runs tasks from 'queue', or steals tasks from any queue if 'queue' is
+     * none, as spare threads do.
+     */
+    Status _startThread(boost::optional<size_t> queue);
+    void _runThread(boost::optional<size_t> queue);
+
+    /**
+     * Waits until tasks are queued or the executor shuts down.
+     */
+    void _sleepUntilWorkAvailable();
+
+    void _onThreadBlocked();
+    void _onThreadUnblocked();
+
+    /**
+     * Runs the controller thread, which starts the spare threads. Blocked threads only update
+     * counters, so that they never start threads from wherever they happen to block.
+     */
+    void _runController();
+    void _wakeController();
+
+    /**
+     * Starts a spare thread if tasks are queued, no thread is asleep to run them, and there are
+     * fewer spare threads than blocked ones. Only called by the controller thread.
+     */
+    void _maybeStartSpareThread();
+
+    ServiceContext* const _svcCtx;
+    Options _options;
+
+    // The CPUs this process may run on, which pinned workers are spread across.
+    std::vector<int> _cpus;
+
+    std::vector<std::unique_ptr<RunQueue>> _runQueues;
+    AtomicWord<size_t> _nextQueue{0};
+    AtomicWord<size_t> _numQueuedTasks{0};
+
+    AtomicWord<bool> _stillRunning{false};
+
+    mutable Mutex _mutex =
+        MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "ServiceExecutorWorkStealing::_mutex");
+    stdx::condition_variable _workAvailable;
+    stdx::condition_variable _shutdownCondition;
+
+    AtomicWord<size_t> _numSleepingThreads{0};
+    AtomicWord<size_t> _numRunningThreads{0};
+    AtomicWord<size_t> _numBlockedThreads{0};
+    AtomicWord<size_t> _numSpareThreads{0};
+    AtomicWord<long long> _numStolenTasks{0};
+
+    // Starts spare threads in place of blocked ones. While no tasks are queued _controllerIdle is
+    // set, and scheduling a task when no thread is asleep to run it wakes the controller.
+    stdx::thread _controllerThread;
+    Mutex _controllerMutex = MONGO_MAKE_LATCH("ServiceExecutorWorkStealing::_controllerMutex");
+    stdx::condition_variable _controllerWakeup;
+    bool _controllerWoken = false;
+    AtomicWord<bool> _controllerIdle{false};
+
+    // Runs the transport layer's ingress reactor, on which runOnDataAvailable() waits.
+    ReactorHandle _reactor;
+    stdx::thread _reactorThread;
+
+    static inline thread_local ThreadContext* _threadContext = nullptr;
+};
+
+}  // namespace transport
+}  // namespace mongo
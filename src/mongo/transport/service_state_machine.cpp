@@ -33,7 +33,9 @@
 
 #include "mongo/transport/service_state_machine.h"
 
+#include <algorithm>
 #include <memory>
+#include <utility>
 
 #include "mongo/config.h"
 #include "mongo/db/client.h"
@@ -61,6 +63,10 @@
 namespace mongo {
 namespace {
 MONGO_FAIL_POINT_DEFINE(doNotSetMoreToCome);
+
+// The most exhaust replies which are held back to be sunk in a single write.
+constexpr std::size_t kMaxDeferredExhaustReplies = 16;
+
 /**
  * Creates and returns a legacy exhaust message, if exhaust is allowed. The returned message is to
  * be used as the subsequent 'synthetic' exhaust request. Returns an empty message if exhaust is not
@@ -319,6 +325,11 @@ void ServiceStateMachine::_sourceMessage(ThreadGuard guard) {
 
     auto sourceMsgImpl = [&] {
         if (_transportMode == transport::Mode::kSynchronous) {
+            // Once the executor has waited for the client to send data, reading the message does
+            // not leave the thread idle.
+            if (_serviceExecutor->waitsForDataBeforeSourcing()) {
+                return Future<Message>::makeReady(_session()->sourceMessage());
+            }
             MONGO_IDLE_THREAD_BLOCK;
             return Future<Message>::makeReady(_session()->sourceMessage());
         } else {
@@ -343,6 +354,20 @@ void ServiceStateMachine::_sinkMessage(ThreadGuard guard, Message toSink) {
     guard.release();
 
     auto sinkMsgImpl = [&] {
+        if (!_deferredReplies.empty()) {
+            // Sink the replies which were held back along with this one, in a single write.
+            auto replies = std::exchange(_deferredReplies, {});
+            _deferredRepliesBytes = 0;
+            replies.push_back(std::move(toSink));
+
+            if (_transportMode == transport::Mode::kSynchronous) {
+                return Future<void>::makeReady(_session()->sinkMessages(std::move(replies)));
+            } else {
+                invariant(_transportMode == transport::Mode::kAsynchronous);
+                return _session()->asyncSinkMessages(std::move(replies));
+            }
+        }
+
         if (_transportMode == transport::Mode::kSynchronous) {
             // We don't consider ourselves idle while sending the reply since we are still doing
             // work on behalf of the client. Contrast that with sourceMessage() where we are waiting
@@ -357,6 +382,24 @@ void ServiceStateMachine::_sinkMessage(ThreadGuard guard, Message toSink) {
     sinkMsgImpl().getAsync([this](Status status) { _sinkCallback(std::move(status)); });
 }
 
+bool ServiceStateMachine::_shouldDeferExhaustReply(const Message& reply) {
+    if (_deferredReplies.size() >= kMaxDeferredExhaustReplies) {
+        return false;
+    }
+
+    auto stats = _session()->getSendBufferStats();
+    if (!stats) {
+        return false;
+    }
+
+    // If the replies fit in the free space of the send buffer, then sinking them will not block.
+    // Otherwise, hold them back while the remote host drains the send buffer, unless they would
+    // fill the whole buffer by themselves.
+    auto bytes = _deferredRepliesBytes + reply.size();
+    auto freeBytes = stats->size - std::min(stats->queued, stats->size);
+    return bytes > freeBytes && bytes < stats->size;
+}
+
 void ServiceStateMachine::_sourceCallback(Status status) {
     // The first thing to do is create a ThreadGuard which will take ownership of the SSM in this
     // thread.
@@ -435,9 +478,9 @@ void ServiceStateMachine::_sinkCallback(Status status) {
                                           ServiceExecutor::kMayYieldBeforeSchedule);
     } else {
         _state.store(State::Source);
-        return _scheduleNextWithGuard(std::move(guard),
-                                      ServiceExecutor::kDeferredTask |
-                                          ServiceExecutor::kMayYieldBeforeSchedule);
+        return _scheduleSourceWithGuard(std::move(guard),
+                                        ServiceExecutor::kDeferredTask |
+                                            ServiceExecutor::kMayYieldBeforeSchedule);
     }
 }
 
@@ -520,13 +563,33 @@ void ServiceStateMachine::_processMessage(ThreadGuard guard) {
                     .observe(
                         _sessionHandle, _serviceContext->getPreciseClockSource()->now(), toSink);
 
+                // Exhaust replies are held back while the socket cannot take them without blocking,
+                // and the next batch is generated in the meantime.
+                if (_inExhaust && dbresponse.canDeferExhaustReply &&
+                    _shouldDeferExhaustReply(toSink)) {
+                    _deferredRepliesBytes += toSink.size();
+                    _deferredReplies.push_back(std::move(toSink));
+                    return _scheduleNextWithGuard(std::move(guard),
+                                                  ServiceExecutor::kDeferredTask |
+                                                      ServiceExecutor::kMayYieldBeforeSchedule);
+                }
+
                 _sinkMessage(std::move(guard), std::move(toSink));
 
+            } else if (!_deferredReplies.empty()) {
+                // There is no reply to this exhaust request, so sink the replies which were held
+                // back.
+                auto lastReply = std::move(_deferredReplies.back());
+                _deferredReplies.pop_back();
+                _deferredRepliesBytes -= lastReply.size();
+                _inMessage.reset();
+                _inExhaust = false;
+                _sinkMessage(std::move(guard), std::move(lastReply));
             } else {
                 _state.store(State::Source);
                 _inMessage.reset();
                 _inExhaust = false;
-                return _scheduleNextWithGuard(std::move(guard), ServiceExecutor::kDeferredTask);
+                return _scheduleSourceWithGuard(std::move(guard), ServiceExecutor::kDeferredTask);
             }
         })
         .get();
@@ -619,6 +682,26 @@ void ServiceStateMachine::_scheduleNextWithGuard(ThreadGuard guard,
     _cleanupSession(std::move(terminateGuard));
 }
 
+void ServiceStateMachine::_scheduleSourceWithGuard(
+    ThreadGuard guard, transport::ServiceExecutor::ScheduleFlags flags) {
+    invariant(state() == State::Source);
+    if (!_serviceExecutor->waitsForDataBeforeSourcing()) {
+        return _scheduleNextWithGuard(std::move(guard), flags);
+    }
+
+    guard.release();
+    _serviceExecutor->runOnDataAvailable(
+        _session().get(), [ssm = shared_from_this()](Status status) {
+            ThreadGuard guard(ssm.get());
+            if (!status.isOK()) {
+                // The session was closed or the executor is shutting down.
+                ssm->_terminateAndLogIfError(status);
+                ssm->_state.store(State::EndSession);
+            }
+            ssm->_runNextInGuard(std::move(guard));
+        });
+}
+
 void ServiceStateMachine::terminate() {
     if (state() == State::Ended)
         return;
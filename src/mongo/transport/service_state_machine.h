@@ -32,6 +32,7 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "mongo/base/status.h"
 #include "mongo/config.h"
@@ -182,6 +183,14 @@ private:
                                 transport::ServiceExecutor::ScheduleFlags flags,
                                 Ownership ownershipModel = Ownership::kOwned);
 
+    /*
+     * Schedules sourcing the next message. If the serviceExecutor waits for data before sourcing,
+     * the next step is only scheduled once the client has sent data, so that no thread is held
+     * while the client is idle.
+     */
+    void _scheduleSourceWithGuard(ThreadGuard guard,
+                                  transport::ServiceExecutor::ScheduleFlags flags);
+
     /*
      * Gets the transport::Session associated with this connection
      */
@@ -214,6 +223,12 @@ private:
     void _sourceMessage(ThreadGuard guard);
     void _sinkMessage(ThreadGuard guard, Message toSink);
 
+    /*
+     * Returns whether an exhaust reply should be held back, so that the next batch is generated
+     * while the socket drains, and then sent together with it.
+     */
+    bool _shouldDeferExhaustReply(const Message& reply);
+
     /*
      * Releases all the resources associated with the session and call the cleanupHook.
      */
@@ -242,6 +257,10 @@ private:
     boost::optional<MessageCompressorId> _compressorId;
     Message _inMessage;
 
+    // Exhaust replies which have been held back to be sunk along with the next reply.
+    std::vector<Message> _deferredReplies;
+    std::size_t _deferredRepliesBytes = 0;
+
     // Allows delegating destruction of opCtx to another function to potentially remove its cost
     // from the critical path. This is currently only used in `_processMessage()`.
     ServiceContext::UniqueOperationContext _killedOpCtx;
@@ -50,6 +50,7 @@
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
 #include "mongo/util/tick_source_mock.h"
 
 namespace mongo {
@@ -287,6 +288,41 @@ private:
     ScheduleHook _scheduleHook;
 };
 
+/**
+ * A MockServiceExecutor which, like ServiceExecutorWorkStealing, asks sessions to wait for data
+ * before sourcing each message.
+ */
+class MockWaitingServiceExecutor : public MockServiceExecutor {
+public:
+    using MockServiceExecutor::MockServiceExecutor;
+
+    bool waitsForDataBeforeSourcing() const override {
+        return true;
+    }
+};
+
+/**
+ * Counts the IdleThreadBlocks entered by the thread it is installed on.
+ */
+class IdleThreadBlockCounter : public IdleThreadBlock::Observer {
+public:
+    IdleThreadBlockCounter() {
+        IdleThreadBlock::setObserverForThread(this);
+    }
+
+    ~IdleThreadBlockCounter() {
+        IdleThreadBlock::setObserverForThread(nullptr);
+    }
+
+    void onBeginIdle() override {
+        ++count;
+    }
+
+    void onEndIdle() override {}
+
+    int count = 0;
+};
+
 class SimpleEvent {
 public:
     void signal() {
@@ -438,6 +474,26 @@ TEST_F(ServiceStateMachineFixture, TestOkaySimpleCommand) {
     checkPingOk();
 }
 
+TEST_F(ServiceStateMachineFixture, SourcingIsIdleUnlessExecutorWaitedForData) {
+    IdleThreadBlockCounter idleThreadBlocks;
+
+    // The blocking read waits for the client to send a request.
+    _ssm->runNext();
+    ASSERT_EQ(_ssm->state(), State::Process);
+    ASSERT_EQ(1, idleThreadBlocks.count);
+}
+
+TEST_F(ServiceStateMachineFixture, SourcingAfterWaitingForDataIsNotIdle) {
+    MockWaitingServiceExecutor executor(getGlobalServiceContext());
+    _ssm->setServiceExecutor(&executor);
+    IdleThreadBlockCounter idleThreadBlocks;
+
+    // The executor only runs the read once the request has arrived.
+    _ssm->runNext();
+    ASSERT_EQ(_ssm->state(), State::Process);
+    ASSERT_EQ(0, idleThreadBlocks.count);
+}
+
 Message getMoreRequestWithExhaust(const std::string& nss,
                                   long long cursorId,
                                   const int32_t requestId) {
@@ -69,6 +69,28 @@ void Session::mutateTags(const std::function<TagMask(TagMask)>& mutateFunc) {
     } while (!_tags.compareAndSwap(&oldValue, newValue));
 }
 
+Status Session::sinkMessages(std::vector<Message> messages) {
+    for (auto& message : messages) {
+        if (auto status = sinkMessage(std::move(message)); !status.isOK()) {
+            return status;
+        }
+    }
+
+    return Status::OK();
+}
+
+Future<void> Session::asyncSinkMessages(std::vector<Message> messages, const BatonHandle& handle) {
+    auto future = Future<void>::makeReady();
+    for (auto& message : messages) {
+        future = std::move(future).then(
+            [self = shared_from_this(), message = std::move(message), handle]() mutable {
+                return self->asyncSinkMessage(std::move(message), handle);
+            });
+    }
+
+    return future;
+}
+
 Session::TagMask Session::getTags() const {
     return _tags.load();
 }
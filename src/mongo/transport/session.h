@@ -30,6 +30,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "mongo/config.h"
 #include "mongo/db/baton.h"
@@ -128,6 +129,32 @@ public:
     virtual Status sinkMessage(Message message) = 0;
     virtual Future<void> asyncSinkMessage(Message message, const BatonHandle& handle = nullptr) = 0;
 
+    /**
+     * Sink (send) several Messages to the remote host for this Session, in order.
+     *
+     * Implementations may coalesce the messages into a single vectored write. By default they are
+     * sunk one at a time.
+     */
+    virtual Status sinkMessages(std::vector<Message> messages);
+    virtual Future<void> asyncSinkMessages(std::vector<Message> messages,
+                                           const BatonHandle& handle = nullptr);
+
+    /**
+     * The capacity of the send buffer of the underlying socket, and how many bytes are queued in
+     * it which the remote host has not yet received.
+     */
+    struct SendBufferStats {
+        std::size_t size;
+        std::size_t queued;
+    };
+
+    /**
+     * Returns the current state of the send buffer, or boost::none if it cannot be determined.
+     */
+    virtual boost::optional<SendBufferStats> getSendBufferStats() {
+        return boost::none;
+    }
+
     /**
      * Cancel any outstanding async operations. There is no way to cancel synchronous calls.
      * Futures will finish with an ErrorCodes::CallbackCancelled error if they haven't already
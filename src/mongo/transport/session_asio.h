@@ -30,6 +30,12 @@
 #pragma once
 
 #include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/sockios.h>
+#include <sys/ioctl.h>
+#endif
 
 #include "mongo/base/system_error.h"
 #include "mongo/config.h"
@@ -38,6 +44,7 @@
 #include "mongo/transport/baton.h"
 #include "mongo/transport/ssl_connection_context.h"
 #include "mongo/transport/transport_layer_asio.h"
+#include "mongo/transport/transport_options_gen.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/net/socket_utils.h"
 #ifdef MONGO_CONFIG_SSL
@@ -181,6 +188,10 @@ public:
     }
 
     Future<void> waitForData() override {
+        if (_readAheadEnd > _readAheadBegin) {
+            return Future<void>::makeReady();
+        }
+
 #ifdef MONGO_CONFIG_SSL
         if (_sslSocket)
             return asio::async_read(*_sslSocket, asio::null_buffers(), UseFuture{}).ignoreValue();
@@ -210,6 +221,52 @@ public:
             });
     }
 
+    Status sinkMessages(std::vector<Message> messages) override {
+        ensureSync();
+
+        return write(makeBuffers(messages))
+            .then([this, &messages] {
+                if (_isIngressSession) {
+                    networkCounter.hitPhysicalOut(totalSize(messages));
+                }
+            })
+            .getNoThrow();
+    }
+
+    Future<void> asyncSinkMessages(std::vector<Message> messages,
+                                   const BatonHandle& baton = nullptr) override {
+        ensureAsync();
+        return write(makeBuffers(messages), baton)
+            .then([this, messages = std::move(messages) /*keep the buffers alive*/]() {
+                if (_isIngressSession) {
+                    networkCounter.hitPhysicalOut(totalSize(messages));
+                }
+            });
+    }
+
+    boost::optional<SendBufferStats> getSendBufferStats() override {
+#ifdef __linux__
+        std::error_code ec;
+        asio::socket_base::send_buffer_size size;
+        getSocket().get_option(size, ec);
+        if (ec) {
+            return boost::none;
+        }
+
+        // The kernel grows the send buffer as the connection's throughput grows, unless its size
+        // was set explicitly, so it is queried each time rather than cached.
+        int queued;
+        if (::ioctl(getSocket().native_handle(), SIOCOUTQ, &queued) != 0) {
+            return boost::none;
+        }
+
+        return SendBufferStats{static_cast<std::size_t>(size.value()),
+                               static_cast<std::size_t>(queued)};
+#else
+        return boost::none;
+#endif
+    }
+
     void cancelAsyncOperations(const BatonHandle& baton = nullptr) override {
         LOGV2_DEBUG(4615608,
                     3,
@@ -407,6 +464,23 @@ private:
         TimeoutType _timeout;
     };
 
+    static ConstBufferVector makeBuffers(const std::vector<Message>& messages) {
+        std::vector<asio::const_buffer> buffers;
+        buffers.reserve(messages.size());
+        for (const auto& message : messages) {
+            buffers.emplace_back(message.buf(), message.size());
+        }
+        return ConstBufferVector(std::move(buffers));
+    }
+
+    static std::size_t totalSize(const std::vector<Message>& messages) {
+        std::size_t size = 0;
+        for (const auto& message : messages) {
+            size += message.size();
+        }
+        return size;
+    }
+
     GenericSocket& getSocket() {
 #ifdef MONGO_CONFIG_SSL
         if (_sslSocket) {
@@ -416,10 +490,58 @@ private:
         return _socket;
     }
 
+    Status validateMessageLength(size_t msgLen) {
+        static constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+
+        if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
+            StringBuilder sb;
+            sb << "recv(): message msgLen " << msgLen << " is invalid. "
+               << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
+            const auto str = sb.str();
+            LOGV2(4615638,
+                  "recv(): message msgLen {msgLen} is invalid. Min: {min} Max: {max}",
+                  "recv(): message mstLen is invalid.",
+                  "msgLen"_attr = msgLen,
+                  "min"_attr = kHeaderSize,
+                  "max"_attr = MaxMessageSizeBytes);
+
+            return Status(ErrorCodes::ProtocolError, str);
+        }
+
+        return Status::OK();
+    }
+
+    /**
+     * Returns true if messages can be sourced through the read-ahead buffer. TLS streams do their
+     * own buffering, and the first read of an ingress session must detect a TLS handshake.
+     */
+    bool canReadAhead() const {
+        if (size_t(gTransportLayerReadAheadBytes) <= sizeof(MSGHEADER::Value)) {
+            return false;
+        }
+
+#ifdef MONGO_CONFIG_SSL
+        if (_sslSocket || !_ranHandshake) {
+            return false;
+        }
+#endif
+        return true;
+    }
+
     Future<Message> sourceMessageImpl(const BatonHandle& baton = nullptr) {
         static constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
 
-        auto headerBuffer = SharedBuffer::allocate(kHeaderSize);
+        if (canReadAhead()) {
+            if (_readAheadEnd - _readAheadBegin >= kHeaderSize) {
+                return sourceBufferedMessage(baton);
+            }
+
+            return fillReadAhead(kHeaderSize, baton).then([this, baton] {
+                return sourceBufferedMessage(baton);
+            });
+        }
+
+        auto headerBuffer = SharedBuffer::allocatePooled(kHeaderSize);
         auto ptr = headerBuffer.get();
         return read(asio::buffer(ptr, kHeaderSize), baton)
             .then([headerBuffer = std::move(headerBuffer), this, baton]() mutable {
@@ -428,19 +550,8 @@ private:
                 }
 
                 const auto msgLen = size_t(MSGHEADER::View(headerBuffer.get()).getMessageLength());
-                if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
-                    StringBuilder sb;
-                    sb << "recv(): message msgLen " << msgLen << " is invalid. "
-                       << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
-                    const auto str = sb.str();
-                    LOGV2(4615638,
-                          "recv(): message msgLen {msgLen} is invalid. Min: {min} Max: {max}",
-                          "recv(): message mstLen is invalid.",
-                          "msgLen"_attr = msgLen,
-                          "min"_attr = kHeaderSize,
-                          "max"_attr = MaxMessageSizeBytes);
-
-                    return Future<Message>::makeReady(Status(ErrorCodes::ProtocolError, str));
+                if (auto status = validateMessageLength(msgLen); !status.isOK()) {
+                    return Future<Message>::makeReady(std::move(status));
                 }
 
                 if (msgLen == kHeaderSize) {
@@ -451,7 +562,7 @@ private:
                     return Future<Message>::makeReady(Message(std::move(headerBuffer)));
                 }
 
-                auto buffer = SharedBuffer::allocate(msgLen);
+                auto buffer = SharedBuffer::allocatePooled(msgLen);
                 memcpy(buffer.get(), headerBuffer.get(), kHeaderSize);
 
                 MsgData::View msgView(buffer.get());
@@ -465,6 +576,71 @@ private:
             });
     }
 
+    /**
+     * Reads until there are at least 'minBytes' in the read-ahead buffer, taking as many more as
+     * the socket has ready and the buffer can hold.
+     */
+    Future<void> fillReadAhead(size_t minBytes, const BatonHandle& baton) {
+        const size_t capacity = gTransportLayerReadAheadBytes;
+        invariant(minBytes <= capacity);
+
+        if (!_readAheadBuffer) {
+            _readAheadBuffer = SharedBuffer::allocate(capacity);
+        }
+
+        // Move the start of the next message to the front of the buffer.
+        const auto buffered = _readAheadEnd - _readAheadBegin;
+        if (_readAheadBegin > 0) {
+            memmove(_readAheadBuffer.get(), _readAheadBuffer.get() + _readAheadBegin, buffered);
+            _readAheadBegin = 0;
+            _readAheadEnd = buffered;
+        }
+
+        auto ptr = _readAheadBuffer.get() + _readAheadEnd;
+        return opportunisticReadSome(
+                   _socket, asio::buffer(ptr, capacity - _readAheadEnd), minBytes - buffered, baton)
+            .then([this](size_t size) { _readAheadEnd += size; });
+    }
+
+    /**
+     * Sources the message whose header is at the front of the read-ahead buffer. The part of a
+     * message which did not fit in the buffer is read directly into the message.
+     */
+    Future<Message> sourceBufferedMessage(const BatonHandle& baton) {
+        static constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+
+        const char* header = _readAheadBuffer.get() + _readAheadBegin;
+        if (checkForHTTPRequest(asio::buffer(header, kHeaderSize))) {
+            return sendHTTPResponse(baton);
+        }
+
+        const auto msgLen = size_t(MSGHEADER::ConstView(header).getMessageLength());
+        if (auto status = validateMessageLength(msgLen); !status.isOK()) {
+            return Future<Message>::makeReady(std::move(status));
+        }
+
+        auto buffer = SharedBuffer::allocatePooled(msgLen);
+        const auto buffered = std::min(msgLen, _readAheadEnd - _readAheadBegin);
+        memcpy(buffer.get(), header, buffered);
+        _readAheadBegin += buffered;
+
+        if (buffered == msgLen) {
+            if (_isIngressSession) {
+                networkCounter.hitPhysicalIn(msgLen);
+            }
+            return Future<Message>::makeReady(Message(std::move(buffer)));
+        }
+
+        auto ptr = buffer.get() + buffered;
+        return read(asio::buffer(ptr, msgLen - buffered), baton)
+            .then([this, buffer = std::move(buffer), msgLen]() mutable {
+                if (_isIngressSession) {
+                    networkCounter.hitPhysicalIn(msgLen);
+                }
+                return Message(std::move(buffer));
+            });
+    }
+
     template <typename MutableBufferSequence>
     Future<void> read(const MutableBufferSequence& buffers, const BatonHandle& baton = nullptr) {
         // TODO SERVER-47229 Guard active ops for cancelation here.
@@ -577,6 +753,56 @@ private:
         }
     }
 
+    /**
+     * Like opportunisticRead, but returns once at least 'minBytes' have been read into 'buffer',
+     * along with however many more were already available, up to its size.
+     */
+    template <typename Stream>
+    Future<size_t> opportunisticReadSome(Stream& stream,
+                                         asio::mutable_buffer buffer,
+                                         size_t minBytes,
+                                         const BatonHandle& baton = nullptr) {
+        std::error_code ec;
+        size_t size;
+
+        do {
+            size = asio::read(stream, buffer, asio::transfer_at_least(minBytes), ec);
+        } while (ec == asio::error::interrupted);  // retry syscall EINTR
+
+        if (((ec == asio::error::would_block) || (ec == asio::error::try_again)) &&
+            (_blockingMode == Async)) {
+            // Some of the bytes may have been read already.
+            auto asyncBuffer = buffer + size;
+            auto remainingMinBytes = minBytes - size;
+
+            if (auto networkingBaton = baton ? baton->networking() : nullptr;
+                networkingBaton && networkingBaton->canWait()) {
+                return networkingBaton->addSession(*this, NetworkingBaton::Type::In)
+                    .onError([](Status error) {
+                        if (ErrorCodes::isShutdownError(error)) {
+                            // As in opportunisticRead(), fall back to asio::async_read() below.
+                            return Status::OK();
+                        }
+
+                        return error;
+                    })
+                    .then([&stream, asyncBuffer, remainingMinBytes, baton, this] {
+                        return opportunisticReadSome(
+                            stream, asyncBuffer, remainingMinBytes, baton);
+                    })
+                    .then([size](size_t asyncSize) { return size + asyncSize; });
+            }
+
+            return asio::async_read(stream,
+                                    asyncBuffer,
+                                    asio::transfer_at_least(remainingMinBytes),
+                                    UseFuture{})
+                .then([size](size_t asyncSize) { return size + asyncSize; });
+        } else {
+            return futurize(ec, size);
+        }
+    }
+
     /**
      * moreToSend checks the ssl socket after an opportunisticWrite.  If there are still bytes to
      * send, we manually send them off the underlying socket.  Then we hook that up with a future
@@ -622,16 +848,16 @@ private:
 
         if (MONGO_unlikely(transportLayerASIOshortOpportunisticReadWrite.shouldFail()) &&
             _blockingMode == Async) {
-            asio::const_buffer localBuffer = buffers;
+            asio::const_buffer localBuffer = *asio::buffer_sequence_begin(buffers);
 
-            if (buffers.size()) {
-                localBuffer = asio::const_buffer(buffers.data(), 1);
+            if (localBuffer.size()) {
+                localBuffer = asio::const_buffer(localBuffer.data(), 1);
             }
 
             do {
                 size = asio::write(stream, localBuffer, ec);
             } while (ec == asio::error::interrupted);  // retry syscall EINTR
-            if (!ec && buffers.size() > 1) {
+            if (!ec && asio::buffer_size(buffers) > 1) {
                 ec = asio::error::would_block;
             }
         } else {
@@ -831,6 +1057,12 @@ private:
     std::shared_ptr<const SSLConnectionContext> _sslContext;
 #endif
 
+    // Bytes received beyond the end of the last message sourced, between '_readAheadBegin' and
+    // '_readAheadEnd'. Only used when gTransportLayerReadAheadBytes is set.
+    SharedBuffer _readAheadBuffer;
+    size_t _readAheadBegin = 0;
+    size_t _readAheadEnd = 0;
+
     TransportLayerASIO* const _tl;
     bool _isIngressSession;
 };
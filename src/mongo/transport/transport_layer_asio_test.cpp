@@ -36,9 +36,11 @@
 #include "mongo/logv2/log.h"
 #include "mongo/rpc/op_msg.h"
 #include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/transport_options_gen.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/net/sock.h"
+#include "mongo/util/scopeguard.h"
 
 #include "asio.hpp"
 
@@ -259,6 +261,16 @@ private:
     Mode _mode;
 };
 
+Message makePing(int value) {
+    OpMsgBuilder builder;
+    builder.setBody(BSON("ping" << value));
+    Message msg = builder.finish();
+    msg.header().setResponseToMsgId(0);
+    msg.header().setId(0);
+    OpMsg::appendChecksum(&msg);
+    return msg;
+}
+
 class TimeoutConnector {
 public:
     TimeoutConnector(int port, bool sendRequest)
@@ -273,18 +285,46 @@ public:
     }
 
     void sendMessage() {
-        OpMsgBuilder builder;
-        builder.setBody(BSON("ping" << 1));
-        Message msg = builder.finish();
-        msg.header().setResponseToMsgId(0);
-        msg.header().setId(0);
-        OpMsg::appendChecksum(&msg);
+        Message msg = makePing(1);
 
         std::error_code ec;
         asio::write(_sock, asio::buffer(msg.buf(), msg.size()), ec);
         ASSERT_FALSE(ec);
     }
 
+    /**
+     * Sends 'count' pings, numbered from 0, with a single write.
+     */
+    void sendPipelinedMessages(int count) {
+        std::string bytes;
+        for (int i = 0; i < count; ++i) {
+            Message msg = makePing(i);
+            bytes.append(msg.buf(), msg.size());
+        }
+
+        std::error_code ec;
+        asio::write(_sock, asio::buffer(bytes), ec);
+        ASSERT_FALSE(ec);
+    }
+
+    /**
+     * Reads a single message.
+     */
+    Message receiveMessage() {
+        char header[sizeof(MSGHEADER::Value)];
+        std::error_code ec;
+        asio::read(_sock, asio::buffer(header), ec);
+        ASSERT_FALSE(ec);
+
+        const auto msgLen = size_t(MSGHEADER::ConstView(header).getMessageLength());
+        auto buffer = SharedBuffer::allocate(msgLen);
+        memcpy(buffer.get(), header, sizeof(header));
+        asio::read(_sock, asio::buffer(buffer.get() + sizeof(header), msgLen - sizeof(header)), ec);
+        ASSERT_FALSE(ec);
+
+        return Message(std::move(buffer));
+    }
+
 private:
     asio::io_context _ctx;
     asio::ip::tcp::socket _sock;
@@ -382,5 +422,89 @@ TEST(TransportLayerASIO, SwitchTimeoutModes) {
     tla->shutdown();
 }
 
+/* check that messages which arrive together are split correctly when reading ahead */
+class ReadAheadSEP : public TimeoutSEP {
+public:
+    explicit ReadAheadSEP(int numMessages) : _numMessages(numMessages) {}
+
+    void startSession(transport::SessionHandle session) override {
+        LOGV2(5338705, "Accepted connection", "remote"_attr = session->remote());
+        startWorkerThread([this, session = std::move(session)]() mutable {
+            for (int i = 0; i < _numMessages; ++i) {
+                auto swMessage = session->sourceMessage();
+                ASSERT_OK(swMessage.getStatus());
+                ASSERT_BSONOBJ_EQ(OpMsg::parse(swMessage.getValue()).body, BSON("ping" << i));
+            }
+
+            session.reset();
+            notifyComplete();
+        });
+    }
+
+private:
+    const int _numMessages;
+};
+
+TEST(TransportLayerASIO, ReadAheadSourcesPipelinedMessages) {
+    // Small enough that most reads end partway through a message.
+    const auto originalReadAheadBytes = transport::gTransportLayerReadAheadBytes;
+    transport::gTransportLayerReadAheadBytes = 64;
+    ON_BLOCK_EXIT([&] { transport::gTransportLayerReadAheadBytes = originalReadAheadBytes; });
+
+    const int kNumMessages = 10;
+    ReadAheadSEP sep(kNumMessages);
+    auto tla = makeAndStartTL(&sep);
+
+    TimeoutConnector connector(tla->listenerPort(), false);
+    connector.sendPipelinedMessages(kNumMessages);
+
+    ASSERT_TRUE(sep.waitForTimeout(Milliseconds{30000}));
+    tla->shutdown();
+}
+
+/* check that messages which are sunk together arrive intact and in order */
+class SinkMessagesSEP : public TimeoutSEP {
+public:
+    explicit SinkMessagesSEP(int numMessages) : _numMessages(numMessages) {}
+
+    void startSession(transport::SessionHandle session) override {
+        LOGV2(5338725, "Accepted connection", "remote"_attr = session->remote());
+        startWorkerThread([this, session = std::move(session)]() mutable {
+#ifdef __linux__
+            auto stats = session->getSendBufferStats();
+            ASSERT_TRUE(stats);
+            ASSERT_GT(stats->size, 0U);
+#endif
+
+            std::vector<Message> messages;
+            for (int i = 0; i < _numMessages; ++i) {
+                messages.push_back(makePing(i));
+            }
+            ASSERT_OK(session->sinkMessages(std::move(messages)));
+
+            session.reset();
+            notifyComplete();
+        });
+    }
+
+private:
+    const int _numMessages;
+};
+
+TEST(TransportLayerASIO, SinkMessagesWritesInOrder) {
+    const int kNumMessages = 10;
+    SinkMessagesSEP sep(kNumMessages);
+    auto tla = makeAndStartTL(&sep);
+
+    TimeoutConnector connector(tla->listenerPort(), false);
+    for (int i = 0; i < kNumMessages; ++i) {
+        auto msg = connector.receiveMessage();
+        ASSERT_BSONOBJ_EQ(OpMsg::parse(msg).body, BSON("ping" << i));
+    }
+
+    ASSERT_TRUE(sep.waitForTimeout(Milliseconds{30000}));
+    tla->shutdown();
+}
+
 }  // namespace
 }  // namespace mongo
@@ -39,13 +39,27 @@ thread_local const char* idleThreadLocation = nullptr;
 }  // namespace for_debuggers
 using for_debuggers::idleThreadLocation;
 
+namespace {
+thread_local IdleThreadBlock::Observer* idleThreadObserver = nullptr;
+}  // namespace
+
+void IdleThreadBlock::setObserverForThread(Observer* observer) {
+    idleThreadObserver = observer;
+}
+
 void IdleThreadBlock::beginIdleThreadBlock(const char* location) {
     invariant(!idleThreadLocation);
     idleThreadLocation = location;
+    if (idleThreadObserver) {
+        idleThreadObserver->onBeginIdle();
+    }
 }
 
 void IdleThreadBlock::endIdleThreadBlock() {
     invariant(idleThreadLocation);
     idleThreadLocation = nullptr;
+    if (idleThreadObserver) {
+        idleThreadObserver->onEndIdle();
+    }
 }
 }  // namespace mongo
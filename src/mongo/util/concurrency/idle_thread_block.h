@@ -54,6 +54,23 @@ public:
         endIdleThreadBlock();
     }
 
+    /**
+     * Notified when the thread it is installed on enters and leaves an IdleThreadBlock, e.g. so
+     * that a thread pool can run another thread while one of its own waits.
+     */
+    class Observer {
+    public:
+        virtual ~Observer() = default;
+        virtual void onBeginIdle() = 0;
+        virtual void onEndIdle() = 0;
+    };
+
+    /**
+     * Installs 'observer' on the current thread, replacing any previous one. Passing nullptr
+     * removes it. The observer must outlive its installation.
+     */
+    static void setObserverForThread(Observer* observer);
+
     // These should not be called by mongo C++ code. They are only public to allow exposing this
     // functionality to a C api.
     static void beginIdleThreadBlock(const char* location);
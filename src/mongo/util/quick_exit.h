@@ -27,6 +27,7 @@
  *    it in the license file.
  */
 
+#include "mongo/logv2/log_util.h"
 #include "mongo/platform/compiler.h"
 #include "mongo/util/assert_util.h"
 
@@ -49,6 +50,8 @@ MONGO_COMPILER_NORETURN void quickExitWithoutLogging(int);
 
 MONGO_COMPILER_NORETURN inline void quickExit(int code) {
     checkForTripwireAssertions(code);
+    // A no-op unless the log file is written asynchronously.
+    logv2::flushLogs();
     quickExitWithoutLogging(code);
 }
 
@@ -38,6 +38,7 @@
 
 #include "mongo/util/allocator.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/shared_buffer_pool.h"
 
 namespace mongo {
 
@@ -56,6 +57,21 @@ public:
         return takeOwnership(mongoMalloc(sizeof(Holder) + bytes), bytes);
     }
 
+    /**
+     * Like allocate(), but takes the buffer from this thread's SharedBufferPool and returns it to
+     * the pool of the thread which drops the last reference. The capacity is rounded up to the
+     * pool's size class. Falls back to allocate() when pooling is disabled or 'bytes' is too large
+     * to be pooled.
+     */
+    static SharedBuffer allocatePooled(size_t bytes) {
+        auto block = SharedBufferPool::acquire(sizeof(Holder), bytes);
+        if (!block.ptr) {
+            return allocate(bytes);
+        }
+
+        return SharedBuffer(new (block.ptr) Holder(1U, block.capacity, true /* pooled */));
+    }
+
     /**
      * Resizes the buffer, copying the current contents.
      *
@@ -67,6 +83,20 @@ public:
     void realloc(size_t size) {
         invariant(!_holder || !_holder->isShared());
 
+        // A pooled buffer grows into a block of a larger size class. The outgrown block is freed
+        // rather than cached, as the kind of message which outgrew it would only outgrow it again.
+        if (_holder && _holder->isPooled()) {
+            auto tmp = SharedBuffer::allocatePooled(size);
+            memcpy(tmp.get(), get(), std::min(size, capacity()));
+
+            Holder* outgrown = _holder.detach();
+            const auto sizeClass = outgrown->sizeClass();
+            outgrown->~Holder();
+            SharedBufferPool::discard(outgrown, sizeClass);
+            _holder = std::move(tmp._holder);
+            return;
+        }
+
         const size_t realSize = size + sizeof(Holder);
         void* newPtr = mongoRealloc(_holder.get(), realSize);
 
@@ -85,7 +115,7 @@ public:
             auto tmp = SharedBuffer::allocate(size);
             memcpy(tmp._holder->data(),
                    _holder->data(),
-                   std::min(size, static_cast<size_t>(_holder->_capacity)));
+                   std::min(size, _holder->capacity()));
             swap(tmp);
         } else if (_holder) {
             realloc(size);
@@ -115,15 +145,15 @@ public:
      * Users of this type must maintain the "used" size separately.
      */
     size_t capacity() const {
-        return _holder ? _holder->_capacity : 0;
+        return _holder ? _holder->capacity() : 0;
     }
 
 private:
     class Holder {
     public:
-        explicit Holder(unsigned initial, size_t capacity)
-            : _refCount(initial), _capacity(capacity) {
-            invariant(capacity == _capacity);
+        explicit Holder(unsigned initial, size_t capacity, bool pooled = false)
+            : _refCount(initial), _capacity(capacity | (pooled ? kPooledFlag : 0)) {
+            invariant(capacity == this->capacity());
         }
 
         // these are called automatically by boost::intrusive_ptr
@@ -135,8 +165,14 @@ private:
             if (h->_refCount.subtractAndFetch(1) == 0) {
                 // We placement new'ed a Holder in takeOwnership above,
                 // so we must destroy the object here.
+                const bool pooled = h->isPooled();
+                const auto sizeClass = pooled ? h->sizeClass() : SharedBufferPool::kNotPooled;
                 h->~Holder();
-                free(h);
+                if (pooled) {
+                    SharedBufferPool::release(h, sizeClass);
+                } else {
+                    free(h);
+                }
             }
         }
 
@@ -152,9 +188,29 @@ private:
             return _refCount.load() > 1;
         }
 
+        size_t capacity() const {
+            return _capacity & ~kPooledFlag;
+        }
+
+        bool isPooled() const {
+            return _capacity & kPooledFlag;
+        }
+
+        /**
+         * The SharedBufferPool size class of a pooled buffer, which its capacity determines.
+         */
+        uint32_t sizeClass() const {
+            return SharedBufferPool::sizeClassOf(capacity());
+        }
+
+        // Set in '_capacity' for a buffer taken from a SharedBufferPool. Keeps the Holder, which
+        // prefixes every buffer, at 8 bytes.
+        static constexpr uint32_t kPooledFlag = 1U << 31;
+
         AtomicWord<unsigned> _refCount;
         uint32_t _capacity;
     };
+    MONGO_STATIC_ASSERT(sizeof(Holder) == 8);
 
     explicit SharedBuffer(Holder* holder) : _holder(holder, /*add_ref=*/false) {
         // NOTE: The 'false' above is because we have already initialized the Holder with a
@@ -0,0 +1,193 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/shared_buffer_pool.h"
+
+#include <array>
+#include <cstdlib>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/platform/bits.h"
+#include "mongo/util/allocator.h"
+
+namespace mongo {
+
+AtomicWord<long long> SharedBufferPool::maxCachedBytesPerThread{
+    SharedBufferPool::kDefaultMaxCachedBytesPerThread};
+AtomicWord<long long> SharedBufferPool::maxCachedBytes{SharedBufferPool::kDefaultMaxCachedBytes};
+
+namespace {
+
+AtomicWord<long long> hits;
+AtomicWord<long long> misses;
+AtomicWord<long long> outstandingBytes;
+AtomicWord<long long> cachedBytes;
+
+uint32_t sizeClassFor(size_t bytes) {
+    if (bytes <= SharedBufferPool::kMinCapacity) {
+        return 0;
+    }
+
+    static const int kMinCapacityBits =
+        64 - countLeadingZeros64(SharedBufferPool::kMinCapacity - 1);
+    return 64 - countLeadingZeros64(bytes - 1) - kMinCapacityBits;
+}
+
+/**
+ * The blocks a thread has released, by size class. Blocks are pushed and popped from the back, so
+ * that the most recently used, and most likely still cached, block is reused first.
+ */
+class ThreadCache {
+public:
+    ~ThreadCache();
+
+    void* pop(uint32_t sizeClass) {
+        auto& count = _counts[sizeClass];
+        if (count == 0) {
+            return nullptr;
+        }
+
+        _bytes -= SharedBufferPool::sizeClassCapacity(sizeClass);
+        return _blocks[sizeClass][--count];
+    }
+
+    bool push(void* ptr, uint32_t sizeClass, long long maxBytes) {
+        const auto capacity = SharedBufferPool::sizeClassCapacity(sizeClass);
+        auto& count = _counts[sizeClass];
+        if (count == SharedBufferPool::kMaxCachedBlocksPerSizeClass ||
+            _bytes + static_cast<long long>(capacity) > maxBytes) {
+            return false;
+        }
+
+        _bytes += capacity;
+        _blocks[sizeClass][count++] = ptr;
+        return true;
+    }
+
+private:
+    std::array<std::array<void*, SharedBufferPool::kMaxCachedBlocksPerSizeClass>,
+               SharedBufferPool::kNumSizeClasses>
+        _blocks;
+    std::array<size_t, SharedBufferPool::kNumSizeClasses> _counts{};
+    long long _bytes = 0;
+};
+
+// Buffers can be released by thread_local destructors which run after this thread's cache is
+// gone. Those are freed rather than cached.
+thread_local bool threadCacheDestroyed = false;
+
+ThreadCache::~ThreadCache() {
+    for (uint32_t sizeClass = 0; sizeClass < SharedBufferPool::kNumSizeClasses; ++sizeClass) {
+        while (auto ptr = pop(sizeClass)) {
+            cachedBytes.fetchAndAddRelaxed(
+                -static_cast<long long>(SharedBufferPool::sizeClassCapacity(sizeClass)));
+            std::free(ptr);
+        }
+    }
+    threadCacheDestroyed = true;
+}
+
+ThreadCache* getThreadCache() {
+    if (threadCacheDestroyed) {
+        return nullptr;
+    }
+
+    thread_local ThreadCache cache;
+    return &cache;
+}
+
+}  // namespace
+
+SharedBufferPool::Block SharedBufferPool::acquire(size_t prefixBytes, size_t bytes) {
+    if (bytes > kMaxCapacity || maxCachedBytesPerThread.loadRelaxed() <= 0) {
+        return {};
+    }
+
+    Block block;
+    block.sizeClass = sizeClassFor(bytes);
+    block.capacity = sizeClassCapacity(block.sizeClass);
+
+    if (auto cache = getThreadCache()) {
+        block.ptr = cache->pop(block.sizeClass);
+    }
+
+    if (block.ptr) {
+        hits.fetchAndAddRelaxed(1);
+        cachedBytes.fetchAndAddRelaxed(-static_cast<long long>(block.capacity));
+    } else {
+        misses.fetchAndAddRelaxed(1);
+        block.ptr = mongoMalloc(prefixBytes + block.capacity);
+    }
+
+    outstandingBytes.fetchAndAddRelaxed(block.capacity);
+    return block;
+}
+
+void SharedBufferPool::release(void* ptr, uint32_t sizeClass) noexcept {
+    const auto capacity = static_cast<long long>(sizeClassCapacity(sizeClass));
+    outstandingBytes.fetchAndAddRelaxed(-capacity);
+
+    // Reserve room under the process-wide limit before caching the block in this thread.
+    if (cachedBytes.fetchAndAddRelaxed(capacity) + capacity <= maxCachedBytes.loadRelaxed()) {
+        auto cache = getThreadCache();
+        if (cache && cache->push(ptr, sizeClass, maxCachedBytesPerThread.loadRelaxed())) {
+            return;
+        }
+    }
+
+    cachedBytes.fetchAndAddRelaxed(-capacity);
+    std::free(ptr);
+}
+
+void SharedBufferPool::discard(void* ptr, uint32_t sizeClass) noexcept {
+    outstandingBytes.fetchAndAddRelaxed(-static_cast<long long>(sizeClassCapacity(sizeClass)));
+    std::free(ptr);
+}
+
+SharedBufferPool::Stats SharedBufferPool::getStats() {
+    Stats stats;
+    stats.hits = hits.loadRelaxed();
+    stats.misses = misses.loadRelaxed();
+    stats.outstandingBytes = outstandingBytes.loadRelaxed();
+    stats.cachedBytes = cachedBytes.loadRelaxed();
+    return stats;
+}
+
+void SharedBufferPool::appendStats(BSONObjBuilder* builder) {
+    const auto stats = getStats();
+    builder->append("hits", stats.hits);
+    builder->append("misses", stats.misses);
+    builder->append("outstandingBytes", stats.outstandingBytes);
+    builder->append("cachedBytes", stats.cachedBytes);
+}
+
+}  // namespace mongo
@@ -0,0 +1,127 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * Per-thread caches of memory blocks backing the SharedBuffers which network messages are received
+ * into and built in. Blocks come in power of two size classes, so a block released after one
+ * message can be reused for any later message of about the same size without going back to the
+ * allocator.
+ *
+ * A block is cached by the thread which releases it, up to maxCachedBytesPerThread for that thread
+ * and maxCachedBytes for all threads together, so that the memory held by the pools does not grow
+ * with the number of threads. Blocks which do not fit, and all blocks larger than kMaxCapacity,
+ * are freed. Callers should use SharedBuffer::allocatePooled() rather than this class directly.
+ */
+class SharedBufferPool {
+public:
+    static constexpr uint32_t kNotPooled = UINT32_MAX;
+
+    static constexpr size_t kMinCapacity = 512;
+    static constexpr uint32_t kNumSizeClasses = 12;
+    static constexpr size_t kMaxCapacity = kMinCapacity << (kNumSizeClasses - 1);
+
+    // The most blocks of each size class a thread caches.
+    static constexpr size_t kMaxCachedBlocksPerSizeClass = 16;
+
+    static constexpr long long kDefaultMaxCachedBytesPerThread = 4 * 1024 * 1024;
+    static constexpr long long kDefaultMaxCachedBytes = 64 * 1024 * 1024;
+
+    /**
+     * The number of bytes of released blocks each thread may cache. Setting this to 0 disables
+     * pooling, so that every buffer comes from and goes back to the allocator.
+     */
+    static AtomicWord<long long> maxCachedBytesPerThread;
+
+    /**
+     * The number of bytes of released blocks all threads together may cache.
+     */
+    static AtomicWord<long long> maxCachedBytes;
+
+    struct Block {
+        void* ptr = nullptr;
+        uint32_t sizeClass = kNotPooled;
+        size_t capacity = 0;
+    };
+
+    struct Stats {
+        long long hits = 0;
+        long long misses = 0;
+        long long outstandingBytes = 0;
+        long long cachedBytes = 0;
+    };
+
+    static constexpr size_t sizeClassCapacity(uint32_t sizeClass) {
+        return kMinCapacity << sizeClass;
+    }
+
+    /**
+     * Returns the size class of a block with 'capacity', which must have come from acquire().
+     */
+    static uint32_t sizeClassOf(size_t capacity) {
+        return countTrailingZeros64(capacity / kMinCapacity);
+    }
+
+    /**
+     * Returns a block with 'prefixBytes' followed by at least 'bytes' of capacity. The block is
+     * taken from this thread's cache when it has one of the right size class. Returns a Block with
+     * a null 'ptr' when pooling is disabled or 'bytes' is larger than kMaxCapacity.
+     */
+    static Block acquire(size_t prefixBytes, size_t bytes);
+
+    /**
+     * Returns a block from acquire() to this thread's cache, or frees it if the cache is full.
+     */
+    static void release(void* ptr, uint32_t sizeClass) noexcept;
+
+    /**
+     * Frees a block from acquire() without caching it.
+     */
+    static void discard(void* ptr, uint32_t sizeClass) noexcept;
+
+    static Stats getStats();
+
+    /**
+     * Appends the hits, misses, outstanding bytes and cached bytes of all threads' pools.
+     */
+    static void appendStats(BSONObjBuilder* builder);
+};
+
+}  // namespace mongo
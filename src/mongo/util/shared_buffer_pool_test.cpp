@@ -0,0 +1,181 @@
+/**
+ *    Copyright (C) 2021-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <cstring>
+
+#include "mongo/stdx/thread.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/shared_buffer.h"
+
+namespace mongo {
+namespace {
+
+TEST(SharedBufferPoolTest, ReleasedBufferIsReusedForSameSizeClass) {
+    const char* first;
+    {
+        auto buf = SharedBuffer::allocatePooled(1000);
+        ASSERT_EQ(buf.capacity(), 1024U);
+        first = buf.get();
+    }
+
+    const auto before = SharedBufferPool::getStats();
+    auto buf = SharedBuffer::allocatePooled(600);
+    const auto after = SharedBufferPool::getStats();
+
+    ASSERT_EQ(buf.get(), first);
+    ASSERT_EQ(after.hits, before.hits + 1);
+    ASSERT_EQ(after.misses, before.misses);
+    ASSERT_EQ(after.outstandingBytes, before.outstandingBytes + 1024);
+    ASSERT_EQ(after.cachedBytes, before.cachedBytes - 1024);
+}
+
+TEST(SharedBufferPoolTest, BufferIsCachedByReleasingThread) {
+    auto buf = SharedBuffer::allocatePooled(SharedBufferPool::kMinCapacity);
+    const char* ptr = buf.get();
+
+    const char* reused = nullptr;
+    stdx::thread([&] {
+        buf = {};
+        reused = SharedBuffer::allocatePooled(1).get();
+    }).join();
+
+    ASSERT_EQ(reused, ptr);
+}
+
+TEST(SharedBufferPoolTest, ReallocGrowsIntoLargerSizeClass) {
+    auto buf = SharedBuffer::allocatePooled(SharedBufferPool::kMinCapacity);
+    memset(buf.get(), 'a', buf.capacity());
+
+    buf.realloc(SharedBufferPool::kMinCapacity * 3);
+    ASSERT_EQ(buf.capacity(), SharedBufferPool::kMinCapacity * 4);
+    for (size_t i = 0; i < SharedBufferPool::kMinCapacity; ++i) {
+        ASSERT_EQ(buf.get()[i], 'a');
+    }
+}
+
+TEST(SharedBufferPoolTest, ReallocFreesOutgrownBlock) {
+    // Run on a new thread so that the cache starts out empty.
+    stdx::thread([] {
+        auto buf = SharedBuffer::allocatePooled(SharedBufferPool::kMinCapacity);
+
+        const auto before = SharedBufferPool::getStats();
+        buf.realloc(SharedBufferPool::kMinCapacity * 3);
+        const auto after = SharedBufferPool::getStats();
+
+        ASSERT_EQ(after.cachedBytes, before.cachedBytes);
+        ASSERT_EQ(after.outstandingBytes,
+                  before.outstandingBytes +
+                      static_cast<long long>(SharedBufferPool::kMinCapacity * 3));
+
+        // The outgrown block is not handed out again.
+        auto next = SharedBuffer::allocatePooled(SharedBufferPool::kMinCapacity);
+        ASSERT_EQ(SharedBufferPool::getStats().misses, after.misses + 1);
+    }).join();
+}
+
+TEST(SharedBufferPoolTest, SizeClassFollowsFromCapacity) {
+    for (uint32_t sizeClass = 0; sizeClass < SharedBufferPool::kNumSizeClasses; ++sizeClass) {
+        ASSERT_EQ(SharedBufferPool::sizeClassOf(SharedBufferPool::sizeClassCapacity(sizeClass)),
+                  sizeClass);
+    }
+}
+
+TEST(SharedBufferPoolTest, LargeBuffersAreNotPooled) {
+    const auto before = SharedBufferPool::getStats();
+    auto buf = SharedBuffer::allocatePooled(SharedBufferPool::kMaxCapacity + 1);
+    const auto after = SharedBufferPool::getStats();
+
+    ASSERT_EQ(buf.capacity(), SharedBufferPool::kMaxCapacity + 1);
+    ASSERT_EQ(after.hits, before.hits);
+    ASSERT_EQ(after.misses, before.misses);
+    ASSERT_EQ(after.outstandingBytes, before.outstandingBytes);
+}
+
+TEST(SharedBufferPoolTest, DisablingPoolAllocatesExactSize) {
+    const auto maxCachedBytes = SharedBufferPool::maxCachedBytesPerThread.load();
+    SharedBufferPool::maxCachedBytesPerThread.store(0);
+    ON_BLOCK_EXIT([&] { SharedBufferPool::maxCachedBytesPerThread.store(maxCachedBytes); });
+
+    const auto before = SharedBufferPool::getStats();
+    auto buf = SharedBuffer::allocatePooled(1000);
+    const auto after = SharedBufferPool::getStats();
+
+    ASSERT_EQ(buf.capacity(), 1000U);
+    ASSERT_EQ(after.hits, before.hits);
+    ASSERT_EQ(after.misses, before.misses);
+}
+
+TEST(SharedBufferPoolTest, ReleasedBuffersBeyondLimitAreFreed) {
+    const auto maxCachedBytes = SharedBufferPool::maxCachedBytesPerThread.load();
+    SharedBufferPool::maxCachedBytesPerThread.store(SharedBufferPool::sizeClassCapacity(1));
+    ON_BLOCK_EXIT([&] { SharedBufferPool::maxCachedBytesPerThread.store(maxCachedBytes); });
+
+    // Run on a new thread so that the cache starts out empty.
+    stdx::thread([] {
+        auto first = SharedBuffer::allocatePooled(SharedBufferPool::sizeClassCapacity(1));
+        auto second = SharedBuffer::allocatePooled(SharedBufferPool::sizeClassCapacity(1));
+
+        const auto before = SharedBufferPool::getStats();
+        first = {};
+        second = {};
+        const auto after = SharedBufferPool::getStats();
+
+        ASSERT_EQ(after.cachedBytes,
+                  before.cachedBytes +
+                      static_cast<long long>(SharedBufferPool::sizeClassCapacity(1)));
+    }).join();
+}
+
+TEST(SharedBufferPoolTest, ReleasedBuffersBeyondProcessLimitAreFreed) {
+    const auto maxCachedBytes = SharedBufferPool::maxCachedBytes.load();
+    ON_BLOCK_EXIT([&] { SharedBufferPool::maxCachedBytes.store(maxCachedBytes); });
+
+    // Run on a new thread so that the cache starts out empty.
+    stdx::thread([] {
+        auto buf = SharedBuffer::allocatePooled(SharedBufferPool::kMinCapacity);
+
+        // Leave no room for any more cached blocks, although this thread's cache is empty.
+        const auto before = SharedBufferPool::getStats();
+        SharedBufferPool::maxCachedBytes.store(before.cachedBytes);
+        buf = {};
+        const auto after = SharedBufferPool::getStats();
+
+        ASSERT_EQ(after.cachedBytes, before.cachedBytes);
+        ASSERT_EQ(after.outstandingBytes,
+                  before.outstandingBytes -
+                      static_cast<long long>(SharedBufferPool::kMinCapacity));
+    }).join();
+}
+
+}  // namespace
+}  // namespace mongo